@@ -17,6 +17,8 @@
 
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
 
+#include "objects/mesh.h"
+
 namespace gvr {
 
 btCollisionShape *convertCollider2CollisionShape(Collider *collider) {
@@ -73,14 +75,20 @@ btConvexHullShape *createConvexHullShapeFromMesh(Mesh *mesh) {
         btShapeHull *hull_shape_optimizer = NULL;
         unsigned short vertex_index;
 
+        // use the animated pose if the mesh is skinned on the CPU
+        std::shared_ptr<const SkinnedPose> pose =
+                mesh->getVertexBoneData().getSkinnedPose();
+        const std::vector<glm::vec3>& vertices =
+                (pose != NULL) ? pose->vertices() : mesh->vertices();
+
         initial_hull_shape = new btConvexHullShape();
 
         for (int i = 0; i < mesh->indices().size(); i++) {
             vertex_index = mesh->indices()[i];
 
-            btVector3 vertex(mesh->vertices()[vertex_index].x,
-                             mesh->vertices()[vertex_index].y,
-                             mesh->vertices()[vertex_index].z);
+            btVector3 vertex(vertices[vertex_index].x,
+                             vertices[vertex_index].y,
+                             vertices[vertex_index].z);
 
             initial_hull_shape->addPoint(vertex);
         }
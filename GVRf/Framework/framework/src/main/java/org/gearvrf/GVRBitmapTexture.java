@@ -294,6 +294,7 @@ public class GVRBitmapTexture extends GVRTexture {
         GLUtils.texImage2D(GL_TEXTURE_2D, 0, bitmap, 0);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);        
+        NativeBaseTexture.bitmapUploaded(getNative(), bitmap.getWidth(), bitmap.getHeight());
         return (glGetError() == GL_NO_ERROR);
     }
 
@@ -387,5 +388,7 @@ final class NativeBaseTexture {
     static native boolean update(long pointer, int width, int height,
             byte[] grayscaleData);
 
+    static native void bitmapUploaded(long pointer, int width, int height);
+
     static native boolean updateFromBuffer(long pointer, int width, int height, int format, int type, Buffer pixels);
 }
@@ -155,7 +155,11 @@ class GVRJassimpAdapter {
 
         // Triangles
         IntBuffer indexBuffer = aiMesh.getIndexBuffer();
-        if (indexBuffer != null) {
+        if (indexBuffer != null && aiMesh.getNumVertices() > 65535) {
+            int[] triangles = new int[indexBuffer.capacity()];
+            indexBuffer.get(triangles);
+            mesh.setIntIndices(triangles);
+        } else if (indexBuffer != null) {
             CharBuffer triangles = CharBuffer.allocate(indexBuffer.capacity());
             for (int i = 0; i < indexBuffer.capacity(); ++i) {
                 triangles.put((char)indexBuffer.get());
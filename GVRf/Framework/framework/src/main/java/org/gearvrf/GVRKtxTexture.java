@@ -0,0 +1,97 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.gearvrf;
+
+import java.io.File;
+import java.io.IOException;
+
+import android.content.res.AssetFileDescriptor;
+import android.os.ParcelFileDescriptor;
+
+/**
+ * A compressed texture streamed from a KTX 1.1 or KTX 2.0 file.
+ * 
+ * The file is memory mapped and its mip levels are uploaded straight
+ * from the mapping, so the image data never enters the Java heap. The
+ * coarsest levels are uploaded first, over a few frames; finer levels
+ * only follow once an object using the texture is drawn large enough
+ * on screen to need them.
+ * 
+ * KTX 2.0 files must not be supercompressed and must hold an ETC2, EAC
+ * or ASTC format. The asset must be stored uncompressed in the APK.
+ */
+public class GVRKtxTexture extends GVRTexture {
+
+    /**
+     * Load a KTX file.
+     * 
+     * @param gvrContext
+     *            Current {@link GVRContext}
+     * @param file
+     *            The KTX file
+     * @throws IOException
+     *             If the file cannot be opened or is not a KTX file this
+     *             class can load
+     */
+    public GVRKtxTexture(GVRContext gvrContext, File file) throws IOException {
+        super(gvrContext, load(gvrContext, file));
+    }
+
+    /**
+     * Load a KTX asset.
+     * 
+     * @param gvrContext
+     *            Current {@link GVRContext}
+     * @param asset
+     *            Descriptor of the asset, e.g. from
+     *            {@code AssetManager.openFd()}. It may be closed once the
+     *            texture has been created.
+     * @throws IOException
+     *             If the asset is not a KTX file this class can load
+     */
+    public GVRKtxTexture(GVRContext gvrContext, AssetFileDescriptor asset)
+            throws IOException {
+        super(gvrContext, load(gvrContext, asset.getParcelFileDescriptor(),
+                asset.getStartOffset(), asset.getLength()));
+    }
+
+    private static long load(GVRContext gvrContext, File file)
+            throws IOException {
+        ParcelFileDescriptor descriptor = ParcelFileDescriptor.open(file,
+                ParcelFileDescriptor.MODE_READ_ONLY);
+        try {
+            return load(gvrContext, descriptor, 0, -1);
+        } finally {
+            descriptor.close();
+        }
+    }
+
+    private static long load(GVRContext gvrContext,
+            ParcelFileDescriptor descriptor, long offset, long length)
+            throws IOException {
+        long ptr = NativeKtxTexture.load(descriptor.getFd(), offset, length,
+                gvrContext.DEFAULT_TEXTURE_PARAMETERS.getCurrentValuesArray());
+        if (0 == ptr) {
+            throw new IOException("Cannot load KTX texture");
+        }
+        return ptr;
+    }
+}
+
+class NativeKtxTexture {
+    static native long load(int fd, long offset, long length,
+            int[] textureParameterValues);
+}
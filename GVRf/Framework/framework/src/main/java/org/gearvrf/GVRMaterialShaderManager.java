@@ -49,6 +49,25 @@ import org.gearvrf.utility.Log;
     /**
      * Builds a shader program from the supplied vertex and fragment shader
      * code.
+     * <p>
+     * A vertex shader which declares {@code in mat4 a_model_instance;} opts
+     * in to instancing: render data sharing a mesh, materials and render
+     * states are drawn with one instanced draw call. Such a shader must
+     * take the model matrix from {@code a_model_instance} and the view and
+     * projection matrices from {@code u_view} and {@code u_proj}.
+     * <p>
+     * A GLSL 300 shader may also take the view dependent matrices from the
+     * std140 block {@code Camera}, which is uploaded once per render pass:
+     * <pre>
+     * layout (std140) uniform Camera {
+     *     mat4 u_view;
+     *     mat4 u_proj;
+     *     mat4 u_view_inv;
+     *     mat4 u_view_[2];
+     *     mat4 u_view_inv_[2];
+     *     highp int u_right;
+     * };
+     * </pre>
      *
      * @param vertexShader
      *            GLSL source code for a vertex shader.
@@ -196,6 +196,77 @@ public class GVRMesh extends GVRHybridObject implements PrettyPrint {
         NativeMesh.setIndices(getNative(), indices);
     }
 
+    /**
+     * Get the vertex indices of the mesh as 32 bit integers. Works for
+     * meshes with 16 bit as well as 32 bit indices.
+     *
+     * @return Array with the packed index data.
+     */
+    public int[] getIntIndices() {
+        return NativeMesh.getIntIndices(getNative());
+    }
+
+    /**
+     * Sets 32 bit vertex indices for meshes with more than 65535 vertices.
+     * Replaces the indices set by {@link #setIndices(char[])}; prefer the
+     * 16 bit version for smaller meshes as it uses half the memory.
+     *
+     * @param indices
+     *            Array containing the packed index data.
+     */
+    public void setIntIndices(int[] indices) {
+        NativeMesh.setIntIndices(getNative(), indices);
+    }
+
+    /**
+     * Mark the mesh as dynamic. Dynamic meshes are meant to be changed
+     * every frame with {@link #updateVertexAttribute(String, int, float[])};
+     * they are streamed into several rotating vertex buffers and only the
+     * changed vertices are uploaded. Static meshes, the default, re-upload
+     * all their vertex data whenever anything changes.
+     *
+     * @param dynamic
+     *            true to stream the vertex data of the mesh
+     */
+    public void setDynamic(boolean dynamic) {
+        NativeMesh.setDynamic(getNative(), dynamic);
+    }
+
+    /**
+     * Also skin the mesh on the CPU whenever its bones move. The
+     * skinning is done on worker threads before each frame is culled,
+     * and mesh colliders then pick against the animated pose instead
+     * of the bind pose. Convex hulls built for the physics engine
+     * after that also use the animated pose. Rendering still skins
+     * in the vertex shader.
+     *
+     * @param enable
+     *            true to keep a CPU skinned pose of the mesh
+     */
+    public void setCpuSkinning(boolean enable) {
+        NativeMesh.setCpuSkinning(getNative(), enable);
+    }
+
+    /**
+     * Overwrite a range of vertices of an existing attribute. Only that
+     * range is uploaded again if the mesh is dynamic.
+     *
+     * @param key
+     *            Name of the shader attribute, "a_position" and "a_normal"
+     *            for the vertices and normals.
+     * @param firstVertex
+     *            Index of the first vertex to overwrite.
+     * @param values
+     *            New values, all the components of each vertex in turn.
+     * @throws IllegalArgumentException
+     *            if the attribute does not exist or the range is out of bounds.
+     */
+    public void updateVertexAttribute(String key, int firstVertex, float[] values) {
+        if (!NativeMesh.updateVertexAttribute(getNative(), key, firstVertex, values)) {
+            throw new IllegalArgumentException("Cannot update vertex attribute " + key);
+        }
+    }
+
     /**
      * Get the array of {@code float} scalars bound to the shader attribute
      * {@code key}.
@@ -415,7 +486,7 @@ public class GVRMesh extends GVRHybridObject implements PrettyPrint {
     public void prettyPrint(StringBuffer sb, int indent) {
         sb.append(getVertices() == null ? 0 : Integer.toString(getVertices().length / 3));
         sb.append(" vertices, ");
-        sb.append(getIndices() == null ? 0 : Integer.toString(getIndices().length / 3));
+        sb.append(getIntIndices() == null ? 0 : Integer.toString(getIntIndices().length / 3));
         sb.append(" triangles, ");
         sb.append(getTexCoords() == null ? 0 : Integer.toString(getTexCoords().length / 2));
         sb.append(" tex-coords, ");
@@ -499,6 +570,17 @@ class NativeMesh {
 
     static native void setIndices(long mesh, char[] indices);
 
+    static native int[] getIntIndices(long mesh);
+
+    static native void setIntIndices(long mesh, int[] indices);
+
+    static native void setDynamic(long mesh, boolean dynamic);
+
+    static native void setCpuSkinning(long mesh, boolean enable);
+
+    static native boolean updateVertexAttribute(long mesh, String key, int firstVertex,
+            float[] values);
+
     static native float[] getFloatVector(long mesh, String key);
 
     static native void setFloatVector(long mesh, String key, float[] floatVector);
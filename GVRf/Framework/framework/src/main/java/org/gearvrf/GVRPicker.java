@@ -16,6 +16,7 @@
 package org.gearvrf;
 
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.List;
@@ -586,6 +587,49 @@ public class GVRPicker extends GVRBehavior {
         }
     }
 
+    /**
+     * Casts several rays into the scene graph at once, for example one for
+     * each controller and cursor.
+     * <p/>
+     * All the rays are tested in a single pass over the colliders of the
+     * scene, and the hits are returned in a {@link GVRRayHits} backed by a
+     * direct buffer instead of one object per hit.
+     *
+     * @param scene
+     *            The {@link GVRScene} with all the objects to be tested.
+     * @param trans
+     *            The {@link GVRTransform} establishing the coordinate system of
+     *            the rays, or null if they are in world coordinates.
+     * @param rays
+     *            Six floats per ray: the x, y, z of its origin followed by the
+     *            x, y, z of its direction.
+     * @param hits
+     *            The result of a previous call to reuse, or null.
+     * @return The hits of each ray, sorted by distance.
+     */
+    public static final GVRRayHits pickRays(GVRScene scene, GVRTransform trans, float[] rays,
+                                            GVRRayHits hits) {
+        if (hits == null) {
+            hits = new GVRRayHits();
+        }
+        long nativeTrans = (trans != null) ? trans.getNative() : 0L;
+        int rayCount = rays.length / 6;
+
+        sFindObjectsLock.lock();
+        try {
+            int size = NativePicker.pickRays(scene.getNative(), nativeTrans, rays, rayCount, hits.mBuffer);
+            if (size > hits.mBuffer.capacity()) {
+                // the native side keeps the hits, copy them without picking again
+                hits.mBuffer = ByteBuffer.allocateDirect(size * 2).order(ByteOrder.nativeOrder());
+                NativePicker.copyRayHits(hits.mBuffer);
+            }
+            hits.setRayCount(rayCount);
+            return hits;
+        } finally {
+            sFindObjectsLock.unlock();
+        }
+    }
+
     /**
      * Casts a ray into the scene graph, and returns the objects it intersects.
      * 
@@ -724,6 +768,57 @@ public class GVRPicker extends GVRBehavior {
         }
     }
 
+    /**
+     * The hits of the rays cast by
+     * {@link GVRPicker#pickRays(GVRScene, GVRTransform, float[], GVRRayHits)}.
+     *
+     * The hits are read straight from the buffer filled by the native
+     * picker, the hits of each ray are sorted by distance.
+     */
+    public static final class GVRRayHits {
+        private static final int HIT_SIZE = 24;
+        private ByteBuffer mBuffer = ByteBuffer.allocateDirect(1024).order(ByteOrder.nativeOrder());
+        private int mRayCount;
+        private int mHitStart;
+
+        void setRayCount(int rayCount) {
+            mRayCount = rayCount;
+            mHitStart = ((rayCount + 1) * 4 + 7) & ~7;
+        }
+
+        /** The number of rays cast */
+        public int getRayCount() {
+            return mRayCount;
+        }
+
+        /** The number of hits of a ray */
+        public int getHitCount(int ray) {
+            return mBuffer.getInt((ray + 1) * 4) - mBuffer.getInt(ray * 4);
+        }
+
+        /** The collider of the hit-th nearest hit of a ray */
+        public GVRCollider getCollider(int ray, int hit) {
+            return GVRCollider.lookup(mBuffer.getLong(hitOffset(ray, hit)));
+        }
+
+        /** The distance from the ray origin of the hit-th nearest hit of a ray */
+        public float getDistance(int ray, int hit) {
+            return mBuffer.getFloat(hitOffset(ray, hit) + 8);
+        }
+
+        /** The hit location of the hit-th nearest hit of a ray, as an [x, y, z] array */
+        public void getHitLocation(int ray, int hit, float[] location) {
+            int offset = hitOffset(ray, hit);
+            location[0] = mBuffer.getFloat(offset + 12);
+            location[1] = mBuffer.getFloat(offset + 16);
+            location[2] = mBuffer.getFloat(offset + 20);
+        }
+
+        private int hitOffset(int ray, int hit) {
+            return mHitStart + (mBuffer.getInt(ray * 4) + hit) * HIT_SIZE;
+        }
+    }
+
     static final ReentrantLock sFindObjectsLock = new ReentrantLock();
 }
 
@@ -738,6 +833,11 @@ final class NativePicker {
 
     static native GVRPicker.GVRPickedObject[] pickVisible(long scene);
 
+    static native int pickRays(long scene, long transform, float[] rays, int rayCount,
+            ByteBuffer results);
+
+    static native int copyRayHits(ByteBuffer results);
+
     static native boolean pickSceneObjectAgainstBoundingBox(long sceneObject,
             float ox, float oy, float oz, float dx, float dy, float dz, ByteBuffer readbackBuffer);
 }
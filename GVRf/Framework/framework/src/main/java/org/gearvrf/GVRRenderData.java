@@ -995,6 +995,30 @@ public class GVRRenderData extends GVRComponent implements PrettyPrint {
         return this;
     }
 
+    /**
+     * Checks if the mesh of this render data hides the objects behind it
+     * when software occlusion culling is enabled.
+     * @return true if this render data is an occluder
+     * @see #setOccluder(boolean)
+     */
+    public boolean isOccluder() {
+        return NativeRenderData.isOccluder(getNative());
+    }
+
+    /**
+     * Marks the mesh of this render data as an occluder.
+     * Occluders are rasterized into a small depth buffer on the CPU and
+     * objects entirely behind them are not rendered. Large opaque
+     * meshes with few triangles, like walls and floors, make the best
+     * occluders. Only used when software occlusion culling is enabled.
+     * @param occluder true to use the mesh as occluder
+     * @see GVRScene#setSoftwareOcclusion(boolean)
+     */
+    public GVRRenderData setOccluder(boolean occluder) {
+        NativeRenderData.setOccluder(getNative(), occluder);
+        return this;
+    }
+
     @Override
     public void prettyPrint(StringBuffer sb, int indent) {
         GVRMesh mesh = null;
@@ -1136,6 +1160,10 @@ class NativeRenderData {
 
     static native boolean getCastShadows(long renderData);
 
+    static native void setOccluder(long renderData, boolean occluder);
+
+    static native boolean isOccluder(long renderData);
+
     static native void setStencilFunc(long renderData, int func, int ref, int mask);
 
     static native void setStencilOp(long renderData, int fail, int zfail, int zpass);
@@ -292,6 +292,21 @@ public class GVRScene extends GVRHybridObject implements PrettyPrint, IScriptabl
         NativeScene.setFrustumCulling(getNative(), flag);
     }
 
+    /**
+     * Enables culling against a flattened copy of the scene graph.
+     * <p>
+     * Instead of walking the scene graph recursively every frame,
+     * the renderer keeps the scene objects and their bounds in flat
+     * arrays which are only rebuilt when the hierarchy changes.
+     * This is faster for large scenes but uses more memory.
+     * Flat culling is disabled by default.
+     * @param flag true to enable flat culling, false to disable it
+     * @see #setFrustumCulling(boolean)
+     */
+    public void setFlatCulling(boolean flag) {
+        NativeScene.setFlatCulling(getNative(), flag);
+    }
+
     /**
      * Sets the occlusion query for the {@link GVRScene}.
      */
@@ -299,6 +314,21 @@ public class GVRScene extends GVRHybridObject implements PrettyPrint, IScriptabl
         NativeScene.setOcclusionQuery(getNative(), flag);
     }
 
+    /**
+     * Selects how occlusion culling is done once it has been enabled
+     * with {@link #setOcclusionQuery(boolean)}.
+     * <p>
+     * By default the bounds of the objects are tested on the GPU and the
+     * results arrive a few frames later. With software occlusion the
+     * render data marked with {@link GVRRenderData#setOccluder(boolean)}
+     * are rasterized into a small depth buffer on a worker thread and
+     * the objects behind them are dropped in the same frame.
+     * @param flag true to cull on the CPU, false to use GPU queries
+     */
+    public void setSoftwareOcclusion(boolean flag) {
+        NativeScene.setSoftwareOcclusion(getNative(), flag);
+    }
+
     private GVRConsole mStatsConsole = null;
     private boolean mStatsEnabled = false;
     private boolean pendingStats = false;
@@ -354,9 +384,21 @@ public class GVRScene extends GVRHybridObject implements PrettyPrint, IScriptabl
         if (mStatsEnabled) {
             int numberDrawCalls = NativeScene.getNumberDrawCalls(getNative());
             int numberTriangles = NativeScene.getNumberTriangles(getNative());
+            int numberStateChanges = NativeScene.getNumberStateChanges(getNative());
+            int numberSkipped = NativeScene.getNumberSkippedStateChanges(getNative());
+            int numberTransforms = NativeScene.getNumberTransformsUpdated(getNative());
+            int numberBounds = NativeScene.getNumberBoundsRefit(getNative());
+            float uploadMillis = NativeScene.getTextureUploadMilliseconds(getNative());
+            int uploadBytes = NativeScene.getTextureUploadBytes(getNative());
+            int textureKB = NativeScene.getTextureMemoryKB(getNative());
+            int numberEvicted = NativeScene.getNumberTexturesEvicted(getNative());
 
             mStatsConsole.writeLine("Draw Calls: %d", numberDrawCalls);
             mStatsConsole.writeLine("Triangles: %d", numberTriangles);
+            mStatsConsole.writeLine("State Changes: %d (%d skipped)", numberStateChanges, numberSkipped);
+            mStatsConsole.writeLine("Transforms: %d updated, %d bounds refit", numberTransforms, numberBounds);
+            mStatsConsole.writeLine("Texture Uploads: %.2f ms, %d KB", uploadMillis, uploadBytes / 1024);
+            mStatsConsole.writeLine("Texture Memory: %d KB, %d evicted", textureKB, numberEvicted);
 
             if (mStatMessage.length() > 0) {
                 String lines[] = mStatMessage.toString().split(System.lineSeparator());
@@ -733,6 +775,10 @@ class NativeScene {
 
     public static native void setOcclusionQuery(long scene, boolean flag);
 
+    static native void setSoftwareOcclusion(long scene, boolean flag);
+
+    static native void setFlatCulling(long scene, boolean flag);
+
     static native void setMainCameraRig(long scene, long cameraRig);
 
     public static native void resetStats(long scene);
@@ -741,6 +787,22 @@ class NativeScene {
 
     public static native int getNumberTriangles(long scene);
 
+    public static native int getNumberStateChanges(long scene);
+
+    public static native int getNumberSkippedStateChanges(long scene);
+
+    public static native int getNumberTransformsUpdated(long scene);
+
+    public static native int getNumberBoundsRefit(long scene);
+
+    public static native float getTextureUploadMilliseconds(long scene);
+
+    public static native int getTextureUploadBytes(long scene);
+
+    public static native int getTextureMemoryKB(long scene);
+
+    public static native int getNumberTexturesEvicted(long scene);
+
     public static native void exportToFile(long scene, String file_path);
 
     static native boolean addLight(long scene, long light);
@@ -76,6 +76,12 @@ public class GVRShaderTemplate
 {
     protected Integer mGLSLVersion = 100;
 
+    /*
+     * Most lights which get their own uniform block. Leaves room for the
+     * camera block within the 12 blocks every GLES 3.0 shader stage supports.
+     */
+    private static final int MAX_LIGHT_BLOCKS = 8;
+
     protected class ShaderVariant
     {
         String FragmentShaderSource;
@@ -746,7 +752,7 @@ public class GVRShaderTemplate
                 lightFunction += "   c = vec4(enable, enable, enable, 1) * AddLight(s, r);\n";
                 lightFunction += "   color.xyz += c.xyz;\n";
                 lightFunction += "   color.w = c.w;\n";
-                lightSources += "\nuniform Uniform" + lightClassName + " " + uniformId + ";\n";
+                lightSources += makeLightUniform(light, lightlist.length);
             }
             ++index;
         }
@@ -796,7 +802,7 @@ public class GVRShaderTemplate
                 lightShader = lightShader.replace("@LIGHTIN", lightid);
                 lightFunction += lightShader;
                 lightDefs += makeVertexOutputs(light.getVertexDescriptor(), vertexId, "out ");
-                lightSources += "\nuniform Uniform" + light.getClass().getSimpleName() + " " + lightid + ";\n";
+                lightSources += makeLightUniform(light, lightlist.length);
             }
             ++index;
         }
@@ -811,6 +817,31 @@ public class GVRShaderTemplate
         return lightDefs + lightSources + lightFunction;
     }
 
+    /**
+     * Declares the uniforms for a light source.
+     * With GLSL 300 each light gets its own std140 uniform block named
+     * "Light_" followed by the light ID. The light uploads the block once
+     * when it changes instead of setting every uniform for every shader.
+     * 
+     * @param light
+     *            light to declare the uniforms for
+     * @param numLights
+     *            number of lights in the scene
+     * @return string with the shader source code for the light uniforms
+     */
+    private String makeLightUniform(GVRLightBase light, int numLights)
+    {
+        String lightid = light.getLightID();
+        String structName = "Uniform" + light.getClass().getSimpleName();
+
+        if ((mGLSLVersion < 300) || (numLights > MAX_LIGHT_BLOCKS))
+        {
+            return "\nuniform " + structName + " " + lightid + ";\n";
+        }
+        return "\nlayout (std140) uniform Light_" + lightid + " {\n   "
+                + structName + " " + lightid + ";\n};\n";
+    }
+
     private Map<String, LightClass> scanLights(GVRLightBase[] lightlist)
     {
         Map<String, LightClass> lightClasses = new HashMap<String, LightClass>();
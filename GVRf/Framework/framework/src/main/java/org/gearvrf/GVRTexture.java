@@ -90,6 +90,19 @@ public class GVRTexture extends GVRHybridObject {
                 textureParameters.getCurrentValuesArray());
     }
 
+    /**
+     * Set how much GPU memory textures may use before the least recently
+     * used ones are evicted down to a low resolution mip level. Only
+     * textures which can reload their pixels, like {@link GVRKtxTexture},
+     * are evicted and they load the finer levels again when they are
+     * drawn large enough to need them.
+     *
+     * @param bytes Memory budget in bytes, 0 (the default) never evicts.
+     */
+    public static void setGpuMemoryBudget(long bytes) {
+        NativeTexture.setGpuMemoryBudget(bytes);
+    }
+
     /**
      * Returns the list of atlas information necessary to map
      * the texture atlas to each scene object.
@@ -291,4 +304,6 @@ class NativeTexture {
 
     static native void updateTextureParameters(long texture,
             int[] textureParametersValues);
+
+    static native void setGpuMemoryBudget(long bytes);
 }
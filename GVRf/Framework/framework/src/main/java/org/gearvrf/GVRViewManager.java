@@ -490,10 +490,11 @@ abstract class GVRViewManager extends GVRContext {
         mFrameHandler.beforeDrawEyes();
 
         GVRPerspectiveCamera centerCamera = mMainScene.getMainCameraRig().getCenterCamera();
+        // cull also culls the shadow map views used by makeShadowMaps
+        cull(mMainScene.getNative(), centerCamera.getNative(), mRenderBundle.getMaterialShaderManager().getNative());
         makeShadowMaps(mMainScene.getNative(), mRenderBundle.getMaterialShaderManager().getNative(),
                 mRenderBundle.getPostEffectRenderTextureA().getWidth(),
                 mRenderBundle.getPostEffectRenderTextureA().getHeight());
-        cull(mMainScene.getNative(), centerCamera.getNative(), mRenderBundle.getMaterialShaderManager().getNative());
     }
 
     protected void afterDrawEyes() {
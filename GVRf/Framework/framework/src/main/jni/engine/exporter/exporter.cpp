@@ -98,9 +98,7 @@ void gvr2aiMesh(Mesh &gvrmesh, aiMesh &aimesh) {
         aimesh.mTextureCoords[0][j] = aiVector3D(uvs[j].x, uvs[j].y, 0);
     }
 
-    const auto &indices = gvrmesh.indices();
-
-    aimesh.mNumFaces = (unsigned int)(indices.size() / 3);
+    aimesh.mNumFaces = (unsigned int)(gvrmesh.getIndexCount() / 3);
     aimesh.mFaces = new aiFace[aimesh.mNumFaces];
 
     j = 0;
@@ -109,9 +107,9 @@ void gvr2aiMesh(Mesh &gvrmesh, aiMesh &aimesh) {
         face.mIndices = new unsigned int[3];
         face.mNumIndices = 3;
 
-        face.mIndices[0] = indices[j + 2];
-        face.mIndices[1] = indices[j + 1];
-        face.mIndices[2] = indices[j];
+        face.mIndices[0] = gvrmesh.getIndex(j + 2);
+        face.mIndices[1] = gvrmesh.getIndex(j + 1);
+        face.mIndices[2] = gvrmesh.getIndex(j);
         j = j + 3;
     }
 }
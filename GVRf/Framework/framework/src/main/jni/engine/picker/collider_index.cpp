@@ -0,0 +1,461 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * World space bounding volume hierarchy over the colliders of a scene.
+ ***************************************************************************/
+
+#include "collider_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "objects/bounding_volume.h"
+#include "objects/scene_object.h"
+#include "util/gvr_simd.h"
+
+namespace gvr {
+
+using namespace simd;
+
+static float surfaceArea(const glm::vec3& min_corner, const glm::vec3& max_corner) {
+    glm::vec3 size(max_corner - min_corner);
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static bool isFinite(const glm::vec3& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+ColliderIndex::Reader::Reader(const ColliderIndex& index) : index_(index) {
+    std::lock_guard<std::mutex> lock(index.readers_mutex_);
+    epoch_ = index.epoch_;
+    snapshot_ = index.snapshot_;
+    ++index.readers_[epoch_];
+}
+
+ColliderIndex::Reader::~Reader() {
+    std::lock_guard<std::mutex> lock(index_.readers_mutex_);
+    auto it = index_.readers_.find(epoch_);
+
+    if (0 == --it->second) {
+        index_.readers_.erase(it);
+        index_.readers_left_.notify_all();
+    }
+}
+
+ColliderIndex::ColliderIndex() : snapshot_(std::make_shared<Snapshot>()), epoch_(0) {
+}
+
+/*
+ * Readers entering from now on see the new snapshot.
+ */
+void ColliderIndex::publish(const std::shared_ptr<const Snapshot>& snapshot) {
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    snapshot_ = snapshot;
+    ++epoch_;
+}
+
+void ColliderIndex::update(const std::vector<Component*>& colliders,
+        bool colliders_changed) {
+    if (colliders_changed || !refit()) {
+        build(colliders);
+    }
+}
+
+void ColliderIndex::build(const std::vector<Component*>& colliders) {
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    BoundingVolume bounds;
+
+    snapshot->entries.reserve(colliders.size());
+    for (auto it = colliders.begin(); it != colliders.end(); ++it) {
+        Collider* collider = reinterpret_cast<Collider*>(*it);
+
+        if (collider->getWorldBounds(bounds) && isFinite(bounds.min_corner())
+                && isFinite(bounds.max_corner())) {
+            Entry entry = { collider, bounds.min_corner(), bounds.max_corner() };
+            snapshot->entries.push_back(entry);
+        } else {
+            snapshot->unbounded.push_back(collider);
+        }
+    }
+    if (!snapshot->entries.empty()) {
+        snapshot->nodes.reserve(2 * snapshot->entries.size() / LEAF_SIZE + 1);
+        buildNode(*snapshot, 0, snapshot->entries.size());
+    }
+    snapshot->built_area = totalArea(*snapshot);
+    publish(snapshot);
+}
+
+/*
+ * Median split along the longest axis of the entry centers. Colliders
+ * are few compared to triangles, so this is good enough and keeps the
+ * depth logarithmic.
+ */
+int ColliderIndex::buildNode(Snapshot& snapshot, int first, int count) {
+    std::vector<Entry>& entries = snapshot.entries;
+    Node node;
+    glm::vec3 center_min(std::numeric_limits<float>::max());
+    glm::vec3 center_max(-std::numeric_limits<float>::max());
+
+    node.min_corner = center_min;
+    node.max_corner = center_max;
+    for (int i = first; i < first + count; ++i) {
+        glm::vec3 center((entries[i].min_corner + entries[i].max_corner) * 0.5f);
+
+        node.min_corner = glm::min(node.min_corner, entries[i].min_corner);
+        node.max_corner = glm::max(node.max_corner, entries[i].max_corner);
+        center_min = glm::min(center_min, center);
+        center_max = glm::max(center_max, center);
+    }
+    node.first = first;
+    node.count = count;
+
+    int index = snapshot.nodes.size();
+    snapshot.nodes.push_back(node);
+    if (count <= LEAF_SIZE) {
+        return index;
+    }
+
+    glm::vec3 extent(center_max - center_min);
+    int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2)
+                                     : ((extent.y > extent.z) ? 1 : 2);
+    int middle = first + count / 2;
+
+    std::nth_element(entries.begin() + first, entries.begin() + middle,
+            entries.begin() + first + count,
+            [axis](const Entry& a, const Entry& b) {
+                return (a.min_corner[axis] + a.max_corner[axis])
+                        < (b.min_corner[axis] + b.max_corner[axis]);
+            });
+    buildNode(snapshot, first, middle - first);
+    int right = buildNode(snapshot, middle, first + count - middle);
+    snapshot.nodes[index].first = right;
+    snapshot.nodes[index].count = 0;
+    return index;
+}
+
+float ColliderIndex::totalArea(const Snapshot& snapshot) {
+    float area = 0.0f;
+
+    for (auto it = snapshot.nodes.begin(); it != snapshot.nodes.end(); ++it) {
+        area += surfaceArea(it->min_corner, it->max_corner);
+    }
+    return area;
+}
+
+/*
+ * Recompute the bounds of the colliders whose scene object has a dirty
+ * bounding volume and propagate them up the hierarchy. Returns false if
+ * the hierarchy must be rebuilt instead.
+ */
+bool ColliderIndex::refit() {
+    std::shared_ptr<const Snapshot> current = snapshot_;
+    std::shared_ptr<Snapshot> refitted;
+    BoundingVolume bounds;
+
+    for (auto it = current->unbounded.begin(); it != current->unbounded.end(); ++it) {
+        SceneObject* owner = (*it)->owner_object();
+
+        // a collider which gained a mesh belongs in the hierarchy now
+        if ((nullptr != owner) && owner->isBoundingVolumeDirty()
+                && (*it)->getWorldBounds(bounds)) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < current->entries.size(); ++i) {
+        const Entry& entry = current->entries[i];
+        if (nullptr == entry.collider) {
+            continue;
+        }
+        SceneObject* owner = entry.collider->owner_object();
+        if ((nullptr == owner) || !(owner->isBoundingVolumeDirty()
+                || entry.collider->hasAnimatedBounds())) {
+            continue;
+        }
+        if (!entry.collider->getWorldBounds(bounds)
+                || !isFinite(bounds.min_corner()) || !isFinite(bounds.max_corner())) {
+            return false;
+        }
+        if ((bounds.min_corner() == entry.min_corner)
+                && (bounds.max_corner() == entry.max_corner)) {
+            continue;
+        }
+        if (nullptr == refitted) {
+            refitted = std::make_shared<Snapshot>(*current);
+        }
+        refitted->entries[i].min_corner = bounds.min_corner();
+        refitted->entries[i].max_corner = bounds.max_corner();
+    }
+    if (nullptr == refitted) {
+        return true;
+    }
+
+    // children always come after their parent
+    std::vector<Node>& nodes = refitted->nodes;
+    for (int i = nodes.size() - 1; i >= 0; --i) {
+        Node& node = nodes[i];
+
+        if (node.count > 0) {
+            node.min_corner = refitted->entries[node.first].min_corner;
+            node.max_corner = refitted->entries[node.first].max_corner;
+            for (int e = node.first + 1; e < node.first + node.count; ++e) {
+                node.min_corner = glm::min(node.min_corner, refitted->entries[e].min_corner);
+                node.max_corner = glm::max(node.max_corner, refitted->entries[e].max_corner);
+            }
+        } else {
+            const Node& left = nodes[i + 1];
+            const Node& right = nodes[node.first];
+            node.min_corner = glm::min(left.min_corner, right.min_corner);
+            node.max_corner = glm::max(left.max_corner, right.max_corner);
+        }
+    }
+    if (totalArea(*refitted) > REBUILD_AREA_RATIO * refitted->built_area) {
+        return false;
+    }
+    publish(refitted);
+    return true;
+}
+
+/*
+ * Older snapshots may still refer to the collider even if the current
+ * one does not, so the caller always has to synchronize.
+ */
+uint64_t ColliderIndex::remove(Collider* collider) {
+    std::shared_ptr<const Snapshot> current = snapshot_;
+    std::shared_ptr<Snapshot> removed;
+
+    for (int i = 0; i < current->entries.size(); ++i) {
+        if (current->entries[i].collider == collider) {
+            removed = std::make_shared<Snapshot>(*current);
+            removed->entries[i].collider = nullptr;
+            break;
+        }
+    }
+    if (nullptr == removed) {
+        auto it = std::find(current->unbounded.begin(), current->unbounded.end(), collider);
+        if (it != current->unbounded.end()) {
+            removed = std::make_shared<Snapshot>(*current);
+            removed->unbounded.erase(removed->unbounded.begin() + (it - current->unbounded.begin()));
+        }
+    }
+    if (nullptr != removed) {
+        publish(removed);
+    }
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    return epoch_;
+}
+
+uint64_t ColliderIndex::clear() {
+    publish(std::make_shared<Snapshot>());
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    return epoch_;
+}
+
+void ColliderIndex::synchronize(uint64_t epoch) const {
+    std::unique_lock<std::mutex> lock(readers_mutex_);
+
+    // pickers only hold a Reader for the duration of one pick
+    readers_left_.wait(lock, [this, epoch]() {
+        return readers_.empty() || (readers_.begin()->first >= epoch);
+    });
+}
+
+void ColliderIndex::intersect(const Snapshot& snapshot, const glm::vec3* ray_starts,
+        const glm::vec3* ray_dirs, int ray_count, bool closest,
+        const std::vector<Collider*>* pickable, std::vector<ColliderData>* hits) {
+    for (int first = 0; first < ray_count; first += MAX_RAYS) {
+        // MAX_RAYS is only declared, so it must not be bound to a reference
+        const int count = ray_count - first;
+        intersectBatch(snapshot, ray_starts + first, ray_dirs + first,
+                (count < MAX_RAYS) ? count : MAX_RAYS, closest, pickable,
+                hits + first);
+    }
+}
+
+static bool isPickable(Collider* collider, const std::vector<Collider*>* pickable) {
+    return (nullptr == pickable)
+            || std::binary_search(pickable->begin(), pickable->end(), collider);
+}
+
+/*
+ * Calls isHit on an enabled collider and records the hit, keeping only
+ * the nearest one if closest is set.
+ */
+static void testCollider(Collider* collider, const glm::vec3& ray_start,
+        const glm::vec3& ray_dir, bool closest, std::vector<ColliderData>& hits,
+        float& nearest) {
+    SceneObject* owner = collider->owner_object();
+
+    if (!collider->enabled() || (nullptr == owner) || !owner->enabled()) {
+        return;
+    }
+    ColliderData data = collider->isHit(ray_start, ray_dir);
+    if (!data.IsHit
+            || ((collider->pick_distance() > 0) && (collider->pick_distance() < data.Distance))) {
+        return;
+    }
+    if (!closest) {
+        hits.push_back(data);
+    } else if (data.Distance < nearest) {
+        nearest = data.Distance;
+        hits.resize(1);
+        hits[0] = data;
+    }
+}
+
+/*
+ * Slab test of four rays of the batch, starting at ray first, against
+ * one box. Returns a bit for each ray which enters the box before its
+ * distance limit.
+ */
+static int rayBoxes(const ColliderIndex::RayPacket& rays, int first,
+        const glm::vec3& min_corner, const glm::vec3& max_corner) {
+    Lanes x0, x1, y0, y1, z0, z1;
+    slab(splat(min_corner.x), splat(max_corner.x), load(rays.start_x + first),
+            load(rays.inv_x + first), x0, x1);
+    slab(splat(min_corner.y), splat(max_corner.y), load(rays.start_y + first),
+            load(rays.inv_y + first), y0, y1);
+    slab(splat(min_corner.z), splat(max_corner.z), load(rays.start_z + first),
+            load(rays.inv_z + first), z0, z1);
+    const Lanes enter = max(max(x0, y0), max(z0, splat(0.0f)));
+    const Lanes leave = min(min(x1, y1), min(z1, load(rays.limit + first)));
+
+    return bits(greaterEqual(leave, enter));
+}
+
+/*
+ * Bits of the rays in the mask which enter the box.
+ */
+static unsigned int rayBoxes(const ColliderIndex::RayPacket& rays, int ray_count,
+        unsigned int mask, const glm::vec3& min_corner, const glm::vec3& max_corner) {
+    unsigned int hit = 0;
+
+    for (int first = 0; first < ray_count; first += 4) {
+        if (0 != ((mask >> first) & 0xF)) {
+            hit |= rayBoxes(rays, first, min_corner, max_corner) << first;
+        }
+    }
+    return hit & mask;
+}
+
+void ColliderIndex::intersectBatch(const Snapshot& snapshot,
+        const glm::vec3* ray_starts, const glm::vec3* ray_dirs, int ray_count,
+        bool closest, const std::vector<Collider*>* pickable,
+        std::vector<ColliderData>* hits) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    RayPacket rays;
+    float lengths[MAX_RAYS];
+    float nearest[MAX_RAYS];
+    unsigned int all_rays = 0;
+
+    // box distances are in units of the ray, ColliderData ones in world units
+    for (int r = 0; r < MAX_RAYS; ++r) {
+        if (r >= ray_count) {
+            rays.start_x[r] = rays.start_y[r] = rays.start_z[r] = 0.0f;
+            rays.inv_x[r] = rays.inv_y[r] = rays.inv_z[r] = 1.0f;
+            rays.limit[r] = -1.0f;
+            continue;
+        }
+        lengths[r] = glm::length(ray_dirs[r]);
+        nearest[r] = infinity;
+        if (closest && !hits[r].empty()) {
+            nearest[r] = hits[r][0].Distance;
+        }
+        rays.start_x[r] = ray_starts[r].x;
+        rays.start_y[r] = ray_starts[r].y;
+        rays.start_z[r] = ray_starts[r].z;
+        rays.inv_x[r] = 1.0f / ray_dirs[r].x;
+        rays.inv_y[r] = 1.0f / ray_dirs[r].y;
+        rays.inv_z[r] = 1.0f / ray_dirs[r].z;
+        rays.limit[r] = nearest[r] / lengths[r];
+        all_rays |= 1u << r;
+    }
+
+    for (auto it = snapshot.unbounded.begin(); it != snapshot.unbounded.end(); ++it) {
+        if (!isPickable(*it, pickable)) {
+            continue;
+        }
+        for (int r = 0; r < ray_count; ++r) {
+            testCollider(*it, ray_starts[r], ray_dirs[r], closest, hits[r], nearest[r]);
+            rays.limit[r] = nearest[r] / lengths[r];
+        }
+    }
+    if (snapshot.nodes.empty() || (0 == ray_count)) {
+        return;
+    }
+
+    struct StackEntry {
+        int node;
+        unsigned int rays;
+    } stack[STACK_SIZE];
+    int top = 0;
+
+    stack[top++] = { 0, all_rays };
+    while (top > 0) {
+        const StackEntry entry = stack[--top];
+        const Node& node = snapshot.nodes[entry.node];
+        unsigned int node_rays = rayBoxes(rays, ray_count, entry.rays,
+                node.min_corner, node.max_corner);
+
+        if (0 == node_rays) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int e = node.first; e < node.first + node.count; ++e) {
+                const Entry& leaf_entry = snapshot.entries[e];
+                if ((nullptr == leaf_entry.collider)
+                        || !isPickable(leaf_entry.collider, pickable)) {
+                    continue;
+                }
+                unsigned int entry_rays = rayBoxes(rays, ray_count, node_rays,
+                        leaf_entry.min_corner, leaf_entry.max_corner);
+                for (int r = 0; 0 != entry_rays; ++r, entry_rays >>= 1) {
+                    if (entry_rays & 1) {
+                        testCollider(leaf_entry.collider, ray_starts[r], ray_dirs[r],
+                                closest, hits[r], nearest[r]);
+                        rays.limit[r] = nearest[r] / lengths[r];
+                    }
+                }
+            }
+            continue;
+        }
+
+        // visit the child nearer along the first ray first
+        int first_ray = 0;
+        while (0 == (node_rays & (1u << first_ray))) {
+            ++first_ray;
+        }
+        const Node& left = snapshot.nodes[entry.node + 1];
+        const Node& right = snapshot.nodes[node.first];
+        glm::vec3 offset((left.min_corner + left.max_corner)
+                - (right.min_corner + right.max_corner));
+        StackEntry left_entry = { entry.node + 1, node_rays };
+        StackEntry right_entry = { node.first, node_rays };
+
+        if (glm::dot(offset, ray_dirs[first_ray]) > 0.0f) {
+            stack[top++] = left_entry;
+            stack[top++] = right_entry;
+        } else {
+            stack[top++] = right_entry;
+            stack[top++] = left_entry;
+        }
+    }
+}
+}
@@ -0,0 +1,194 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * World space bounding volume hierarchy over the colliders of a scene.
+ ***************************************************************************/
+
+#ifndef COLLIDER_INDEX_H_
+#define COLLIDER_INDEX_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "objects/components/collider.h"
+
+namespace gvr {
+class Component;
+
+/*
+ * Bounding volume hierarchy over the world space bounds of the colliders
+ * of a scene, used by the Picker so that a ray only tests the colliders
+ * whose bounds it crosses.
+ *
+ * The hierarchy is published as an immutable Snapshot (read-copy-update).
+ * Readers hold a Reader for the duration of a pick, which only locks to
+ * enter and leave. Writers build a new snapshot and swap it in. Every
+ * publication starts a new epoch and each Reader records the epoch it
+ * entered in, so removing a collider can wait until all the readers
+ * which entered before it was removed have left, whichever snapshot
+ * they hold. The collider may be deleted afterwards.
+ *
+ * Colliders which can not report their bounds (Collider::getWorldBounds
+ * returns false) are kept in a separate list tested against every ray.
+ *
+ * Writers must be serialized by the caller (Scene holds its collider
+ * lock) and update() must be called on the GL thread, before the scene
+ * bounding volumes are recomputed for the frame.
+ */
+class ColliderIndex {
+public:
+    struct Entry {
+        Collider* collider;     // null once the collider has been removed
+        glm::vec3 min_corner;
+        glm::vec3 max_corner;
+    };
+
+    /*
+     * Leaves hold the entries [first, first + count). Internal nodes
+     * have count 0, their left child follows them and first is the
+     * index of the right child.
+     */
+    struct Node {
+        glm::vec3 min_corner;
+        int first;
+        glm::vec3 max_corner;
+        int count;
+    };
+
+    struct Snapshot {
+        std::vector<Node> nodes;
+        std::vector<Entry> entries;
+        std::vector<Collider*> unbounded;
+        // total surface area of the nodes right after the last build
+        float built_area = 0.0f;
+    };
+
+    // rays walked together, one bit each in a mask
+    static const int MAX_RAYS = 32;
+
+    /*
+     * Rays of a batch as structure of arrays, four are tested at once.
+     * limit is the distance beyond which boxes are skipped.
+     */
+    struct RayPacket {
+        float start_x[MAX_RAYS], start_y[MAX_RAYS], start_z[MAX_RAYS];
+        float inv_x[MAX_RAYS], inv_y[MAX_RAYS], inv_z[MAX_RAYS];
+        float limit[MAX_RAYS];
+    };
+
+    /*
+     * Holds the current snapshot and keeps the colliders it refers to
+     * from being deleted until it is destroyed.
+     */
+    class Reader {
+    public:
+        explicit Reader(const ColliderIndex& index);
+        ~Reader();
+
+        const Snapshot& snapshot() const {
+            return *snapshot_;
+        }
+
+    private:
+        Reader(const Reader& reader);
+        Reader(Reader&& reader);
+        Reader& operator=(const Reader& reader);
+        Reader& operator=(Reader&& reader);
+
+        const ColliderIndex& index_;
+        std::shared_ptr<const Snapshot> snapshot_;
+        uint64_t epoch_;
+    };
+
+    ColliderIndex();
+
+    /*
+     * Bring the hierarchy up to date with the colliders. It is rebuilt
+     * if the set of colliders changed, otherwise only the bounds of the
+     * colliders whose scene object moved are refit. A rebuild also
+     * happens when refitting has degraded the hierarchy too much.
+     */
+    void update(const std::vector<Component*>& colliders, bool colliders_changed);
+
+    /*
+     * Publish a snapshot without the collider. Returns the epoch to
+     * pass to synchronize() once the writer lock has been released.
+     */
+    uint64_t remove(Collider* collider);
+
+    /*
+     * Publish an empty snapshot, returns the epoch to synchronize with.
+     */
+    uint64_t clear();
+
+    /*
+     * Wait until every reader which entered before the given epoch
+     * has left.
+     */
+    void synchronize(uint64_t epoch) const;
+
+    /*
+     * Intersect several world space rays with the colliders in one walk
+     * over the hierarchy. hits must point to ray_count lists, the hits
+     * of each ray are appended to its list unsorted. If closest is set
+     * only the nearest hit of each ray is kept and the nodes beyond it
+     * are skipped. If pickable is not null only the colliders in that
+     * sorted list are tested.
+     */
+    static void intersect(const Snapshot& snapshot, const glm::vec3* ray_starts,
+            const glm::vec3* ray_dirs, int ray_count, bool closest,
+            const std::vector<Collider*>* pickable,
+            std::vector<ColliderData>* hits);
+
+private:
+    ColliderIndex(const ColliderIndex& collider_index);
+    ColliderIndex(ColliderIndex&& collider_index);
+    ColliderIndex& operator=(const ColliderIndex& collider_index);
+    ColliderIndex& operator=(ColliderIndex&& collider_index);
+
+    static const int LEAF_SIZE = 4;
+    static const int STACK_SIZE = 128;
+    // rebuild once refitting has grown the node areas this much
+    static constexpr float REBUILD_AREA_RATIO = 2.0f;
+
+    void build(const std::vector<Component*>& colliders);
+    bool refit();
+    void publish(const std::shared_ptr<const Snapshot>& snapshot);
+    static int buildNode(Snapshot& snapshot, int first, int count);
+    static float totalArea(const Snapshot& snapshot);
+    static void intersectBatch(const Snapshot& snapshot,
+            const glm::vec3* ray_starts, const glm::vec3* ray_dirs,
+            int ray_count, bool closest, const std::vector<Collider*>* pickable,
+            std::vector<ColliderData>* hits);
+
+    // written by the writers only, read by the readers under readers_mutex_
+    std::shared_ptr<const Snapshot> snapshot_;
+    uint64_t epoch_;
+    mutable std::mutex readers_mutex_;
+    mutable std::condition_variable readers_left_;
+    // number of readers still inside each epoch
+    mutable std::map<uint64_t, int> readers_;
+};
+
+}
+#endif
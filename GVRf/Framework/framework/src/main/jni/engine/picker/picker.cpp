@@ -42,39 +42,106 @@ Picker::~Picker() {
  * Intersects all the colliders in the scene with the input ray
  * and returns the list of collisions.
  *
- * This function is not thread-safe because it relies on a static
- * array of colliders which could be updated by a different thread.
+ * The colliders are found through the scene collider index, so only
+ * those whose bounds the ray crosses are tested and the collider lock
+ * is not taken.
  */
 void Picker::pickScene(Scene* scene, std::vector<ColliderData>& picklist, Transform* t,
          float ox, float oy, float oz, float dx, float dy, float dz) {
     glm::vec3 ray_start(ox, oy, oz);
     glm::vec3 ray_dir(dx, dy, dz);
-    const std::vector<Component*>& colliders = scene->lockColliders();
     const glm::mat4& model_matrix = t->getModelMatrix();
+    ColliderIndex::Reader reader(scene->getColliderIndex());
+    std::shared_ptr<const std::vector<Collider*>> visible;
 
-    Collider::transformRay(model_matrix, ray_start, ray_dir);
-    for (auto it = colliders.begin(); it != colliders.end(); ++it) {
-        Collider* collider = reinterpret_cast<Collider*>(*it);
-        SceneObject* owner = collider->owner_object();
-        if (collider->enabled() && (owner != NULL) && owner->enabled()) {
-            ColliderData data = collider->isHit(ray_start, ray_dir);
-            if ((collider->pick_distance() > 0) && (collider->pick_distance() < data.Distance)) {
-                data.IsHit = false;
-            }
-             if (data.IsHit) {
-                picklist.push_back(data);
-            }
-        }
+    if (scene->getPickVisible()) {
+        visible = scene->getVisibleColliders();
     }
+    Collider::transformRay(model_matrix, ray_start, ray_dir);
+    ColliderIndex::intersect(reader.snapshot(), &ray_start, &ray_dir, 1, false,
+            visible.get(), &picklist);
     std::sort(picklist.begin(), picklist.end(), compareColliderData);
-    scene->unlockColliders();
  }
 
+/*
+ * Finds the collider nearest to the origin of the input ray.
+ * Parts of the scene beyond the nearest hit found so far are skipped.
+ * Returns false if nothing was hit.
+ */
+bool Picker::pickClosest(Scene* scene, ColliderData& hit, Transform* t,
+         float ox, float oy, float oz, float dx, float dy, float dz) {
+    glm::vec3 ray_start(ox, oy, oz);
+    glm::vec3 ray_dir(dx, dy, dz);
+    const glm::mat4& model_matrix = t->getModelMatrix();
+    ColliderIndex::Reader reader(scene->getColliderIndex());
+    std::shared_ptr<const std::vector<Collider*>> visible;
+    std::vector<ColliderData> hits;
+
+    if (scene->getPickVisible()) {
+        visible = scene->getVisibleColliders();
+    }
+    Collider::transformRay(model_matrix, ray_start, ray_dir);
+    ColliderIndex::intersect(reader.snapshot(), &ray_start, &ray_dir, 1, true,
+            visible.get(), &hits);
+    if (hits.empty()) {
+        return false;
+    }
+    hit = hits[0];
+    return true;
+}
+
 void Picker::pickScene(Scene* scene, std::vector<ColliderData>& pickList) {
     Transform* t = scene->main_camera_rig()->getHeadTransform();
     pickScene(scene, pickList, t, 0, 0, 0, 0, 0, -1.0f);
 }
 
+/*
+ * Intersects several rays with the colliders in the scene in one walk
+ * over the collider index, four rays at a time.
+ * rays holds ray_count rays as origin x, y, z followed by direction
+ * x, y, z, in the coordinate system of the transform t (world
+ * coordinates if t is null). The hits of each ray are returned in
+ * batch, sorted by distance.
+ */
+void Picker::pickRays(Scene* scene, Transform* t, const float* rays,
+        int ray_count, PickBatch& batch) {
+    ColliderIndex::Reader reader(scene->getColliderIndex());
+    std::shared_ptr<const std::vector<Collider*>> visible;
+    glm::mat4 model_matrix;
+
+    if (scene->getPickVisible()) {
+        visible = scene->getVisibleColliders();
+    }
+    if (t != NULL) {
+        model_matrix = t->getModelMatrix();
+    }
+    batch.ray_starts_.resize(ray_count);
+    batch.ray_dirs_.resize(ray_count);
+    if (batch.ray_hits_.size() < ray_count) {
+        batch.ray_hits_.resize(ray_count);
+    }
+    for (int i = 0; i < ray_count; ++i, rays += 6) {
+        batch.ray_starts_[i] = glm::vec3(rays[0], rays[1], rays[2]);
+        batch.ray_dirs_[i] = glm::vec3(rays[3], rays[4], rays[5]);
+        Collider::transformRay(model_matrix, batch.ray_starts_[i], batch.ray_dirs_[i]);
+        batch.ray_hits_[i].clear();
+    }
+    ColliderIndex::intersect(reader.snapshot(), batch.ray_starts_.data(),
+            batch.ray_dirs_.data(), ray_count, false, visible.get(),
+            batch.ray_hits_.data());
+
+    batch.hits_.clear();
+    batch.offsets_.resize(ray_count + 1);
+    for (int i = 0; i < ray_count; ++i) {
+        std::vector<ColliderData>& hits = batch.ray_hits_[i];
+
+        std::sort(hits.begin(), hits.end(), compareColliderData);
+        batch.offsets_[i] = batch.hits_.size();
+        batch.hits_.insert(batch.hits_.end(), hits.begin(), hits.end());
+    }
+    batch.offsets_[ray_count] = batch.hits_.size();
+}
+
 float Picker::pickSceneObject(const SceneObject* scene_object,
         const CameraRig* camera_rig) {
 
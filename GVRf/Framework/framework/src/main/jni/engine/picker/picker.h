@@ -33,6 +33,46 @@ class SceneObject;
 class CameraRig;
 class Transform;
 
+/*
+ * Hits of a batch of pick rays, sorted by distance for each ray.
+ * Keep one around and pass it to every Picker::pickRays call so its
+ * memory is reused.
+ */
+class PickBatch {
+public:
+    int ray_count() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    int total_hit_count() const {
+        return hits_.size();
+    }
+
+    int hit_count(int ray) const {
+        return offsets_[ray + 1] - offsets_[ray];
+    }
+
+    /*
+     * Index of the first hit of the ray in hits().
+     */
+    int first_hit(int ray) const {
+        return offsets_[ray];
+    }
+
+    const std::vector<ColliderData>& hits() const {
+        return hits_;
+    }
+
+private:
+    friend class Picker;
+
+    std::vector<glm::vec3> ray_starts_;
+    std::vector<glm::vec3> ray_dirs_;
+    std::vector<std::vector<ColliderData>> ray_hits_;
+    std::vector<ColliderData> hits_;
+    std::vector<int> offsets_;
+};
+
 class Picker {
 private:
     Picker();
@@ -46,6 +86,15 @@ public:
             Transform* t,
             float ox, float oy, float oz,
             float dx, float dy, float dz);
+    static bool pickClosest(
+            Scene* scene, ColliderData& hit,
+            Transform* t,
+            float ox, float oy, float oz,
+            float dx, float dy, float dz);
+    static void pickRays(
+            Scene* scene, Transform* t,
+            const float* rays, int ray_count,
+            PickBatch& batch);
     static float pickSceneObject(
             const SceneObject* scene_object,
             const CameraRig* camera_rig);
@@ -18,6 +18,9 @@
  * JNI
  ***************************************************************************/
 
+#include <cstring>
+#include <mutex>
+
 #include "picker.h"
 #include "objects/scene.h"
 
@@ -44,6 +47,13 @@ extern "C" {
     JNIEXPORT jobjectArray JNICALL
     Java_org_gearvrf_NativePicker_pickVisible(JNIEnv * env,
             jobject obj, jlong jscene);
+    JNIEXPORT jint JNICALL
+    Java_org_gearvrf_NativePicker_pickRays(JNIEnv * env,
+            jobject obj, jlong jscene, jlong jtransform, jfloatArray jrays,
+            jint ray_count, jobject jresults);
+    JNIEXPORT jint JNICALL
+    Java_org_gearvrf_NativePicker_copyRayHits(JNIEnv * env,
+            jobject obj, jobject jresults);
 }
 
 JNIEXPORT jlongArray JNICALL
@@ -172,4 +182,89 @@ Java_org_gearvrf_NativePicker_pickVisible(JNIEnv * env,
     return pickList;
 }
 
+/*
+ * Hits of the last pickRays call, kept until the next one so that
+ * copyRayHits can fetch them into a larger buffer without picking again.
+ */
+static std::mutex batch_mutex;
+static PickBatch batch;
+
+/*
+ * Writes the hits of the batch into the direct byte buffer jresults, in
+ * native byte order:
+ *  - ray_count + 1 ints, the index of the first hit of each ray followed
+ *    by the total number of hits, padded to a multiple of 8 bytes
+ *  - for each hit a long collider pointer, then the distance and the
+ *    x, y, z of the hit location as floats
+ * Returns the number of bytes needed. If the buffer is smaller nothing
+ * is written.
+ */
+static int copyHits(JNIEnv * env, const PickBatch& batch, jobject jresults)
+{
+    const int HIT_SIZE = sizeof(jlong) + 4 * sizeof(jfloat);
+    int ray_count = batch.ray_count();
+    int header_size = ((ray_count + 1) * sizeof(jint) + 7) & ~7;
+    int size = header_size + batch.total_hit_count() * HIT_SIZE;
+    char* results = static_cast<char*>(env->GetDirectBufferAddress(jresults));
+
+    if ((results == NULL) || (env->GetDirectBufferCapacity(jresults) < size)) {
+        return size;
+    }
+    jint* offsets = reinterpret_cast<jint*>(results);
+    for (int i = 0; i < ray_count; ++i) {
+        offsets[i] = batch.first_hit(i);
+    }
+    offsets[ray_count] = batch.total_hit_count();
+
+    char* hit = results + header_size;
+    const std::vector<ColliderData>& hits = batch.hits();
+    for (auto it = hits.begin(); it != hits.end(); ++it, hit += HIT_SIZE) {
+        jlong collider = reinterpret_cast<jlong>(it->ColliderHit);
+        jfloat values[4] = { it->Distance, it->HitPosition.x,
+                it->HitPosition.y, it->HitPosition.z };
+
+        memcpy(hit, &collider, sizeof(collider));
+        memcpy(hit + sizeof(collider), values, sizeof(values));
+    }
+    return size;
+}
+
+/*
+ * Picks ray_count rays at once and writes all the hits into jresults as
+ * described in copyHits. Returns the number of bytes needed; if the
+ * buffer is smaller the caller should call copyRayHits with a larger one.
+ * Returns -1 if jrays holds fewer than ray_count rays.
+ */
+JNIEXPORT jint JNICALL
+Java_org_gearvrf_NativePicker_pickRays(JNIEnv * env,
+        jobject obj, jlong jscene, jlong jtransform, jfloatArray jrays,
+        jint ray_count, jobject jresults)
+{
+    if ((ray_count < 0) || (ray_count > env->GetArrayLength(jrays) / 6)) {
+        LOGE("NativePicker::pickRays %d rays in an array of %d floats",
+                ray_count, env->GetArrayLength(jrays));
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(batch_mutex);
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Transform* t = reinterpret_cast<Transform*>(jtransform);
+    jfloat* rays = env->GetFloatArrayElements(jrays, 0);
+
+    Picker::pickRays(scene, t, rays, ray_count, batch);
+    env->ReleaseFloatArrayElements(jrays, rays, JNI_ABORT);
+    return copyHits(env, batch, jresults);
+}
+
+/*
+ * Copies the hits of the last pickRays call into jresults.
+ * Returns the number of bytes needed, as pickRays does.
+ */
+JNIEXPORT jint JNICALL
+Java_org_gearvrf_NativePicker_copyRayHits(JNIEnv * env,
+        jobject obj, jobject jresults)
+{
+    std::lock_guard<std::mutex> lock(batch_mutex);
+    return copyHits(env, batch, jresults);
+}
+
 }
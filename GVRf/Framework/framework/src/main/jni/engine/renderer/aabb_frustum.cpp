@@ -0,0 +1,107 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Tests several axis aligned bounding boxes against a view frustum at once.
+ ***************************************************************************/
+
+#include "aabb_frustum.h"
+#include "util/gvr_simd.h"
+
+namespace gvr {
+
+/*
+ * The largest of the eight corner distances to a plane is the sum of
+ * the largest products per axis and the smallest distance the sum of
+ * the smallest products. Summing in the same order as the scalar code
+ * keeps the results identical, so no corner has to be tested on its own.
+ */
+static void classifyLanes(const float frustum[6][4],
+        const float* min_x, const float* min_y, const float* min_z,
+        const float* max_x, const float* max_y, const float* max_z,
+        unsigned char* outside, unsigned char* inside) {
+    using namespace simd;
+    const Lanes zero = splat(0.0f);
+    const Lanes xmin = load(min_x);
+    const Lanes ymin = load(min_y);
+    const Lanes zmin = load(min_z);
+    const Lanes xmax = load(max_x);
+    const Lanes ymax = load(max_y);
+    const Lanes zmax = load(max_z);
+    int out[AABB_FRUSTUM_LANES] = { };
+    int in[AABB_FRUSTUM_LANES] = { };
+
+    for (int p = 0; p < 6; ++p) {
+        const Lanes a = splat(frustum[p][0]);
+        const Lanes b = splat(frustum[p][1]);
+        const Lanes c = splat(frustum[p][2]);
+        const Lanes d = splat(frustum[p][3]);
+        const Lanes x0 = mul(a, xmin);
+        const Lanes x1 = mul(a, xmax);
+        const Lanes y0 = mul(b, ymin);
+        const Lanes y1 = mul(b, ymax);
+        const Lanes z0 = mul(c, zmin);
+        const Lanes z1 = mul(c, zmax);
+
+        Lanes far = add(max(x0, x1), max(y0, y1));
+        far = add(add(far, max(z0, z1)), d);
+        Lanes near = add(min(x0, x1), min(y0, y1));
+        near = add(add(near, min(z0, z1)), d);
+
+        const int far_in = bits(greater(far, zero));
+        const int near_in = bits(greater(near, zero));
+        for (int i = 0; i < AABB_FRUSTUM_LANES; ++i) {
+            out[i] |= ((~far_in >> i) & 1) << p;
+            in[i] |= ((near_in >> i) & 1) << p;
+        }
+    }
+    for (int i = 0; i < AABB_FRUSTUM_LANES; ++i) {
+        outside[i] = out[i];
+        inside[i] = in[i];
+    }
+}
+
+void classifyAABBsVsFrustum(const float frustum[6][4],
+        const float* min_x, const float* min_y, const float* min_z,
+        const float* max_x, const float* max_y, const float* max_z,
+        int count, unsigned char* outside, unsigned char* inside) {
+    if (count >= AABB_FRUSTUM_LANES) {
+        classifyLanes(frustum, min_x, min_y, min_z, max_x, max_y, max_z,
+                outside, inside);
+        return;
+    }
+
+    // pad the last partial block with empty boxes
+    float box[6][AABB_FRUSTUM_LANES] = { };
+    unsigned char out[AABB_FRUSTUM_LANES];
+    unsigned char in[AABB_FRUSTUM_LANES];
+
+    for (int i = 0; i < count; ++i) {
+        box[0][i] = min_x[i];
+        box[1][i] = min_y[i];
+        box[2][i] = min_z[i];
+        box[3][i] = max_x[i];
+        box[4][i] = max_y[i];
+        box[5][i] = max_z[i];
+    }
+    classifyLanes(frustum, box[0], box[1], box[2], box[3], box[4], box[5],
+            out, in);
+    for (int i = 0; i < count; ++i) {
+        outside[i] = out[i];
+        inside[i] = in[i];
+    }
+}
+
+}
@@ -0,0 +1,74 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Tests several axis aligned bounding boxes against a view frustum at once.
+ ***************************************************************************/
+
+#ifndef AABB_FRUSTUM_H_
+#define AABB_FRUSTUM_H_
+
+namespace gvr {
+
+// Results of SceneObject::checkAABBVsFrustumOpt
+enum AABB_STATE {
+    OUTSIDE, INTERSECT, INSIDE
+};
+
+/*
+ * Number of boxes classifyAABBsVsFrustum tests in one SIMD pass.
+ */
+static const int AABB_FRUSTUM_LANES = 4;
+
+/*
+ * Classify up to AABB_FRUSTUM_LANES boxes, given as separate min / max
+ * coordinate arrays, against the six planes built by
+ * Renderer::build_frustum. Uses the lanes of util/gvr_simd.h, NEON on
+ * ARM, SSE on x86 and plain C++ everywhere else.
+ *
+ * For every box bit p of outside[i] is set if all eight corners are
+ * outside plane p and bit p of inside[i] is set if all eight corners
+ * are inside plane p. SceneObject::checkAABBVsFrustumOpt calls it for
+ * a single box, so the recursive and the flattened cull agree.
+ */
+void classifyAABBsVsFrustum(const float frustum[6][4],
+        const float* min_x, const float* min_y, const float* min_z,
+        const float* max_x, const float* max_y, const float* max_z,
+        int count, unsigned char* outside, unsigned char* inside);
+
+/*
+ * Turn the plane bits of one box into OUTSIDE, INTERSECT or INSIDE,
+ * skipping the planes already set in planeMask and adding the planes
+ * the box is completely inside of. Planes after the first one the box
+ * is outside of are left out of the mask, as if testing stopped there.
+ */
+inline int resolveAABBVsFrustum(unsigned char outside, unsigned char inside,
+        int& planeMask) {
+    const int active = ~planeMask & 0x3f;
+    const int out = outside & active;
+    const int in = inside & active;
+
+    if (out) {
+        // planes after the first one the box is outside of are not tested
+        const int first = out & -out;
+        planeMask |= in & (first - 1);
+        return OUTSIDE;
+    }
+    planeMask |= in;
+    return (in == active) ? INSIDE : INTERSECT;
+}
+
+}
+#endif
@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 #include "batch.h"
+
+#include <algorithm>
+
 #include "objects/scene_object.h"
 #include "objects/components/camera.h"
 #include "objects/components/render_data.h"
@@ -21,6 +24,18 @@
 #define BATCH_SIZE 60
 
 namespace gvr {
+
+/*
+ * Only single pass render data are batched across materials, with
+ * the main texture layer as a vertex attribute.
+ */
+static int textureLayer(RenderData* render_data) {
+    if (render_data->pass_count() != 1) {
+        return -1;
+    }
+    return render_data->material(0)->batch_layer();
+}
+
 Batch::Batch(int no_vertices, int no_indices) :
         draw_count_(0), vertex_count_(0), index_count_(0), vertex_limit_(no_vertices),
         indices_limit_(no_indices), renderdata_(nullptr),mesh_init_(false),
@@ -31,6 +46,7 @@ Batch::Batch(int no_vertices, int no_indices) :
     normals_.reserve(no_vertices);
     tex_coords_.reserve(no_vertices);
     matrix_indices_.reserve(no_vertices);
+    texture_layers_.reserve(no_vertices);
 }
 
 Batch::~Batch() {
@@ -39,7 +55,11 @@ Batch::~Batch() {
     renderdata_ = nullptr;
 }
 
-bool Batch::updateMesh(Mesh* render_mesh){
+/*
+ * Append the mesh, texture_layer is the layer of the main texture of
+ * its material in a texture array or -1.
+ */
+bool Batch::updateMesh(Mesh* render_mesh, int texture_layer){
     const std::vector<unsigned short>& indices = render_mesh->indices();
     const std::vector<glm::vec3>& vertices = render_mesh->vertices();
     const std::vector<glm::vec3>& normals = render_mesh->normals();
@@ -53,6 +73,7 @@ bool Batch::updateMesh(Mesh* render_mesh){
         matrix_indices_.push_back(draw_count_);
         tex_coords_.push_back(tex_cords[i]);
     }
+    texture_layers_.insert(texture_layers_.end(), size, std::max(texture_layer, 0));
     // Check if models has normals
     if(normals.size() > 0){
         int normals_size = normals.size();
@@ -108,7 +129,8 @@ bool Batch::add(RenderData *render_data) {
             return true;
         }
     }
-    // if mesh is large, render in normal way
+    // if mesh is large or uses 32 bit indices, render in normal way;
+    // indices() is empty for meshes with 32 bit indices
     if (indices.size() == 0 || (indices.size() + index_count_ > indices_limit_)) {
         if (draw_count_ > 0) {
             return false;
@@ -127,7 +149,7 @@ bool Batch::add(RenderData *render_data) {
        }
     }
     render_data_set_.insert(render_data); // store all the renderdata which are in batch
-    updateMesh(render_mesh);
+    updateMesh(render_mesh, textureLayer(render_data));
     return true;
 }
 void Batch::clearData(){
@@ -139,6 +161,7 @@ void Batch::clearData(){
     matrix_indices_.clear();
     matrices_.clear();
     tex_coords_.clear();
+    texture_layers_.clear();
     vertices_.clear();
     normals_.clear();
     indices_.clear();
@@ -175,6 +198,7 @@ void Batch::meshInit(){
     mesh_.setVec2Vector("a_texcoord",tex_coords_);
     mesh_.set_indices(indices_);
     mesh_.setFloatVector("a_matrix_index", matrix_indices_);
+    mesh_.setFloatVector("a_texture_layer", texture_layers_);
     if (nullptr != renderdata_) {
         renderdata_->set_mesh(&mesh_);
     }
@@ -207,7 +231,7 @@ void Batch::regenerateMeshData(){
         // Store the model matrix and its index into map for update
         matrix_index_map_[render_data] = draw_count_;
         matrices_.push_back(model_matrix);
-        updateMesh(render_mesh);
+        updateMesh(render_mesh, textureLayer(render_data));
     }
 }
 }
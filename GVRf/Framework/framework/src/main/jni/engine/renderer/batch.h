@@ -85,7 +85,7 @@ public:
         return index_count_;
     }
 private:
-    bool updateMesh(Mesh* render_mesh);
+    bool updateMesh(Mesh* render_mesh, int texture_layer);
     void clearData();
     bool isRenderModified();
     bool batch_dirty_;
@@ -100,6 +100,8 @@ private:
     std::vector<unsigned short> indices_;
     std::vector<glm::mat4> matrices_;
     std::vector<float> matrix_indices_;
+    // layer of the main texture in its texture array, 0 if not in one
+    std::vector<float> texture_layers_;
     int vertex_limit_;
     int indices_limit_;
     int draw_count_;
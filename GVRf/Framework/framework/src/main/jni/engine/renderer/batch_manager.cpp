@@ -45,7 +45,8 @@ BatchManager::~BatchManager(){
  /*
   * It creates array of indices which specifies indices of the spliting of batches in renderdata vector
   * for renderdatas to have in same batch, they need to have same render order, material,
-  * shader type and mesh dynamic-ness
+  * shader type and mesh dynamic-ness. Materials only differing by the texture array layer
+  * of their main texture count as the same
   */
 void BatchManager::batchSetup(std::vector<RenderData*>& render_data_vector) {
    batch_indices_.clear();
@@ -53,6 +54,13 @@ void BatchManager::batchSetup(std::vector<RenderData*>& render_data_vector) {
    RenderData* prev = nullptr;
    RenderData* curr = nullptr;
 
+   // materials whose main texture moved into or out of an atlas dirty their render-data here
+   for (int i = 0; i < render_vector_size; i++) {
+       RenderData* render_data = render_data_vector[i];
+       for (int j = 0; j < render_data->pass_count(); j++) {
+           render_data->material(j)->updateBatchKey();
+       }
+   }
    if(render_vector_size != 0){
        batch_indices_.push_back(0);
        prev = render_data_vector[0];
@@ -67,7 +75,7 @@ void BatchManager::batchSetup(std::vector<RenderData*>& render_data_vector) {
     for (int i = 1; i < render_vector_size ; i++) {
         curr = render_data_vector[i];
         if(!(prev->batching() && prev->rendering_order() == curr->rendering_order() && isRenderPassEqual(prev,curr)
-            && !prev->getHashCode().compare(curr->getHashCode())) || !curr->batching()){
+            && prev->getHashCode() == curr->getHashCode()) || !curr->batching()){
             batch_indices_.push_back(i);
             prev = curr;
         }
@@ -93,14 +101,16 @@ void BatchManager::renderBatches(RenderState& rstate) {
 
         rstate.material_override = nullptr;
         const std::unordered_set<RenderData*>& render_data_set = batch->getRenderDataSet();
+        render_list_.clear();
         for (auto it3 : render_data_set) {
             if(it3->owner_object()==nullptr)
                 continue;
 
             // this check is needed as we are not removing render data from batches
             if(!it3->owner_object()->isCulled() && it3->enabled() && it3->owner_object()->enabled())
-                    gRenderer->renderRenderData(rstate, it3);
+                    render_list_.push_back(it3);
             }
+            gRenderer->renderRenderDataList(rstate, render_list_.data(), render_list_.size());
             continue;
         }
 
@@ -131,12 +141,12 @@ void BatchManager::renderBatches(RenderState& rstate) {
             rstate.material_override = batch->material(passIndex);
             if(rstate.material_override == nullptr)
                 continue;
+            rstate.material_override->markTexturesUsed();
 
             rstate.shader_manager->getTextureShader()->render_batch(matrices,
                         renderdata, rstate, batch->getIndexCount(),
                         batch->getNumberOfMeshes());
         }
-        gRenderer->restoreRenderStates(renderdata);
     }
 }
 
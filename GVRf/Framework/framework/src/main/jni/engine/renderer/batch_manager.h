@@ -67,6 +67,8 @@ private:
 
     std::vector<int> batch_indices_;
 
+    // visible render data of a batch which is not batched on the CPU
+    std::vector<RenderData*> render_list_;
 };
 }
 #endif // BATCH_MANAGER_H
\ No newline at end of file
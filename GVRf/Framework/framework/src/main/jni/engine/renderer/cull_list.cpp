@@ -0,0 +1,287 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Flattened copy of the scene graph used for view frustum culling.
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "cull_list.h"
+#include "aabb_frustum.h"
+
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+CullList::CullList() :
+        version_(0), built_(false) {
+}
+
+void CullList::append(SceneObject* object) {
+    int index = objects_.size();
+
+    objects_.push_back(object);
+    render_datas_.push_back(object->render_data());
+    subtree_end_.push_back(0);
+
+    const std::vector<SceneObject*>& children = object->children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        append(*it);
+    }
+    subtree_end_[index] = objects_.size();
+}
+
+/*
+ * Flatten the scene graph in depth first order.
+ * Only called when the hierarchy has changed.
+ */
+void CullList::rebuild(SceneObject* root) {
+    objects_.clear();
+    render_datas_.clear();
+    subtree_end_.clear();
+    append(root);
+
+    int size = objects_.size();
+    flags_.resize(size);
+    min_x_.resize(size);
+    min_y_.resize(size);
+    min_z_.resize(size);
+    max_x_.resize(size);
+    max_y_.resize(size);
+    max_z_.resize(size);
+    built_ = true;
+
+    if (DEBUG_RENDERER) {
+        LOGD("FRUSTUM: rebuilt cull list with %d objects\n", size);
+    }
+}
+
+/*
+ * Copy the current bounds and flags into the arrays.
+ * Children are visited before their parents so a dirty parent
+ * only aggregates bounding volumes which are already up to date.
+ */
+void CullList::refit() {
+    for (int i = objects_.size() - 1; i >= 0; --i) {
+        SceneObject* object = objects_[i];
+        const BoundingVolume& bv = object->getBoundingVolume();
+        const glm::vec3& min_corner = bv.min_corner();
+        const glm::vec3& max_corner = bv.max_corner();
+
+        flags_[i] = (object->enabled() ? ENABLED : 0)
+                | (object->visible() ? VISIBLE : 0);
+        min_x_[i] = min_corner.x;
+        min_y_[i] = min_corner.y;
+        min_z_[i] = min_corner.z;
+        max_x_[i] = max_corner.x;
+        max_y_[i] = max_corner.y;
+        max_z_[i] = max_corner.z;
+    }
+}
+
+/*
+ * Add an object to the render list. The camera distance is left to
+ * Renderer::state_sort since the render data is shared by the views.
+ */
+void CullList::accept(int index, bool main_view,
+        std::vector<SceneObject*>& scene_objects) {
+    SceneObject* object = objects_[index];
+
+    scene_objects.push_back(object);
+    if (main_view) {
+        object->setCullStatus(false);
+    }
+}
+
+/*
+ * Test the bounds of one object against the frustum. The first time
+ * an object of a block is tested the whole block is classified with
+ * the SIMD kernel, the following objects only resolve their bits
+ * against the current plane mask.
+ */
+int CullList::checkAABBVsFrustum(ViewState& view, int index,
+        const float frustum[6][4], int& planeMask) {
+    const int block = index / AABB_FRUSTUM_LANES;
+
+    if (view.block_stamp[block] != view.cull_stamp) {
+        const int first = block * AABB_FRUSTUM_LANES;
+        const int count = std::min<int>(AABB_FRUSTUM_LANES,
+                objects_.size() - first);
+
+        classifyAABBsVsFrustum(frustum, &min_x_[first], &min_y_[first],
+                &min_z_[first], &max_x_[first], &max_y_[first],
+                &max_z_[first], count, &view.outside_planes[first],
+                &view.inside_planes[first]);
+        view.block_stamp[block] = view.cull_stamp;
+    }
+    return resolveAABBVsFrustum(view.outside_planes[index],
+            view.inside_planes[index], planeMask);
+}
+
+void CullList::update(SceneObject* root, int view_count) {
+    unsigned int version = SceneObject::hierarchyVersion();
+
+    if (!built_ || (version != version_) || objects_.empty()
+            || (objects_[0] != root)) {
+        version_ = version;
+        rebuild(root);
+    }
+    refit();
+
+    int size = objects_.size();
+    if (views_.size() < view_count) {
+        views_.resize(view_count);
+    }
+    for (auto it = views_.begin(); it != views_.end(); ++it) {
+        if (it->outside_planes.size() != size) {
+            it->outside_planes.resize(size);
+            it->inside_planes.resize(size);
+            it->block_stamp.assign(
+                    (size + AABB_FRUSTUM_LANES - 1) / AABB_FRUSTUM_LANES,
+                    it->cull_stamp);
+        }
+    }
+}
+
+void CullList::cull(int view_index, const float frustum[6][4],
+        bool need_cull, bool main_view,
+        std::vector<SceneObject*>& scene_objects) {
+    ViewState& view = views_[view_index];
+    std::vector<SubtreeState>& stack = view.stack;
+    int size = objects_.size();
+    int planeMask = 0;
+
+    ++view.cull_stamp;
+    stack.clear();
+
+    for (int i = 0; i < size;) {
+        // restore the parent state when leaving a subtree
+        while (!stack.empty() && (i >= stack.back().end)) {
+            planeMask = stack.back().plane_mask;
+            need_cull = stack.back().need_cull;
+            stack.pop_back();
+        }
+        if (!(flags_[i] & ENABLED)) {
+            i = subtree_end_[i];
+            continue;
+        }
+
+        SubtreeState parent = { subtree_end_[i], planeMask, need_cull };
+
+        if (need_cull) {
+            int checkResult = OUTSIDE;
+
+            if (flags_[i] & VISIBLE) {
+                checkResult = checkAABBVsFrustum(view, i, frustum,
+                        planeMask);
+            }
+            if (checkResult == OUTSIDE) {
+                if (main_view) {
+                    objects_[i]->setCullStatus(true);
+                }
+                i = subtree_end_[i];
+                planeMask = parent.plane_mask;
+                continue;
+            }
+            if (checkResult == INSIDE) {
+                accept(i, main_view, scene_objects);
+                need_cull = false;
+            } else {
+                RenderData* render_data = render_datas_[i];
+
+                // test the object's own mesh only if it has children
+                if ((nullptr != render_data)
+                        && (nullptr != render_data->material(0))) {
+                    if (subtree_end_[i] > i + 1) {
+                        const BoundingVolume& bv =
+                                objects_[i]->getMeshBoundingVolume();
+                        int tempMask = planeMask;
+                        checkResult = SceneObject::checkAABBVsFrustumOpt(
+                                frustum, bv.min_corner(), bv.max_corner(),
+                                tempMask);
+                    }
+                    if (checkResult != OUTSIDE) {
+                        accept(i, main_view, scene_objects);
+                    }
+                }
+            }
+        } else {
+            accept(i, main_view, scene_objects);
+        }
+
+        if (subtree_end_[i] > i + 1) {
+            stack.push_back(parent);
+        } else {
+            planeMask = parent.plane_mask;
+            need_cull = parent.need_cull;
+        }
+        ++i;
+    }
+}
+
+void frustum_cull(glm::vec3 camera_position, SceneObject* object,
+        const float frustum[6][4], std::vector<SceneObject*>& scene_objects,
+        bool need_cull, int planeMask, bool main_view) {
+
+    // frustumCull() return 3 possible values:
+    // 0 when the HBV of the object is completely outside the frustum: cull itself and all its children out
+    // 1 when the HBV of the object is intersecting the frustum but the object itself is not: cull it out and continue culling test with its children
+    // 2 when the HBV of the object is intersecting the frustum and the mesh BV of the object are intersecting (inside) the frustum: render itself and continue culling test with its children
+    // 3 when the HBV of the object is completely inside the frustum: render itself and all its children without further culling test
+    int cullVal;
+
+    if (!object->enabled()) {
+        return;
+    }
+
+    if (need_cull) {
+        cullVal = object->frustumCull(camera_position, frustum, planeMask);
+        if (cullVal == 0) {
+            if (main_view) {
+                object->setCullStatus(true);
+            }
+            return;
+        }
+
+        if (cullVal >= 2) {
+            if (main_view) {
+                object->setCullStatus(false);
+            }
+            scene_objects.push_back(object);
+        }
+
+        if (cullVal == 3) {
+            if (main_view) {
+                object->setCullStatus(false);
+            }
+            need_cull = false;
+        }
+    } else {
+        if (main_view) {
+            object->setCullStatus(false);
+        }
+        scene_objects.push_back(object);
+    }
+
+    const std::vector<SceneObject*>& children = object->children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        frustum_cull(camera_position, *it, frustum, scene_objects, need_cull, planeMask, main_view);
+    }
+}
+
+}
@@ -0,0 +1,140 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Flattened copy of the scene graph used for view frustum culling.
+ ***************************************************************************/
+
+#ifndef CULL_LIST_H_
+#define CULL_LIST_H_
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace gvr {
+class SceneObject;
+class RenderData;
+
+/*
+ * Keeps the scene objects of a scene in depth first order together with
+ * their world space bounds and enabled / visible bits, stored as
+ * structure of arrays. Culling is then a single linear walk over the
+ * arrays which skips whole subtrees by index instead of recursing
+ * through SceneObject::children().
+ *
+ * The arrays are only rebuilt when SceneObject::hierarchyVersion()
+ * changes. The bounds are refit every frame, but only the objects whose
+ * hierarchical bounding volume is dirty are recomputed.
+ *
+ * update() must be called on the GL thread. Afterwards several views
+ * may be culled concurrently, as long as each uses its own view index.
+ */
+class CullList {
+public:
+    CullList();
+
+    /*
+     * Bring the flattened scene graph under root up to date and make
+     * room for view_count views.
+     */
+    void update(SceneObject* root, int view_count);
+
+    /*
+     * Cull the flattened scene graph against the given frustum.
+     * The objects which should be rendered are appended to scene_objects
+     * in the same order frustum_cull would produce them.
+     * Only the main view updates the cull status of the objects.
+     */
+    void cull(int view, const float frustum[6][4], bool need_cull,
+            bool main_view, std::vector<SceneObject*>& scene_objects);
+
+    int size() const {
+        return objects_.size();
+    }
+
+private:
+    CullList(const CullList& cull_list);
+    CullList(CullList&& cull_list);
+    CullList& operator=(const CullList& cull_list);
+    CullList& operator=(CullList&& cull_list);
+
+    enum Flags {
+        ENABLED = 1, VISIBLE = 2
+    };
+
+    /*
+     * Parent state to restore once the traversal leaves a subtree.
+     */
+    struct SubtreeState {
+        int end;
+        int plane_mask;
+        bool need_cull;
+    };
+
+    /*
+     * Traversal state owned by a single view.
+     */
+    struct ViewState {
+        // incremented on every cull to invalidate the plane bits
+        unsigned int cull_stamp;
+
+        // plane bits from classifyAABBsVsFrustum, computed for
+        // AABB_FRUSTUM_LANES objects at a time when first needed
+        std::vector<unsigned char> outside_planes;
+        std::vector<unsigned char> inside_planes;
+        std::vector<unsigned int> block_stamp;
+
+        std::vector<SubtreeState> stack;
+    };
+
+    void rebuild(SceneObject* root);
+    void append(SceneObject* object);
+    void refit();
+    void accept(int index, bool main_view,
+            std::vector<SceneObject*>& scene_objects);
+    int checkAABBVsFrustum(ViewState& view, int index,
+            const float frustum[6][4], int& planeMask);
+
+    unsigned int version_;
+    bool built_;
+
+    std::vector<SceneObject*> objects_;
+    std::vector<RenderData*> render_datas_;
+    // index one past the last descendant of each object
+    std::vector<int> subtree_end_;
+    std::vector<unsigned char> flags_;
+    std::vector<float> min_x_;
+    std::vector<float> min_y_;
+    std::vector<float> min_z_;
+    std::vector<float> max_x_;
+    std::vector<float> max_y_;
+    std::vector<float> max_z_;
+
+    std::vector<ViewState> views_;
+};
+
+/*
+ * Recursive cull of the scene graph under object, used when flat culling
+ * is off and as the reference the CullList must match. Only the main
+ * view may modify the cull status of the scene objects, the other views
+ * are culled at the same time.
+ */
+void frustum_cull(glm::vec3 camera_position, SceneObject* object,
+        const float frustum[6][4], std::vector<SceneObject*>& scene_objects,
+        bool need_cull, int planeMask, bool main_view);
+
+}
+#endif
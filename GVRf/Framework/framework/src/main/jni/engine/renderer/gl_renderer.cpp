@@ -23,12 +23,36 @@
 #include "objects/post_effect_data.h"
 #include "objects/scene.h"
 #include "objects/textures/render_texture.h"
+#include "objects/textures/texture_atlas.h"
+#include "objects/textures/texture_residency.h"
+#include "objects/textures/texture_uploader.h"
 #include "shaders/shader_manager.h"
 #include "shaders/post_effect_shader_manager.h"
 #include "gl_renderer.h"
+#include "objects/light.h"
 
 namespace gvr
 {
+    GLRenderer::~GLRenderer()
+    {
+        if (instance_vboID_ != 0)
+        {
+            GL(glDeleteBuffers(1, &instance_vboID_));
+        }
+    }
+
+    /*
+     * Upload this frame's share of the queued textures before culling,
+     * they are drawn once the GPU has received them.
+     */
+    void GLRenderer::cull(Scene *scene, Camera *camera,
+            ShaderManager* shader_manager)
+    {
+        TextureUploader::getInstance().update();
+        TextureAtlas::getInstance().update();
+        TextureResidency::getInstance().update();
+        Renderer::cull(scene, camera, shader_manager);
+    }
 
     void GLRenderer::clearBuffers(const Camera &camera) const
     {
@@ -43,7 +67,7 @@ namespace gvr
         if (useStencilBuffer_)
         {
             mask |= GL_STENCIL_BUFFER_BIT;
-            glStencilMask(~0);
+            GLState::getInstance().stencilMask(~0);
         }
         glClear(mask);
     }
@@ -70,21 +94,18 @@ namespace gvr
         rstate.scene = scene;
         rstate.render_mask = camera->render_mask();
         rstate.uniforms.u_right = rstate.render_mask & RenderData::RenderMaskBit::Right;
+        updateUniformBlocks(rstate);
 
         std::vector<PostEffectData*> post_effects = camera->post_effect_data();
 
-        GL(glDepthMask(GL_TRUE));
-        GL(glEnable(GL_DEPTH_TEST));
-        GL(glDepthFunc(GL_LEQUAL));
-        GL(glEnable(GL_CULL_FACE));
-        GL(glFrontFace(GL_CCW));
-        GL(glCullFace(GL_BACK));
-        GL(glEnable(GL_BLEND));
-        GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
-        GL(glBlendEquation(GL_FUNC_ADD));
-        GL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-        GL(glDisable(GL_POLYGON_OFFSET_FILL));
-        GL(glLineWidth(1.0f));
+        GLState& gl = GLState::getInstance();
+        gl.invalidate();
+        gl.depthFunc(GL_LEQUAL);
+        gl.frontFace(GL_CCW);
+        gl.blendEquation(GL_FUNC_ADD);
+        gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        gl.lineWidth(1.0f);
+        restoreRenderStates();
 
         if (post_effects.size() == 0)
         {
@@ -93,6 +114,11 @@ namespace gvr
 
             clearBuffers(*camera);
             renderRenderDataVector(rstate);
+            if (scene->get_occlusion_culling())
+            {
+                occlusion_culler_.issueQueries(shader_manager->getBoundingBoxShader());
+            }
+            restoreRenderStates();
         }
         else
         {
@@ -102,13 +128,15 @@ namespace gvr
             GL(glViewport(0, 0, texture_render_texture->width(), texture_render_texture->height()));
 
             clearBuffers(*camera);
-            for (auto it = render_data_vector.begin(); it != render_data_vector.end(); ++it)
+            renderRenderDataList(rstate, render_data_vector.data(), render_data_vector.size());
+            if (scene->get_occlusion_culling())
             {
-                GL(renderRenderData(rstate, *it));
+                occlusion_culler_.issueQueries(shader_manager->getBoundingBoxShader());
             }
+            restoreRenderStates();
 
-            GL(glDisable(GL_DEPTH_TEST));
-            GL(glDisable(GL_CULL_FACE));
+            gl.disable(GL_DEPTH_TEST);
+            gl.disable(GL_CULL_FACE);
 
             for (int i = 0; i < post_effects.size() - 1; ++i)
             {
@@ -134,9 +162,9 @@ namespace gvr
             renderPostEffectData(camera, texture_render_texture, post_effects.back(), post_effect_shader_manager);
         }
 
-        GL(glDisable(GL_DEPTH_TEST));
-        GL(glDisable(GL_CULL_FACE));
-        GL(glDisable(GL_BLEND));
+        gl.disable(GL_DEPTH_TEST);
+        gl.disable(GL_CULL_FACE);
+        gl.disable(GL_BLEND);
     }
 
     void GLRenderer::cullAndRender(RenderTarget* renderTarget, Scene* scene,
@@ -149,41 +177,44 @@ namespace gvr
         Camera* camera = renderTarget->getCamera();
         const std::vector<PostEffectData*>& post_effects = camera->post_effect_data();
         RenderTexture* saveRenderTexture = renderTarget->getTexture();
+        RenderView* view = findView(renderTarget);
+
+        // use the view culled by Renderer::cull if there is one,
+        // otherwise cull now without touching the main view
+        if (nullptr == view)
+        {
+            int view_index = shadow_views_.size() + 1;
+
+            view = &target_view_;
+            setupView(*view, camera, renderTarget, false, rstate.shadow_map);
+            if (!isCullPrepared(scene))
+            {
+                prepareCull(scene, view_index + 1);
+            }
+            cullView(scene, *view, view_index);
+        }
+        const std::vector<RenderData*>& render_list = view->render_data;
+        view->ready = false;
 
-        cullFromCamera(scene, camera, shader_manager);
         rstate.shader_manager = shader_manager;
         rstate.scene = scene;
-        if (!rstate.shadow_map)
-        {
-            state_sort();
-            GL(glEnable (GL_BLEND));
-            GL(glBlendEquation (GL_FUNC_ADD));
-            GL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-        }
-        GL(glDepthMask(GL_TRUE));
-        GL(glEnable (GL_DEPTH_TEST));
-        GL(glDepthFunc (GL_LEQUAL));
-        GL(glEnable (GL_CULL_FACE));
-        GL(glFrontFace (GL_CCW));
-        GL(glCullFace (GL_BACK));
-        GL(glDisable (GL_POLYGON_OFFSET_FILL));
-        GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
-        GL(glLineWidth(1.0f));
+
+        GLState& gl = GLState::getInstance();
+        gl.invalidate();
+        gl.blendEquation(GL_FUNC_ADD);
+        gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        gl.depthFunc(GL_LEQUAL);
+        gl.frontFace(GL_CCW);
+        gl.lineWidth(1.0f);
+        restoreRenderStates();
         if ((post_effects.size() == 0) ||
             (post_effect_render_texture_a == nullptr))
         {
             saveRenderTexture->useStencil(useStencilBuffer_);
             renderTarget->beginRendering();
-            for (auto it = render_data_vector.begin();
-                 it != render_data_vector.end();
-                 ++it)
-            {
-                RenderData* rdata = *it;
-                if (!rstate.shadow_map || rdata->cast_shadows())
-                {
-                    GL(renderRenderData(rstate, rdata));
-                }
-            }
+            updateUniformBlocks(rstate);
+            renderRenderDataList(rstate, render_list.data(), render_list.size());
+            restoreRenderStates();
             renderTarget->endRendering();
         }
         else
@@ -193,18 +224,11 @@ namespace gvr
             renderTexture->useStencil(useStencilBuffer_);
             renderTarget->setTexture(renderTexture);
             renderTarget->beginRendering();
-            for (auto it = render_data_vector.begin();
-                 it != render_data_vector.end();
-                 ++it)
-            {
-                RenderData* rdata = *it;
-                if (!rstate.shadow_map || rdata->cast_shadows())
-                {
-                    GL(renderRenderData(rstate, rdata));
-                }
-            }
-            GL(glDisable(GL_DEPTH_TEST));
-            GL(glDisable(GL_CULL_FACE));
+            updateUniformBlocks(rstate);
+            renderRenderDataList(rstate, render_list.data(), render_list.size());
+            restoreRenderStates();
+            gl.disable(GL_DEPTH_TEST);
+            gl.disable(GL_CULL_FACE);
             renderTarget->endRendering();
             for (int i = 0; i < post_effects.size() - 1; ++i)
             {
@@ -227,13 +251,16 @@ namespace gvr
             GL(renderPostEffectData(camera, renderTexture, post_effects.back(), post_effect_shader_manager));
             renderTarget->endRendering();
         }
-        GL(glDisable(GL_DEPTH_TEST));
-        GL(glDisable(GL_CULL_FACE));
-        GL(glDisable(GL_BLEND));
+        gl.disable(GL_DEPTH_TEST);
+        gl.disable(GL_CULL_FACE);
+        gl.disable(GL_BLEND);
     }
 
 /**
- * Set the render states for render data
+ * Set the render states for render data.
+ * Every state a render data can change is set on each draw, the state
+ * cache drops the calls which do not change anything. This way nothing
+ * has to be restored after the draw.
  */
     void GLRenderer::setRenderStates(RenderData *render_data, RenderState &rstate)
     {
@@ -241,88 +268,110 @@ namespace gvr
         if (!(rstate.render_mask & render_data->render_mask()))
             return;
 
+        GLState& gl = GLState::getInstance();
+        bool stencil_only = false;
+
+        gl.setEnabled(GL_POLYGON_OFFSET_FILL, render_data->offset());
         if (render_data->offset())
         {
-            GL(glEnable(GL_POLYGON_OFFSET_FILL));
-            GL(glPolygonOffset(render_data->offset_factor(), render_data->offset_units()));
+            gl.polygonOffset(render_data->offset_factor(), render_data->offset_units());
         }
-        if (!render_data->depth_test())
-        {
-            GL(glDisable(GL_DEPTH_TEST));
-        }
-
+        gl.setEnabled(GL_DEPTH_TEST, render_data->depth_test());
+        gl.setEnabled(GL_STENCIL_TEST, render_data->stencil_test());
         if (render_data->stencil_test())
         {
-            GL(glEnable(GL_STENCIL_TEST));
-
-            GL(glStencilFunc(render_data->stencil_func_func(), render_data->stencil_func_ref(),
-                             render_data->stencil_func_mask()));
+            gl.stencilFunc(render_data->stencil_func_func(), render_data->stencil_func_ref(),
+                           render_data->stencil_func_mask());
 
             int sfail = render_data->stencil_op_sfail();
             int dpfail = render_data->stencil_op_dpfail();
             int dppass = render_data->stencil_op_dppass();
             if (0 != sfail && 0 != dpfail && 0 != dppass)
             {
-                GL(glStencilOp(sfail, dpfail, dppass));
+                gl.stencilOp(sfail, dpfail, dppass);
             }
 
-            GL(glStencilMask(render_data->stencil_mask_mask()));
-            if (RenderData::Queue::Stencil == render_data->rendering_order())
-            {
-                GL(glDepthMask(GL_FALSE));
-                GL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
-            }
+            gl.stencilMask(render_data->stencil_mask_mask());
+            stencil_only = (RenderData::Queue::Stencil == render_data->rendering_order());
         }
-
-        if (!render_data->alpha_blend())
+        gl.depthMask(stencil_only ? GL_FALSE : GL_TRUE);
+        if (stencil_only)
         {
-            GL(glDisable(GL_BLEND));
+            gl.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
         }
+        else
+        {
+            gl.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        }
+
+        gl.setEnabled(GL_BLEND, render_data->alpha_blend());
+        gl.setEnabled(GL_SAMPLE_ALPHA_TO_COVERAGE, render_data->alpha_to_coverage());
         if (render_data->alpha_to_coverage())
         {
-            GL(glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE));
-            GL(glSampleCoverage(render_data->sample_coverage(),
-                                render_data->invert_coverage_mask()));
+            gl.sampleCoverage(render_data->sample_coverage(),
+                              render_data->invert_coverage_mask());
         }
-        glBlendFunc(render_data->source_alpha_blend_func(), render_data->dest_alpha_blend_func());
+        gl.blendFunc(render_data->source_alpha_blend_func(), render_data->dest_alpha_blend_func());
     }
+
 /**
- * Restore the render states for render data
+ * Restore the default render states once a list of render data
+ * has been drawn, before post effects or code outside the renderer
+ * get to draw.
  */
-    void GLRenderer::restoreRenderStates(RenderData *render_data)
+    void GLRenderer::restoreRenderStates()
     {
-        if (render_data->cull_face() != RenderData::CullBack)
-        {
-            GL(glEnable(GL_CULL_FACE));
-            GL(glCullFace(GL_BACK));
-        }
+        GLState& gl = GLState::getInstance();
+
+        gl.enable(GL_CULL_FACE);
+        gl.cullFace(GL_BACK);
+        gl.disable(GL_POLYGON_OFFSET_FILL);
+        gl.enable(GL_DEPTH_TEST);
+        gl.disable(GL_STENCIL_TEST);
+        gl.depthMask(GL_TRUE);
+        gl.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        gl.enable(GL_BLEND);
+        gl.disable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
 
-        if (render_data->offset())
+    /**
+     * Upload the view dependent uniforms of a render pass and attach
+     * the light blocks, so the shaders only have to set the uniforms
+     * which depend on the model.
+     * Programs which do not declare the blocks keep using the
+     * individual uniforms set by their shader.
+     */
+    void GLRenderer::updateUniformBlocks(RenderState& rstate)
+    {
+        camera_data_.u_view = rstate.uniforms.u_view;
+        camera_data_.u_proj = rstate.uniforms.u_proj;
+        camera_data_.u_view_inv = glm::inverse(rstate.uniforms.u_view);
+        if (use_multiview && !rstate.shadow_map)
         {
-            GL(glDisable(GL_POLYGON_OFFSET_FILL));
+            const CameraRig* rig = rstate.scene->main_camera_rig();
+            camera_data_.u_view_[0] = rig->left_camera()->getViewMatrix();
+            camera_data_.u_view_[1] = rig->right_camera()->getViewMatrix();
+            camera_data_.u_view_inv_[0] = glm::inverse(camera_data_.u_view_[0]);
+            camera_data_.u_view_inv_[1] = glm::inverse(camera_data_.u_view_[1]);
         }
-        if (!render_data->depth_test())
+        else
         {
-            GL(glEnable(GL_DEPTH_TEST));
+            camera_data_.u_view_[0] = camera_data_.u_view_[1] = camera_data_.u_view;
+            camera_data_.u_view_inv_[0] = camera_data_.u_view_inv_[1] = camera_data_.u_view_inv;
         }
+        camera_data_.u_right = rstate.uniforms.u_right ? 1 : 0;
+        camera_block_.set(0, &camera_data_, sizeof(CameraBlock));
+        camera_block_.bind(CAMERA_BLOCK_BINDING);
 
-        if (render_data->stencil_test())
+        if (0 == max_block_bindings_)
         {
-            GL(glDisable(GL_STENCIL_TEST));
-            if (RenderData::Queue::Stencil == render_data->rendering_order())
-            {
-                GL(glDepthMask(GL_TRUE));
-                GL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
-            }
+            glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &max_block_bindings_);
         }
-
-        if (!render_data->alpha_blend())
+        const std::vector<Light*>& lights = rstate.scene->getLightList();
+        int binding = LIGHT_BLOCK_BINDING;
+        for (auto it = lights.begin(); it != lights.end(); ++it, ++binding)
         {
-            GL(glEnable(GL_BLEND));
-        }
-        if (render_data->alpha_to_coverage())
-        {
-            GL(glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE));
+            (*it)->bindUniformBlock((binding < max_block_bindings_) ? binding : -1);
         }
     }
 
@@ -392,18 +441,20 @@ namespace gvr
     }
     void GLRenderer::set_face_culling(int cull_face)
     {
+        GLState& gl = GLState::getInstance();
+
         switch (cull_face)
         {
-            case RenderData::CullFront:glEnable(GL_CULL_FACE);
-                glCullFace(GL_FRONT);
+            case RenderData::CullFront:gl.enable(GL_CULL_FACE);
+                gl.cullFace(GL_FRONT);
                 break;
 
-            case RenderData::CullNone:glDisable(GL_CULL_FACE);
+            case RenderData::CullNone:gl.disable(GL_CULL_FACE);
                 break;
 
                 // CullBack as Default
-            default:glEnable(GL_CULL_FACE);
-                glCullFace(GL_BACK);
+            default:gl.enable(GL_CULL_FACE);
+                gl.cullFace(GL_BACK);
                 break;
         }
     }
@@ -422,6 +473,11 @@ namespace gvr
         }
      }
 
+    /**
+     * Drop the objects whose proxy boxes were hidden by the depth buffer
+     * a few frames ago. The queries for this frame are drawn by
+     * renderCamera once the main pass has filled the depth buffer.
+     */
     void GLRenderer::occlusion_cull(Scene* scene,
             std::vector<SceneObject*>& scene_objects, ShaderManager *shader_manager,
             glm::mat4 vp_matrix) {
@@ -429,91 +485,168 @@ namespace gvr
         if(!occlusion_cull_init(scene, scene_objects))
             return;
 
-        for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it)
+        occlusion_visible_.clear();
+        occlusion_culler_.cull(vp_matrix, scene_objects, occlusion_visible_);
+        for (auto it = occlusion_visible_.begin(); it != occlusion_visible_.end(); ++it)
         {
-            SceneObject *scene_object = (*it);
-            RenderData *render_data = scene_object->render_data();
-            if (render_data == 0 || render_data->material(0) == 0)
-            {
-                continue;
-            }
+            addRenderData((*it)->render_data());
+            scene->pick(*it);
+        }
+        scene->unlockColliders();
+
+        if (DEBUG_RENDERER)
+        {
+            LOGD("OCCLUSION: %d of %d objects occluded\n",
+                 occlusion_culler_.occluded_count(), (int) scene_objects.size());
+        }
+    }
+
+    void GLRenderer::renderMesh(RenderState &rstate, RenderData *render_data)
+    {
 
-            //If a query was issued on an earlier or same frame and if results are
-            //available, then update the same. If results are unavailable, do nothing
-            if (!scene_object->is_query_issued())
+        for (int curr_pass = 0; curr_pass < render_data->pass_count(); ++curr_pass)
+        {
+            numberTriangles += render_data->mesh()->getNumTriangles();
+            numberDrawCalls++;
+
+            set_face_culling(render_data->pass(curr_pass)->cull_face());
+            Material* curr_material = rstate.material_override;
+
+            if (curr_material == nullptr)
+                curr_material = render_data->pass(curr_pass)->material();
+            if (curr_material != nullptr)
             {
-                continue;
+                GL(renderMaterialShader(rstate, render_data, curr_material));
             }
+        }
+    }
 
-            //If a previous query is active, do not issue a new query.
-            //This avoids overloading the GPU with too many queries
-            //Queries may span multiple frames
+    /*
+     * Returns the shader which renders the material, throws if there
+     * is no custom shader of the material's type.
+     */
+    ShaderBase* GLRenderer::findShader(RenderState& rstate, Material* material)
+    {
+        ShaderManager* shader_manager = rstate.shader_manager;
 
-            bool is_query_issued = scene_object->is_query_issued();
-            if (!is_query_issued)
+        switch (material->shader_type())
+        {
+            case Material::ShaderType::UNLIT_HORIZONTAL_STEREO_SHADER:
+                return shader_manager->getUnlitHorizontalStereoShader();
+            case Material::ShaderType::UNLIT_VERTICAL_STEREO_SHADER:
+                return shader_manager->getUnlitVerticalStereoShader();
+            case Material::ShaderType::OES_SHADER:
+                return shader_manager->getOESShader();
+            case Material::ShaderType::OES_HORIZONTAL_STEREO_SHADER:
+                return shader_manager->getOESHorizontalStereoShader();
+            case Material::ShaderType::OES_VERTICAL_STEREO_SHADER:
+                return shader_manager->getOESVerticalStereoShader();
+            case Material::ShaderType::CUBEMAP_SHADER:
+                return shader_manager->getCubemapShader();
+            case Material::ShaderType::CUBEMAP_REFLECTION_SHADER:
+                return shader_manager->getCubemapReflectionShader();
+            case Material::ShaderType::TEXTURE_SHADER:
+                return shader_manager->getTextureShader();
+            case Material::ShaderType::EXTERNAL_RENDERER_SHADER:
+                return shader_manager->getExternalRendererShader();
+            case Material::ShaderType::ASSIMP_SHADER:
+                return shader_manager->getAssimpShader();
+            case Material::ShaderType::LIGHTMAP_SHADER:
+                return shader_manager->getLightMapShader();
+            case Material::ShaderType::UNLIT_FBO_SHADER:
+                return shader_manager->getUnlitFboShader();
+            default:
+                return shader_manager->getCustomShader(material->shader_type());
+        }
+    }
+
+    bool GLRenderer::supportsInstancing(RenderState& rstate, RenderData* render_data)
+    {
+        if ((render_data->mesh() == nullptr) || render_data->mesh()->hasBones())
+        {
+            return false;
+        }
+        try
+        {
+            for (int i = 0; i < render_data->pass_count(); ++i)
             {
-                //Setup basic bounding box and material
-                RenderData *bounding_box_render_data(new RenderData());
-                Mesh *bounding_box_mesh = render_data->mesh()->createBoundingBox();
-                Material *bbox_material = new Material(
-                        Material::BOUNDING_BOX_SHADER);
-                RenderPass *pass = new RenderPass();
-                pass->set_material(bbox_material);
-                bounding_box_render_data->set_mesh(bounding_box_mesh);
-                bounding_box_render_data->add_pass(pass);
-
-                GLuint *query = scene_object->get_occlusion_array();
-
-                glDepthFunc(GL_LEQUAL);
-                glEnable(GL_DEPTH_TEST);
-                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-                glm::mat4 model_matrix_tmp(
-                        scene_object->transform()->getModelMatrix());
-                glm::mat4 mvp_matrix_tmp(vp_matrix * model_matrix_tmp);
-
-                //Issue the query only with a bounding box
-                glBeginQuery(GL_ANY_SAMPLES_PASSED, query[0]);
-                shader_manager->getBoundingBoxShader()->render(mvp_matrix_tmp,
-                        bounding_box_render_data,
-                        bounding_box_render_data->material(0));
-                glEndQuery(GL_ANY_SAMPLES_PASSED);
-                scene_object->set_query_issued(true);
-
-                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-                //Delete the generated bounding box mesh
-                bounding_box_mesh->cleanUp();
-                delete bbox_material;
-                delete pass;
-                delete bounding_box_render_data;
+                Material* material = rstate.material_override;
+
+                if (material == nullptr)
+                    material = render_data->pass(i)->material();
+                if ((material == nullptr)
+                    || (Material::ShaderType::BEING_GENERATED == material->shader_type())
+                    || !findShader(rstate, material)->supportsInstancing(&rstate))
+                {
+                    return false;
+                }
             }
+        }
+        catch (const std::string&)
+        {
+            return false;
+        }
+        return true;
+    }
 
-            GLuint query_result = GL_FALSE;
-            GLuint *query = (*it)->get_occlusion_array();
-            glGetQueryObjectuiv(query[0], GL_QUERY_RESULT_AVAILABLE, &query_result);
+    /*
+     * Returns true if one of the passes uses a shader which can only
+     * draw instanced. Only called for render data which supports it.
+     */
+    bool GLRenderer::requiresInstancing(RenderState& rstate, RenderData* render_data)
+    {
+        for (int i = 0; i < render_data->pass_count(); ++i)
+        {
+            Material* material = rstate.material_override;
 
-            if (query_result)
+            if (material == nullptr)
+                material = render_data->pass(i)->material();
+            if (findShader(rstate, material)->requiresInstancing(&rstate))
             {
-                GLuint pixel_count;
-                glGetQueryObjectuiv(query[0], GL_QUERY_RESULT, &pixel_count);
-                bool visibility = ((pixel_count & GL_TRUE) == GL_TRUE);
-
-                (*it)->set_visible(visibility);
-                (*it)->set_query_issued(false);
-                addRenderData((*it)->render_data());
-                scene->pick(scene_object);
+                return true;
             }
         }
-        scene->unlockColliders();
+        return false;
     }
 
-    void GLRenderer::renderMesh(RenderState &rstate, RenderData *render_data)
+    /*
+     * Upload the model matrices of the instances into the stream buffer
+     * and draw all the passes once with glDrawElementsInstanced.
+     * A single instance is drawn the usual way if the shaders allow it,
+     * which saves updating the buffer and the attribute pointers.
+     */
+    void GLRenderer::renderInstances(RenderState& rstate, RenderData* const* render_datas,
+                                     int count)
     {
+        RenderData* render_data = render_datas[0];
+        Mesh* mesh = render_data->mesh();
 
+        if ((count == 1) && !requiresInstancing(rstate, render_data))
+        {
+            GL(renderRenderData(rstate, render_data));
+            return;
+        }
+
+        instance_matrices_.resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            Transform* const t = render_datas[i]->owner_object()->transform();
+            instance_matrices_[i] = (t != nullptr) ? t->getModelMatrix() : glm::mat4();
+        }
+        if (instance_vboID_ == 0)
+        {
+            glGenBuffers(1, &instance_vboID_);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instance_vboID_);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * count, instance_matrices_.data(),
+                     GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        setRenderStates(render_data, rstate);
+        rstate.instance_count = count;
         for (int curr_pass = 0; curr_pass < render_data->pass_count(); ++curr_pass)
         {
-            numberTriangles += render_data->mesh()->getNumTriangles();
+            numberTriangles += mesh->getNumTriangles() * count;
             numberDrawCalls++;
 
             set_face_culling(render_data->pass(curr_pass)->cull_face());
@@ -526,6 +659,47 @@ namespace gvr
                 GL(renderMaterialShader(rstate, render_data, curr_material));
             }
         }
+        rstate.instance_count = 0;
+    }
+
+    /*
+     * Point the a_model_instance attribute of the program at the
+     * instance matrices. The VAO of the mesh must be bound.
+     */
+    void GLRenderer::bindInstanceMatrices(GLint instanceLocation)
+    {
+        if (instanceLocation < 0)
+        {
+            return;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instance_vboID_);
+        for (int i = 0; i < 4; ++i)
+        {
+            GLuint location = instanceLocation + i;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (GLvoid*) (sizeof(glm::vec4) * i));
+            glVertexAttribDivisor(location, 1);
+            glEnableVertexAttribArray(location);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /*
+     * Tell the streamed textures of a material how many pixels the
+     * bounding sphere of the object covers on screen.
+     */
+    void GLRenderer::requestTextureDetail(RenderState& rstate, RenderData* render_data,
+            Material* material) {
+        const BoundingVolume& bv = render_data->owner_object()->getBoundingVolume();
+        glm::vec4 center = rstate.uniforms.u_view * glm::vec4(bv.center(), 1.0f);
+        float distance = std::max(-center.z, 0.001f);
+        float pixels = bv.radius() * rstate.uniforms.u_proj[1][1]
+                * rstate.viewportHeight / distance;
+        const std::vector<Texture*>& textures = material->streamed_textures();
+
+        for (auto it = textures.begin(); it != textures.end(); ++it) {
+            (*it)->requestScreenSize(pixels);
+        }
     }
 
     void GLRenderer::renderMaterialShader(RenderState& rstate, RenderData* render_data, Material *curr_material) {
@@ -543,6 +717,9 @@ namespace gvr
         if (t == nullptr)
             return;
 
+        if (!rstate.shadow_map && !curr_material->streamed_textures().empty()) {
+            requestTextureDetail(rstate, render_data, curr_material);
+        }
         rstate.uniforms.u_model = t->getModelMatrix();
     	rstate.uniforms.u_mv = rstate.uniforms.u_view * rstate.uniforms.u_model;
     	rstate.uniforms.u_mv_it = glm::inverseTranspose(rstate.uniforms.u_mv);
@@ -566,55 +743,16 @@ namespace gvr
         ShaderBase* shader = NULL;
 
         try {
-             //TODO: Improve this logic to avoid a big "switch case"
             if (rstate.material_override != nullptr)
                 curr_material = rstate.material_override;
-             switch (curr_material->shader_type()) {
-                case Material::ShaderType::UNLIT_HORIZONTAL_STEREO_SHADER:
-                	shader = shader_manager->getUnlitHorizontalStereoShader();
-                    break;
-                case Material::ShaderType::UNLIT_VERTICAL_STEREO_SHADER:
-                    shader = shader_manager->getUnlitVerticalStereoShader();
-                    break;
-                case Material::ShaderType::OES_SHADER:
-                    shader = shader_manager->getOESShader();
-                    break;
-                case Material::ShaderType::OES_HORIZONTAL_STEREO_SHADER:
-                    shader = shader_manager->getOESHorizontalStereoShader();
-                    break;
-                case Material::ShaderType::OES_VERTICAL_STEREO_SHADER:
-                    shader = shader_manager->getOESVerticalStereoShader();
-                    break;
-                case Material::ShaderType::CUBEMAP_SHADER:
-                    shader = shader_manager->getCubemapShader();
-                    break;
-                case Material::ShaderType::CUBEMAP_REFLECTION_SHADER:
-                    if(use_multiview){
-                        rstate.uniforms.u_view_inv_[0] = glm::inverse(rstate.uniforms.u_view_[0]);
-                        rstate.uniforms.u_view_inv_[1] = glm::inverse(rstate.uniforms.u_view_[1]);
-                    }
-                    else
-                        rstate.uniforms.u_view_inv = glm::inverse(rstate.uniforms.u_view);
-                    shader = shader_manager->getCubemapReflectionShader();
-                    break;
-                case Material::ShaderType::TEXTURE_SHADER:
-                    shader = shader_manager->getTextureShader();
-                    break;
-                case Material::ShaderType::EXTERNAL_RENDERER_SHADER:
-                    shader = shader_manager->getExternalRendererShader();
-                    break;
-                case Material::ShaderType::ASSIMP_SHADER:
-                    shader = shader_manager->getAssimpShader();
-                    break;
-                case Material::ShaderType::LIGHTMAP_SHADER:
-                    shader = shader_manager->getLightMapShader();
-                    break;
-    			case Material::ShaderType::UNLIT_FBO_SHADER:
-    				shader = shader_manager->getUnlitFboShader();
-                    break;
-                default:
-                    shader = shader_manager->getCustomShader(curr_material->shader_type());
-                    break;
+            shader = findShader(rstate, curr_material);
+            if (Material::ShaderType::CUBEMAP_REFLECTION_SHADER == curr_material->shader_type()) {
+                if(use_multiview){
+                    rstate.uniforms.u_view_inv_[0] = glm::inverse(rstate.uniforms.u_view_[0]);
+                    rstate.uniforms.u_view_inv_[1] = glm::inverse(rstate.uniforms.u_view_[1]);
+                }
+                else
+                    rstate.uniforms.u_view_inv = glm::inverse(rstate.uniforms.u_view);
             }
              if (shader == NULL) {
                  LOGE("Rendering error: GVRRenderData shader cannot be determined\n");
@@ -626,12 +764,13 @@ namespace gvr
                  (render_data->draw_mode() == GL_LINE_LOOP)) {
                  if (curr_material->hasUniform("line_width")) {
                      float lineWidth = curr_material->getFloat("line_width");
-                     glLineWidth(lineWidth);
+                     GLState::getInstance().lineWidth(lineWidth);
                  }
                  else {
-                     glLineWidth(1.0f);
+                     GLState::getInstance().lineWidth(1.0f);
                  }
              }
+             curr_material->markTexturesUsed();
              shader->render(&rstate, render_data, curr_material);
         } catch (const std::string &error) {
             LOGE(
@@ -645,8 +784,17 @@ namespace gvr
         //there is no program associated with EXTERNAL_RENDERER_SHADER
         if (-1 != programId) {
             glBindVertexArray(mesh->getVAOId(programId));
-            if (mesh->indices().size() > 0) {
-                glDrawElements(render_data->draw_mode(), mesh->indices().size(), GL_UNSIGNED_SHORT, 0);
+            if (rstate.instance_count > 0) {
+                bindInstanceMatrices(shader->getInstanceLocation());
+                if (mesh->getIndexCount() > 0) {
+                    glDrawElementsInstanced(render_data->draw_mode(), mesh->getIndexCount(),
+                                            mesh->getIndexType(), 0, rstate.instance_count);
+                } else {
+                    glDrawArraysInstanced(render_data->draw_mode(), 0, mesh->vertices().size(),
+                                          rstate.instance_count);
+                }
+            } else if (mesh->getIndexCount() > 0) {
+                glDrawElements(render_data->draw_mode(), mesh->getIndexCount(), mesh->getIndexType(), 0);
 
             } else {
                 glDrawArrays(render_data->draw_mode(), 0, mesh->vertices().size());
@@ -38,6 +38,10 @@
 #include "objects/mesh.h"
 #include "objects/bounding_volume.h"
 #include "gl/gl_program.h"
+#include "gl/gl_state.h"
+#include "gl/gl_uniform_block.h"
+#include "occlusion_culler.h"
+#include "objects/textures/texture_residency.h"
 #include <unordered_map>
 #include "renderer.h"
 
@@ -51,13 +55,37 @@ class PostEffectShaderManager;
 class RenderData;
 class RenderTexture;
 class ShaderManager;
+class ShaderBase;
 class Light;
 
+/*
+ * CPU copy of the std140 "Camera" uniform block:
+ *
+ * layout (std140) uniform Camera {
+ *     mat4 u_view;
+ *     mat4 u_proj;
+ *     mat4 u_view_inv;
+ *     mat4 u_view_[2];
+ *     mat4 u_view_inv_[2];
+ *     highp int u_right;
+ * };
+ */
+struct CameraBlock {
+    glm::mat4 u_view;
+    glm::mat4 u_proj;
+    glm::mat4 u_view_inv;
+    glm::mat4 u_view_[2];
+    glm::mat4 u_view_inv_[2];
+    int u_right;
+    int padding[3];
+};
+
 class GLRenderer: public Renderer {
     friend class Renderer;
 protected:
-    GLRenderer(){}
-    virtual ~GLRenderer(){}
+    GLRenderer() : instance_vboID_(0), camera_block_(sizeof(CameraBlock)),
+            max_block_bindings_(0) {}
+    virtual ~GLRenderer();
 public:
     // pure virtual
      void renderCamera(Scene* scene, Camera* camera,
@@ -72,8 +100,27 @@ public:
              RenderTexture* post_effect_render_texture_a,
              RenderTexture* post_effect_render_texture_b);
 
-    void restoreRenderStates(RenderData* render_data);
+    void restoreRenderStates();
+
+    virtual void resetStats() {
+        Renderer::resetStats();
+        GLState::getInstance().resetStats();
+    }
+    virtual int getNumberStateChanges() {
+        return GLState::getInstance().changed();
+    }
+    virtual int getNumberSkippedStateChanges() {
+        return GLState::getInstance().skipped();
+    }
+    virtual int getTextureMemoryKB() {
+        return TextureResidency::getInstance().resident_bytes() / 1024;
+    }
+    virtual int getNumberTexturesEvicted() {
+        return TextureResidency::getInstance().evicted_count();
+    }
     void setRenderStates(RenderData* render_data, RenderState& rstate);
+    virtual void cull(Scene *scene, Camera *camera,
+            ShaderManager* shader_manager);
     virtual void cullAndRender(RenderTarget* renderTarget, Scene* scene,
                         ShaderManager* shader_manager, PostEffectShaderManager* post_effect_shader_manager,
                         RenderTexture* post_effect_render_texture_a,
@@ -100,15 +147,36 @@ public:
 private:
     // this is specific to GL
     bool checkTextureReady(Material* material);
+    void requestTextureDetail(RenderState& rstate, RenderData* render_data,
+            Material* material);
 
     // Pure Virtual
     virtual void renderMesh(RenderState& rstate, RenderData* render_data);
     virtual void renderMaterialShader(RenderState& rstate, RenderData* render_data, Material *material) ;
+    virtual bool supportsInstancing(RenderState& rstate, RenderData* render_data);
+    bool requiresInstancing(RenderState& rstate, RenderData* render_data);
+    virtual void renderInstances(RenderState& rstate, RenderData* const* render_datas, int count);
+    ShaderBase* findShader(RenderState& rstate, Material* material);
+    void bindInstanceMatrices(GLint instanceLocation);
+    void updateUniformBlocks(RenderState& rstate);
     void occlusion_cull(Scene* scene,
                     std::vector<SceneObject*>& scene_objects,
                     ShaderManager *shader_manager, glm::mat4 vp_matrix);
 
     void clearBuffers(const Camera& camera) const;
+
+    // per instance model matrices, streamed for each instanced draw
+    GLuint instance_vboID_;
+    std::vector<glm::mat4> instance_matrices_;
+
+    // per pass view data and light blocks, shared by all programs
+    CameraBlock camera_data_;
+    GLUniformBlock camera_block_;
+    GLint max_block_bindings_;
+
+    // queries are recorded while culling and drawn after the main pass
+    OcclusionCuller occlusion_culler_;
+    std::vector<SceneObject*> occlusion_visible_;
 };
 
 }
@@ -0,0 +1,96 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Runs short per frame jobs on a small pool of worker threads.
+ ***************************************************************************/
+
+#include "job_queue.h"
+
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+JobQueue::JobQueue(int thread_count) :
+        pending_(0), stop_(false) {
+    if (thread_count < 0) {
+        int cores = std::thread::hardware_concurrency();
+        thread_count = (cores > 4) ? 3 : ((cores > 1) ? cores - 1 : 0);
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        threads_.push_back(std::thread(&JobQueue::run, this));
+    }
+    LOGD("JobQueue: started %d worker threads", thread_count);
+}
+
+JobQueue::~JobQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    job_added_.notify_all();
+    for (auto it = threads_.begin(); it != threads_.end(); ++it) {
+        it->join();
+    }
+}
+
+void JobQueue::add(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+        ++pending_;
+    }
+    job_added_.notify_one();
+}
+
+void JobQueue::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // help out instead of sleeping while there is work left
+    while (!jobs_.empty()) {
+        std::function<void()> job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+        --pending_;
+    }
+    while (pending_ > 0) {
+        job_done_.wait(lock);
+    }
+}
+
+void JobQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;) {
+        while (!stop_ && jobs_.empty()) {
+            job_added_.wait(lock);
+        }
+        if (stop_) {
+            return;
+        }
+        std::function<void()> job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+        if (--pending_ == 0) {
+            job_done_.notify_all();
+        }
+    }
+}
+
+}
@@ -0,0 +1,79 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Runs short per frame jobs on a small pool of worker threads.
+ ***************************************************************************/
+
+#ifndef JOB_QUEUE_H_
+#define JOB_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gvr {
+
+/*
+ * A fixed pool of worker threads executing the jobs added to the queue.
+ * The thread calling wait() also executes jobs until the queue is
+ * empty, so a queue without worker threads simply runs all the jobs
+ * on the calling thread.
+ *
+ * Jobs must not throw and must not call into GL.
+ */
+class JobQueue {
+public:
+    /*
+     * Create a queue with the given number of worker threads.
+     * A negative count picks one thread less than the number of cores,
+     * at most three.
+     */
+    explicit JobQueue(int thread_count = -1);
+    ~JobQueue();
+
+    void add(std::function<void()> job);
+
+    /*
+     * Block until all the jobs added so far have completed.
+     */
+    void wait();
+
+    int thread_count() const {
+        return threads_.size();
+    }
+
+private:
+    JobQueue(const JobQueue& job_queue);
+    JobQueue(JobQueue&& job_queue);
+    JobQueue& operator=(const JobQueue& job_queue);
+    JobQueue& operator=(JobQueue&& job_queue);
+
+    void run();
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable job_added_;
+    std::condition_variable job_done_;
+    int pending_;
+    bool stop_;
+};
+
+}
+#endif
@@ -0,0 +1,274 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Hardware occlusion culling with pooled queries and proxy boxes.
+ ***************************************************************************/
+
+#include "occlusion_culler.h"
+
+#include "gl/gl_state.h"
+#include "objects/bounding_volume.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "shaders/material/bounding_box_shader.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+static const GLfloat CUBE_VERTICES[] = {
+        -0.5f, -0.5f, -0.5f,    0.5f, -0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f,    0.5f,  0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,    0.5f, -0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,    0.5f,  0.5f,  0.5f
+};
+
+static const GLushort CUBE_INDICES[] = {
+        0, 2, 1,  1, 2, 3,      // back
+        4, 5, 6,  5, 7, 6,      // front
+        0, 4, 2,  2, 4, 6,      // left
+        1, 3, 5,  3, 7, 5,      // right
+        0, 1, 4,  1, 5, 4,      // bottom
+        2, 6, 3,  3, 6, 7       // top
+};
+
+static const int CUBE_INDEX_COUNT = sizeof(CUBE_INDICES) / sizeof(GLushort);
+
+OcclusionCuller::OcclusionCuller() :
+        frame_(0), issued_frame_(0), occluded_count_(0), query_count_(0),
+        vao_(0), vbo_(0), ibo_(0), cube_program_(0) {
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    if (!all_queries_.empty()) {
+        glDeleteQueries(all_queries_.size(), all_queries_.data());
+    }
+    if (0 != vao_) {
+        glDeleteVertexArrays(1, &vao_);
+        glDeleteBuffers(1, &vbo_);
+        glDeleteBuffers(1, &ibo_);
+    }
+}
+
+GLuint OcclusionCuller::acquireQuery() {
+    if (free_queries_.empty()) {
+        GLuint queries[QUERY_BATCH];
+
+        glGenQueries(QUERY_BATCH, queries);
+        all_queries_.insert(all_queries_.end(), queries, queries + QUERY_BATCH);
+        free_queries_.insert(free_queries_.end(), queries,
+                queries + QUERY_BATCH);
+    }
+    GLuint query = free_queries_.back();
+    free_queries_.pop_back();
+    return query;
+}
+
+void OcclusionCuller::releaseQuery(GLuint query) {
+    free_queries_.push_back(query);
+}
+
+/*
+ * Read the result of the pending query of an object if it is old
+ * enough and the GPU is done with it, otherwise leave it pending.
+ */
+void OcclusionCuller::collect(ObjectState& state) {
+    if ((0 == state.query) || (frame_ - state.issued < QUERY_LATENCY)) {
+        return;
+    }
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return;
+    }
+
+    GLuint samples_passed = GL_FALSE;
+    glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &samples_passed);
+    releaseQuery(state.query);
+    state.query = 0;
+
+    if (samples_passed) {
+        state.visible = true;
+        state.hidden_results = 0;
+    } else if (++state.hidden_results >= HIDDEN_RESULTS) {
+        state.visible = false;
+    }
+}
+
+/*
+ * Occluded objects are tested every frame so they reappear quickly,
+ * visible ones only every few frames.
+ */
+bool OcclusionCuller::needsQuery(const ObjectState& state) const {
+    if (0 != state.query) {
+        return false;
+    }
+    return !state.visible || (frame_ - state.tested >= VISIBLE_QUERY_INTERVAL);
+}
+
+void OcclusionCuller::sweep() {
+    for (auto it = states_.begin(); it != states_.end();) {
+        if (frame_ - it->second.seen > STALE_FRAMES) {
+            if (0 != it->second.query) {
+                releaseQuery(it->second.query);
+            }
+            it = states_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void OcclusionCuller::cull(const glm::mat4& vp_matrix,
+        const std::vector<SceneObject*>& scene_objects,
+        std::vector<SceneObject*>& visible_objects) {
+    ++frame_;
+    occluded_count_ = 0;
+    query_count_ = 0;
+    proxies_.clear();
+    if (0 == frame_ % STALE_FRAMES) {
+        sweep();
+    }
+
+    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
+        SceneObject* scene_object = *it;
+        RenderData* render_data = scene_object->render_data();
+
+        // nothing to save on objects which do not draw
+        if ((nullptr == render_data) || (nullptr == render_data->material(0))
+                || (nullptr == render_data->mesh())) {
+            visible_objects.push_back(scene_object);
+            continue;
+        }
+
+        auto found = states_.find(scene_object);
+        if (found == states_.end()) {
+            ObjectState state = { 0, 0, frame_ - VISIBLE_QUERY_INTERVAL,
+                    frame_, 0, true };
+            found = states_.insert(std::make_pair(scene_object, state)).first;
+        }
+        ObjectState& state = found->second;
+
+        // an object back in the frustum is drawn until a new query says
+        // otherwise, the result of a query issued before it left is stale
+        if (state.seen != frame_ - 1) {
+            if (0 != state.query) {
+                releaseQuery(state.query);
+                state.query = 0;
+            }
+            state.visible = true;
+            state.hidden_results = 0;
+            state.tested = frame_ - VISIBLE_QUERY_INTERVAL;
+        }
+        collect(state);
+        state.seen = frame_;
+
+        const BoundingVolume& bv = scene_object->getMeshBoundingVolume();
+        glm::vec3 size(bv.max_corner() - bv.min_corner());
+        glm::mat4 model(size.x, 0, 0, 0,
+                0, size.y, 0, 0,
+                0, 0, size.z, 0,
+                bv.center().x, bv.center().y, bv.center().z, 1);
+        glm::mat4 mvp(vp_matrix * model);
+
+        // a box crossing the near plane would be clipped, so it cannot be tested
+        bool crosses_near = false;
+        for (int i = 0; i < 8; ++i) {
+            const GLfloat* v = &CUBE_VERTICES[i * 3];
+            glm::vec4 clip(mvp * glm::vec4(v[0], v[1], v[2], 1.0f));
+
+            if (clip.z < -clip.w) {
+                crosses_near = true;
+                break;
+            }
+        }
+        if (crosses_near) {
+            state.visible = true;
+            state.hidden_results = 0;
+        } else if (needsQuery(state)) {
+            Proxy proxy = { &state, mvp };
+            proxies_.push_back(proxy);
+        }
+
+        if (state.visible) {
+            visible_objects.push_back(scene_object);
+        } else {
+            ++occluded_count_;
+        }
+    }
+}
+
+void OcclusionCuller::createCube(GLuint program_id) {
+    GLint position = glGetAttribLocation(program_id, "a_position");
+
+    if (0 == vao_) {
+        glGenVertexArrays(1, &vao_);
+        glGenBuffers(1, &vbo_);
+        glGenBuffers(1, &ibo_);
+    }
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES,
+            GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CUBE_INDICES), CUBE_INDICES,
+            GL_STATIC_DRAW);
+    glEnableVertexAttribArray(position);
+    glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    cube_program_ = program_id;
+}
+
+void OcclusionCuller::issueQueries(BoundingBoxShader* shader) {
+    if (issued_frame_ == frame_) {
+        return;
+    }
+    issued_frame_ = frame_;
+    if (proxies_.empty()) {
+        return;
+    }
+
+    GLState& gl = GLState::getInstance();
+    gl.enable(GL_DEPTH_TEST);
+    gl.depthFunc(GL_LEQUAL);
+    gl.depthMask(GL_FALSE);
+    gl.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    gl.disable(GL_CULL_FACE);
+    gl.disable(GL_BLEND);
+    gl.disable(GL_STENCIL_TEST);
+
+    if (cube_program_ != shader->getProgramId()) {
+        createCube(shader->getProgramId());
+    } else {
+        glBindVertexArray(vao_);
+    }
+    for (auto it = proxies_.begin(); it != proxies_.end(); ++it) {
+        ObjectState* state = it->state;
+
+        state->query = acquireQuery();
+        state->issued = frame_;
+        state->tested = frame_;
+        shader->render(it->mvp);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, state->query);
+        glDrawElements(GL_TRIANGLES, CUBE_INDEX_COUNT, GL_UNSIGNED_SHORT, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+    }
+    glBindVertexArray(0);
+    query_count_ = proxies_.size();
+    proxies_.clear();
+    checkGLError("OcclusionCuller::issueQueries");
+}
+
+}
@@ -0,0 +1,135 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Hardware occlusion culling with pooled queries and proxy boxes.
+ ***************************************************************************/
+
+#ifndef OCCLUSION_CULLER_H_
+#define OCCLUSION_CULLER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "gl/gl_headers.h"
+#include "glm/glm.hpp"
+
+namespace gvr {
+class SceneObject;
+class BoundingBoxShader;
+
+/*
+ * Tests the world space mesh bounds of the scene objects against the
+ * depth buffer with occlusion queries.
+ *
+ * All the proxies share a single unit cube which is scaled to the
+ * bounds of each object. Query objects are allocated lazily from a pool
+ * and only read back once they are at least QUERY_LATENCY frames old and
+ * their result is available, so the CPU never waits for the GPU.
+ * Until a result arrives an object keeps the visibility it had the
+ * frame before, and a new object or one which was outside the frustum
+ * the frame before is considered visible.
+ *
+ * The visibility state is keyed by the scene object pointer, which is
+ * never dereferenced. Entries of objects which have not survived frustum
+ * culling for a while are dropped and their queries returned to the pool.
+ *
+ * Must only be used on the GL thread.
+ */
+class OcclusionCuller {
+public:
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    /*
+     * Collect the available query results and append the objects which
+     * should be rendered this frame to visible_objects. The objects which
+     * need a new query are recorded for issueQueries.
+     */
+    void cull(const glm::mat4& vp_matrix,
+            const std::vector<SceneObject*>& scene_objects,
+            std::vector<SceneObject*>& visible_objects);
+
+    /*
+     * Draw the proxies recorded by the last call to cull against the
+     * depth buffer of the pass which was just rendered. Only the first
+     * pass of a frame issues queries, later eyes do nothing.
+     */
+    void issueQueries(BoundingBoxShader* shader);
+
+    int occluded_count() const {
+        return occluded_count_;
+    }
+
+    int query_count() const {
+        return query_count_;
+    }
+
+private:
+    OcclusionCuller(const OcclusionCuller& occlusion_culler);
+    OcclusionCuller(OcclusionCuller&& occlusion_culler);
+    OcclusionCuller& operator=(const OcclusionCuller& occlusion_culler);
+    OcclusionCuller& operator=(OcclusionCuller&& occlusion_culler);
+
+    // frames to wait before polling a query
+    static const unsigned int QUERY_LATENCY = 2;
+    // frames between the queries of an object which is visible
+    static const unsigned int VISIBLE_QUERY_INTERVAL = 4;
+    // occluded results in a row before an object is culled
+    static const int HIDDEN_RESULTS = 2;
+    // frames after which the state of an unseen object is dropped
+    static const unsigned int STALE_FRAMES = 120;
+    // queries generated at once when the pool is empty
+    static const int QUERY_BATCH = 32;
+
+    struct ObjectState {
+        GLuint query;           // 0 when no query is pending
+        unsigned int issued;    // frame the pending query was issued
+        unsigned int tested;    // frame the last query was issued
+        unsigned int seen;      // last frame the object passed frustum culling
+        int hidden_results;
+        bool visible;
+    };
+
+    struct Proxy {
+        ObjectState* state;
+        glm::mat4 mvp;
+    };
+
+    void collect(ObjectState& state);
+    bool needsQuery(const ObjectState& state) const;
+    void sweep();
+    GLuint acquireQuery();
+    void releaseQuery(GLuint query);
+    void createCube(GLuint program_id);
+
+    unsigned int frame_;
+    unsigned int issued_frame_;
+    int occluded_count_;
+    int query_count_;
+
+    std::unordered_map<const SceneObject*, ObjectState> states_;
+    std::vector<Proxy> proxies_;
+    std::vector<GLuint> free_queries_;
+    std::vector<GLuint> all_queries_;
+
+    GLuint vao_;
+    GLuint vbo_;
+    GLuint ibo_;
+    GLuint cube_program_;
+};
+
+}
+#endif
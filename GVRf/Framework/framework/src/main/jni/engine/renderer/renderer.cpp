@@ -17,17 +17,23 @@
  * Renders a scene, a screen.
  ***************************************************************************/
 
+#include <algorithm>
+
 #include "renderer.h"
 #include "glm/gtc/matrix_inverse.hpp"
 
 #include "objects/post_effect_data.h"
 #include "objects/scene.h"
+#include "objects/vertex_bone_data.h"
+#include "objects/components/shadow_map.h"
 #include "objects/textures/render_texture.h"
 #include "shaders/shader_manager.h"
 #include "shaders/post_effect_shader_manager.h"
 
 #include "gl_renderer.h"
 #include "vulkan_renderer.h"
+#include "job_queue.h"
+#include "software_occlusion_culler.h"
 #define MAX_INDICES 500
 #define BATCH_SIZE 60
 bool do_batching = true;
@@ -56,92 +62,121 @@ Renderer* Renderer::getInstance(const char* type){
     }
     return instance;
 }
-Renderer::Renderer():numberDrawCalls(0), numberTriangles(0), batch_manager(nullptr) {
+Renderer::Renderer():numberDrawCalls(0), numberTriangles(0), batch_manager(nullptr),
+        job_queue_(nullptr), software_culler_(nullptr) {
     if(do_batching && !gRenderer->isVulkanInstace()) {
         batch_manager = new BatchManager(BATCH_SIZE, MAX_INDICES);
     }
 }
-void Renderer::frustum_cull(glm::vec3 camera_position, SceneObject *object,
-        float frustum[6][4], std::vector<SceneObject*>& scene_objects,
-        bool need_cull, int planeMask) {
-
-    // frustumCull() return 3 possible values:
-    // 0 when the HBV of the object is completely outside the frustum: cull itself and all its children out
-    // 1 when the HBV of the object is intersecting the frustum but the object itself is not: cull it out and continue culling test with its children
-    // 2 when the HBV of the object is intersecting the frustum and the mesh BV of the object are intersecting (inside) the frustum: render itself and continue culling test with its children
-    // 3 when the HBV of the object is completely inside the frustum: render itself and all its children without further culling test
-    int cullVal;
-
-    if (!object->enabled()) {
-        return;
-    }
-
-    //allows for on demand calculation of the camera distance; usually matters
-    //when transparent objects are in play
-    RenderData* renderData = object->render_data();
-    if (nullptr != renderData) {
-        renderData->setCameraDistanceLambda([object, camera_position]() {
-            // Transform the bounding volume
-            BoundingVolume bounding_volume_ = object->getBoundingVolume();
-            glm::vec4 transformed_sphere_center(bounding_volume_.center(), 1.0f);
+Renderer::~Renderer() {
+    delete job_queue_;
+    delete software_culler_;
+    delete batch_manager;
+}
+/*
+ * Squared distance from the camera of a view to the center of the
+ * bounds of a render data. Computed per view since the render data
+ * is shared by all the views culled in parallel.
+ */
+static float camera_distance(RenderData* render_data,
+        const glm::vec3& camera_position) {
+    SceneObject* object = render_data->owner_object();
 
-            // Calculate distance from camera
-            glm::vec4 position(camera_position, 1.0f);
-            glm::vec4 difference = transformed_sphere_center - position;
-            float distance = glm::dot(difference, difference);
+    if (nullptr == object) {
+        return 0.0f;
+    }
+    glm::vec3 difference = object->getRefitBoundingVolume().center()
+            - camera_position;
+    return glm::dot(difference, difference);
+}
 
-            // this distance will be used when sorting transparent objects
-            return distance;
-        });
+/*
+ * Stable LSD radix sort of the render datas by RenderData::getSortKey,
+ * 8 bits per pass from the last word of the key to the first. Passes
+ * in which all the keys have the same digit are skipped, which is the
+ * case for most of the high order bytes.
+ */
+static void radix_sort(std::vector<RenderData*>& render_list,
+        const glm::vec3& camera_position, SortBuffers& buffers) {
+    static const int WORD_COUNT = RenderData::SortKey::WORD_COUNT;
+    static const int DIGIT_COUNT = WORD_COUNT * 8;
+    typedef SortBuffers::Entry SortEntry;
+    const int size = render_list.size();
+
+    if (size < 2) {
+        return;
     }
 
-    if (need_cull) {
-        cullVal = object->frustumCull(camera_position, frustum, planeMask);
-        if (cullVal == 0) {
-            object->setCullStatus(true);
-            return;
+    std::vector<SortEntry>& entries = buffers.entries;
+    std::vector<unsigned int>& counts = buffers.counts;
+    entries.resize(size);
+    buffers.scratch.resize(size);
+    counts.assign(DIGIT_COUNT * 256, 0);
+
+    for (int i = 0; i < size; ++i) {
+        const RenderData::SortKey key = render_list[i]->getSortKey(
+                camera_distance(render_list[i], camera_position));
+
+        entries[i].key = key;
+        entries[i].render_data = render_list[i];
+        for (int digit = 0; digit < DIGIT_COUNT; ++digit) {
+            uint64_t word = key.words[WORD_COUNT - 1 - digit / 8];
+            ++counts[digit * 256 + ((word >> ((digit % 8) * 8)) & 0xff)];
         }
+    }
 
-        if (cullVal >= 2) {
-            object->setCullStatus(false);
-            scene_objects.push_back(object);
-        }
+    SortEntry* src = entries.data();
+    SortEntry* dst = buffers.scratch.data();
+    for (int digit = 0; digit < DIGIT_COUNT; ++digit) {
+        const int word = WORD_COUNT - 1 - digit / 8;
+        const int shift = (digit % 8) * 8;
+        unsigned int* count = &counts[digit * 256];
+        unsigned int offset = 0;
 
-        if (cullVal == 3) {
-            object->setCullStatus(false);
-            need_cull = false;
+        if (count[(src[0].key.words[word] >> shift) & 0xff] == size) {
+            continue;
         }
-    } else {
-        object->setCullStatus(false);
-        scene_objects.push_back(object);
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            unsigned int bucket_size = count[bucket];
+            count[bucket] = offset;
+            offset += bucket_size;
+        }
+        for (int i = 0; i < size; ++i) {
+            dst[count[(src[i].key.words[word] >> shift) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
     }
-
-    const std::vector<SceneObject*> children = object->children();
-    for (auto it = children.begin(); it != children.end(); ++it) {
-        frustum_cull(camera_position, *it, frustum, scene_objects, need_cull, planeMask);
+    for (int i = 0; i < size; ++i) {
+        render_list[i] = src[i].render_data;
     }
 }
 
 void Renderer::state_sort() {
+    state_sort(render_data_vector, main_view_.camera_position,
+            main_view_.sort_buffers);
+}
+
+void Renderer::state_sort(std::vector<RenderData*>& render_list,
+        const glm::vec3& camera_position, SortBuffers& buffers) {
     // The current implementation of sorting is based on
     // 1. rendering order first to maintain specified order
     // 2. shader type second to minimize the gl cost of switching shader
-    // 3. camera distance last to minimize overdraw
-    std::sort(render_data_vector.begin(), render_data_vector.end(),
-            compareRenderDataByOrderShaderDistance);
+    // 3. material and render states to minimize state changes
+    // 4. camera distance last to minimize overdraw
+    radix_sort(render_list, camera_position, buffers);
 
     if (DEBUG_RENDERER) {
         LOGD("SORTING: After sorting");
 
-        for (int i = 0; i < render_data_vector.size(); ++i) {
-            RenderData* renderData = render_data_vector[i];
+        for (int i = 0; i < render_list.size(); ++i) {
+            RenderData* renderData = render_list[i];
 
             if (DEBUG_RENDERER) {
                 LOGD(
                         "SORTING: pass_count = %d, rendering order = %d, shader_type = %d, camera_distance = %f\n",
                         renderData->pass_count(), renderData->rendering_order(),
                         renderData->material(0)->shader_type(),
-                        renderData->camera_distance());
+                        camera_distance(renderData, camera_position));
             }
         }
     }
@@ -149,6 +184,7 @@ void Renderer::state_sort() {
 /**
     This function compares passes of render-data
     it checks whether no of passes are equal and then material and cull_status of each pass
+    single pass render-data may differ in the atlas layer of their material, see Material::batchEquals
 
 */
 bool isRenderPassEqual(RenderData* rdata1, RenderData* rdata2){
@@ -158,6 +194,10 @@ bool isRenderPassEqual(RenderData* rdata1, RenderData* rdata2){
     if(pass_count1 != pass_count2)
         return false;
 
+    if(pass_count1 == 1){
+        return rdata1->material(0)->batchEquals(*rdata2->material(0)) &&
+                rdata1->cull_face(0) == rdata2->cull_face(0);
+    }
     for(int i=0; i< pass_count1; i++){
         if(!(rdata1->material(i) == rdata2->material(i) && rdata1->material(i)->shader_type() == rdata2->material(i)->shader_type() &&
                    rdata1->cull_face(i) == rdata2->cull_face(i)))
@@ -166,6 +206,10 @@ bool isRenderPassEqual(RenderData* rdata1, RenderData* rdata2){
     return true;
 }
 
+/*
+ * Cull the main view and the views of all the shadow maps in parallel.
+ * The shadow maps pick up their render data in cullAndRender.
+ */
 void Renderer::cull(Scene *scene, Camera *camera,
         ShaderManager* shader_manager) {
 
@@ -173,16 +217,156 @@ void Renderer::cull(Scene *scene, Camera *camera,
             || camera->owner_object()->transform() == nullptr) {
         return;
     }
-    cullFromCamera(scene, camera, shader_manager);
+    if (nullptr == job_queue_) {
+        job_queue_ = new JobQueue();
+    }
+    SceneObject::applyPendingEdits();
+    VertexBoneData::skinAll(*job_queue_);
+
+    // 1. Update the model matrices and the bounds once for all the views
+    //    of this frame, then set up the views on the GL thread
+    const std::vector<Light*>& lights = scene->getLightList();
+    int num_shadow_views = 0;
+
+    prepared_scenes_.clear();
+    prepareCull(scene, std::max(lights.size(), shadow_views_.size()) + 2);
+    setupView(main_view_, camera, nullptr, true, false);
+    for (auto it = lights.begin(); it != lights.end(); ++it) {
+        ShadowMap* shadow_map = (*it)->getShadowMap();
+
+        if ((nullptr == shadow_map) || !shadow_map->hasTexture()) {
+            continue;
+        }
+        if (shadow_views_.size() <= num_shadow_views) {
+            shadow_views_.resize(num_shadow_views + 1);
+        }
+        setupView(shadow_views_[num_shadow_views], shadow_map->getCamera(),
+                shadow_map, false, true);
+        ++num_shadow_views;
+    }
+    for (int i = num_shadow_views; i < shadow_views_.size(); ++i) {
+        shadow_views_[i].ready = false;
+    }
+
+    // 2. Cull and sort every view in its own job
+    job_queue_->add([this, scene]() {
+        cullView(scene, main_view_, 0);
+    });
+    for (int i = 0; i < num_shadow_views; ++i) {
+        job_queue_->add([this, scene, i]() {
+            cullView(scene, shadow_views_[i], i + 1);
+        });
+    }
+    job_queue_->wait();
 
-    // Note: this needs to be scaled to sort on N states
-    state_sort();
+    // 3. Occlusion queries need GL so they are issued here
+    render_data_vector.clear();
+    if (scene->get_occlusion_culling() && !scene->get_software_occlusion()) {
+        occlusion_cull(scene, main_view_.scene_objects, shader_manager,
+                main_view_.vp_matrix);
+        state_sort();
+    } else {
+        render_data_vector.swap(main_view_.render_data);
+    }
+    main_view_.ready = false;
 
     if(do_batching && !gRenderer->isVulkanInstace()){
         batch_manager->batchSetup(render_data_vector);
     }
 }
 
+void Renderer::setupView(RenderView& view, Camera* camera,
+        RenderTarget* render_target, bool main_view, bool shadow_map) {
+    glm::mat4 view_matrix = camera->getViewMatrix();
+    glm::mat4 projection_matrix = camera->getProjectionMatrix();
+
+    view.render_target = render_target;
+    view.main_view = main_view;
+    view.shadow_map = shadow_map;
+    view.ready = false;
+    view.vp_matrix = projection_matrix * view_matrix;
+    view.camera_position = glm::vec3(view_matrix[3]);
+    build_frustum(view.frustum, (const float*) glm::value_ptr(view.vp_matrix));
+}
+
+void Renderer::prepareCull(Scene* scene, int view_count) {
+    SceneObject* root = scene->getRoot();
+
+    prepared_scenes_.push_back(scene);
+    scene->getTransformList().update(root, job_queue_);
+
+    // the collider index refits the objects whose bounds are still dirty
+    scene->updateColliderIndex();
+
+    // recompute the dirty bounding volumes now, the cull jobs only read them
+    scene->getTransformList().refitBounds();
+    if (scene->get_flat_culling()) {
+        scene->getCullList().update(root, view_count);
+    }
+}
+
+void Renderer::cullView(Scene* scene, RenderView& view, int view_index) {
+    view.scene_objects.clear();
+    view.render_data.clear();
+
+    if (scene->get_flat_culling()) {
+        scene->getCullList().cull(view_index, view.frustum,
+                scene->get_frustum_culling(), view.main_view,
+                view.scene_objects);
+    } else {
+        frustum_cull(view.camera_position, scene->getRoot(), view.frustum,
+                view.scene_objects, scene->get_frustum_culling(), 0,
+                view.main_view);
+    }
+
+    if (view.main_view) {
+        // with occlusion queries the render data is gathered on the GL thread
+        if (scene->get_occlusion_culling()) {
+            if (!scene->get_software_occlusion()) {
+                view.ready = true;
+                return;
+            }
+            softwareOcclusionCull(view.vp_matrix, view.scene_objects);
+        }
+        scene->lockColliders();
+        scene->clearVisibleColliders();
+        for (auto it = view.scene_objects.begin();
+                it != view.scene_objects.end(); ++it) {
+            addRenderData((*it)->render_data(), view.render_data);
+            scene->pick(*it);
+        }
+        scene->unlockColliders();
+    } else {
+        for (auto it = view.scene_objects.begin();
+                it != view.scene_objects.end(); ++it) {
+            RenderData* render_data = (*it)->render_data();
+
+            if (!view.shadow_map
+                    || ((nullptr != render_data) && render_data->cast_shadows())) {
+                addRenderData(render_data, view.render_data);
+            }
+        }
+    }
+    if (!view.shadow_map) {
+        state_sort(view.render_data, view.camera_position, view.sort_buffers);
+    }
+    view.ready = true;
+}
+
+bool Renderer::isCullPrepared(Scene* scene) const {
+    return std::find(prepared_scenes_.begin(), prepared_scenes_.end(), scene)
+            != prepared_scenes_.end();
+}
+
+RenderView* Renderer::findView(RenderTarget* render_target) {
+    for (auto it = shadow_views_.begin(); it != shadow_views_.end(); ++it) {
+        if (it->ready && (it->render_target == render_target)) {
+            return &(*it);
+        }
+    }
+    return nullptr;
+}
+
 /*
  * Perform view frustum culling from a specific camera viewpoint
  */
@@ -210,28 +394,58 @@ void Renderer::cullFromCamera(Scene *scene, Camera* camera,
         LOGD("FRUSTUM: start frustum culling for root %s\n", object->name().c_str());
     }
     //    frustum_cull(camera->owner_object()->transform()->position(), object, frustum, scene_objects, scene->get_frustum_culling(), 0);
-    frustum_cull(campos, object, frustum, scene_objects, scene->get_frustum_culling(), 0);
+    if (!isCullPrepared(scene)) {
+        prepareCull(scene, 1);
+    }
+    if (scene->get_flat_culling()) {
+        scene->getCullList().cull(0, frustum, scene->get_frustum_culling(), true, scene_objects);
+    } else {
+        frustum_cull(campos, object, frustum, scene_objects, scene->get_frustum_culling(), 0, true);
+    }
     if (DEBUG_RENDERER) {
         LOGD("FRUSTUM: end frustum culling for root %s\n", object->name().c_str());
     }
     // 3. do occlusion culling, if enabled
+    if (scene->get_occlusion_culling() && scene->get_software_occlusion()) {
+        softwareOcclusionCull(vp_matrix, scene_objects);
+    }
     occlusion_cull(scene, scene_objects, shader_manager, vp_matrix);
 }
 
+/*
+ * Drop the objects hidden by the occluders. Only called for the main
+ * view, so a single depth buffer is enough.
+ */
+void Renderer::softwareOcclusionCull(const glm::mat4& vp_matrix,
+        std::vector<SceneObject*>& scene_objects) {
+    if (nullptr == software_culler_) {
+        software_culler_ = new SoftwareOcclusionCuller();
+    }
+    software_culler_->cull(vp_matrix, scene_objects);
+    if (DEBUG_RENDERER) {
+        LOGD("OCCLUSION: %d occluder triangles hide %d objects\n",
+                software_culler_->occluder_triangles(),
+                software_culler_->occluded_count());
+    }
+}
+
 
 void Renderer::renderRenderDataVector(RenderState &rstate) {
 
     if (!do_batching || gRenderer->isVulkanInstace() ) {
-        for (auto it = render_data_vector.begin();
-                it != render_data_vector.end(); ++it) {
-            GL(renderRenderData(rstate, *it));
-        }
+        renderRenderDataList(rstate, render_data_vector.data(),
+                render_data_vector.size());
     } else {
          batch_manager->renderBatches(rstate);
     }
 }
 
 void Renderer::addRenderData(RenderData *render_data) {
+    addRenderData(render_data, render_data_vector);
+}
+
+void Renderer::addRenderData(RenderData *render_data,
+        std::vector<RenderData*>& render_list) {
     if (render_data == 0 || render_data->material(0) == 0 || !render_data->enabled()) {
         return;
     }
@@ -244,7 +458,7 @@ void Renderer::addRenderData(RenderData *render_data) {
         return;
     }
 
-    render_data_vector.push_back(render_data);
+    render_list.push_back(render_data);
     return;
 }
 
@@ -252,7 +466,8 @@ bool Renderer::occlusion_cull_init(Scene* scene, std::vector<SceneObject*>& scen
 
     scene->lockColliders();
     scene->clearVisibleColliders();
-    bool do_culling = scene->get_occlusion_culling();
+    bool do_culling = scene->get_occlusion_culling()
+            && !scene->get_software_occlusion();
     if (!do_culling) {
         for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
             SceneObject *scene_object = (*it);
@@ -407,15 +622,94 @@ void Renderer::renderRenderData(RenderState& rstate, RenderData* render_data) {
     if (!(rstate.render_mask & render_data->render_mask()))
         return;
 
-    // Set the states
+    // Set the states, redundant changes are dropped by the state cache
     setRenderStates(render_data, rstate);
     if (render_data->mesh() != 0) {
         GL(renderMesh(rstate, render_data));
     }
-    // Restoring to Default.
-    // TODO: There's a lot of redundant state changes. If on every render face culling is being set there's no need to
-    // restore defaults. Possibly later we could add a OpenGL state wrapper to avoid redundant api calls.
-    restoreRenderStates(render_data);
+}
+
+/*
+ * Render data can be drawn together if only the scene object and the
+ * distance differ.
+ */
+static bool sameInstanceState(RenderData* a, RenderData* b) {
+    if ((a->rendering_order() != b->rendering_order())
+            || (a->pass_count() != b->pass_count())
+            || (a->getHashCode() != b->getHashCode())) {
+        return false;
+    }
+    for (int i = 0; i < a->pass_count(); ++i) {
+        if ((a->pass(i)->material() != b->pass(i)->material())
+                || (a->pass(i)->cull_face() != b->pass(i)->cull_face())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool compareByMesh(RenderData* a, RenderData* b) {
+    return a->mesh() < b->mesh();
+}
+
+void Renderer::renderRenderDataList(RenderState& rstate, RenderData* const* render_list,
+        int count) {
+    for (int i = 0; i < count;) {
+        RenderData* render_data = render_list[i];
+
+        if ((rstate.shadow_map && !render_data->cast_shadows())
+                || !(rstate.render_mask & render_data->render_mask())) {
+            ++i;
+            continue;
+        }
+        if (!supportsInstancing(rstate, render_data)) {
+            GL(renderRenderData(rstate, render_data));
+            ++i;
+            continue;
+        }
+
+        // gather the run of render data with the same state, transparent
+        // objects only if they also share the mesh so the order is kept
+        bool transparent = render_data->rendering_order() >= RenderData::Transparent;
+        instance_list_.clear();
+        instance_list_.push_back(render_data);
+        for (++i; i < count; ++i) {
+            RenderData* next = render_list[i];
+
+            if ((rstate.shadow_map && !next->cast_shadows())
+                    || !(rstate.render_mask & next->render_mask())) {
+                continue;
+            }
+            // the mesh decides too, skinned meshes are never instanced
+            if (!sameInstanceState(render_data, next)
+                    || (transparent && (next->mesh() != render_data->mesh()))
+                    || !supportsInstancing(rstate, next)) {
+                break;
+            }
+            instance_list_.push_back(next);
+        }
+        if (!transparent) {
+            std::stable_sort(instance_list_.begin(), instance_list_.end(), compareByMesh);
+        }
+
+        // one draw per mesh
+        RenderData** first = instance_list_.data();
+        RenderData** end = first + instance_list_.size();
+        while (first < end) {
+            RenderData** last = first + 1;
+            while ((last < end) && ((*last)->mesh() == (*first)->mesh())) {
+                ++last;
+            }
+            renderInstances(rstate, first, last - first);
+            first = last;
+        }
+    }
+}
+
+void Renderer::renderInstances(RenderState& rstate, RenderData* const* render_datas, int count) {
+    for (int i = 0; i < count; ++i) {
+        GL(renderRenderData(rstate, render_datas[i]));
+    }
 }
 
 void Renderer::renderPostEffectData(Camera* camera,
@@ -30,6 +30,7 @@
 #include "objects/eye_type.h"
 #include "objects/mesh.h"
 #include "objects/bounding_volume.h"
+#include "objects/components/render_data.h"
 #include "gl/gl_program.h"
 #include <unordered_map>
 #include "batch_manager.h"
@@ -47,6 +48,8 @@ class RenderTarget;
 class RenderTexture;
 class ShaderManager;
 class Light;
+class JobQueue;
+class SoftwareOcclusionCuller;
 
 /*
  * These uniforms are commonly used in shaders.
@@ -80,11 +83,46 @@ struct RenderState {
     ShaderUniformsPerObject uniforms;
     ShaderManager*          shader_manager;
     bool shadow_map;
+    int                     instance_count = 0; // > 0 while drawing instances
+};
+
+/*
+ * Buffers of the radix sort in Renderer::state_sort. Each view keeps
+ * its own so the views can be sorted in parallel, and sorting stops
+ * allocating once they have grown to the size of the render list.
+ */
+struct SortBuffers {
+    struct Entry {
+        RenderData::SortKey key;
+        RenderData* render_data;
+    };
+    std::vector<Entry>          entries;
+    std::vector<Entry>          scratch;
+    std::vector<unsigned int>   counts;
+};
+
+/*
+ * The objects visible from one viewpoint and the render data to draw
+ * for them. Each view is culled by its own job so several views can be
+ * culled in parallel. The main view is culled from the center camera
+ * and drawn for both eyes, the other views belong to a render target.
+ */
+struct RenderView {
+    RenderTarget*               render_target;  // nullptr for the main view
+    bool                        main_view;
+    bool                        shadow_map;
+    bool                        ready;          // culled but not rendered yet
+    glm::mat4                   vp_matrix;
+    glm::vec3                   camera_position;
+    float                       frustum[6][4];
+    std::vector<SceneObject*>   scene_objects;
+    std::vector<RenderData*>    render_data;
+    SortBuffers                 sort_buffers;
 };
 
 class Renderer {
 public:
-    void resetStats() {
+    virtual void resetStats() {
         numberDrawCalls = 0;
         numberTriangles = 0;
     }
@@ -101,6 +139,21 @@ public:
      int getNumberTriangles() {
         return numberTriangles;
      }
+
+     // render state changes sent to the driver and the redundant ones skipped
+     virtual int getNumberStateChanges() {
+        return 0;
+     }
+     virtual int getNumberSkippedStateChanges() {
+        return 0;
+     }
+     // GPU memory of the textures tracked for eviction
+     virtual int getTextureMemoryKB() {
+        return 0;
+     }
+     virtual int getNumberTexturesEvicted() {
+        return 0;
+     }
      int incrementTriangles(int number=1){
         return numberTriangles += number;
      }
@@ -118,6 +171,13 @@ public:
             ShaderManager* shader_manager);
      virtual void renderRenderData(RenderState& rstate, RenderData* render_data);
 
+     /*
+      * Render a list of render data, drawing the render data which share
+      * a mesh and materials with one instanced draw call where the shader
+      * supports it.
+      */
+     void renderRenderDataList(RenderState& rstate, RenderData* const* render_list, int count);
+
 
      virtual void renderCamera(Scene* scene, Camera* camera,
              ShaderManager* shader_manager,
@@ -146,7 +206,7 @@ public:
             RenderTexture* post_effect_render_texture_b) = 0;
     virtual void cullFromCamera(Scene *scene, Camera *camera,
                                 ShaderManager* shader_manager);
-    virtual void restoreRenderStates(RenderData* render_data) = 0;
+    virtual void restoreRenderStates() = 0;
     virtual void setRenderStates(RenderData* render_data, RenderState& rstate) = 0;
     virtual void cullAndRender(RenderTarget* renderTarget, Scene* scene,
                         ShaderManager* shader_manager, PostEffectShaderManager* post_effect_shader_manager,
@@ -157,9 +217,6 @@ public:
 private:
     static bool isVulkan_;
     virtual void build_frustum(float frustum[6][4], const float *vp_matrix);
-    virtual void frustum_cull(glm::vec3 camera_position, SceneObject *object,
-            float frustum[6][4], std::vector<SceneObject*>& scene_objects,
-            bool continue_cull, int planeMask);
 
     virtual bool isShader3d(const Material* curr_material);
     virtual bool isDefaultPosition3d(const Material* curr_material);
@@ -169,31 +226,92 @@ private:
     Renderer& operator=(const Renderer& render_engine);
     Renderer& operator=(Renderer&& render_engine);
     BatchManager* batch_manager;
+    JobQueue* job_queue_;
+    SoftwareOcclusionCuller* software_culler_;
     static Renderer* instance;
     
 protected:
     Renderer();
-    virtual ~Renderer(){
-        delete batch_manager;
-    }
+    virtual ~Renderer();
     virtual void state_sort();
+    void state_sort(std::vector<RenderData*>& render_list,
+            const glm::vec3& camera_position, SortBuffers& buffers);
     virtual void renderMesh(RenderState& rstate, RenderData* render_data) = 0;
     virtual void renderMaterialShader(RenderState& rstate, RenderData* render_data, Material *material) = 0;
     virtual void occlusion_cull(Scene* scene,
                 std::vector<SceneObject*>& scene_objects,
                 ShaderManager *shader_manager, glm::mat4 vp_matrix) = 0;
+
+    /*
+     * Returns true if all the passes of the render data use shaders
+     * which support instancing.
+     */
+    virtual bool supportsInstancing(RenderState& rstate, RenderData* render_data) {
+        return false;
+    }
+
+    /*
+     * Draw render data sharing the same mesh, materials and render
+     * states at once.
+     */
+    virtual void renderInstances(RenderState& rstate, RenderData* const* render_datas, int count);
     void addRenderData(RenderData *render_data);
+    void addRenderData(RenderData *render_data,
+            std::vector<RenderData*>& render_list);
     virtual bool occlusion_cull_init(Scene* scene, std::vector<SceneObject*>& scene_objects);
 
+    /*
+     * Compute the frustum of a view on the GL thread.
+     */
+    void setupView(RenderView& view, Camera* camera,
+            RenderTarget* render_target, bool main_view, bool shadow_map);
+
+    /*
+     * Update the model matrices, the bounding volumes and the cull list
+     * of the scene so that view_count views can be culled concurrently.
+     * Done once a frame per scene, the cull jobs only read the results.
+     */
+    void prepareCull(Scene* scene, int view_count);
+
+    /*
+     * Returns true if prepareCull has been called for the scene
+     * since the last Renderer::cull.
+     */
+    bool isCullPrepared(Scene* scene) const;
+
+    /*
+     * Cull a view set up by setupView and gather its render data.
+     * Does not call GL, runs on the job queue.
+     */
+    void cullView(Scene* scene, RenderView& view, int view_index);
+
+    /*
+     * Remove the objects hidden by the occluders from scene_objects
+     * using the CPU depth buffer. Does not call GL.
+     */
+    void softwareOcclusionCull(const glm::mat4& vp_matrix,
+            std::vector<SceneObject*>& scene_objects);
+
+    /*
+     * Returns the view culled for the render target this frame
+     * which has not been rendered yet, or nullptr.
+     */
+    RenderView* findView(RenderTarget* render_target);
+
     virtual void
             renderPostEffectData(Camera* camera,
             RenderTexture* render_texture, PostEffectData* post_effect_data,
             PostEffectShaderManager* post_effect_shader_manager);
 
     std::vector<RenderData*> render_data_vector;
+    RenderView main_view_;
+    std::vector<RenderView> shadow_views_;
+    RenderView target_view_;
+    std::vector<Scene*> prepared_scenes_;
     int numberDrawCalls;
     int numberTriangles;
     bool useStencilBuffer_ = false;
+    std::vector<RenderData*> instance_list_;
 
 public:
     //to be used only on the gl thread
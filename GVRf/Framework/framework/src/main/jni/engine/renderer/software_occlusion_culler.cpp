@@ -0,0 +1,287 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Occlusion culling against a depth buffer rasterized on the CPU.
+ ***************************************************************************/
+
+#include "software_occlusion_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "objects/bounding_volume.h"
+#include "objects/mesh.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "objects/components/transform.h"
+
+#include "util/gvr_simd.h"
+
+namespace gvr {
+
+using namespace simd;
+
+SoftwareOcclusionCuller::SoftwareOcclusionCuller(int width, int height) :
+        width_((std::max(width, 4) + 3) & ~3), height_(std::max(height, 1)),
+        occluder_triangles_(0), occluded_count_(0) {
+    tiles_x_ = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y_ = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+    depth_.assign(width_ * height_, 1.0f);
+    tile_max_.assign(tiles_x_ * tiles_y_, 1.0f);
+}
+
+void SoftwareOcclusionCuller::clear(const glm::mat4& vp_matrix) {
+    vp_matrix_ = vp_matrix;
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+    std::fill(tile_max_.begin(), tile_max_.end(), 1.0f);
+    occluder_triangles_ = 0;
+    occluded_count_ = 0;
+}
+
+void SoftwareOcclusionCuller::drawOccluder(const glm::mat4& model_matrix,
+        const Mesh& mesh) {
+    glm::mat4 mvp(vp_matrix_ * model_matrix);
+
+    if (!mesh.int_indices().empty()) {
+        drawTriangles(mvp, mesh.vertices(), mesh.int_indices());
+    } else {
+        drawTriangles(mvp, mesh.vertices(), mesh.indices());
+    }
+}
+
+template <class Index>
+void SoftwareOcclusionCuller::drawTriangles(const glm::mat4& mvp,
+        const std::vector<glm::vec3>& vertices,
+        const std::vector<Index>& indices) {
+    const float half_width = width_ * 0.5f;
+    const float half_height = height_ * 0.5f;
+
+    screen_.resize(vertices.size());
+    for (int i = 0; i < vertices.size(); ++i) {
+        glm::vec4 clip(mvp * glm::vec4(vertices[i], 1.0f));
+
+        // w = 0 marks a vertex in front of the near plane
+        if ((clip.w <= 0.0f) || (clip.z < -clip.w)) {
+            screen_[i] = glm::vec4(0.0f);
+            continue;
+        }
+        float inv_w = 1.0f / clip.w;
+        screen_[i] = glm::vec4((clip.x * inv_w + 1.0f) * half_width,
+                (clip.y * inv_w + 1.0f) * half_height,
+                (clip.z * inv_w + 1.0f) * 0.5f, 1.0f);
+    }
+
+    for (int i = 0; i + 2 < indices.size(); i += 3) {
+        if (occluder_triangles_ >= MAX_OCCLUDER_TRIANGLES) {
+            return;
+        }
+        if ((indices[i] >= screen_.size()) || (indices[i + 1] >= screen_.size())
+                || (indices[i + 2] >= screen_.size())) {
+            continue;
+        }
+        const glm::vec4& v0 = screen_[indices[i]];
+        const glm::vec4& v1 = screen_[indices[i + 1]];
+        const glm::vec4& v2 = screen_[indices[i + 2]];
+
+        if ((v0.w == 0.0f) || (v1.w == 0.0f) || (v2.w == 0.0f)) {
+            continue;
+        }
+        drawTriangle(glm::vec3(v0), glm::vec3(v1), glm::vec3(v2));
+    }
+}
+
+/*
+ * Half space rasterization with the edge functions evaluated for four
+ * pixel centers at a time. Both windings are drawn.
+ */
+void SoftwareOcclusionCuller::drawTriangle(const glm::vec3& v0,
+        const glm::vec3& w1, const glm::vec3& w2) {
+    float area = (w1.x - v0.x) * (w2.y - v0.y) - (w1.y - v0.y) * (w2.x - v0.x);
+
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    const glm::vec3& v1 = (area > 0.0f) ? w1 : w2;
+    const glm::vec3& v2 = (area > 0.0f) ? w2 : w1;
+    area = std::fabs(area);
+
+    int min_x = std::max(0, (int) std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+    int max_x = std::min(width_ - 1, (int) std::floor(std::max(v0.x, std::max(v1.x, v2.x))));
+    int min_y = std::max(0, (int) std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+    int max_y = std::min(height_ - 1, (int) std::floor(std::max(v0.y, std::max(v1.y, v2.y))));
+
+    if ((min_x > max_x) || (min_y > max_y)) {
+        return;
+    }
+    ++occluder_triangles_;
+
+    // edge function e(x, y) = a * x + b * y + c, positive inside
+    const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = -(a0 * v1.x + b0 * v1.y);
+    const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = -(a1 * v2.x + b1 * v2.y);
+    const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = -(a2 * v0.x + b2 * v0.y);
+
+    // depth plane, biased to the farthest depth within a pixel
+    const float dzdx = (a1 * (v1.z - v0.z) + a2 * (v2.z - v0.z)) / area;
+    const float dzdy = (b1 * (v1.z - v0.z) + b2 * (v2.z - v0.z)) / area;
+    const float max_z = std::max(v0.z, std::max(v1.z, v2.z));
+    const float bias = 0.5f * (std::fabs(dzdx) + std::fabs(dzdy));
+    const float cz = v0.z - dzdx * v0.x - dzdy * v0.y + bias;
+
+    const Lanes zero = splat(0.0f);
+    const Lanes far = splat(max_z);
+    const Lanes la0 = splat(a0), la1 = splat(a1), la2 = splat(a2);
+    const Lanes ldz = splat(dzdx);
+    const int start_x = min_x & ~3;
+
+    for (int y = min_y; y <= max_y; ++y) {
+        const float py = y + 0.5f;
+        const Lanes row0 = splat(b0 * py + c0);
+        const Lanes row1 = splat(b1 * py + c1);
+        const Lanes row2 = splat(b2 * py + c2);
+        const Lanes rowz = splat(dzdy * py + cz);
+        float* depth = &depth_[y * width_];
+
+        for (int x = start_x; x <= max_x; x += 4) {
+            const Lanes px = ramp(x + 0.5f);
+            LaneMask inside = greaterEqual(madd(la0, px, row0), zero);
+            inside = both(inside, greaterEqual(madd(la1, px, row1), zero));
+            inside = both(inside, greaterEqual(madd(la2, px, row2), zero));
+            if (!any(inside)) {
+                continue;
+            }
+            const Lanes z = min(madd(ldz, px, rowz), far);
+            const Lanes old = load(depth + x);
+            store(depth + x, select(inside, min(old, z), old));
+        }
+    }
+}
+
+void SoftwareOcclusionCuller::finish() {
+    for (int ty = 0; ty < tiles_y_; ++ty) {
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            const int end_x = std::min(width_, (tx + 1) * TILE_SIZE);
+            const int end_y = std::min(height_, (ty + 1) * TILE_SIZE);
+            float farthest = 0.0f;
+
+            for (int y = ty * TILE_SIZE; y < end_y; ++y) {
+                const float* depth = &depth_[y * width_];
+                for (int x = tx * TILE_SIZE; x < end_x; ++x) {
+                    farthest = std::max(farthest, depth[x]);
+                }
+            }
+            tile_max_[ty * tiles_x_ + tx] = farthest;
+        }
+    }
+}
+
+bool SoftwareOcclusionCuller::isOccluded(const glm::vec3& min_corner,
+        const glm::vec3& max_corner) const {
+    float min_x = width_, max_x = -1.0f;
+    float min_y = height_, max_y = -1.0f;
+    float min_z = 1.0f;
+
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 corner((i & 1) ? max_corner.x : min_corner.x,
+                (i & 2) ? max_corner.y : min_corner.y,
+                (i & 4) ? max_corner.z : min_corner.z, 1.0f);
+        glm::vec4 clip(vp_matrix_ * corner);
+
+        if ((clip.w <= 0.0f) || (clip.z < -clip.w)) {
+            return false;
+        }
+        float inv_w = 1.0f / clip.w;
+        float x = (clip.x * inv_w + 1.0f) * width_ * 0.5f;
+        float y = (clip.y * inv_w + 1.0f) * height_ * 0.5f;
+
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        min_z = std::min(min_z, (clip.z * inv_w + 1.0f) * 0.5f);
+    }
+
+    // boxes outside of the buffer are left to frustum culling
+    int x0 = std::max(0, (int) std::floor(min_x));
+    int x1 = std::min(width_ - 1, (int) std::floor(max_x));
+    int y0 = std::max(0, (int) std::floor(min_y));
+    int y1 = std::min(height_ - 1, (int) std::floor(max_y));
+    if ((x0 > x1) || (y0 > y1)) {
+        return false;
+    }
+
+    const Lanes box_z = splat(min_z);
+    for (int ty = y0 / TILE_SIZE; ty <= y1 / TILE_SIZE; ++ty) {
+        for (int tx = x0 / TILE_SIZE; tx <= x1 / TILE_SIZE; ++tx) {
+            if (min_z > tile_max_[ty * tiles_x_ + tx]) {
+                continue;
+            }
+
+            // some pixels of the tile may be in front, check those inside the box
+            const int px0 = std::max(x0, tx * TILE_SIZE);
+            const int px1 = std::min(x1, tx * TILE_SIZE + TILE_SIZE - 1);
+            const int py0 = std::max(y0, ty * TILE_SIZE);
+            const int py1 = std::min(y1, ty * TILE_SIZE + TILE_SIZE - 1);
+            const Lanes first = splat(px0);
+            const Lanes last = splat(px1);
+
+            for (int y = py0; y <= py1; ++y) {
+                const float* depth = &depth_[y * width_];
+                for (int x = px0 & ~3; x <= px1; x += 4) {
+                    const Lanes px = ramp(x);
+                    LaneMask visible = both(greaterEqual(px, first),
+                            greaterEqual(last, px));
+                    visible = both(visible, greaterEqual(load(depth + x), box_z));
+                    if (any(visible)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void SoftwareOcclusionCuller::cull(const glm::mat4& vp_matrix,
+        std::vector<SceneObject*>& scene_objects) {
+    clear(vp_matrix);
+    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
+        RenderData* render_data = (*it)->render_data();
+
+        if ((nullptr != render_data) && render_data->occluder()
+                && (nullptr != render_data->mesh()) && (nullptr != (*it)->transform())) {
+            drawOccluder((*it)->transform()->getModelMatrix(), *render_data->mesh());
+        }
+    }
+    if (0 == occluder_triangles_) {
+        return;
+    }
+    finish();
+
+    auto end = std::remove_if(scene_objects.begin(), scene_objects.end(),
+            [this](SceneObject* scene_object) {
+                RenderData* render_data = scene_object->render_data();
+
+                if ((nullptr == render_data) || render_data->occluder()) {
+                    return false;
+                }
+                const BoundingVolume& bv = scene_object->getMeshBoundingVolume();
+                return isOccluded(bv.min_corner(), bv.max_corner());
+            });
+    occluded_count_ = scene_objects.end() - end;
+    scene_objects.erase(end, scene_objects.end());
+}
+
+}
@@ -0,0 +1,139 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Occlusion culling against a depth buffer rasterized on the CPU.
+ ***************************************************************************/
+
+#ifndef SOFTWARE_OCCLUSION_CULLER_H_
+#define SOFTWARE_OCCLUSION_CULLER_H_
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace gvr {
+class Mesh;
+class SceneObject;
+
+/*
+ * Rasterizes the meshes of the render data marked as occluders
+ * (RenderData::occluder) into a small depth buffer and removes the
+ * objects whose world space mesh bounds are behind it.
+ *
+ * Pixels are covered when their center is inside a triangle and store
+ * the farthest depth of the triangle within the pixel, boxes are tested
+ * with their nearest depth against every pixel they touch. Triangles
+ * crossing the near plane are skipped and boxes crossing it are always
+ * visible, so the test errs on the side of drawing.
+ *
+ * Does not call GL, so it can run on a worker thread. One instance must
+ * only be used by one thread at a time.
+ */
+class SoftwareOcclusionCuller {
+public:
+    static const int DEFAULT_WIDTH = 256;
+    static const int DEFAULT_HEIGHT = 128;
+    // occluder triangles rasterized per frame at most
+    static const int MAX_OCCLUDER_TRIANGLES = 32 * 1024;
+
+    /*
+     * The width is rounded up to a multiple of four.
+     */
+    SoftwareOcclusionCuller(int width = DEFAULT_WIDTH,
+            int height = DEFAULT_HEIGHT);
+
+    /*
+     * Rasterize the occluders among scene_objects and remove the objects
+     * they hide. Occluders are never removed.
+     */
+    void cull(const glm::mat4& vp_matrix,
+            std::vector<SceneObject*>& scene_objects);
+
+    /*
+     * Start a new depth buffer for the given view projection matrix.
+     */
+    void clear(const glm::mat4& vp_matrix);
+
+    /*
+     * Rasterize the triangles of a mesh with the given model matrix.
+     */
+    void drawOccluder(const glm::mat4& model_matrix, const Mesh& mesh);
+
+    /*
+     * Compute the farthest depth of every tile. Must be called after
+     * the occluders have been drawn and before testing.
+     */
+    void finish();
+
+    /*
+     * Returns true if the world space box is entirely behind the occluders.
+     */
+    bool isOccluded(const glm::vec3& min_corner,
+            const glm::vec3& max_corner) const;
+
+    int width() const {
+        return width_;
+    }
+
+    int height() const {
+        return height_;
+    }
+
+    /*
+     * Depth of the pixels in [0, 1], row by row, 1 where nothing was drawn.
+     */
+    const std::vector<float>& depth() const {
+        return depth_;
+    }
+
+    int occluder_triangles() const {
+        return occluder_triangles_;
+    }
+
+    int occluded_count() const {
+        return occluded_count_;
+    }
+
+private:
+    SoftwareOcclusionCuller(const SoftwareOcclusionCuller& culler);
+    SoftwareOcclusionCuller(SoftwareOcclusionCuller&& culler);
+    SoftwareOcclusionCuller& operator=(const SoftwareOcclusionCuller& culler);
+    SoftwareOcclusionCuller& operator=(SoftwareOcclusionCuller&& culler);
+
+    static const int TILE_SIZE = 8;
+
+    template <class Index>
+    void drawTriangles(const glm::mat4& mvp,
+            const std::vector<glm::vec3>& vertices,
+            const std::vector<Index>& indices);
+    void drawTriangle(const glm::vec3& v0, const glm::vec3& v1,
+            const glm::vec3& v2);
+
+    int width_;
+    int height_;
+    int tiles_x_;
+    int tiles_y_;
+    glm::mat4 vp_matrix_;
+    std::vector<float> depth_;
+    std::vector<float> tile_max_;
+    // vertices of the current occluder in screen space, z in [0, 1]
+    std::vector<glm::vec4> screen_;
+    int occluder_triangles_;
+    int occluded_count_;
+};
+
+}
+#endif
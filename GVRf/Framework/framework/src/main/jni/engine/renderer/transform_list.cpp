@@ -0,0 +1,200 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Flattened copy of the transform hierarchy of a scene.
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "transform_list.h"
+#include "job_queue.h"
+
+#include "objects/scene_object.h"
+#include "objects/components/transform.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+TransformList::TransformList() :
+        version_(0), built_(false), updated_count_(0), refit_count_(0) {
+}
+
+void TransformList::append(SceneObject* object, int parent) {
+    int index = transforms_.size();
+
+    objects_.push_back(object);
+    transforms_.push_back(object->transform());
+    parents_.push_back(parent);
+    subtree_end_.push_back(0);
+
+    const std::vector<SceneObject*>& children = object->children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        append(*it, index);
+    }
+    subtree_end_[index] = transforms_.size();
+}
+
+/*
+ * Flatten the scene graph in depth first order.
+ * Only called when the hierarchy has changed.
+ */
+void TransformList::rebuild(SceneObject* root) {
+    objects_.clear();
+    transforms_.clear();
+    parents_.clear();
+    subtree_end_.clear();
+    append(root, -1);
+    invalid_.resize((transforms_.size() + 31) / 32);
+    built_ = true;
+
+    if (DEBUG_RENDERER) {
+        LOGD("TRANSFORM: rebuilt transform list with %d objects\n", size());
+    }
+}
+
+/*
+ * Collect the transforms whose model matrix is invalid.
+ * Returns how many there are.
+ */
+int TransformList::markInvalid() {
+    int count = 0;
+
+    std::fill(invalid_.begin(), invalid_.end(), 0);
+    for (int i = 0; i < transforms_.size(); ++i) {
+        Transform* t = transforms_[i];
+
+        if ((nullptr != t) && !t->isModelMatrixValid()) {
+            invalid_[i >> 5] |= 1u << (i & 31);
+            ++count;
+        }
+    }
+    return count;
+}
+
+/*
+ * Recompute the invalid model matrices in [first, end). The parent of
+ * each transform in the range must be in the range or already updated.
+ * Like Transform::getModelMatrix, objects whose parent has no
+ * transform are left alone.
+ */
+void TransformList::updateRange(int first, int end) {
+    if (first >= end) {
+        return;
+    }
+    const int last_word = (end - 1) >> 5;
+
+    for (int word = first >> 5; word <= last_word; ++word) {
+        unsigned int bits = invalid_[word];
+
+        if (word == (first >> 5)) {
+            bits &= ~0u << (first & 31);
+        }
+        if (word == last_word) {
+            bits &= ~0u >> (31 - ((end - 1) & 31));
+        }
+        while (0 != bits) {
+            const int i = (word << 5) + __builtin_ctz(bits);
+            const int parent = parents_[i];
+            bits &= bits - 1;
+
+            if (parent < 0) {
+                transforms_[i]->updateModelMatrix(nullptr);
+            } else if (nullptr != transforms_[parent]) {
+                transforms_[i]->updateModelMatrix(
+                        &transforms_[parent]->cachedModelMatrix());
+            }
+        }
+    }
+}
+
+/*
+ * Objects with a single child are updated first. The subtrees below
+ * the first object with several children do not depend on each other
+ * and are grouped into ranges of similar size, one job each.
+ */
+void TransformList::updateParallel(JobQueue* job_queue) {
+    const int size = transforms_.size();
+    int top = 0;
+
+    while ((top + 1 < size) && (subtree_end_[top + 1] == subtree_end_[top])) {
+        ++top;
+    }
+    updateRange(0, top + 1);
+
+    // MIN_JOB_SIZE is only declared, so it must not be bound to a reference
+    int job_size = (size - top - 1) / (2 * job_queue->thread_count() + 1);
+    if (job_size < MIN_JOB_SIZE) {
+        job_size = MIN_JOB_SIZE;
+    }
+    int first = top + 1;
+
+    for (int child = top + 1; child < size; child = subtree_end_[child]) {
+        const int end = subtree_end_[child];
+
+        if ((end - first >= job_size) || (end == size)) {
+            job_queue->add([this, first, end]() {
+                updateRange(first, end);
+            });
+            first = end;
+        }
+    }
+    job_queue->wait();
+}
+
+void TransformList::update(SceneObject* root, JobQueue* job_queue) {
+    unsigned int version = SceneObject::hierarchyVersion();
+
+    if (!built_ || (version != version_)) {
+        version_ = version;
+        rebuild(root);
+    }
+    updated_count_ = markInvalid();
+    if (0 == updated_count_) {
+        return;
+    }
+    if ((nullptr != job_queue) && (job_queue->thread_count() > 0)
+            && (updated_count_ >= PARALLEL_THRESHOLD)) {
+        updateParallel(job_queue);
+    } else {
+        updateRange(0, transforms_.size());
+    }
+}
+
+/*
+ * A dirty object always has dirty ancestors, so the dirty objects are
+ * found top down by skipping the subtrees of the clean ones, then
+ * recomputed in reverse.
+ */
+void TransformList::refitBounds() {
+    const int size = objects_.size();
+
+    dirty_bounds_.clear();
+    for (int i = 0; i < size;) {
+        if (objects_[i]->isBoundingVolumeDirty()) {
+            dirty_bounds_.push_back(i);
+            ++i;
+        } else {
+            i = subtree_end_[i];
+        }
+    }
+    for (auto it = dirty_bounds_.rbegin(); it != dirty_bounds_.rend(); ++it) {
+        objects_[*it]->getBoundingVolume();
+    }
+    refit_count_ = dirty_bounds_.size();
+}
+
+}
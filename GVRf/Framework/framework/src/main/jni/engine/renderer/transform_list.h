@@ -0,0 +1,121 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Flattened copy of the transform hierarchy of a scene.
+ ***************************************************************************/
+
+#ifndef TRANSFORM_LIST_H_
+#define TRANSFORM_LIST_H_
+
+#include <vector>
+
+namespace gvr {
+class JobQueue;
+class SceneObject;
+class Transform;
+
+/*
+ * Keeps the transforms of a scene in depth first order, so that every
+ * parent comes before its children, together with the index of each
+ * parent. Once per frame the transforms whose model matrix was
+ * invalidated are collected into a bitset and recomputed in a single
+ * linear pass from the already updated matrix of their parent, instead
+ * of recursing up the hierarchy from every caller of getModelMatrix.
+ *
+ * The model matrices stay cached in the Transform components, so the
+ * Transform API is unchanged and still computes them on demand for
+ * transforms which moved since the last update.
+ *
+ * The same order is used to refit the hierarchical bounding volumes
+ * bottom up, visiting only the objects whose bounds are dirty.
+ *
+ * The arrays are only rebuilt when SceneObject::hierarchyVersion()
+ * changes. update() and refitBounds() must be called on the GL thread.
+ */
+class TransformList {
+public:
+    TransformList();
+
+    /*
+     * Recompute the invalid model matrices of the transforms under
+     * root. If a job queue is given and many transforms moved,
+     * independent subtrees are updated by several jobs.
+     */
+    void update(SceneObject* root, JobQueue* job_queue);
+
+    /*
+     * Recompute the dirty hierarchical bounding volumes, children
+     * before their parents so that none of them recurses. Subtrees
+     * whose root is clean are skipped as a whole. Call after update().
+     */
+    void refitBounds();
+
+    int size() const {
+        return transforms_.size();
+    }
+
+    /*
+     * Number of model matrices recomputed by the last update.
+     */
+    int updated_count() const {
+        return updated_count_;
+    }
+
+    /*
+     * Number of bounding volumes recomputed by the last refitBounds.
+     */
+    int refit_count() const {
+        return refit_count_;
+    }
+
+private:
+    TransformList(const TransformList& transform_list);
+    TransformList(TransformList&& transform_list);
+    TransformList& operator=(const TransformList& transform_list);
+    TransformList& operator=(TransformList&& transform_list);
+
+    // below this many invalid transforms the update is not split up
+    static const int PARALLEL_THRESHOLD = 2048;
+    // fewest transforms handed to one job
+    static const int MIN_JOB_SIZE = 512;
+
+    void rebuild(SceneObject* root);
+    void append(SceneObject* object, int parent);
+    int markInvalid();
+    void updateRange(int first, int end);
+    void updateParallel(JobQueue* job_queue);
+
+    unsigned int version_;
+    bool built_;
+    int updated_count_;
+    int refit_count_;
+
+    std::vector<SceneObject*> objects_;
+    // null for scene objects without a transform
+    std::vector<Transform*> transforms_;
+    // index of the parent, -1 for the root
+    std::vector<int> parents_;
+    // index one past the last descendant of each object
+    std::vector<int> subtree_end_;
+    // one bit per transform whose model matrix is invalid
+    std::vector<unsigned int> invalid_;
+    // objects with dirty bounds found by the last refitBounds
+    std::vector<int> dirty_bounds_;
+};
+
+}
+#endif
@@ -83,7 +83,7 @@ public:
              PostEffectShaderManager* post_effect_shader_manager,
              RenderTexture* post_effect_render_texture_a,
              RenderTexture* post_effect_render_texture_b){}
-    void restoreRenderStates(RenderData* render_data){}
+    void restoreRenderStates(){}
     void setRenderStates(RenderData* render_data, RenderState& rstate){}
     virtual void cullAndRender(RenderTarget* renderTarget, Scene* scene,
                         ShaderManager* shader_manager, PostEffectShaderManager* post_effect_shader_manager,
@@ -20,7 +20,11 @@
 #ifndef GL_PROGRAM_H_
 #define GL_PROGRAM_H_
 
+#include <string>
+
 #include "gl/gl_headers.h"
+#include "gl/gl_state.h"
+#include "gl/gl_uniform_block.h"
 
 #include "util/gvr_log.h"
 #include "util/gvr_gl.h"
@@ -38,6 +42,7 @@ public:
         id_ = createProgram(1, &pVertexSourceStrings,
                 vertex_shader_string_lengths, &pFragmentSourceStrings,
                 fragment_shader_string_lengths);
+        instance_location_ = findInstanceLocation(id_);
     }
 
     GLProgram(const char** pVertexSourceStrings,
@@ -47,10 +52,12 @@ public:
             id_(
                     createProgram(count, pVertexSourceStrings,
                             pVertexSourceStringLengths, pFragmentSourceStrings,
-                            pFragmentSourceStringLengths)) {
+                            pFragmentSourceStringLengths)),
+            instance_location_(findInstanceLocation(id_)) {
     }
 
     ~GLProgram() {
+        GLState::getInstance().deleteProgram(id_);
         GL(glDeleteProgram(id_));
     }
 
@@ -58,6 +65,21 @@ public:
         return id_;
     }
 
+    /*
+     * Location of the per instance model matrix a_model_instance, or -1
+     * if the linked program does not use it.
+     */
+    GLint instanceLocation() const {
+        return instance_location_;
+    }
+
+    /*
+     * Make this the current program, unless it already is.
+     */
+    void use() const {
+        GLState::getInstance().useProgram(id_);
+    }
+
     GLuint loadShader(GLenum shaderType, int strLength, const char** pSourceStrings,
             const GLint*pSourceStringLengths) {
         GLuint shader = glCreateShader(shaderType);
@@ -133,13 +155,23 @@ public:
                 }
                 glDeleteProgram(program);
                 program = 0;
+            } else {
+                GLUniformBlock::bindProgram(program, CAMERA_BLOCK_NAME,
+                        CAMERA_BLOCK_BINDING);
+                GLUniformBlock::bindProgram(program, BONE_BLOCK_NAME,
+                        BONE_BLOCK_BINDING);
             }
         }
         return program;
     }
 
 private:
+    static GLint findInstanceLocation(GLuint program) {
+        return (program != 0) ? glGetAttribLocation(program, "a_model_instance") : -1;
+    }
+
     GLuint id_;
+    GLint instance_location_;
 };
 
 }
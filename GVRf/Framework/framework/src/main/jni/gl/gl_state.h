@@ -0,0 +1,346 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Shadow copy of the GL render state.
+ ***************************************************************************/
+
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#include "gl/gl_headers.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+/*
+ * Tracks the render state the renderer, the shaders and the texture
+ * capturer change per draw and skips GL calls which would not change
+ * anything. Everything on the GL thread which changes one of these
+ * states has to go through this class, or call invalidate() afterwards.
+ *
+ * The state starts out unknown, so the first call always reaches GL.
+ * The renderer invalidates the cache at the start of every render pass
+ * since the application and the VR backends can change GL state
+ * between passes.
+ */
+class GLState {
+public:
+    static GLState& getInstance() {
+        static GLState instance;
+        return instance;
+    }
+
+    /*
+     * Forget the cached state, the next call of every setter reaches GL.
+     */
+    void invalidate() {
+        for (int i = 0; i < CAP_COUNT; ++i) {
+            caps_[i] = UNKNOWN;
+        }
+        program_ = INVALID;
+        depth_mask_ = UNKNOWN;
+        depth_func_ = INVALID;
+        color_mask_ = INVALID;
+        cull_face_ = INVALID;
+        front_face_ = INVALID;
+        blend_func_valid_ = false;
+        blend_equation_ = INVALID;
+        offset_valid_ = false;
+        stencil_func_valid_ = false;
+        stencil_op_valid_ = false;
+        stencil_mask_valid_ = false;
+        coverage_valid_ = false;
+        line_width_ = -1.0f;
+    }
+
+    void resetStats() {
+        changed_ = 0;
+        skipped_ = 0;
+    }
+
+    // number of state calls passed to GL since the last resetStats()
+    int changed() const {
+        return changed_;
+    }
+
+    // number of state calls skipped since the last resetStats()
+    int skipped() const {
+        return skipped_;
+    }
+
+    void setEnabled(GLenum cap, bool enabled) {
+        int index = capIndex(cap);
+        if (index < 0) {
+            enabled ? glEnable(cap) : glDisable(cap);
+            ++changed_;
+            return;
+        }
+        int value = enabled ? ENABLED : DISABLED;
+        if (update(caps_[index], value)) {
+            enabled ? glEnable(cap) : glDisable(cap);
+        }
+    }
+
+    void enable(GLenum cap) {
+        setEnabled(cap, true);
+    }
+
+    void disable(GLenum cap) {
+        setEnabled(cap, false);
+    }
+
+    /*
+     * Answer from the cache if possible instead of querying GL.
+     */
+    bool isEnabled(GLenum cap) {
+        int index = capIndex(cap);
+        if ((index < 0) || (UNKNOWN == caps_[index])) {
+            return glIsEnabled(cap);
+        }
+        return ENABLED == caps_[index];
+    }
+
+    void useProgram(GLuint program) {
+        if (update(program_, (int) program)) {
+            glUseProgram(program);
+        }
+    }
+
+    /*
+     * Called when a program is deleted, GL may reuse its name.
+     */
+    void deleteProgram(GLuint program) {
+        if (program_ == (int) program) {
+            program_ = INVALID;
+        }
+    }
+
+    void depthMask(GLboolean flag) {
+        if (update(depth_mask_, flag ? ENABLED : DISABLED)) {
+            glDepthMask(flag);
+        }
+    }
+
+    void depthFunc(GLenum func) {
+        if (update(depth_func_, func)) {
+            glDepthFunc(func);
+        }
+    }
+
+    void colorMask(GLboolean red, GLboolean green, GLboolean blue,
+            GLboolean alpha) {
+        int mask = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0)
+                | (alpha ? 8 : 0);
+        if (update(color_mask_, mask)) {
+            glColorMask(red, green, blue, alpha);
+        }
+    }
+
+    void cullFace(GLenum mode) {
+        if (update(cull_face_, mode)) {
+            glCullFace(mode);
+        }
+    }
+
+    void frontFace(GLenum mode) {
+        if (update(front_face_, mode)) {
+            glFrontFace(mode);
+        }
+    }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        if (blend_func_valid_ && (blend_src_ == src) && (blend_dst_ == dst)) {
+            ++skipped_;
+            return;
+        }
+        blend_func_valid_ = true;
+        blend_src_ = src;
+        blend_dst_ = dst;
+        ++changed_;
+        glBlendFunc(src, dst);
+    }
+
+    void blendEquation(GLenum mode) {
+        if (update(blend_equation_, mode)) {
+            glBlendEquation(mode);
+        }
+    }
+
+    void polygonOffset(GLfloat factor, GLfloat units) {
+        if (offset_valid_ && (offset_factor_ == factor)
+                && (offset_units_ == units)) {
+            ++skipped_;
+            return;
+        }
+        offset_valid_ = true;
+        offset_factor_ = factor;
+        offset_units_ = units;
+        ++changed_;
+        glPolygonOffset(factor, units);
+    }
+
+    void stencilFunc(GLenum func, GLint ref, GLuint mask) {
+        if (stencil_func_valid_ && (stencil_func_ == func)
+                && (stencil_ref_ == ref) && (stencil_func_mask_ == mask)) {
+            ++skipped_;
+            return;
+        }
+        stencil_func_valid_ = true;
+        stencil_func_ = func;
+        stencil_ref_ = ref;
+        stencil_func_mask_ = mask;
+        ++changed_;
+        glStencilFunc(func, ref, mask);
+    }
+
+    void stencilOp(GLenum sfail, GLenum dpfail, GLenum dppass) {
+        if (stencil_op_valid_ && (stencil_sfail_ == sfail)
+                && (stencil_dpfail_ == dpfail) && (stencil_dppass_ == dppass)) {
+            ++skipped_;
+            return;
+        }
+        stencil_op_valid_ = true;
+        stencil_sfail_ = sfail;
+        stencil_dpfail_ = dpfail;
+        stencil_dppass_ = dppass;
+        ++changed_;
+        glStencilOp(sfail, dpfail, dppass);
+    }
+
+    void stencilMask(GLuint mask) {
+        if (stencil_mask_valid_ && (stencil_mask_ == mask)) {
+            ++skipped_;
+            return;
+        }
+        stencil_mask_valid_ = true;
+        stencil_mask_ = mask;
+        ++changed_;
+        glStencilMask(mask);
+    }
+
+    void sampleCoverage(GLfloat value, GLboolean invert) {
+        if (coverage_valid_ && (coverage_value_ == value)
+                && (coverage_invert_ == invert)) {
+            ++skipped_;
+            return;
+        }
+        coverage_valid_ = true;
+        coverage_value_ = value;
+        coverage_invert_ = invert;
+        ++changed_;
+        glSampleCoverage(value, invert);
+    }
+
+    void lineWidth(GLfloat width) {
+        if (line_width_ == width) {
+            ++skipped_;
+            return;
+        }
+        line_width_ = width;
+        ++changed_;
+        glLineWidth(width);
+    }
+
+private:
+    GLState() :
+            changed_(0), skipped_(0) {
+        invalidate();
+    }
+
+    GLState(const GLState& gl_state);
+    GLState(GLState&& gl_state);
+    GLState& operator=(const GLState& gl_state);
+    GLState& operator=(GLState&& gl_state);
+
+    enum {
+        UNKNOWN = -1, DISABLED = 0, ENABLED = 1, INVALID = -1
+    };
+
+    enum Capability {
+        BLEND, CULL_FACE, DEPTH_TEST, STENCIL_TEST, POLYGON_OFFSET_FILL,
+        SAMPLE_ALPHA_TO_COVERAGE, SCISSOR_TEST, CAP_COUNT
+    };
+
+    static int capIndex(GLenum cap) {
+        switch (cap) {
+        case GL_BLEND:
+            return BLEND;
+        case GL_CULL_FACE:
+            return CULL_FACE;
+        case GL_DEPTH_TEST:
+            return DEPTH_TEST;
+        case GL_STENCIL_TEST:
+            return STENCIL_TEST;
+        case GL_POLYGON_OFFSET_FILL:
+            return POLYGON_OFFSET_FILL;
+        case GL_SAMPLE_ALPHA_TO_COVERAGE:
+            return SAMPLE_ALPHA_TO_COVERAGE;
+        case GL_SCISSOR_TEST:
+            return SCISSOR_TEST;
+        default:
+            return -1;
+        }
+    }
+
+    /*
+     * Update a cached value, returns true if the GL call is needed.
+     */
+    bool update(int& cached, int value) {
+        if (cached == value) {
+            ++skipped_;
+            return false;
+        }
+        cached = value;
+        ++changed_;
+        return true;
+    }
+
+private:
+    int caps_[CAP_COUNT];
+    int program_;
+    int depth_mask_;
+    int depth_func_;
+    int color_mask_;
+    int cull_face_;
+    int front_face_;
+    bool blend_func_valid_;
+    GLenum blend_src_;
+    GLenum blend_dst_;
+    int blend_equation_;
+    bool offset_valid_;
+    GLfloat offset_factor_;
+    GLfloat offset_units_;
+    bool stencil_func_valid_;
+    GLenum stencil_func_;
+    GLint stencil_ref_;
+    GLuint stencil_func_mask_;
+    bool stencil_op_valid_;
+    GLenum stencil_sfail_;
+    GLenum stencil_dpfail_;
+    GLenum stencil_dppass_;
+    bool stencil_mask_valid_;
+    GLuint stencil_mask_;
+    bool coverage_valid_;
+    GLfloat coverage_value_;
+    GLboolean coverage_invert_;
+    GLfloat line_width_;
+    int changed_;
+    int skipped_;
+};
+
+}
+
+#endif
@@ -70,6 +70,15 @@ public:
         return target_;
     }
 
+    // parameters the texture was created or last updated with
+    const int* texture_parameters() const {
+        return texture_parameters_;
+    }
+
+    void set_texture_parameters(const int* texture_parameters) {
+        std::memcpy(texture_parameters_, texture_parameters, sizeof(texture_parameters_));
+    }
+
     virtual void runPendingGL() {
         switch (pending_gl_task_) {
         case GL_TASK_NONE:
@@ -151,7 +160,7 @@ private:
     };
     int pending_gl_task_;
 
-    int texture_parameters_[MAX_TEXTURE_PARAM_NUM];
+    int texture_parameters_[MAX_TEXTURE_PARAM_NUM] = { };
 };
 
 }
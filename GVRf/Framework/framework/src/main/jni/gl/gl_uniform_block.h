@@ -0,0 +1,132 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * RAII class for GL uniform buffer objects.
+ ***************************************************************************/
+
+#ifndef GL_UNIFORM_BLOCK_H_
+#define GL_UNIFORM_BLOCK_H_
+
+#include <cstring>
+#include <vector>
+
+#include "gl/gl_headers.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+/*
+ * Binding points shared by all programs. The camera block is updated
+ * once per render pass, the bone block is rebound for every skinned
+ * mesh drawn and every scene light owns the binding point
+ * LIGHT_BLOCK_BINDING + its index in the scene's light list.
+ */
+enum UniformBlockBinding {
+    CAMERA_BLOCK_BINDING = 0,
+    BONE_BLOCK_BINDING = 1,
+    LIGHT_BLOCK_BINDING = 2
+};
+
+static const char CAMERA_BLOCK_NAME[] = "Camera";
+static const char BONE_BLOCK_NAME[] = "Bones";
+
+/*
+ * A std140 uniform block with a CPU side copy of its contents.
+ * set() only changes the copy, bind() uploads it in a single call
+ * when it changed since the last upload.
+ */
+class GLUniformBlock {
+public:
+    explicit GLUniformBlock(int size) :
+            id_(0), data_(size, 0), dirty_(true) {
+    }
+
+    ~GLUniformBlock() {
+        if (0 != id_) {
+            GL(glDeleteBuffers(1, &id_));
+        }
+    }
+
+    int size() const {
+        return data_.size();
+    }
+
+    void set(int offset, const void* data, int size) {
+        if ((offset < 0) || (size < 0)
+                || ((size_t) offset + (size_t) size > data_.size())) {
+            return;
+        }
+        if (memcmp(&data_[offset], data, size) != 0) {
+            memcpy(&data_[offset], data, size);
+            dirty_ = true;
+        }
+    }
+
+    /*
+     * Upload the block if it changed and attach it to a binding point.
+     * The whole buffer is respecified so the driver can orphan the copy
+     * still used by the previous pass instead of waiting for it.
+     * If used_size is given only that many bytes at the start of the
+     * block are copied, the rest of the buffer is left undefined.
+     */
+    void bind(GLuint binding_point, int used_size = -1) {
+        if (0 == id_) {
+            glGenBuffers(1, &id_);
+        }
+        if (dirty_) {
+            glBindBuffer(GL_UNIFORM_BUFFER, id_);
+            if ((used_size < 0) || ((size_t) used_size >= data_.size())) {
+                glBufferData(GL_UNIFORM_BUFFER, data_.size(), data_.data(),
+                        GL_DYNAMIC_DRAW);
+            } else {
+                glBufferData(GL_UNIFORM_BUFFER, data_.size(), nullptr,
+                        GL_DYNAMIC_DRAW);
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, used_size, data_.data());
+            }
+            dirty_ = false;
+        }
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, id_);
+    }
+
+    /*
+     * Attach the named block of a program to a binding point.
+     * Returns false if the program does not declare the block.
+     */
+    static bool bindProgram(GLuint program, const char* block_name,
+            GLuint binding_point) {
+        GLuint index = glGetUniformBlockIndex(program, block_name);
+        if (GL_INVALID_INDEX == index) {
+            return false;
+        }
+        glUniformBlockBinding(program, index, binding_point);
+        return true;
+    }
+
+private:
+    GLUniformBlock(const GLUniformBlock& gl_uniform_block);
+    GLUniformBlock(GLUniformBlock&& gl_uniform_block);
+    GLUniformBlock& operator=(const GLUniformBlock& gl_uniform_block);
+    GLUniformBlock& operator=(GLUniformBlock&& gl_uniform_block);
+
+private:
+    GLuint id_;
+    std::vector<char> data_;
+    bool dirty_;
+};
+
+}
+
+#endif
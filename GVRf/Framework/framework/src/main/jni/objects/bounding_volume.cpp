@@ -19,12 +19,14 @@
 
 #include "bounding_volume.h"
 #include "util/gvr_log.h"
+#include "util/gvr_simd.h"
+
+#include "glm/gtc/type_ptr.hpp"
 
 namespace gvr {
 
 BoundingVolume::BoundingVolume() {
     reset();
-    scratch_abs_matrix = glm::mat4();
 }
 
 void BoundingVolume::reset() {
@@ -132,35 +134,40 @@ void BoundingVolume::expand(const glm::vec3 &in_center, float in_radius) {
  * expand the volume by the incoming volume
  */
 void BoundingVolume::expand(const BoundingVolume &volume) {
-    expand(volume.min_corner());
-    expand(volume.max_corner());
+    min_corner_ = glm::min(min_corner_, volume.min_corner());
+    max_corner_ = glm::max(max_corner_, volume.max_corner());
+    updateCenterAndRadius();
 }
 
 /*
  * Uses the technique described here:
  * http://zeuxcg.org/2010/10/17/aabb-from-obb-with-component-wise-abs/
  */
-void BoundingVolume::transform(const BoundingVolume &in_volume, glm::mat4 matrix) {
-    // Make sure the bounding volume itself is cleared before transformation
-    reset();
+void BoundingVolume::transform(const BoundingVolume &in_volume, const glm::mat4& matrix) {
+    using namespace simd;
 
     glm::vec3 center = (in_volume.min_corner() + in_volume.max_corner()) / 2.0f;
     glm::vec3 extent = (in_volume.max_corner() - in_volume.min_corner()) / 2.0f;
 
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            scratch_abs_matrix[i, j] = abs(matrix[i, j]);
-        }
-    }
+    // the columns of the matrix in lanes, the last lane is ignored
+    const float* m = glm::value_ptr(matrix);
+    const Lanes zero = splat(0.0f);
+    const Lanes x_axis = load(m), y_axis = load(m + 4), z_axis = load(m + 8);
 
-    glm::vec4 new_center = matrix * glm::vec4(center, 1.0f);
-    glm::vec4 new_extent = scratch_abs_matrix * glm::vec4(extent, 0.0f);
+    Lanes new_center = madd(x_axis, splat(center.x), load(m + 12));
+    new_center = madd(y_axis, splat(center.y), new_center);
+    new_center = madd(z_axis, splat(center.z), new_center);
 
-    glm::vec4 bb_min = new_center - new_extent;
-    glm::vec4 bb_max = new_center + new_extent;
+    Lanes new_extent = mul(max(x_axis, sub(zero, x_axis)), splat(extent.x));
+    new_extent = madd(max(y_axis, sub(zero, y_axis)), splat(extent.y), new_extent);
+    new_extent = madd(max(z_axis, sub(zero, z_axis)), splat(extent.z), new_extent);
 
-    expand(glm::vec3(bb_min.x, bb_min.y, bb_min.z));
-    expand(glm::vec3(bb_max.x, bb_max.y, bb_max.z));
+    float bb_min[4], bb_max[4];
+    store(bb_min, sub(new_center, new_extent));
+    store(bb_max, add(new_center, new_extent));
+    min_corner_ = glm::vec3(bb_min[0], bb_min[1], bb_min[2]);
+    max_corner_ = glm::vec3(bb_max[0], bb_max[1], bb_max[2]);
+    updateCenterAndRadius();
 }
 
 bool BoundingVolume::intersect(glm::vec3& hitPoint, const glm::vec3& rayStart, const glm::vec3& rayDir)  const
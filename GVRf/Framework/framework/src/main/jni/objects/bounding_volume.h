@@ -55,7 +55,7 @@ public:
     void expand(const glm::vec3 point);
     void expand(const BoundingVolume &volume);
     void expand(const glm::vec3 &in_center, float in_radius);
-    void transform(const BoundingVolume &volume, glm::mat4 matrix);
+    void transform(const BoundingVolume &volume, const glm::mat4& matrix);
     bool intersect(glm::vec3& hitPoint, const glm::vec3& rayStart, const glm::vec3& rayDir)  const;
 
 private:
@@ -67,8 +67,6 @@ private:
     glm::vec3 min_corner_;
     glm::vec3 max_corner_;
 
-    //Used as a scratch matrix while computing the transformed bounding volume
-    glm::mat4 scratch_abs_matrix;
 };
 }
 #endif
@@ -6,6 +6,7 @@
 
 #include "objects/components/component.h"
 #include "objects/components/bone.h"
+#include "objects/vertex_bone_data.h"
 
 #include "glm/gtc/matrix_inverse.hpp"
 
@@ -19,7 +20,8 @@ Bone::Bone()
   , name_()
   , boneWeights_()
   , offsetMatrix_()
-  , finalTransformMatrixPtr_(nullptr)
+  , boneData_(nullptr)
+  , boneId_(0)
 {
 }
 
@@ -34,4 +36,17 @@ void Bone::setBoneWeights(std::vector<BoneWeight*>&& boneWeights) {
     boneWeights_ = std::move(boneWeights);
 }
 
+void Bone::setFinalTransformMatrix(const glm::mat4 &mat) {
+    if (boneData_) {
+        boneData_->setFinalBoneTransform(boneId_, mat);
+    }
+}
+
+const glm::mat4 &Bone::getFinalTransformMatrix() const {
+    if (boneData_) {
+        return boneData_->getFinalBoneTransform(boneId_);
+    }
+    return identityMatrix_;
+}
+
 }
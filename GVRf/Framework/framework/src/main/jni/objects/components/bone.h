@@ -17,6 +17,8 @@
 #include "util/gvr_log.h"
 
 namespace gvr {
+class VertexBoneData;
+
 class Bone: public Component {
 public:
     Bone();
@@ -33,21 +35,17 @@ public:
         return offsetMatrix_;
     }
 
-    void setFinalTransformMatrixPtr(glm::mat4 *ptr) {
-        finalTransformMatrixPtr_ = ptr;
-    }
-
-    void setFinalTransformMatrix(glm::mat4 &mat) {
-        *finalTransformMatrixPtr_ = mat;
+    /*
+     * The final transform of the bone is kept in the palette of
+     * the bone data, at the given index.
+     */
+    void setBoneData(VertexBoneData* boneData, int boneId) {
+        boneData_ = boneData;
+        boneId_ = boneId;
     }
 
-    glm::mat4 &getFinalTransformMatrix() {
-        if (finalTransformMatrixPtr_)
-        {
-            return *finalTransformMatrixPtr_;
-        }
-        return identityMatrix_;
-    }
+    void setFinalTransformMatrix(const glm::mat4 &mat);
+    const glm::mat4 &getFinalTransformMatrix() const;
 
     static long long getComponentType() {
         return COMPONENT_TYPE_BONE;
@@ -64,7 +62,8 @@ private:
     std::string name_;
     std::vector<BoneWeight*> boneWeights_;
     glm::mat4 offsetMatrix_;
-    glm::mat4 *finalTransformMatrixPtr_;
+    VertexBoneData *boneData_;
+    int boneId_;
 };
 
 }
@@ -50,7 +50,7 @@ const glm::mat4& Camera::getViewMatrix() {
     if (owner_object() != nullptr) {
         Transform *const t = owner_object()->transform();
         if (t != nullptr) {
-            view_matrix_ = glm::affineInverse(t->getModelMatrix(true));
+            view_matrix_ = glm::affineInverse(t->getModelMatrix());
         }
     }
     return view_matrix_;
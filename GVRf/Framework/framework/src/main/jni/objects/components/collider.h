@@ -29,6 +29,7 @@
 
 namespace gvr {
 class Collider;
+class BoundingVolume;
 
 /*
  * Information from a collision when a collider is picked.
@@ -71,6 +72,24 @@ public:
      */
     virtual ColliderData isHit(const glm::vec3& rayStart, const glm::vec3& rayDir) = 0;
 
+    /*
+     * Get the world space box enclosing everything isHit can hit.
+     * Returns false if the collider has no such bounds, it is then
+     * tested against every pick ray.
+     * Must be called on the GL thread.
+     */
+    virtual bool getWorldBounds(BoundingVolume& bounds) {
+        return false;
+    }
+
+    /*
+     * True if the world bounds may change while the owner stays put,
+     * the picker then checks them every frame.
+     */
+    virtual bool hasAnimatedBounds() {
+        return false;
+    }
+
     virtual void set_owner_object(SceneObject*);
 
     virtual long shape_type() {
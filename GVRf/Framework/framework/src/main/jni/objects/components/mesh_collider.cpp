@@ -27,6 +27,7 @@
 #include "mesh_collider.h"
 #include "render_data.h"
 #include "objects/mesh.h"
+#include "objects/mesh_bvh.h"
 #include "objects/bounding_volume.h"
 #include "objects/mesh.h"
 #include "objects/scene_object.h"
@@ -45,6 +46,70 @@ MeshCollider::MeshCollider(bool useMeshBounds) :
 
 MeshCollider::~MeshCollider() { }
 
+void MeshCollider::set_mesh(Mesh* mesh)
+{
+    mesh_ = mesh;
+    // the picker refits its bounds when the owner is dirty
+    if (owner_object() != NULL)
+    {
+        owner_object()->dirtyHierarchicalBoundingVolume();
+    }
+}
+
+/*
+ * The mesh of the collider, or the mesh of the render data
+ * if the collider has none.
+ */
+Mesh* MeshCollider::collisionMesh()
+{
+    SceneObject* owner = owner_object();
+
+    if ((mesh_ == NULL) && (owner != NULL) && (owner->render_data() != NULL))
+    {
+        return owner->render_data()->mesh();
+    }
+    return mesh_;
+}
+
+/*
+ * The bounds of the mesh, or of its pose skinned on the CPU,
+ * transformed into world coordinates.
+ */
+bool MeshCollider::getWorldBounds(BoundingVolume& bounds)
+{
+    SceneObject* owner = owner_object();
+    Mesh* mesh = collisionMesh();
+
+    if ((owner == NULL) || (owner->transform() == NULL))
+    {
+        return false;
+    }
+    if ((mesh == NULL) || mesh->vertices().empty())
+    {
+        return false;
+    }
+    std::shared_ptr<const SkinnedPose> pose = mesh->getVertexBoneData().getSkinnedPose();
+    if (pose != NULL)
+    {
+        BoundingVolume pose_bounds;
+        pose_bounds.expand(pose->min_corner());
+        pose_bounds.expand(pose->max_corner());
+        bounds.transform(pose_bounds, owner->transform()->getModelMatrix());
+    }
+    else
+    {
+        bounds.transform(mesh->getBoundingVolume(), owner->transform()->getModelMatrix());
+    }
+    return true;
+}
+
+bool MeshCollider::hasAnimatedBounds()
+{
+    Mesh* mesh = collisionMesh();
+
+    return (mesh != NULL) && mesh->getVertexBoneData().cpuSkinning();
+}
+
 /*
  * Hit test the triangles in the mesh against the input ray.
  *
@@ -96,7 +161,15 @@ ColliderData MeshCollider::isHit(const glm::vec3& rayStart, const glm::vec3& ray
     ColliderData data;
     if (mesh != NULL)
     {
-        if (useMeshBounds_)
+        std::shared_ptr<const SkinnedPose> pose = mesh->getVertexBoneData().getSkinnedPose();
+        if (useMeshBounds_ && (pose != NULL))
+        {
+            BoundingVolume bounds;
+            bounds.expand(pose->min_corner());
+            bounds.expand(pose->max_corner());
+            data = MeshCollider::isHit(bounds, O, D);
+        }
+        else if (useMeshBounds_)
         {
             const BoundingVolume& bounds = mesh->getBoundingVolume();
             data = MeshCollider::isHit(bounds, O, D);
@@ -119,39 +192,28 @@ ColliderData MeshCollider::isHit(const glm::vec3& rayStart, const glm::vec3& ray
 
 /*
  * Hit test the input ray against the triangles of the given mesh.
+ * The triangles are searched through the bounding volume hierarchy
+ * cached by the mesh, or by its skinned pose if it is skinned on the CPU.
  * @param mesh  mesh to hit test
  * @param rayStart  start of the pick ray in model coordinates
  * @param rayDir    direction of the pick ray in model coordinates
  * @return ColliderData with the hit point and distance in model coordinates
  */
-ColliderData MeshCollider::isHit(const Mesh& mesh, const glm::vec3& rayStart, const glm::vec3& rayDir) {
-    const std::vector<glm::vec3>& vertices = mesh.vertices();
+ColliderData MeshCollider::isHit(Mesh& mesh, const glm::vec3& rayStart, const glm::vec3& rayDir) {
     ColliderData data;
-    if (vertices.size() > 0)
+    glm::vec3 hitPos;
+    std::shared_ptr<const SkinnedPose> pose = mesh.getVertexBoneData().getSkinnedPose();
+    std::shared_ptr<MeshBVH> bvh = (pose != NULL) ? pose->getBVH(mesh) : mesh.getBVH();
+    float distance = bvh->intersect(rayStart, rayDir, hitPos);
+
+    if (distance > 0)
     {
-        for (int i = 0; i < mesh.triangles().size(); i += 3)
-        {
-            glm::vec3 V1(vertices[mesh.triangles()[i]]);
-            glm::vec3 V2(vertices[mesh.triangles()[i + 1]]);
-            glm::vec3 V3(vertices[mesh.triangles()[i + 2]]);
-
-            /*
-             * Compute the point where the ray penetrates the mesh in
-             * the coordinate space of the mesh. The hit point will
-             * be in mesh coordinates as will the distance.
-             */
-            glm::vec3 hitPos;
-            float distance = rayTriangleIntersect(hitPos, rayStart, rayDir, V1, V2, V3);
-            if ((distance > 0) && (distance < data.Distance))
-            {
-                data.IsHit = true;
-                data.HitPosition = hitPos;
-                data.Distance = distance;
-            }
-         }
-      }
-      return data;
-   }
+        data.IsHit = true;
+        data.HitPosition = hitPos;
+        data.Distance = distance;
+    }
+    return data;
+}
 
     /*
      * Determine if the ray penetrates an axially aligned bounding box
@@ -170,41 +232,4 @@ ColliderData MeshCollider::isHit(const Mesh& mesh, const glm::vec3& rayStart, co
          }
          return data;
     }
-
-    float MeshCollider::rayTriangleIntersect(glm::vec3& hitPos, const glm::vec3& rayStart, const glm::vec3& rayDir,
-                                       const glm::vec3& V1, const glm::vec3& V2, const glm::vec3& V3)
-    {
-        glm::vec3 e1(V2 - V1);
-        glm::vec3 e2(V3 - V1);
-        glm::vec3 P = glm::cross(rayDir, e2);
-        glm::vec3 T(glm::vec3(rayStart) - V1);
-        float det = glm::dot(e1, P);
-        const float EPSILON = 0.00001f;
-
-        if (det > -EPSILON && det < EPSILON) {
-            return -1;
-        }
-
-        float inv_det = 1.0f / det;
-        float u = glm::dot(T, P) * inv_det;
-
-        if (u < 0.0f || u > 1.0f) {
-            return -1;
-        }
-
-        glm::vec3 Q = glm::cross(T, e1);
-        float v = glm::dot(glm::vec3(rayDir), Q) * inv_det;
-
-        if (v < 0.0f || (u + v) > 1.0f) {
-            return -1;
-        }
-
-        float t = glm::dot(e2, Q) * inv_det;
-
-        if (t > EPSILON) {
-            hitPos = (1.0f - u - v) * V1 + u * V2 + v * V3;
-            return t;
-        }
-        return -1;
-    }
-}
\ No newline at end of file
+}
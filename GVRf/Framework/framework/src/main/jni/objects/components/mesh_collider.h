@@ -43,11 +43,11 @@ public:
         return mesh_;
     }
 
-    void set_mesh(Mesh* mesh) {
-        mesh_ = mesh;
-    }
+    void set_mesh(Mesh* mesh);
 
     ColliderData isHit(const glm::vec3& rayStart, const glm::vec3& rayDir);
+    bool getWorldBounds(BoundingVolume& bounds);
+    bool hasAnimatedBounds();
     static ColliderData isHit(const BoundingVolume& bounds, const glm::vec3& rayStart, const glm::vec3& rayDir);
 
 private:
@@ -55,9 +55,8 @@ private:
     MeshCollider(MeshCollider&& mesh_collider);
     MeshCollider& operator=(const MeshCollider& mesh_collider);
     MeshCollider& operator=(MeshCollider&& mesh_collider);
-    static ColliderData isHit(const Mesh& mesh, const glm::vec3& rayStart, const glm::vec3& rayDir);
-    static float rayTriangleIntersect(glm::vec3& hitPos, const glm::vec3& rayStart, const glm::vec3& rayDir,
-                               const glm::vec3& V1, const glm::vec3& V2, const glm::vec3& V3);
+    static ColliderData isHit(Mesh& mesh, const glm::vec3& rayStart, const glm::vec3& rayDir);
+    Mesh* collisionMesh();
 private:
     bool useMeshBounds_;
     Mesh* mesh_;
@@ -14,6 +14,9 @@
  */
 
 
+#include <algorithm>
+#include <cstring>
+
 #include "objects/hybrid_object.h"
 #include "objects/components/render_data.h"
 
@@ -49,7 +52,7 @@ bool RenderData::cull_face(int pass) const {
     if (pass >= 0 && pass < render_pass_list_.size()) {
         return render_pass_list_[pass]->cull_face();
     }
-    return nullptr;
+    return false;
 }
 
 Material* RenderData::material(int pass) const {
@@ -83,44 +86,104 @@ void RenderData::setStencilTest(bool flag) {
     stencilTestFlag_ = flag;
 }
 
-bool compareRenderDataByOrderShaderDistance(RenderData *i, RenderData *j) {
-    //1. rendering order needs to be sorted first to guarantee specified correct order
-    if (i->rendering_order() == j->rendering_order()) {
-
-        if (i->material(0)->shader_type() == j->material(0)->shader_type()) {
-
-            // if it is a transparent object, sort by camera distance from back to front
-            if (i->rendering_order() >= RenderData::Transparent
-                && i->rendering_order() < RenderData::Overlay) {
-                return i->camera_distance() > j->camera_distance();
-            }
-
-            int no_passes1 = i->pass_count();
-            int no_passes2 = j->pass_count();
-
-            if (no_passes1 == no_passes2) {
-
-                //@todo what about the other passes
-
-                //this is pointer comparison; assumes batching is on; if the materials are not
-                //the same then comparing the pointers further is an arbitrary decision; hence
-                //falling back to camera distance.
-                if (i->material(0) == j->material(0)) {
-                    if (i->cull_face(0) == j->cull_face(0)) {
-                        if (i->getHashCode().compare(j->getHashCode()) == 0) {
-                            // otherwise sort from front to back
-                            return i->camera_distance() < j->camera_distance();
-                        }
-                        return i->getHashCode() < j->getHashCode();
-                    }
-                    return i->cull_face(0) < j->cull_face(0);
-                }
-                return i->material(0) < j->material(0);
-            }
-            return no_passes1 < no_passes2;
-        }
-        return i->material(0)->shader_type() < j->material(0)->shader_type();
+/*
+ * FNV-1a, folding in one render state at a time.
+ */
+template<typename T> static inline uint64_t hashState(uint64_t hash, T value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (int i = 0; i < sizeof(T); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t RenderData::getHashCode() {
+    if (hash_code_dirty_) {
+        uint64_t hash = 14695981039346656037ULL;
+
+        hash = hashState(hash, use_light_);
+        hash = hashState(hash, light_);
+        hash = hashState(hash, getComponentType());
+        hash = hashState(hash, use_lightmap_);
+        hash = hashState(hash, render_mask_);
+        hash = hashState(hash, offset_);
+        hash = hashState(hash, offset_factor_);
+        hash = hashState(hash, offset_units_);
+        hash = hashState(hash, depth_test_);
+        hash = hashState(hash, alpha_blend_);
+        hash = hashState(hash, alpha_to_coverage_);
+        hash = hashState(hash, sample_coverage_);
+        hash = hashState(hash, invert_coverage_mask_);
+        hash = hashState(hash, draw_mode_);
+
+        hash = hashState(hash, stencilTestFlag_);
+        hash = hashState(hash, stencilMaskMask_);
+        hash = hashState(hash, stencilFuncFunc_);
+        hash = hashState(hash, stencilFuncRef_);
+        hash = hashState(hash, stencilFuncMask_);
+        hash = hashState(hash, stencilOpSfail_);
+        hash = hashState(hash, stencilOpDpfail_);
+        hash = hashState(hash, stencilOpDppass_);
+
+        hash_code = hash;
+        hash_code_dirty_ = false;
+    }
+    return hash_code;
+}
+
+/*
+ * The sort key holds, from the most significant word down:
+ *
+ *   16 bits  rendering order
+ *   10 bits  shader type, custom shaders after the built in ones
+ *    2 bits  number of passes
+ *    2 bits  cull face
+ *   64 bits  batch key of the material, its id unless it shares
+ *            a texture array with other materials
+ *   64 bits  render state hash
+ *   32 bits  camera distance, nearest first
+ *
+ * Transparent objects are only sorted by the rendering order, the
+ * shader and the camera distance, farthest first.
+ */
+RenderData::SortKey RenderData::getSortKey(float distance) {
+    static const int CUSTOM_SHADER_BASE = 128;
+    static const int INITIAL_CUSTOM_SHADER_INDEX = 1000;
+    Material* material = render_pass_list_[0]->material();
+    int order = std::min(std::max(rendering_order_ + 0x8000, 0), 0xffff);
+    int shader = material->shader_type();
+    uint32_t distance_bits;
+
+    if (shader >= INITIAL_CUSTOM_SHADER_INDEX) {
+        shader = CUSTOM_SHADER_BASE + shader - INITIAL_CUSTOM_SHADER_INDEX;
     }
-    return i->rendering_order() < j->rendering_order();
+    shader = std::min(std::max(shader, 0), 0x3ff);
+
+    // the bits of a positive float sort like the float itself
+    distance = (distance > 0.0f) ? distance : 0.0f;
+    memcpy(&distance_bits, &distance, sizeof(distance_bits));
+
+    SortKey key;
+    key.words[0] = ((uint64_t) order << 48) | ((uint64_t) shader << 38);
+    if (rendering_order_ >= Transparent && rendering_order_ < Overlay) {
+        key.words[1] = 0;
+        key.words[2] = 0;
+        key.words[3] = ~distance_bits;
+        return key;
+    }
+
+    // materials which may be batched together sort next to each other
+    int passes = std::min<int>(render_pass_list_.size() - 1, 3);
+
+    key.words[0] |= ((uint64_t) passes << 36)
+            | ((uint64_t) (render_pass_list_[0]->cull_face() & 3) << 34);
+    key.words[1] = material->batch_key();
+    key.words[2] = getHashCode();
+    key.words[3] = distance_bits;
+    return key;
+}
+
+bool compareRenderDataByOrderShaderDistance(RenderData *i, RenderData *j) {
+    return i->getSortKey() < j->getSortKey();
+}
 }
-}
\ No newline at end of file
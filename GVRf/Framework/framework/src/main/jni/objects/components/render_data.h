@@ -20,8 +20,10 @@
 #ifndef RENDER_DATA_H_
 #define RENDER_DATA_H_
 
+#include <functional>
 #include <memory>
 #include <vector>
+#include <stdint.h>
 
 #include "gl/gl_program.h"
 #include "glm/glm.hpp"
@@ -68,12 +70,12 @@ public:
             Component(RenderData::getComponentType()), mesh_(0), light_(0),
                     use_light_(false), use_lightmap_(false), batching_(true),
                     render_mask_(DEFAULT_RENDER_MASK), batch_(nullptr),
-                    rendering_order_(DEFAULT_RENDERING_ORDER), hash_code_dirty_(true),
+                    rendering_order_(DEFAULT_RENDERING_ORDER), hash_code_dirty_(true), hash_code(0),
                     offset_(false), offset_factor_(0.0f), offset_units_(0.0f),
                     depth_test_(true), alpha_blend_(true), alpha_to_coverage_(false),
                     source_alpha_blend_func_(GL_ONE), dest_alpha_blend_func_(GL_ONE_MINUS_SRC_ALPHA),
                     sample_coverage_(1.0f), invert_coverage_mask_(GL_FALSE), draw_mode_(GL_TRIANGLES),
-                    texture_capturer(0), cast_shadows_(true), dirty_flag_(std::make_shared<bool>(true)) {
+                    texture_capturer(0), cast_shadows_(true), occluder_(false), dirty_flag_(std::make_shared<bool>(true)) {
     }
 
     void copy(const RenderData& rdata) {
@@ -86,6 +88,7 @@ public:
         batching_ = rdata.batching_;
         render_mask_ = rdata.render_mask_;
         cast_shadows_ = rdata.cast_shadows_;
+        occluder_ = rdata.occluder_;
         batch_ = rdata.batch_;
         for(int i=0;i<rdata.render_pass_list_.size();i++) {
             render_pass_list_.push_back((rdata.render_pass_list_)[i]);
@@ -206,6 +209,18 @@ public:
         cast_shadows_ = cast_shadows;
     }
 
+    /*
+     * Occluders are rasterized by the software occlusion culling
+     * to hide the objects behind them.
+     */
+    bool occluder() const {
+        return occluder_;
+    }
+
+    void set_occluder(bool occluder) {
+        occluder_ = occluder;
+    }
+
     Batch* getBatch() {
         return batch_;
     }
@@ -325,6 +340,11 @@ public:
         return camera_distance_;
     }
 
+    void set_camera_distance(float distance) {
+        camera_distance_ = distance;
+        cameraDistanceLambda_ = nullptr;
+    }
+
     void set_draw_mode(GLenum draw_mode) {
         draw_mode_ = draw_mode;
         hash_code_dirty_ = true;
@@ -342,38 +362,39 @@ public:
         return texture_capturer;
     }
 
-    std::string getHashCode() {
-        if (hash_code_dirty_) {
-            std::string render_data_string;
-            render_data_string.append(to_string(use_light_));
-            render_data_string.append(to_string(light_));
-            render_data_string.append(to_string(getComponentType()));
-            render_data_string.append(to_string(use_lightmap_));
-            render_data_string.append(to_string(render_mask_));
-            render_data_string.append(to_string(offset_));
-            render_data_string.append(to_string(offset_factor_));
-            render_data_string.append(to_string(offset_units_));
-            render_data_string.append(to_string(depth_test_));
-            render_data_string.append(to_string(alpha_blend_));
-            render_data_string.append(to_string(alpha_to_coverage_));
-            render_data_string.append(to_string(sample_coverage_));
-            render_data_string.append(to_string(invert_coverage_mask_));
-            render_data_string.append(to_string(draw_mode_));
-
-            render_data_string.append(to_string(stencilTestFlag_));
-            render_data_string.append(to_string(stencilMaskMask_));
-            render_data_string.append(to_string(stencilFuncFunc_));
-            render_data_string.append(to_string(stencilFuncRef_));
-            render_data_string.append(to_string(stencilFuncMask_));
-            render_data_string.append(to_string(stencilOpSfail_));
-            render_data_string.append(to_string(stencilOpDpfail_));
-            render_data_string.append(to_string(stencilOpDppass_));
-
-            hash_code = render_data_string;
-            hash_code_dirty_ = false;
-
+    /*
+     * 64 bit hash of the render states which decide whether two
+     * render datas can share a batch. Only recomputed after one of
+     * these states has changed.
+     */
+    uint64_t getHashCode();
+
+    /*
+     * Key to sort the render datas of a view by, compared one word
+     * after the other starting with words[0].
+     */
+    struct SortKey {
+        static const int WORD_COUNT = 4;
+        uint64_t words[WORD_COUNT];
+
+        bool operator<(const SortKey& key) const {
+            for (int i = 0; i < WORD_COUNT; ++i) {
+                if (words[i] != key.words[i]) {
+                    return words[i] < key.words[i];
+                }
+            }
+            return false;
         }
-        return hash_code;
+    };
+
+    /*
+     * Sort key given the squared distance from the camera of the view
+     * being sorted. See compareRenderDataByOrderShaderDistance.
+     */
+    SortKey getSortKey(float camera_distance);
+
+    SortKey getSortKey() {
+        return getSortKey(camera_distance());
     }
 
     void setCameraDistanceLambda(std::function<float()> func);
@@ -405,7 +426,7 @@ private:
     Mesh* mesh_;
     Batch* batch_;
     bool hash_code_dirty_;
-    std::string hash_code;
+    uint64_t hash_code;
     std::vector<RenderPass*> render_pass_list_;
     Light* light_;
     std::shared_ptr<bool> dirty_flag_;
@@ -423,6 +444,7 @@ private:
     bool alpha_blend_;
     bool alpha_to_coverage_;
     bool cast_shadows_;
+    bool occluder_;
     float sample_coverage_;
     GLboolean invert_coverage_mask_;
     GLenum draw_mode_;
@@ -147,6 +147,14 @@ extern "C" {
     Java_org_gearvrf_NativeRenderData_getCastShadows(JNIEnv * env,
             jobject obj, jlong jrender_data);
 
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeRenderData_setOccluder(JNIEnv * env,
+        jobject obj, jlong jrender_data, jboolean occluder);
+
+    JNIEXPORT jboolean JNICALL
+    Java_org_gearvrf_NativeRenderData_isOccluder(JNIEnv * env,
+            jobject obj, jlong jrender_data);
+
     JNIEXPORT jint JNICALL
     Java_org_gearvrf_NativeRenderData_getDrawMode(
             JNIEnv * env, jobject obj, jlong jrender_data);
@@ -453,6 +461,22 @@ Java_org_gearvrf_NativeRenderData_getCastShadows(JNIEnv * env,
     return render_data->cast_shadows();
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeRenderData_setOccluder(JNIEnv * env,
+    jobject obj, jlong jrender_data, jboolean occluder)
+{
+    RenderData* render_data = reinterpret_cast<RenderData*>(jrender_data);
+    render_data->set_occluder(occluder);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_gearvrf_NativeRenderData_isOccluder(JNIEnv * env,
+        jobject obj, jlong jrender_data)
+{
+    RenderData* render_data = reinterpret_cast<RenderData*>(jrender_data);
+    return render_data->occluder();
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeRenderData_setStencilFunc(JNIEnv *env, jclass type, jlong renderData,
                                                  jint func, jint ref, jint mask) {
@@ -37,11 +37,51 @@ namespace gvr {
  */
 ColliderData SphereCollider::isHit(const glm::vec3& rayStart, const glm::vec3& rayDir)
 {
-    glm::vec3    sphCenter(0, 0, 0);
-    float        radius = radius_;
-    SceneObject* owner = owner_object();
+    glm::vec3    sphCenter;
+    float        radius;
     glm::mat4    model_matrix;
 
+    getSphere(model_matrix, sphCenter, radius);
+    ColliderData data = isHit(model_matrix, sphCenter, radius, rayStart, rayDir);
+    data.ObjectHit = owner_object();
+    data.ColliderHit = this;
+    return data;
+}
+
+/*
+ * The box around the sphere in model coordinates transformed into
+ * world coordinates.
+ */
+bool SphereCollider::getWorldBounds(BoundingVolume& bounds)
+{
+    glm::vec3    sphCenter;
+    float        radius;
+    glm::mat4    model_matrix;
+
+    if (owner_object() == NULL)
+    {
+        return false;
+    }
+    getSphere(model_matrix, sphCenter, radius);
+
+    BoundingVolume sphere;
+    sphere.expand(sphCenter - glm::vec3(radius));
+    sphere.expand(sphCenter + glm::vec3(radius));
+    bounds.transform(sphere, model_matrix);
+    return true;
+}
+
+/*
+ * Get the model matrix of the owner and the sphere center and radius
+ * in model coordinates.
+ */
+void SphereCollider::getSphere(glm::mat4& model_matrix, glm::vec3& sphCenter, float& radius)
+{
+    SceneObject* owner = owner_object();
+
+    sphCenter = glm::vec3(0, 0, 0);
+    radius = radius_;
+
     /*
      * If we have a scene object with a mesh
      * get the sphere center and radius from that.
@@ -77,10 +117,6 @@ ColliderData SphereCollider::isHit(const glm::vec3& rayStart, const glm::vec3& r
     {
         radius = 1;
     }
-    ColliderData data = isHit(model_matrix, sphCenter, radius, rayStart, rayDir);
-    data.ObjectHit = owner;
-    data.ColliderHit = this;
-    return data;
 }
 
 /*
@@ -44,6 +44,11 @@ public:
     void set_radius(float r)
     {
         radius_ = r;
+        // the picker refits its bounds when the owner is dirty
+        if (owner_object() != NULL)
+        {
+            owner_object()->dirtyHierarchicalBoundingVolume();
+        }
     }
 
     float get_radius()
@@ -52,6 +57,7 @@ public:
     }
 
     ColliderData isHit(const glm::vec3& rayStart, const glm::vec3& rayDir);
+    bool getWorldBounds(BoundingVolume& bounds);
     static ColliderData isHit(Mesh& mesh, const glm::mat4& model_matrix, const glm::vec3& rayStart, const glm::vec3& rayDir);
     static ColliderData isHit(const glm::mat4& model_matrix, const glm::vec3& center, float radius, const glm::vec3& rayStart, const glm::vec3& rayDir);
 
@@ -61,6 +67,8 @@ private:
     SphereCollider& operator=(const SphereCollider& mesh_collider);
     SphereCollider& operator=(SphereCollider&& mesh_collider);
 
+    void getSphere(glm::mat4& model_matrix, glm::vec3& sphCenter, float& radius);
+
 private:
     glm::vec3   center_;
     float       radius_;
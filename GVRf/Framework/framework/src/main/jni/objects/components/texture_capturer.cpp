@@ -7,6 +7,7 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/gtc/matrix_inverse.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "gl/gl_state.h"
 #include "objects/components/render_data.h"
 #include "objects/components/texture_capturer.h"
 #include "objects/material.h"
@@ -84,18 +85,19 @@ void TextureCapturer::beginCapture() {
     glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &mSavedFBO);
     glGetIntegerv(GL_VIEWPORT, mSavedViewport);
     glGetIntegerv(GL_SCISSOR_BOX, mSavedScissor);
-    mIsCullFace = glIsEnabled(GL_CULL_FACE);
-    mIsBlend = glIsEnabled(GL_BLEND);
-    mIsPolygonOffsetFill = glIsEnabled(GL_POLYGON_OFFSET_FILL);
+    GLState& gl = GLState::getInstance();
+    mIsCullFace = gl.isEnabled(GL_CULL_FACE);
+    mIsBlend = gl.isEnabled(GL_BLEND);
+    mIsPolygonOffsetFill = gl.isEnabled(GL_POLYGON_OFFSET_FILL);
 
     // Setup FBO
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mRenderTexture->getFrameBufferId());
 
-    glDisable(GL_CULL_FACE);
-    glEnable (GL_BLEND);
-    glBlendEquation (GL_FUNC_ADD);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable (GL_POLYGON_OFFSET_FILL);
+    gl.disable(GL_CULL_FACE);
+    gl.enable(GL_BLEND);
+    gl.blendEquation(GL_FUNC_ADD);
+    gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gl.disable(GL_POLYGON_OFFSET_FILL);
 
     // Setup viewport
     glViewport(0, 0, mRenderTexture->width(), mRenderTexture->height());
@@ -117,20 +119,10 @@ void TextureCapturer::endCapture() {
     glScissor(mSavedScissor[0], mSavedScissor[1],
               mSavedScissor[2], mSavedScissor[3]);
 
-    if (mIsCullFace)
-        glEnable(GL_CULL_FACE);
-    else
-        glDisable(GL_CULL_FACE);
-
-    if (mIsBlend)
-        glEnable(GL_BLEND);
-    else
-        glDisable(GL_BLEND);
-
-    if (mIsPolygonOffsetFill)
-        glEnable(GL_POLYGON_OFFSET_FILL);
-    else
-        glDisable(GL_POLYGON_OFFSET_FILL);
+    GLState& gl = GLState::getInstance();
+    gl.setEnabled(GL_CULL_FACE, mIsCullFace);
+    gl.setEnabled(GL_BLEND, mIsBlend);
+    gl.setEnabled(GL_POLYGON_OFFSET_FILL, mIsPolygonOffsetFill);
 }
 
 void TextureCapturer::render(RenderState* rstate, RenderData* render_data) {
@@ -22,6 +22,7 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "objects/scene_object.h"
+#include "util/gvr_simd.h"
 #include <math.h>
 namespace gvr {
 
@@ -40,13 +41,7 @@ void Transform::invalidate(bool rotationUpdated) {
     owner_object()->setTransformDirty();
     if (model_matrix_.isValid()) {
         model_matrix_.invalidate();
-        std::vector<SceneObject*> childrenCopy = owner_object()->children();
-        for (auto it = childrenCopy.begin(); it != childrenCopy.end(); ++it) {
-            Transform* const t = (*it)->transform();
-            if (nullptr != t) {
-                t->invalidate(false);
-            }
-        }
+        owner_object()->invalidateChildTransforms();
     }
     if (rotationUpdated) {
         // scale rotation_ if needed to avoid overflow
@@ -69,31 +64,41 @@ void Transform::invalidate(bool rotationUpdated) {
 
 glm::mat4 Transform::getModelMatrix(bool forceRecalculate) {
     if (!model_matrix_.isValid() || forceRecalculate) {
-        glm::mat4 translation_matrix = glm::translate(glm::mat4(), position_);
-        glm::mat4 rotation_matrix = glm::mat4_cast(rotation_);
-        glm::mat4 scale_matrix = glm::scale(glm::mat4(), scale_);
-
-        glm::mat4 trs_matrix = translation_matrix * rotation_matrix
-                * scale_matrix;
         if (owner_object()->parent() != 0) {
             Transform *const t = owner_object()->parent()->transform();
             if (nullptr != t) {
-                glm::mat4 model_matrix = t->getModelMatrix() * trs_matrix;
-                model_matrix_.validate(model_matrix);
+                glm::mat4 parent_matrix = t->getModelMatrix();
+                updateModelMatrix(&parent_matrix);
             }
         } else {
-            model_matrix_.validate(trs_matrix);
+            updateModelMatrix(nullptr);
         }
     }
     return model_matrix_.element();
 }
 
+void Transform::updateModelMatrix(const glm::mat4* parent_matrix) {
+    glm::mat4 trs_matrix = getLocalModelMatrix();
+
+    if (nullptr != parent_matrix) {
+        glm::mat4 model_matrix;
+        simd::multiplyMatrix(glm::value_ptr(*parent_matrix),
+                glm::value_ptr(trs_matrix), glm::value_ptr(model_matrix));
+        model_matrix_.validate(model_matrix);
+    } else {
+        model_matrix_.validate(trs_matrix);
+    }
+}
+
+/*
+ * Same as translation * rotation * scale, without the matrix products.
+ */
 glm::mat4 Transform::getLocalModelMatrix() {
-    glm::mat4 translation_matrix = glm::translate(glm::mat4(), position_);
-    glm::mat4 rotation_matrix = glm::mat4_cast(rotation_);
-    glm::mat4 scale_matrix = glm::scale(glm::mat4(), scale_);
-    glm::mat4 trs_matrix = translation_matrix * rotation_matrix
-            * scale_matrix;
+    glm::mat4 trs_matrix = glm::mat4_cast(rotation_);
+    trs_matrix[0] *= scale_.x;
+    trs_matrix[1] *= scale_.y;
+    trs_matrix[2] *= scale_.z;
+    trs_matrix[3] = glm::vec4(position_, 1.0f);
     return trs_matrix;
 }
 
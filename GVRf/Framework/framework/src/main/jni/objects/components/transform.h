@@ -180,6 +180,21 @@ public:
 
     void invalidate(bool rotationUpdated);
     glm::mat4 getModelMatrix(bool forceRecalculate = false);
+
+    /*
+     * Recompute the model matrix from the local transform and the
+     * model matrix of the parent, which must be up to date, or null
+     * for a root. Used by TransformList to update the scene top down.
+     */
+    void updateModelMatrix(const glm::mat4* parent_matrix);
+
+    /*
+     * Model matrix as last computed, without validating it.
+     */
+    const glm::mat4& cachedModelMatrix() const {
+        return model_matrix_.element();
+    }
+
     glm::mat4 getLocalModelMatrix();
     void translate(float x, float y, float z);
     void setRotationByAxis(float angle, float x, float y, float z);
@@ -28,55 +28,48 @@ namespace gvr {
 /*
  * Loads the uniforms associated with this light
  * into the GPU if they have changed.
+ * Programs which declare the uniform block of the light
+ * only need the block attached, its contents are uploaded
+ * once per render pass by bindUniformBlock.
  * @param program   ID of shader program light is bound ot
  * @param texIndex  next available texture location
  */
     void Light::render(int program, int texIndex)
     {
-        auto it = dirty_.find(program);
-
-        if (it != dirty_.end() && !it->second)
-            return;
         if (lightID_.empty())
         {
             return;
         }
+        if (useUniformBlock(program))
+        {
+            return;
+        }
+        auto it = dirty_.find(program);
+
+        if (it != dirty_.end() && !it->second)
+            return;
         dirty_[program] = false;
-        std::string key;
-        std::string lname = lightID_ + ".";
         int offset;
 
         for (auto it = floats_.begin(); it != floats_.end(); ++it)
         {
-            key = lname + it->first;
             offset = getOffset(it->first, program);
-            if (offset <= 0)
-            {
-                offset = glGetUniformLocation(program, key.c_str());
-                offsets_[it->first][program] = offset;
-            }
             if (offset >= 0)
                 glUniform1f(offset, it->second);
     #ifdef DEBUG_LIGHT
-            LOGD("LIGHT: %s = %f\n", key.c_str(), it->second);
+            LOGD("LIGHT: %s.%s = %f\n", lightID_.c_str(), it->first.c_str(), it->second);
     #endif
         }
 
         for (auto it = vec3s_.begin(); it != vec3s_.end(); ++it)
         {
             offset = getOffset(it->first, program);
-            key = lname + it->first;
-            if (offset <= 0)
-            {
-                offset = glGetUniformLocation(program, key.c_str());
-                offsets_[it->first][program] = offset;
-              }
             if (offset >= 0)
             {
                 glm::vec3 v = it->second;
                 glUniform3f(offset, v.x, v.y, v.z);
     #ifdef DEBUG_LIGHT
-                LOGD("LIGHT: %s = %f, %f, %f\n", key.c_str(), v.x, v.y, v.z);
+                LOGD("LIGHT: %s.%s = %f, %f, %f\n", lightID_.c_str(), it->first.c_str(), v.x, v.y, v.z);
     #endif
             }
         }
@@ -84,41 +77,147 @@ namespace gvr {
         for (auto it = vec4s_.begin(); it != vec4s_.end(); ++it)
         {
             offset = getOffset(it->first, program);
-            key = lname + it->first;
-            if (offset <= 0)
-            {
-                offset = glGetUniformLocation(program, key.c_str());
-                offsets_[it->first][program] = offset;
-            }
             if (offset >= 0)
             {
                 glm::vec4 v = it->second;
                 glUniform4f(offset, v.x, v.y, v.z, v.w);
     #ifdef DEBUG_LIGHT
-                LOGD("LIGHT: %s = %f, %f, %f, %f\n", key.c_str(), v.x, v.y, v.z, v.w);
+                LOGD("LIGHT: %s.%s = %f, %f, %f, %f\n", lightID_.c_str(), it->first.c_str(), v.x, v.y, v.z, v.w);
     #endif
             }
         }
         for (auto it = mat4s_.begin(); it != mat4s_.end(); ++it)
         {
             offset = getOffset(it->first, program);
-            key = lname + it->first;
-            if (offset <= 0)
-            {
-                offset = glGetUniformLocation(program, key.c_str());
-                offsets_[it->first][program] = offset;
-            }
             if (offset >= 0)
             {
                 glm::mat4 v = it->second;
                 glUniformMatrix4fv(offset, 1, GL_FALSE, glm::value_ptr(v));
     #ifdef DEBUG_LIGHT
-                LOGD("LIGHT: %s\n", key.c_str());
+                LOGD("LIGHT: %s.%s\n", lightID_.c_str(), it->first.c_str());
     #endif
             }
         }
     }
 
+    /*
+     * Attach the uniform block of this light to a program.
+     * Returns false if the program does not declare the block
+     * or no binding point is left for this light, in which case
+     * the individual uniforms have to be set.
+     */
+    bool Light::useUniformBlock(int program)
+    {
+        if (blockBinding_ < 0)
+        {
+            return false;
+        }
+        auto it = programBlocks_.find(program);
+        if (it == programBlocks_.end())
+        {
+            std::string name = "Light_" + lightID_;
+            ProgramBlock block = { glGetUniformBlockIndex(program, name.c_str()), -1 };
+            it = programBlocks_.insert(std::make_pair(program, block)).first;
+        }
+        ProgramBlock& block = it->second;
+        if (GL_INVALID_INDEX == block.index)
+        {
+            return false;
+        }
+        if (nullptr == uniformBlock_)
+        {
+            createUniformBlock(program, block.index);
+            updateUniformBlock();
+            uniformBlock_->bind(blockBinding_);
+        }
+        if (block.binding != blockBinding_)
+        {
+            glUniformBlockBinding(program, block.index, blockBinding_);
+            block.binding = blockBinding_;
+        }
+        return true;
+    }
+
+    /*
+     * Size the uniform block from the first program which declares it.
+     * The std140 layout is the same in every program, so the member
+     * offsets only have to be queried once.
+     */
+    void Light::createUniformBlock(int program, GLuint blockIndex)
+    {
+        GLint size = 0;
+        glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        uniformBlock_ = new GLUniformBlock(size);
+        blockOffsets_.clear();
+
+        std::vector<std::string> keys;
+        for (auto it = floats_.begin(); it != floats_.end(); ++it)
+            keys.push_back(it->first);
+        for (auto it = vec3s_.begin(); it != vec3s_.end(); ++it)
+            keys.push_back(it->first);
+        for (auto it = vec4s_.begin(); it != vec4s_.end(); ++it)
+            keys.push_back(it->first);
+        for (auto it = mat4s_.begin(); it != mat4s_.end(); ++it)
+            keys.push_back(it->first);
+
+        for (auto it = keys.begin(); it != keys.end(); ++it)
+        {
+            std::string name = lightID_ + "." + *it;
+            const char* names[1] = { name.c_str() };
+            GLuint index = GL_INVALID_INDEX;
+            GLint offset = -1;
+
+            glGetUniformIndices(program, 1, names, &index);
+            if (GL_INVALID_INDEX != index)
+            {
+                glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_OFFSET, &offset);
+            }
+            blockOffsets_[*it] = offset;
+        }
+        blockDirty_ = true;
+    #ifdef DEBUG_LIGHT
+        LOGD("LIGHT: %s uniform block with %d bytes\n", lightID_.c_str(), size);
+    #endif
+    }
+
+    template <class T> void Light::setBlockValues(const std::map<std::string, T>& values)
+    {
+        for (auto it = values.begin(); it != values.end(); ++it)
+        {
+            auto offset = blockOffsets_.find(it->first);
+            if (offset != blockOffsets_.end())
+            {
+                uniformBlock_->set(offset->second, &it->second, sizeof(T));
+            }
+        }
+    }
+
+    /*
+     * Copy the light values into the uniform block.
+     */
+    void Light::updateUniformBlock()
+    {
+        if (!blockDirty_)
+        {
+            return;
+        }
+        blockDirty_ = false;
+        setBlockValues(floats_);
+        setBlockValues(vec3s_);
+        setBlockValues(vec4s_);
+        setBlockValues(mat4s_);
+    }
+
+    void Light::bindUniformBlock(int binding)
+    {
+        blockBinding_ = binding;
+        if ((nullptr == uniformBlock_) || (binding < 0))
+        {
+            return;
+        }
+        updateUniformBlock();
+        uniformBlock_->bind(binding);
+    }
 
     /**
      * Renders the shadow map for this light.
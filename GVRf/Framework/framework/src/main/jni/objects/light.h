@@ -34,6 +34,7 @@
 #include "util/gvr_jni.h"
 #include "engine/renderer/renderer.h"
 #include "glm/gtc/matrix_inverse.hpp"
+#include "gl/gl_uniform_block.h"
 
 namespace gvr {
 class Color;
@@ -49,7 +50,14 @@ public:
 
     explicit Light()
     :   Component(Light::getComponentType()),
-		shadowMapIndex_(-1) {
+		shadowMapIndex_(-1),
+		uniformBlock_(nullptr),
+		blockBinding_(-1),
+		blockDirty_(true) {
+    }
+
+    ~Light() {
+        delete uniformBlock_;
     }
 
     static long long getComponentType() {
@@ -189,6 +197,14 @@ public:
      */
     void render(int program, int texIndex);
 
+    /**
+     * Internal function called at the start of each render pass
+     * to upload the uniform block of this light (if it changed)
+     * and attach it to the given binding point.
+     * @param binding   binding point, -1 if none is available
+     */
+    void bindUniformBlock(int binding);
+
     /**
      * Internal function called at the start of each frame
      * to update the shadow map.
@@ -224,23 +240,39 @@ private:
         for (auto it = dirty_.begin(); it != dirty_.end(); ++it) {
             it->second = true;
         }
+        blockDirty_ = true;
     }
 
     /*
-     * Get the GL uniform offset for a named uniform.
+     * Get the GL uniform location for a named uniform.
+     * The uniform name is only built the first time
+     * a program asks for it.
      */
-    int getOffset(std::string key, int programId) {
-        auto it = offsets_.find(key);
-        if (it != offsets_.end()) {
-            std::map<int, int> offsets = it->second;
-            auto it2 = offsets.find(programId);
-            if (it2 != offsets.end()) {
-                return it2->second;
-            }
+    int getOffset(const std::string& key, int programId) {
+        std::map<int, int>& offsets = offsets_[key];
+        auto it = offsets.find(programId);
+        if (it != offsets.end()) {
+            return it->second;
         }
-        return -1;
+        std::string name = lightID_ + "." + key;
+        int offset = glGetUniformLocation(programId, name.c_str());
+        offsets[programId] = offset;
+        return offset;
     }
 
+    bool useUniformBlock(int programId);
+    void createUniformBlock(int programId, GLuint blockIndex);
+    void updateUniformBlock();
+    template <class T> void setBlockValues(const std::map<std::string, T>& values);
+
+    /*
+     * Index and binding point of the light block in a program.
+     */
+    struct ProgramBlock {
+        GLuint index;
+        int binding;
+    };
+
 private:
     int shadowMapIndex_;
     std::string lightID_;
@@ -250,6 +282,13 @@ private:
     std::map<std::string, glm::vec4> vec4s_;
     std::map<std::string, glm::mat4> mat4s_;
     std::map<std::string, std::map<int, int> > offsets_;
+
+    // std140 block "Light_<lightID>" shared by all programs declaring it
+    GLUniformBlock* uniformBlock_;
+    int blockBinding_;
+    bool blockDirty_;
+    std::map<std::string, int> blockOffsets_;
+    std::map<int, ProgramBlock> programBlocks_;
 };
 }
 #endif
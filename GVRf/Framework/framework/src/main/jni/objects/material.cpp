@@ -0,0 +1,127 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Links textures and shaders.
+ ***************************************************************************/
+
+#include "material.h"
+#include "objects/textures/texture_array.h"
+
+namespace gvr {
+
+static const std::string MAIN_TEXTURE("main_texture");
+
+std::atomic<uint32_t> Material::next_id_(0);
+
+/*
+ * FNV-1a over the bytes of a value.
+ */
+template<typename T> static inline uint64_t hashValue(uint64_t hash, const T& value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+template<typename T> static inline uint64_t hashMap(uint64_t hash,
+        const std::map<std::string, T>& values) {
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        hash = hashValue(hash, std::hash<std::string>()(it->first));
+        hash = hashValue(hash, it->second);
+    }
+    return hash;
+}
+
+void Material::updateBatchKey() {
+    TextureArray* atlas = nullptr;
+    int layer = -1;
+
+    if (NULL != main_texture) {
+        atlas = main_texture->atlas();
+        layer = main_texture->atlas_layer();
+        if ((nullptr == atlas) && (TEXTURE_SHADER == shader_type_)
+                && main_texture->atlasable()) {
+            TextureAtlas::getInstance().request(main_texture);
+        }
+    }
+    if ((atlas != batch_atlas_) || (layer != batch_layer_)) {
+        batch_atlas_ = atlas;
+        batch_layer_ = layer;
+        dirty();
+    }
+    if (!batch_key_dirty_) {
+        return;
+    }
+    batch_key_dirty_ = false;
+
+    if (nullptr == batch_atlas_) {
+        batch_key_ = id_;
+        return;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+
+    hash = hashValue(hash, shader_type_);
+    hash = hashValue(hash, shader_feature_set_);
+    hash = hashValue(hash, batch_atlas_);
+    for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+        if (it->first != MAIN_TEXTURE) {
+            hash = hashValue(hash, std::hash<std::string>()(it->first));
+            hash = hashValue(hash, it->second);
+        }
+    }
+    hash = hashMap(hash, floats_);
+    hash = hashMap(hash, vec2s_);
+    hash = hashMap(hash, vec3s_);
+    hash = hashMap(hash, vec4s_);
+    hash = hashMap(hash, mat4s_);
+    batch_key_ = hash;
+}
+
+bool Material::batchEquals(const Material& material) const {
+    if (this == &material) {
+        return true;
+    }
+    if ((nullptr == batch_atlas_) || (batch_key_ != material.batch_key_)
+            || (batch_atlas_ != material.batch_atlas_)
+            || (shader_type_ != material.shader_type_)
+            || (shader_feature_set_ != material.shader_feature_set_)
+            || (textures_.size() != material.textures_.size())) {
+        return false;
+    }
+    for (auto it = textures_.begin(), other = material.textures_.begin();
+            it != textures_.end(); ++it, ++other) {
+        if ((it->first != other->first)
+                || ((it->first != MAIN_TEXTURE) && (it->second != other->second))) {
+            return false;
+        }
+    }
+    return (floats_ == material.floats_) && (vec2s_ == material.vec2s_)
+            && (vec3s_ == material.vec3s_) && (vec4s_ == material.vec4s_)
+            && (mat4s_ == material.mat4s_);
+}
+
+void Material::markTexturesUsed() const {
+    for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+        it->second->markUsed();
+    }
+    if (nullptr != batch_atlas_) {
+        batch_atlas_->markUsed();
+    }
+}
+
+}
@@ -20,10 +20,13 @@
 #ifndef MATERIAL_H_
 #define MATERIAL_H_
 
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <unordered_set>
 #include <string>
+#include <vector>
 
 #include "glm/glm.hpp"
 
@@ -65,7 +68,12 @@ public:
             vec2s_(),
             vec3s_(),
             vec4s_(),
-            shader_feature_set_(0)
+            shader_feature_set_(0),
+            id_(next_id_++),
+            batch_key_(id_),
+            batch_key_dirty_(true),
+            batch_atlas_(nullptr),
+            batch_layer_(-1)
     {
         switch (shader_type) {
         default:
@@ -110,7 +118,18 @@ public:
     }
 
     void setTexture(const std::string& key, Texture* texture) {
-        textures_[key] = texture;
+        Texture*& slot = textures_[key];
+        bool streamed = texture->streamed() || ((slot != NULL) && slot->streamed());
+
+        slot = texture;
+        if (streamed) {
+            streamed_textures_.clear();
+            for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+                if (it->second->streamed()) {
+                    streamed_textures_.push_back(it->second);
+                }
+            }
+        }
         //By the time the texture is being set to its attaching material, it is ready
         //This is guaranteed by upper java layer scheduling
         texture->setReady(true);
@@ -219,7 +238,13 @@ public:
 
     void set_shader_feature_set(int feature_set) {
         shader_feature_set_ = feature_set;
+        dirty();
     }
+    // textures which load their mip levels when they are drawn big enough
+    const std::vector<Texture*>& streamed_textures() const {
+        return streamed_textures_;
+    }
+
     bool isMainTextureReady() {
         return (main_texture != NULL) && main_texture->isReady();
     }
@@ -233,9 +258,59 @@ public:
     }
 
     void dirty() {
+        batch_key_dirty_ = true;
         dirtyImpl(dirty_flags_);
     }
 
+    /*
+     * Sequential number of the material, unique and independent of
+     * where the material was allocated.
+     */
+    uint32_t id() const {
+        return id_;
+    }
+
+    /*
+     * Materials with the same key may be drawn in one batch. The key
+     * is the id of the material unless its main texture has been copied
+     * into a TextureArray by the TextureAtlas, then it is a hash of
+     * the shader, the uniforms, the other textures and the array.
+     */
+    uint64_t batch_key() const {
+        return batch_key_;
+    }
+
+    // array holding the main texture as of the last updateBatchKey()
+    TextureArray* batch_atlas() const {
+        return batch_atlas_;
+    }
+
+    int batch_layer() const {
+        return batch_layer_;
+    }
+
+    /*
+     * Called by the BatchManager on the GL thread before batching.
+     * Picks up main textures moved in or out of an atlas, dirtying
+     * the render data so they are batched again, and requests the
+     * copy of the main texture of a texture shader material.
+     */
+    void updateBatchKey();
+
+    /*
+     * Whether the material can be drawn in the same batch as this one,
+     * using its own layer of the same texture array.
+     */
+    bool batchEquals(const Material& material) const;
+
+    /*
+     * Stamp all the textures of the material, and the texture array
+     * its main texture was copied to, as used this frame so the
+     * TextureResidency does not evict them. Called by the renderer
+     * whatever shader draws the material.
+     */
+    void markTexturesUsed() const;
+
     private:
     Material(const Material& material);
     Material(Material&& material);
@@ -246,6 +321,7 @@ private:
     ShaderType shader_type_;
     std::map<std::string, Texture*> textures_;
     Texture* main_texture = NULL;
+    std::vector<Texture*> streamed_textures_;
     std::map<std::string, float> floats_;
     std::map<std::string, glm::vec2> vec2s_;
     std::map<std::string, glm::vec3> vec3s_;
@@ -254,6 +330,13 @@ private:
     std::unordered_set<std::shared_ptr<bool>> dirty_flags_;
 
     unsigned int shader_feature_set_;
+
+    static std::atomic<uint32_t> next_id_;
+    const uint32_t id_;
+    uint64_t batch_key_;
+    bool batch_key_dirty_;
+    TextureArray* batch_atlas_;
+    int batch_layer_;
 };
 
 }
@@ -17,7 +17,11 @@
  * The mesh for rendering.
  ***************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include "mesh.h"
+#include "mesh_bvh.h"
 
 #include "assimp/Importer.hpp"
 #include "glm/gtc/matrix_inverse.hpp"
@@ -25,7 +29,8 @@
 
 namespace gvr {
 
-    std::vector<std::string> Mesh::dynamicAttribute_Names_ = {"a_bone_indices", "a_bone_weights"};
+    std::vector<std::string> Mesh::dynamicAttribute_Names_ = {"a_bone_indices", "a_bone_weights",
+                                                              "a_model_instance"};
 
     Mesh *Mesh::createBoundingBox() {
 
@@ -173,17 +178,325 @@ namespace gvr {
         }
     }
 
-    void Mesh::createAttributeMapping(int programId, int& totalStride, int &attrLen) {
-        totalStride = attrLen = 0;
-        if (programId == -1) {
-            // If program id has not been set, return.
+    /*
+     * Lay out every attribute the mesh has in a single interleaved vertex,
+     * independent of the programs which will read it.
+     */
+    void Mesh::createVertexLayout(std::map<std::string, GLVertexAttribute>& layout,
+                                  int& stride) {
+        stride = 0;
+        auto add = [&layout, &stride](const std::string& name, int size, size_t length) {
+            if (length > 0 && layout.find(name) == layout.end()) {
+                GLVertexAttribute attr = { (GLuint) size, (GLuint) stride };
+                layout[name] = attr;
+                stride += size;
+            }
+        };
+
+        add("a_position", 3, vertices_.size());
+        add("a_normal", 3, normals_.size());
+        for (auto it = float_vectors_.begin(); it != float_vectors_.end(); ++it) {
+            add(it->first, 1, it->second.size());
+        }
+        for (auto it = vec2_vectors_.begin(); it != vec2_vectors_.end(); ++it) {
+            add(it->first, 2, it->second.size());
+        }
+        for (auto it = vec3_vectors_.begin(); it != vec3_vectors_.end(); ++it) {
+            add(it->first, 3, it->second.size());
+        }
+        for (auto it = vec4_vectors_.begin(); it != vec4_vectors_.end(); ++it) {
+            add(it->first, 4, it->second.size());
+        }
+    }
+
+    /*
+     * Copy count vertices of one attribute, starting at vertex first,
+     * into the interleaved buffer.
+     */
+    void Mesh::copyAttribute(std::vector<GLfloat>& buffer, const float* data,
+                             int size, int first, int count, const std::string& name) {
+        auto it = vertex_layout_.find(name);
+        // empty, or shadowed by an attribute of the same name and another type
+        if (count <= 0 || it == vertex_layout_.end() || it->second.size != size) {
             return;
         }
+        GLfloat* dst = buffer.data() + first * vertex_stride_ + it->second.offset;
+
+        data += first * size;
+        for (int i = 0; i < count; ++i) {
+            for (int k = 0; k < size; ++k) {
+                dst[k] = data[k];
+            }
+            dst += vertex_stride_;
+            data += size;
+        }
+    }
+
+    void Mesh::copyAttribute(std::vector<GLfloat>& buffer, const float* data,
+                             int size, int length, const std::string& name) {
+        if (length != 0 && length != vertex_count_) {
+            LOGE("mesh: attribute %s has %d entries for %d vertices", name.c_str(), length,
+                 vertex_count_);
+            if (length > vertex_count_) {
+                length = vertex_count_;
+            }
+        }
+        copyAttribute(buffer, data, size, 0, length, name);
+    }
+
+    /*
+     * Find the CPU copy of an attribute, returns the number of floats
+     * per vertex or 0 if the mesh does not have the attribute.
+     */
+    int Mesh::findAttribute(const std::string& name, float*& data, int& length) {
+        if (name == "a_position") {
+            data = (float*) vertices_.data();
+            length = vertices_.size();
+            return 3;
+        }
+        if (name == "a_normal") {
+            data = (float*) normals_.data();
+            length = normals_.size();
+            return 3;
+        }
+        auto it1 = float_vectors_.find(name);
+        if (it1 != float_vectors_.end()) {
+            data = it1->second.data();
+            length = it1->second.size();
+            return 1;
+        }
+        auto it2 = vec2_vectors_.find(name);
+        if (it2 != vec2_vectors_.end()) {
+            data = (float*) it2->second.data();
+            length = it2->second.size();
+            return 2;
+        }
+        auto it3 = vec3_vectors_.find(name);
+        if (it3 != vec3_vectors_.end()) {
+            data = (float*) it3->second.data();
+            length = it3->second.size();
+            return 3;
+        }
+        auto it4 = vec4_vectors_.find(name);
+        if (it4 != vec4_vectors_.end()) {
+            data = (float*) it4->second.data();
+            length = it4->second.size();
+            return 4;
+        }
+        return 0;
+    }
+
+    bool Mesh::updateVertexAttribute(const std::string& name, int first, const float* values,
+                                     int count) {
+        float* data;
+        int length;
+        int size = findAttribute(name, data, length);
+
+        if (size == 0 || first < 0 || count < 0 || first + count > length) {
+            LOGE("mesh: cannot update vertices %d to %d of attribute %s", first, first + count,
+                 name.c_str());
+            return false;
+        }
+        std::copy(values, values + count * size, data + first * size);
+        if (name == "a_position") {
+            have_bounding_volume_ = false;
+            getBoundingVolume();
+            dirty();
+        }
+
+        // static meshes and meshes waiting for a full upload re-upload everything
+        if (!dynamic_ || vao_dirty_ || vertex_buffer_.empty()) {
+            vao_dirty_ = true;
+            return true;
+        }
+        copyAttribute(vertex_buffer_, data, size, first, count, name);
+        markDirtyRange(first, first + count);
+        return true;
+    }
+
+    /*
+     * Record a range of vertices which has to be streamed into each of
+     * the dynamic vertex buffers before it is drawn again.
+     */
+    void Mesh::markDirtyRange(int begin, int end) {
+        for (int i = 0; i < DYNAMIC_BUFFER_COUNT; ++i) {
+            DirtyRange& range = dirty_ranges_[i];
+            if (range.begin >= range.end) {
+                range.begin = begin;
+                range.end = end;
+            } else {
+                range.begin = std::min(range.begin, begin);
+                range.end = std::max(range.end, end);
+            }
+        }
+        stream_pending_ = true;
+    }
+
+    void Mesh::deleteVertexBuffers() {
+        if (dynamic_vboIDs_[0] != 0) {
+            GL(glDeleteBuffers(DYNAMIC_BUFFER_COUNT, dynamic_vboIDs_));
+            for (int i = 0; i < DYNAMIC_BUFFER_COUNT; ++i) {
+                dynamic_vboIDs_[i] = 0;
+            }
+        } else if (vboID_ != 0) {
+            GL(glDeleteBuffers(1, &vboID_));
+        }
+        if (iboID_ != 0) {
+            GL(glDeleteBuffers(1, &iboID_));
+        }
+        vboID_ = iboID_ = 0;
+        vertex_buffer_.clear();
+        vertex_count_ = 0;
+    }
+
+    /*
+     * Upload the vertex and index data into the buffers shared by all
+     * programs. The VAOs only have to be set up again if the layout of
+     * the vertex changed.
+     */
+    void Mesh::updateVertexBuffer() {
+        if (vertices_.size() == 0 && normals_.size() == 0) {
+            std::string error = "no vertex data yet, shouldn't call here. ";
+            throw error;
+        }
+        if (0 != normals_.size() && vertices_.size() != normals_.size()) {
+            LOGW("mesh: number of vertices and normals do not match! vertices %d, normals %d",
+                 vertices_.size(), normals_.size());
+        }
+
+        std::map<std::string, GLVertexAttribute> layout;
+        int stride;
+        createVertexLayout(layout, stride);
+        bool resized = false;
+        if (stride != vertex_stride_ || layout != vertex_layout_) {
+            vertex_layout_.swap(layout);
+            vertex_stride_ = stride;
+            ++layout_version_;
+            resized = true;
+        }
+        int vertex_count = vertices_.size() ? vertices_.size() : normals_.size();
+        if (vertex_count != vertex_count_) {
+            vertex_count_ = vertex_count;
+            resized = true;
+        }
+        // switched between static and dynamic buffers
+        if (dynamic_ != (dynamic_vboIDs_[0] != 0) && vboID_ != 0) {
+            deleteVertexBuffers();
+            vertex_count_ = vertex_count;
+            // buffer names may be reused, make sure every VAO is set up again
+            ++layout_version_;
+            resized = true;
+        }
+
+        // dynamic meshes keep the interleaved data for partial updates
+        std::vector<GLfloat> static_buffer;
+        std::vector<GLfloat>& buffer = dynamic_ ? vertex_buffer_ : static_buffer;
+        buffer.assign(vertex_count * vertex_stride_, 0.0f);
+
+        copyAttribute(buffer, (const float*) vertices_.data(), 3, vertices_.size(), "a_position");
+        copyAttribute(buffer, (const float*) normals_.data(), 3, normals_.size(), "a_normal");
+        for (auto it = float_vectors_.begin(); it != float_vectors_.end(); ++it) {
+            copyAttribute(buffer, it->second.data(), 1, it->second.size(), it->first);
+        }
+        for (auto it = vec2_vectors_.begin(); it != vec2_vectors_.end(); ++it) {
+            copyAttribute(buffer, (const float*) it->second.data(), 2, it->second.size(),
+                          it->first);
+        }
+        for (auto it = vec3_vectors_.begin(); it != vec3_vectors_.end(); ++it) {
+            copyAttribute(buffer, (const float*) it->second.data(), 3, it->second.size(),
+                          it->first);
+        }
+        for (auto it = vec4_vectors_.begin(); it != vec4_vectors_.end(); ++it) {
+            copyAttribute(buffer, (const float*) it->second.data(), 4, it->second.size(),
+                          it->first);
+        }
+
+        if (iboID_ == 0) {
+            glGenBuffers(1, &iboID_);
+        }
+        if (!dynamic_) {
+            if (vboID_ == 0) {
+                glGenBuffers(1, &vboID_);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, vboID_);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * buffer.size(), buffer.data(),
+                         GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        } else if (resized || dynamic_vboIDs_[0] == 0) {
+            if (dynamic_vboIDs_[0] == 0) {
+                glGenBuffers(DYNAMIC_BUFFER_COUNT, dynamic_vboIDs_);
+            }
+            for (int i = 0; i < DYNAMIC_BUFFER_COUNT; ++i) {
+                glBindBuffer(GL_ARRAY_BUFFER, dynamic_vboIDs_[i]);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * buffer.size(), buffer.data(),
+                             GL_STREAM_DRAW);
+                dirty_ranges_[i].begin = dirty_ranges_[i].end = 0;
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            vboID_ = dynamic_vboIDs_[dynamic_slot_];
+            stream_pending_ = false;
+        } else {
+            // same size, stream it like a partial update
+            markDirtyRange(0, vertex_count);
+        }
+
+        // the element array binding is VAO state, don't disturb the current VAO
+        glBindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID_);
+        if (int_indices_.empty()) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indices_.size(),
+                         indices_.data(), GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * int_indices_.size(),
+                         int_indices_.data(), GL_STATIC_DRAW);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        numTriangles_ = getIndexCount() / 3;
+        vao_dirty_ = false;
+    }
+
+    /*
+     * Move on to the next dynamic vertex buffer and upload the vertices
+     * which changed since it was written last. Rotating through several
+     * buffers avoids waiting for the GPU to finish drawing the previous
+     * contents.
+     */
+    void Mesh::streamVertexBuffer() {
+        dynamic_slot_ = (dynamic_slot_ + 1) % DYNAMIC_BUFFER_COUNT;
+        vboID_ = dynamic_vboIDs_[dynamic_slot_];
+
+        DirtyRange& range = dirty_ranges_[dynamic_slot_];
+        if (range.begin < range.end) {
+            const GLintptr offset = range.begin * vertex_stride_ * sizeof(GLfloat);
+            const GLsizeiptr size = (range.end - range.begin) * vertex_stride_ * sizeof(GLfloat);
+            const GLfloat* src = vertex_buffer_.data() + range.begin * vertex_stride_;
+
+            glBindBuffer(GL_ARRAY_BUFFER, vboID_);
+            void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (dst != nullptr) {
+                memcpy(dst, src, size);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, src);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        range.begin = range.end = 0;
+        stream_pending_ = false;
+    }
+
+    /*
+     * Find the active attributes of the program in the vertex layout.
+     * The VAO of the program must be bound.
+     */
+    void Mesh::bindVertexAttributes(int programId, GLVaoId& id) {
         GLint numActiveAtributes;
         glGetProgramiv(programId, GL_ACTIVE_ATTRIBUTES, &numActiveAtributes);
         GLchar attrName[512];
-        GLAttributeMapping attrData;
 
+        id.pointers.clear();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID_);
         for (int i = 0; i < numActiveAtributes; i++) {
             GLsizei length;
             GLint size;
@@ -191,122 +504,52 @@ namespace gvr {
             glGetActiveAttrib(programId, i, 512, &length, &size, &type, attrName);
             if (std::find(dynamicAttribute_Names_.begin(), dynamicAttribute_Names_.end(),
                           attrName) != dynamicAttribute_Names_.end()) {
-                // Skip dynamic attributes. Currently only bones are dynamic attributes which changes each frame.
-                // They are handled seperately.
+                // Skip dynamic attributes. Currently bones and the instance matrices are dynamic
+                // attributes which change each frame. They are handled seperately.
+                continue;
             }
-            else {
-                attrData.type = GL_FLOAT;
-                int loc = glGetAttribLocation(programId, attrName);
-                attrData.index = loc;
-                attrData.data = NULL;
-                attrData.offset = totalStride;
-                bool addData = true;
-                int len = 0;
-
-                // Two things to note --
-                // 1. The 3 builtin buffers are still seperate from the maps used for the other attributes
-                // 2. The attribute index *has* to be 0, 1 and 2 for position, tex_coords and normal. The
-                // index from querying via glGetActiveAttrib cannot be used. Needs analysis.
-                if (strcmp(attrName, "a_position") == 0) {
-                    attrData.size = 3;
-                    len = vertices_.size();
-                    attrData.data = vertices_.data();
-                }
-                else if (strcmp(attrName, "a_normal") == 0) {
-                    attrData.size = 3;
-                    len = normals_.size();
-                    attrData.data = normals_.data();
-                }
-                else {
-
-                    switch (type) {
-                        case GL_FLOAT:
-                            attrData.size = 1;
-                            {
-                                const std::vector<float> &curr = getFloatVector(attrName);
-                                len = curr.size();
-                                attrData.data = curr.data();
-                            }
-                            break;
-                        case GL_FLOAT_VEC2:
-                            attrData.size = 2;
-                            {
-                                const std::vector<glm::vec2> &curr = getVec2Vector(attrName);
-                                len = curr.size();
-                                attrData.data = curr.data();
-                            }
-                            break;
-                        case GL_FLOAT_VEC3:
-                            attrData.size = 3;
-                            {
-                                const std::vector<glm::vec3> &curr = getVec3Vector(attrName);
-                                len = curr.size();
-                                attrData.data = curr.data();
-                            }
-                            break;
-                        case GL_FLOAT_VEC4:
-                            attrData.size = 4;
-                            {
-                                const std::vector<glm::vec4> &curr = getVec4Vector(attrName);
-                                len = curr.size();
-                                attrData.data = curr.data();
-                            }
-                            break;
-                        default:
-                            addData = false;
-                            LOGE("Looking up %s failed ", attrName);
-                            break;
-                    }
-                }
-                if (addData) {
-                    totalStride += attrData.size;
-                    attrMapping.push_back(attrData);
-                    if (attrLen == 0)
-                        attrLen = len;
-                    else {
-                        if (len != attrLen)
-                            LOGE(" $$$$*** Attib length does not match %d vs %d", len, attrLen);
-                    }
-                }
+            int loc = glGetAttribLocation(programId, attrName);
+            auto it = vertex_layout_.find(attrName);
+            if (loc < 0) {
+                continue;
             }
+            if (it == vertex_layout_.end()) {
+                LOGE("Looking up %s failed ", attrName);
+                glDisableVertexAttribArray(loc);
+                continue;
+            }
+            GLAttributePointer pointer = { (GLuint) loc, it->second };
+            id.pointers.push_back(pointer);
+            glEnableVertexAttribArray(loc);
         }
+        pointVertexAttributes(id);
     }
 
-    void Mesh::createBuffer(std::vector<GLfloat> &buffer, int attrLength) {
-        for (int i = 0; i < attrLength; i++) {
-            for (auto it = attrMapping.begin(); it != attrMapping.end(); ++it) {
-                GLAttributeMapping currAttr = *it;
-                const float *ptr = (float *) currAttr.data;
-                for (int k = 0; k < currAttr.size; k++) {
-                    buffer.push_back(ptr[i * currAttr.size + k]);
-                }
-            }
+    /*
+     * Point the attributes of a VAO at the current vertex buffer.
+     * The VAO must be bound.
+     */
+    void Mesh::pointVertexAttributes(GLVaoId& id) {
+        glBindBuffer(GL_ARRAY_BUFFER, vboID_);
+        for (auto it = id.pointers.begin(); it != id.pointers.end(); ++it) {
+            glVertexAttribPointer(it->location, it->attribute.size, GL_FLOAT, 0,
+                                  vertex_stride_ * sizeof(GLfloat),
+                                  (GLvoid *) (it->attribute.offset * sizeof(GLfloat)));
         }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        id.vboID = vboID_;
     }
 
-
     const GLuint Mesh::getVAOId(int programId) {
         if (programId == -1) {
             LOGI("!! %p Prog Id -- %d ", this, programId);
             return 0;
         }
-        if (vao_dirty_)
-        {
-            generateVAO(programId);
-        }
-        auto it = program_ids_.find(programId);
-        if (it != program_ids_.end())
-        {
-            GLVaoVboId id = it->second;
-            return id.vaoID;
-        }
-        vao_dirty_ = true;
         generateVAO(programId);
-        it = program_ids_.find(programId);
+        auto it = program_ids_.find(programId);
         if (it != program_ids_.end())
         {
-            GLVaoVboId id = it->second;
-            return id.vaoID;
+            return it->second.vaoID;
         }
         LOGI("!! %p Error in creating VAO  for Prog Id -- %d", this, programId);
         return 0;
@@ -314,79 +557,35 @@ namespace gvr {
 
 // generate vertex array object
     void Mesh::generateVAO(int programId) {
-        if (!vao_dirty_) {
-             return;
+        if (vao_dirty_) {
+            updateVertexBuffer();
         }
-
-        if (vertices_.size() == 0 && normals_.size() == 0) {
-            std::string error = "no vertex data yet, shouldn't call here. ";
-            throw error;
-        }
-        if (0 != normals_.size() && vertices_.size() != normals_.size()) {
-            LOGW("mesh: number of vertices and normals do not match! vertices %d, normals %d",
-                 vertices_.size(), normals_.size());
+        if (dynamic_ && stream_pending_) {
+            streamVertexBuffer();
         }
 
-        GLuint vaoID_;
-        GLuint triangle_vboID_;
-        GLuint static_vboID_;
         auto it = program_ids_.find(programId);
-        if (it != program_ids_.end()) {
-
-            GLVaoVboId ids = it->second;
-            vaoID_ = ids.vaoID;
-            triangle_vboID_ = ids.triangle_vboID;
-            static_vboID_ = ids.static_vboID;
-        }
-        else {
-            glGenVertexArrays(1, &vaoID_);
-            glGenBuffers(1, &triangle_vboID_);
-            glGenBuffers(1, &static_vboID_);
+        if (it != program_ids_.end() && it->second.layout_version == layout_version_) {
+            if (it->second.vboID != vboID_) {
+                glBindVertexArray(it->second.vaoID);
+                pointVertexAttributes(it->second);
+                glBindVertexArray(0);
+            }
+            return;
         }
 
-
-        glBindVertexArray(vaoID_);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_vboID_);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indices_.size(),
-                     &indices_[0], GL_STATIC_DRAW);
-        numTriangles_ = indices_.size() / 3;
-
-        attrMapping.clear();
-        int totalStride;
-        int attrLength;
-        createAttributeMapping(programId, totalStride, attrLength);
-
-        std::vector<GLfloat> buffer;
-        createBuffer(buffer, attrLength);
-        glBindBuffer(GL_ARRAY_BUFFER, static_vboID_);
-
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * buffer.size(), &buffer[0],
-                     GL_STATIC_DRAW);
-        int localCnt = 0;
-        for (std::vector<GLAttributeMapping>::iterator it = attrMapping.begin();
-             it != attrMapping.end(); ++it) {
-            GLAttributeMapping currData = *it;
-            glVertexAttribPointer(currData.index, currData.size, currData.type, 0,
-                                  totalStride * sizeof(GLfloat),
-                                  (GLvoid *) (currData.offset * sizeof(GLfloat)));
-            glEnableVertexAttribArray(currData.index);
+        GLVaoId& id = program_ids_[programId];
+        if (it == program_ids_.end()) {
+            glGenVertexArrays(1, &id.vaoID);
         }
+        id.layout_version = layout_version_;
 
+        glBindVertexArray(id.vaoID);
+        bindVertexAttributes(programId, id);
 
         // done generation
         glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-        if (it == program_ids_.end())
-        {
-            GLVaoVboId id;
-            id.vaoID = vaoID_;
-            id.static_vboID = static_vboID_;
-            id.triangle_vboID = triangle_vboID_;
-            program_ids_[programId] = id;
-        }
-        vao_dirty_ = false;
     }
 
     void Mesh::getAttribNames(std::set<std::string> &attrib_names) {
@@ -438,8 +637,7 @@ namespace gvr {
             LOGV("Invalid program Id for bones");
             return;
         }
-        GLVaoVboId id = it->second;
-        glBindVertexArray(id.vaoID);
+        glBindVertexArray(it->second.vaoID);
 
         // BoneID
         GLuint boneVboID;
@@ -473,4 +671,18 @@ namespace gvr {
         dirtyImpl(dirty_flags_);
     }
 
+    std::shared_ptr<MeshBVH> Mesh::getBVH() {
+        std::lock_guard<std::mutex> lock(bvh_mutex_);
+
+        if (*bvh_dirty_ || (nullptr == bvh_)) {
+            if (!int_indices_.empty()) {
+                bvh_ = std::make_shared<MeshBVH>(vertices_, int_indices_);
+            } else {
+                bvh_ = std::make_shared<MeshBVH>(vertices_, indices_);
+            }
+            *bvh_dirty_ = false;
+        }
+        return bvh_;
+    }
+
 }
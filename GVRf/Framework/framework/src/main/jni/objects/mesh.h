@@ -22,6 +22,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <set>
@@ -40,22 +41,37 @@
 #include "objects/vertex_bone_data.h"
 
 namespace gvr {
+class MeshBVH;
+
 class Mesh: public HybridObject {
 public:
     Mesh() :
             vertices_(),
             normals_(),
             indices_(),
+            int_indices_(),
             float_vectors_(),
             vec2_vectors_(),
             vec3_vectors_(),
             vec4_vectors_(),
             have_bounding_volume_(false),
             vao_dirty_(true),
+            vboID_(0),
+            iboID_(0),
+            vertex_stride_(0),
+            vertex_count_(0),
+            layout_version_(0),
+            dynamic_(false),
+            stream_pending_(false),
+            dynamic_slot_(0),
+            dynamic_vboIDs_(),
+            dirty_ranges_(),
             boneVboID_(0),
             vertexBoneData_(this),
-            bone_data_dirty_(true)
+            bone_data_dirty_(true),
+            bvh_dirty_(std::make_shared<bool>(true))
     {
+        dirty_flags_.insert(bvh_dirty_);
     }
 
     ~Mesh() {
@@ -72,6 +88,9 @@ public:
         normals.swap(normals_);
         std::vector<unsigned short> indices;
         indices.swap(indices_);
+        std::vector<unsigned int> int_indices;
+        int_indices.swap(int_indices_);
+        *bvh_dirty_ = true;
 
         deleteVaos();
     }
@@ -82,10 +101,7 @@ public:
         auto it = program_ids_.find(programId);
         if (it != program_ids_.end())
         {
-            GLVaoVboId ids = it->second;
-            GL(glDeleteVertexArrays(1, &ids.vaoID));
-            GL(glDeleteBuffers(1, &ids.static_vboID));
-            GL(glDeleteBuffers(1, &ids.triangle_vboID));
+            GL(glDeleteVertexArrays(1, &it->second.vaoID));
             program_ids_.erase(it);
         }
     }
@@ -96,12 +112,12 @@ public:
     void deleteVaos() {
         for (auto it : program_ids_ )
         {
-            GLVaoVboId ids = it.second;
-            GL(glDeleteVertexArrays(1, &ids.vaoID));
-            GL(glDeleteBuffers(1, &ids.static_vboID));
-            GL(glDeleteBuffers(1, &ids.triangle_vboID));
+            GL(glDeleteVertexArrays(1, &it.second.vaoID));
         }
         program_ids_.clear();
+        deleteVertexBuffers();
+        vertex_layout_.clear();
+        vertex_stride_ = 0;
         have_bounding_volume_ = false;
         vao_dirty_ = true;
         bone_data_dirty_ = true;
@@ -148,33 +164,79 @@ public:
     }
 
     void set_triangles(const std::vector<unsigned short>& triangles) {
-        indices_ = triangles;
-        vao_dirty_ = true;
-        dirty();
+        set_indices(triangles);
     }
 
     void set_triangles(std::vector<unsigned short>&& triangles) {
-        indices_ = std::move(triangles);
-        vao_dirty_ = true;
-        dirty();
+        set_indices(std::move(triangles));
     }
 
+    /**
+     * The 16 bit indices. Empty if the mesh uses 32 bit indices.
+     */
     const std::vector<unsigned short>& indices() const {
         return indices_;
     }
 
     void set_indices(const std::vector<unsigned short>& indices) {
         indices_ = indices;
+        int_indices_.clear();
         vao_dirty_ = true;
         dirty();
     }
 
     void set_indices(std::vector<unsigned short>&& indices) {
         indices_ = std::move(indices);
+        int_indices_.clear();
         vao_dirty_ = true;
         dirty();
     }
 
+    /**
+     * The 32 bit indices. Empty if the mesh uses 16 bit indices.
+     * Setting either kind of indices replaces the other one.
+     */
+    const std::vector<unsigned int>& int_indices() const {
+        return int_indices_;
+    }
+
+    void set_int_indices(const std::vector<unsigned int>& indices) {
+        int_indices_ = indices;
+        indices_.clear();
+        vao_dirty_ = true;
+        dirty();
+    }
+
+    void set_int_indices(std::vector<unsigned int>&& indices) {
+        int_indices_ = std::move(indices);
+        indices_.clear();
+        vao_dirty_ = true;
+        dirty();
+    }
+
+    /**
+     * Size in bytes of a single index, 2 or 4.
+     */
+    int index_size() const {
+        return int_indices_.empty() ? sizeof(unsigned short)
+                : sizeof(unsigned int);
+    }
+
+    /**
+     * Index type to pass to glDrawElements.
+     */
+    GLenum getIndexType() const {
+        return int_indices_.empty() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    int getIndexCount() const {
+        return int_indices_.empty() ? indices_.size() : int_indices_.size();
+    }
+
+    unsigned int getIndex(int i) const {
+        return int_indices_.empty() ? indices_[i] : int_indices_[i];
+    }
+
     bool hasAttribute(std::string key) const {
         if (vec3_vectors_.find(key) != vec3_vectors_.end()) {
             return true;
@@ -310,6 +372,43 @@ public:
         LOGD("SHADER: setVertexAttrib %s\n", key.c_str());
     }
 
+    /**
+     * Dynamic meshes stream their vertices into several rotating
+     * GL_STREAM_DRAW buffers and only upload the vertices changed
+     * through updateVertexAttribute(). Static meshes re-upload the
+     * whole buffer whenever anything changes.
+     */
+    void set_dynamic(bool dynamic) {
+        if (dynamic_ != dynamic) {
+            dynamic_ = dynamic;
+            vao_dirty_ = true;
+        }
+    }
+
+    bool dynamic() const {
+        return dynamic_;
+    }
+
+    /**
+     * Overwrite count vertices of an attribute starting at vertex first,
+     * and mark only that range dirty. values holds count times the
+     * number of floats per vertex of the attribute.
+     * Returns false if the attribute does not exist or the range is
+     * out of bounds.
+     */
+    bool updateVertexAttribute(const std::string& name, int first, const float* values,
+            int count);
+
+    /**
+     * Number of floats per vertex of an attribute, 0 if the mesh
+     * does not have it.
+     */
+    int getAttributeSize(const std::string& name) {
+        float* data;
+        int length;
+        return findAttribute(name, data, length);
+    }
+
     const GLuint getVAOId(int programId);
 
     GLuint getNumTriangles() {
@@ -318,6 +417,13 @@ public:
 
     const BoundingVolume& getBoundingVolume();
 
+    /**
+     * Hierarchy over the triangles for ray picking, built on first use
+     * and rebuilt after the positions or indices change. May be called
+     * from any thread.
+     */
+    std::shared_ptr<MeshBVH> getBVH();
+
     bool hasBones() const {
         return vertexBoneData_.getNumBones();
     }
@@ -360,6 +466,7 @@ private:
     std::map<std::string, std::vector<glm::vec3>> vec3_vectors_;
     std::map<std::string, std::vector<glm::vec4>> vec4_vectors_;
     std::vector<unsigned short> indices_;
+    std::vector<unsigned int> int_indices_;
 
     // add location slot map
     std::map<int, std::string> attribute_float_keys_;
@@ -367,31 +474,72 @@ private:
     std::map<int, std::string> attribute_vec3_keys_;
     std::map<int, std::string> attribute_vec4_keys_;
 
-    // add vertex array object and VBO
+    // one interleaved VBO and IBO per mesh, shared by all programs;
+    // each program only gets a VAO pointing into them
 
-    struct GLVaoVboId {
+    struct GLVertexAttribute {
+        GLuint size;    // in floats
+        GLuint offset;  // in floats from the start of the vertex
+        bool operator==(const GLVertexAttribute& other) const {
+            return size == other.size && offset == other.offset;
+        }
+    };
+    std::map<std::string, GLVertexAttribute> vertex_layout_;
+
+    struct GLAttributePointer {
+        GLuint location;
+        GLVertexAttribute attribute;
+    };
+
+    struct GLVaoId {
         GLuint vaoID;
-        GLuint static_vboID;
-        GLuint triangle_vboID;
+        // layout_version_ the attribute pointers were set up for
+        int layout_version;
+        // vertex buffer the attribute pointers refer to
+        GLuint vboID;
+        std::vector<GLAttributePointer> pointers;
     };
 
-    std::map<GLuint, GLVaoVboId> program_ids_;
+    std::map<GLuint, GLVaoId> program_ids_;
 
-    struct GLAttributeMapping {
-        GLuint          index;
-        GLuint          size;
-        GLenum          type;
-        GLuint          offset;
-        const void*     data;
+    // pending range of vertices, in vertices, empty if begin >= end
+    struct DirtyRange {
+        int begin;
+        int end;
     };
-    std::vector<GLAttributeMapping> attrMapping;
 
-    void createAttributeMapping(int programId, int& totalStride, int& attrLength);
-    void createBuffer(std::vector<GLfloat>& buffer, int attrLength);
+    void createVertexLayout(std::map<std::string, GLVertexAttribute>& layout,
+            int& stride);
+    void copyAttribute(std::vector<GLfloat>& buffer, const float* data,
+            int size, int first, int count, const std::string& name);
+    void copyAttribute(std::vector<GLfloat>& buffer, const float* data,
+            int size, int length, const std::string& name);
+    int findAttribute(const std::string& name, float*& data, int& length);
+    void markDirtyRange(int begin, int end);
+    void deleteVertexBuffers();
+    void updateVertexBuffer();
+    void streamVertexBuffer();
+    void bindVertexAttributes(int programId, GLVaoId& id);
+    void pointVertexAttributes(GLVaoId& id);
 
     // triangle information
     GLuint numTriangles_;
+    // vertex or index data changed since the last upload
     bool vao_dirty_;
+    GLuint vboID_;          // vertex buffer the VAOs should point at
+    GLuint iboID_;
+    int vertex_stride_;     // in floats
+    int vertex_count_;
+    int layout_version_;
+
+    // dynamic meshes rotate through several streamed vertex buffers
+    static const int DYNAMIC_BUFFER_COUNT = 3;
+    bool dynamic_;
+    bool stream_pending_;
+    int dynamic_slot_;
+    GLuint dynamic_vboIDs_[DYNAMIC_BUFFER_COUNT];
+    DirtyRange dirty_ranges_[DYNAMIC_BUFFER_COUNT];
+    std::vector<GLfloat> vertex_buffer_;
     bool have_bounding_volume_;
     BoundingVolume bounding_volume;
 
@@ -405,6 +553,10 @@ private:
     static std::vector<std::string> dynamicAttribute_Names_;
 
     std::unordered_set<std::shared_ptr<bool>> dirty_flags_;
+
+    std::mutex bvh_mutex_;
+    std::shared_ptr<MeshBVH> bvh_;
+    std::shared_ptr<bool> bvh_dirty_;
 };
 }
 #endif
@@ -0,0 +1,449 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Bounding volume hierarchy over the triangles of a mesh.
+ ***************************************************************************/
+
+#include "mesh_bvh.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "util/gvr_simd.h"
+
+namespace gvr {
+
+using namespace simd;
+
+static float surfaceArea(const glm::vec3& min_corner, const glm::vec3& max_corner) {
+    glm::vec3 size(max_corner - min_corner);
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+MeshBVH::MeshBVH(const std::vector<glm::vec3>& vertices,
+        const std::vector<unsigned short>& indices) :
+        triangle_count_(0) {
+    build(vertices, indices);
+}
+
+MeshBVH::MeshBVH(const std::vector<glm::vec3>& vertices,
+        const std::vector<unsigned int>& indices) :
+        triangle_count_(0) {
+    build(vertices, indices);
+}
+
+template <class Index>
+void MeshBVH::build(const std::vector<glm::vec3>& vertices,
+        const std::vector<Index>& indices) {
+    std::vector<BuildTriangle> triangles;
+    std::vector<BuildNode> build_nodes;
+
+    // triangles referencing missing vertices are left out
+    for (int i = 0; i + 2 < indices.size(); i += 3) {
+        if ((indices[i] >= vertices.size()) || (indices[i + 1] >= vertices.size())
+                || (indices[i + 2] >= vertices.size())) {
+            continue;
+        }
+        const glm::vec3& v0 = vertices[indices[i]];
+        const glm::vec3& v1 = vertices[indices[i + 1]];
+        const glm::vec3& v2 = vertices[indices[i + 2]];
+        BuildTriangle triangle;
+
+        triangle.min_corner = glm::min(v0, glm::min(v1, v2));
+        triangle.max_corner = glm::max(v0, glm::max(v1, v2));
+        triangle.centroid = (triangle.min_corner + triangle.max_corner) * 0.5f;
+        triangles.push_back(triangle);
+        corners_.push_back(v0);
+        corners_.push_back(v1);
+        corners_.push_back(v2);
+    }
+    triangle_count_ = triangles.size();
+    if (0 == triangle_count_) {
+        return;
+    }
+
+    order_.resize(triangle_count_);
+    for (int i = 0; i < triangle_count_; ++i) {
+        order_[i] = i;
+    }
+    build_nodes.reserve(2 * triangle_count_ / LEAF_SIZE + 1);
+    buildNode(build_nodes, triangles, 0, triangle_count_, 0);
+    min_corner_ = build_nodes[0].min_corner;
+    max_corner_ = build_nodes[0].max_corner;
+
+    nodes_.reserve(build_nodes.size() / 2 + 1);
+    packets_.reserve(triangle_count_ / LEAF_SIZE + 1);
+    collapse(build_nodes, 0);
+
+    std::vector<glm::vec3> corners;
+    corners_.swap(corners);
+}
+
+/*
+ * Split the triangles order_[first, first + count) along the axis and
+ * bin boundary with the lowest surface area cost. Returns the index of
+ * the new node.
+ */
+int MeshBVH::buildNode(std::vector<BuildNode>& build_nodes,
+        const std::vector<BuildTriangle>& triangles, int first, int count,
+        int depth) {
+    BuildNode node;
+    glm::vec3 centroid_min(std::numeric_limits<float>::max());
+    glm::vec3 centroid_max(-std::numeric_limits<float>::max());
+
+    node.min_corner = centroid_min;
+    node.max_corner = centroid_max;
+    for (int i = first; i < first + count; ++i) {
+        const BuildTriangle& triangle = triangles[order_[i]];
+
+        node.min_corner = glm::min(node.min_corner, triangle.min_corner);
+        node.max_corner = glm::max(node.max_corner, triangle.max_corner);
+        centroid_min = glm::min(centroid_min, triangle.centroid);
+        centroid_max = glm::max(centroid_max, triangle.centroid);
+    }
+    node.left = node.right = EMPTY;
+    node.first = first;
+    node.count = count;
+
+    int index = build_nodes.size();
+    build_nodes.push_back(node);
+    if ((count <= LEAF_SIZE) || (depth >= MAX_DEPTH)) {
+        return index;
+    }
+
+    float best_cost = std::numeric_limits<float>::max();
+    int best_axis = -1;
+    int best_bin = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = centroid_max[axis] - centroid_min[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+
+        float scale = BIN_COUNT / extent;
+        int bin_count[BIN_COUNT] = { };
+        glm::vec3 bin_min[BIN_COUNT];
+        glm::vec3 bin_max[BIN_COUNT];
+
+        for (int b = 0; b < BIN_COUNT; ++b) {
+            bin_min[b] = glm::vec3(std::numeric_limits<float>::max());
+            bin_max[b] = glm::vec3(-std::numeric_limits<float>::max());
+        }
+        for (int i = first; i < first + count; ++i) {
+            const BuildTriangle& triangle = triangles[order_[i]];
+            int b = std::min(BIN_COUNT - 1,
+                    (int) ((triangle.centroid[axis] - centroid_min[axis]) * scale));
+
+            ++bin_count[b];
+            bin_min[b] = glm::min(bin_min[b], triangle.min_corner);
+            bin_max[b] = glm::max(bin_max[b], triangle.max_corner);
+        }
+
+        // sweep from the right to get the cost of every right side
+        float right_cost[BIN_COUNT];
+        glm::vec3 right_min(bin_min[BIN_COUNT - 1]);
+        glm::vec3 right_max(bin_max[BIN_COUNT - 1]);
+        int right_count = bin_count[BIN_COUNT - 1];
+
+        for (int b = BIN_COUNT - 1; b > 0; --b) {
+            right_min = glm::min(right_min, bin_min[b]);
+            right_max = glm::max(right_max, bin_max[b]);
+            right_count += (b < BIN_COUNT - 1) ? bin_count[b] : 0;
+            right_cost[b] = (right_count > 0)
+                    ? surfaceArea(right_min, right_max) * right_count : 0.0f;
+        }
+
+        glm::vec3 left_min(bin_min[0]);
+        glm::vec3 left_max(bin_max[0]);
+        int left_count = 0;
+
+        for (int b = 0; b < BIN_COUNT - 1; ++b) {
+            left_min = glm::min(left_min, bin_min[b]);
+            left_max = glm::max(left_max, bin_max[b]);
+            left_count += bin_count[b];
+            if ((0 == left_count) || (count == left_count)) {
+                continue;
+            }
+
+            float cost = surfaceArea(left_min, left_max) * left_count
+                    + right_cost[b + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = b;
+            }
+        }
+    }
+
+    int middle = first + count / 2;
+    if (best_axis >= 0) {
+        float scale = BIN_COUNT / (centroid_max[best_axis] - centroid_min[best_axis]);
+        float origin = centroid_min[best_axis];
+        auto it = std::partition(order_.begin() + first,
+                order_.begin() + first + count,
+                [&](int t) {
+                    int b = std::min(BIN_COUNT - 1,
+                            (int) ((triangles[t].centroid[best_axis] - origin) * scale));
+                    return b <= best_bin;
+                });
+        int split = it - order_.begin();
+        if ((split > first) && (split < first + count)) {
+            middle = split;
+        }
+    }
+
+    int left = buildNode(build_nodes, triangles, first, middle - first, depth + 1);
+    int right = buildNode(build_nodes, triangles, middle, first + count - middle,
+            depth + 1);
+    build_nodes[index].left = left;
+    build_nodes[index].right = right;
+    return index;
+}
+
+/*
+ * Store the triangles of a leaf in packets of four.
+ * Returns the index of the first packet.
+ */
+int MeshBVH::makeLeaf(const BuildNode& leaf) {
+    int first_packet = packets_.size();
+
+    for (int i = 0; i < leaf.count; i += 4) {
+        Packet packet = { };
+
+        for (int lane = 0; lane < 4; ++lane) {
+            if (i + lane >= leaf.count) {
+                packet.triangle[lane] = EMPTY;
+                continue;
+            }
+            int t = order_[leaf.first + i + lane];
+            const glm::vec3& v0 = corners_[t * 3];
+            glm::vec3 e1(corners_[t * 3 + 1] - v0);
+            glm::vec3 e2(corners_[t * 3 + 2] - v0);
+
+            packet.v0_x[lane] = v0.x;
+            packet.v0_y[lane] = v0.y;
+            packet.v0_z[lane] = v0.z;
+            packet.e1_x[lane] = e1.x;
+            packet.e1_y[lane] = e1.y;
+            packet.e1_z[lane] = e1.z;
+            packet.e2_x[lane] = e2.x;
+            packet.e2_y[lane] = e2.y;
+            packet.e2_z[lane] = e2.z;
+            packet.triangle[lane] = t;
+        }
+        packets_.push_back(packet);
+    }
+    return first_packet;
+}
+
+/*
+ * Turn a binary build node into a node with up to four children by
+ * opening the children with the largest surface area.
+ */
+int MeshBVH::collapse(const std::vector<BuildNode>& build_nodes, int build_index) {
+    const BuildNode& build_node = build_nodes[build_index];
+    int children[4];
+    int count = 0;
+
+    if (EMPTY == build_node.left) {
+        children[count++] = build_index;
+    } else {
+        children[count++] = build_node.left;
+        children[count++] = build_node.right;
+    }
+    while (count < 4) {
+        int largest = -1;
+        float largest_area = -1.0f;
+
+        for (int i = 0; i < count; ++i) {
+            const BuildNode& child = build_nodes[children[i]];
+            float area = surfaceArea(child.min_corner, child.max_corner);
+
+            if ((EMPTY != child.left) && (area > largest_area)) {
+                largest = i;
+                largest_area = area;
+            }
+        }
+        if (largest < 0) {
+            break;
+        }
+        const BuildNode& opened = build_nodes[children[largest]];
+        children[largest] = opened.left;
+        children[count++] = opened.right;
+    }
+
+    int index = nodes_.size();
+    nodes_.push_back(Node());
+    for (int i = 0; i < 4; ++i) {
+        int child = EMPTY;
+        int packet_count = 0;
+        glm::vec3 min_corner(0.0f);
+        glm::vec3 max_corner(0.0f);
+
+        if (i < count) {
+            const BuildNode& node = build_nodes[children[i]];
+
+            min_corner = node.min_corner;
+            max_corner = node.max_corner;
+            if (EMPTY == node.left) {
+                child = -(makeLeaf(node) + 2);
+                packet_count = (node.count + 3) / 4;
+            } else {
+                child = collapse(build_nodes, children[i]);
+            }
+        }
+
+        // nodes_ may have grown while collapsing the child
+        Node& out = nodes_[index];
+        out.min_x[i] = min_corner.x;
+        out.min_y[i] = min_corner.y;
+        out.min_z[i] = min_corner.z;
+        out.max_x[i] = max_corner.x;
+        out.max_y[i] = max_corner.y;
+        out.max_z[i] = max_corner.z;
+        out.child[i] = child;
+        out.packet_count[i] = packet_count;
+    }
+    return index;
+}
+
+float MeshBVH::intersect(const glm::vec3& rayStart, const glm::vec3& rayDir,
+        glm::vec3& hitPos, int* triangle) const {
+    if (nodes_.empty()) {
+        return -1;
+    }
+
+    struct Entry {
+        int child;
+        int packet_count;
+        float distance;
+    };
+    // each level replaces one entry by at most four
+    Entry stack[3 * MAX_DEPTH + 4];
+    int top = 0;
+
+    const float EPSILON = 0.00001f;
+    const float infinity = std::numeric_limits<float>::infinity();
+    const Lanes zero = splat(0.0f);
+    const Lanes one = splat(1.0f);
+    const Lanes min_det = splat(EPSILON * EPSILON);
+    const Lanes min_distance = splat(EPSILON);
+    const Lanes ox = splat(rayStart.x), oy = splat(rayStart.y), oz = splat(rayStart.z);
+    const Lanes dx = splat(rayDir.x), dy = splat(rayDir.y), dz = splat(rayDir.z);
+    const Lanes inv_x = splat(1.0f / rayDir.x);
+    const Lanes inv_y = splat(1.0f / rayDir.y);
+    const Lanes inv_z = splat(1.0f / rayDir.z);
+    float nearest = infinity;
+    int nearest_triangle = EMPTY;
+
+    stack[top++] = { 0, 0, 0.0f };
+    while (top > 0) {
+        const Entry entry = stack[--top];
+
+        if (entry.distance > nearest) {
+            continue;
+        }
+        if (entry.child < EMPTY) {
+            // Moller-Trumbore against four triangles at a time
+            const Packet* packet = &packets_[-(entry.child + 2)];
+            for (int p = 0; p < entry.packet_count; ++p, ++packet) {
+                const Lanes e1x = load(packet->e1_x), e1y = load(packet->e1_y), e1z = load(packet->e1_z);
+                const Lanes e2x = load(packet->e2_x), e2y = load(packet->e2_y), e2z = load(packet->e2_z);
+                const Lanes px = sub(mul(dy, e2z), mul(dz, e2y));
+                const Lanes py = sub(mul(dz, e2x), mul(dx, e2z));
+                const Lanes pz = sub(mul(dx, e2y), mul(dy, e2x));
+                const Lanes det = madd(e1x, px, madd(e1y, py, mul(e1z, pz)));
+                const Lanes inv_det = div(one, det);
+                const Lanes tx = sub(ox, load(packet->v0_x));
+                const Lanes ty = sub(oy, load(packet->v0_y));
+                const Lanes tz = sub(oz, load(packet->v0_z));
+                const Lanes u = mul(madd(tx, px, madd(ty, py, mul(tz, pz))), inv_det);
+                const Lanes qx = sub(mul(ty, e1z), mul(tz, e1y));
+                const Lanes qy = sub(mul(tz, e1x), mul(tx, e1z));
+                const Lanes qz = sub(mul(tx, e1y), mul(ty, e1x));
+                const Lanes v = mul(madd(dx, qx, madd(dy, qy, mul(dz, qz))), inv_det);
+                const Lanes t = mul(madd(e2x, qx, madd(e2y, qy, mul(e2z, qz))), inv_det);
+
+                LaneMask hit = greater(mul(det, det), min_det);
+                hit = both(hit, greaterEqual(u, zero));
+                hit = both(hit, greaterEqual(v, zero));
+                hit = both(hit, greaterEqual(one, add(u, v)));
+                hit = both(hit, greater(t, min_distance));
+                hit = both(hit, greater(splat(nearest), t));
+                if (!any(hit)) {
+                    continue;
+                }
+
+                float distances[4];
+                store(distances, select(hit, t, splat(infinity)));
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (distances[lane] < nearest) {
+                        nearest = distances[lane];
+                        nearest_triangle = packet->triangle[lane];
+                    }
+                }
+            }
+            continue;
+        }
+
+        // slab test against the four child boxes
+        const Node& node = nodes_[entry.child];
+        Lanes x0, x1, y0, y1, z0, z1;
+        slab(load(node.min_x), load(node.max_x), ox, inv_x, x0, x1);
+        slab(load(node.min_y), load(node.max_y), oy, inv_y, y0, y1);
+        slab(load(node.min_z), load(node.max_z), oz, inv_z, z0, z1);
+        const Lanes enter = max(max(x0, y0), max(z0, zero));
+        const Lanes leave = min(min(x1, y1), min(z1, splat(nearest)));
+        const LaneMask hit = greaterEqual(leave, enter);
+        if (!any(hit)) {
+            continue;
+        }
+
+        float distances[4];
+        store(distances, select(hit, enter, splat(infinity)));
+
+        // push the farthest child first so the nearest is visited next
+        Entry hits[4];
+        int hit_count = 0;
+        for (int i = 0; i < 4; ++i) {
+            if ((EMPTY == node.child[i]) || (distances[i] == infinity)) {
+                continue;
+            }
+            Entry e = { node.child[i], node.packet_count[i], distances[i] };
+            int j = hit_count++;
+            for (; (j > 0) && (hits[j - 1].distance < e.distance); --j) {
+                hits[j] = hits[j - 1];
+            }
+            hits[j] = e;
+        }
+        for (int i = 0; i < hit_count; ++i) {
+            stack[top++] = hits[i];
+        }
+    }
+
+    if (EMPTY == nearest_triangle) {
+        return -1;
+    }
+    hitPos = rayStart + nearest * rayDir;
+    if (nullptr != triangle) {
+        *triangle = nearest_triangle;
+    }
+    return nearest;
+}
+
+}
@@ -0,0 +1,144 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Bounding volume hierarchy over the triangles of a mesh.
+ ***************************************************************************/
+
+#ifndef MESH_BVH_H_
+#define MESH_BVH_H_
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace gvr {
+
+/*
+ * Four wide bounding volume hierarchy used to intersect rays with
+ * the triangles of a mesh.
+ *
+ * It is built top down with a binned surface area heuristic into a
+ * binary tree, which is then collapsed so that every node holds the
+ * boxes of up to four children. The boxes of a node and the triangles
+ * of a leaf are stored four at a time, so the ray is tested against
+ * four boxes or four triangles at once.
+ *
+ * The hierarchy is a snapshot of the vertices and indices it was built
+ * from. Use Mesh::getBVH() to get one which is kept up to date.
+ */
+class MeshBVH {
+public:
+    MeshBVH(const std::vector<glm::vec3>& vertices,
+            const std::vector<unsigned short>& indices);
+    MeshBVH(const std::vector<glm::vec3>& vertices,
+            const std::vector<unsigned int>& indices);
+
+    /*
+     * Find the nearest triangle hit by the ray.
+     * Returns the distance along the ray in units of rayDir, or -1 if
+     * no triangle is hit. hitPos receives the hit point and triangle,
+     * if not null, the index of the triangle hit.
+     */
+    float intersect(const glm::vec3& rayStart, const glm::vec3& rayDir,
+            glm::vec3& hitPos, int* triangle = nullptr) const;
+
+    int triangle_count() const {
+        return triangle_count_;
+    }
+
+    int node_count() const {
+        return nodes_.size();
+    }
+
+    const glm::vec3& min_corner() const {
+        return min_corner_;
+    }
+
+    const glm::vec3& max_corner() const {
+        return max_corner_;
+    }
+
+private:
+    MeshBVH(const MeshBVH& mesh_bvh);
+    MeshBVH(MeshBVH&& mesh_bvh);
+    MeshBVH& operator=(const MeshBVH& mesh_bvh);
+    MeshBVH& operator=(MeshBVH&& mesh_bvh);
+
+    static const int LEAF_SIZE = 4;
+    static const int BIN_COUNT = 12;
+    static const int MAX_DEPTH = 48;
+    static const int EMPTY = -1;
+
+    /*
+     * Children are node indices if positive. Leaves are encoded as
+     * -(first packet + 2) with the number of packets in packet_count.
+     */
+    struct Node {
+        float min_x[4], min_y[4], min_z[4];
+        float max_x[4], max_y[4], max_z[4];
+        int child[4];
+        int packet_count[4];
+    };
+
+    /*
+     * Four triangles as first vertex and two edges, unused lanes
+     * have zero edges and never hit.
+     */
+    struct Packet {
+        float v0_x[4], v0_y[4], v0_z[4];
+        float e1_x[4], e1_y[4], e1_z[4];
+        float e2_x[4], e2_y[4], e2_z[4];
+        int triangle[4];
+    };
+
+    struct BuildNode {
+        glm::vec3 min_corner;
+        glm::vec3 max_corner;
+        int left;
+        int right;
+        int first;
+        int count;
+    };
+
+    struct BuildTriangle {
+        glm::vec3 min_corner;
+        glm::vec3 max_corner;
+        glm::vec3 centroid;
+    };
+
+    template <class Index>
+    void build(const std::vector<glm::vec3>& vertices,
+            const std::vector<Index>& indices);
+    int buildNode(std::vector<BuildNode>& build_nodes,
+            const std::vector<BuildTriangle>& triangles, int first, int count,
+            int depth);
+    int collapse(const std::vector<BuildNode>& build_nodes, int build_index);
+    int makeLeaf(const BuildNode& leaf);
+
+    int triangle_count_;
+    glm::vec3 min_corner_;
+    glm::vec3 max_corner_;
+    std::vector<Node> nodes_;
+    std::vector<Packet> packets_;
+    // triangle indices sorted so that each leaf is contiguous
+    std::vector<int> order_;
+    // corners of each triangle in mesh order, only kept while building
+    std::vector<glm::vec3> corners_;
+};
+
+}
+#endif
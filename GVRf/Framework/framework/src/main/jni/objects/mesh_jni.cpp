@@ -60,6 +60,24 @@ extern "C" {
     Java_org_gearvrf_NativeMesh_setIndices(JNIEnv * env,
             jobject obj, jlong jmesh, jcharArray indices);
 
+    JNIEXPORT jintArray JNICALL
+    Java_org_gearvrf_NativeMesh_getIntIndices(JNIEnv * env,
+            jobject obj, jlong jmesh);
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeMesh_setIntIndices(JNIEnv * env,
+            jobject obj, jlong jmesh, jintArray indices);
+
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeMesh_setDynamic(JNIEnv * env,
+            jobject obj, jlong jmesh, jboolean dynamic);
+
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeMesh_setCpuSkinning(JNIEnv * env,
+            jobject obj, jlong jmesh, jboolean enable);
+    JNIEXPORT jboolean JNICALL
+    Java_org_gearvrf_NativeMesh_updateVertexAttribute(JNIEnv * env,
+            jobject obj, jlong jmesh, jstring key, jint first, jfloatArray values);
+
     JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeMesh_setFloatVector(JNIEnv * env,
             jobject obj, jlong jmesh, jstring key, jfloatArray float_vector);
@@ -249,6 +267,66 @@ Java_org_gearvrf_NativeMesh_setIndices(JNIEnv * env,
     env->ReleaseCharArrayElements(indices, jindices_pointer, 0);
 }
 
+JNIEXPORT jintArray JNICALL
+Java_org_gearvrf_NativeMesh_getIntIndices(JNIEnv * env,
+        jobject obj, jlong jmesh) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    int index_count = mesh->getIndexCount();
+    jintArray jindices = env->NewIntArray(index_count);
+    jint* jindices_pointer = env->GetIntArrayElements(jindices, 0);
+    for (int i = 0; i < index_count; ++i) {
+        jindices_pointer[i] = mesh->getIndex(i);
+    }
+    env->ReleaseIntArrayElements(jindices, jindices_pointer, 0);
+    return jindices;
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeMesh_setIntIndices(JNIEnv * env,
+        jobject obj, jlong jmesh, jintArray indices) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    jint* jindices_pointer = env->GetIntArrayElements(indices, 0);
+    int indices_length = env->GetArrayLength(indices);
+    std::vector<unsigned int> native_indices(jindices_pointer,
+            jindices_pointer + indices_length);
+    mesh->set_int_indices(std::move(native_indices));
+    env->ReleaseIntArrayElements(indices, jindices_pointer, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeMesh_setDynamic(JNIEnv * env,
+        jobject obj, jlong jmesh, jboolean dynamic) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    mesh->set_dynamic(dynamic);
+}
+
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeMesh_setCpuSkinning(JNIEnv * env,
+        jobject obj, jlong jmesh, jboolean enable) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    mesh->getVertexBoneData().setCpuSkinning(enable);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_gearvrf_NativeMesh_updateVertexAttribute(JNIEnv * env,
+        jobject obj, jlong jmesh, jstring key, jint first, jfloatArray values) {
+    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    const char* char_key = env->GetStringUTFChars(key, 0);
+    std::string native_key = std::string(char_key);
+    env->ReleaseStringUTFChars(key, char_key);
+
+    int attribute_size = mesh->getAttributeSize(native_key);
+    int values_length = env->GetArrayLength(values);
+    if (attribute_size <= 0 || (values_length % attribute_size) != 0) {
+        return false;
+    }
+    jfloat* values_pointer = env->GetFloatArrayElements(values, 0);
+    bool result = mesh->updateVertexAttribute(native_key, first, values_pointer,
+            values_length / attribute_size);
+    env->ReleaseFloatArrayElements(values, values_pointer, JNI_ABORT);
+    return result;
+}
+
 JNIEXPORT jfloatArray JNICALL
 Java_org_gearvrf_NativeMesh_getFloatVector(JNIEnv * env,
         jobject obj, jlong jmesh, jstring key) {
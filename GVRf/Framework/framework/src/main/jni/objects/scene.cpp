@@ -17,6 +17,8 @@
  * Holds scene objects. Can be used by engines.
  ***************************************************************************/
 
+#include <algorithm>
+
 #include "scene.h"
 
 #include "engine/exporter/exporter.h"
@@ -31,7 +33,13 @@ Scene::Scene() :
         frustum_flag_(false),
         dirtyFlag_(0),
         occlusion_flag_(false),
+        software_occlusion_flag_(false),
+        flat_cull_flag_(false),
         pick_visible_(true),
+        collider_index_dirty_(true),
+        gather_colliders_(false),
+        visible_snapshot_(std::make_shared<std::vector<Collider*>>()),
+        visible_colliders_dirty_(false),
         is_shadowmap_invalid(true) {
     if (main_scene() == NULL) {
         set_main_scene(this);
@@ -59,18 +67,55 @@ void Scene::deleteLightsAndDepthTextureOnRenderThread() {
 }
 
 void Scene::clearAllColliders() {
+    uint64_t epoch;
+
     lockColliders();
     allColliders.clear();
-    visibleColliders.clear();
+    clearVisibleColliders();
+    epoch = collider_index_.clear();
+    collider_index_dirty_ = true;
     unlockColliders();
+    collider_index_.synchronize(epoch);
 }
 
+/*
+ * The scene graph may only be walked on the GL thread,
+ * so the colliders are gathered by the next updateColliderIndex.
+ */
 void Scene::gatherColliders() {
-    lockColliders();
-    allColliders.clear();
-    visibleColliders.clear();
-    scene_root_.getAllComponents(allColliders, Collider::getComponentType());
-    unlockColliders();
+    std::lock_guard<std::mutex> lock(collider_mutex_);
+    gather_colliders_ = true;
+}
+
+void Scene::updateColliderIndex() {
+    std::lock_guard<std::mutex> lock(collider_mutex_);
+    if (gather_colliders_) {
+        allColliders.clear();
+        clearVisibleColliders();
+        scene_root_.getAllComponents(allColliders, Collider::getComponentType());
+        publishVisibleColliders();
+        collider_index_dirty_ = true;
+        gather_colliders_ = false;
+    }
+    collider_index_.update(allColliders, collider_index_dirty_);
+    collider_index_dirty_ = false;
+}
+
+/*
+ * Called with the collider lock held.
+ */
+void Scene::publishVisibleColliders() {
+    std::shared_ptr<std::vector<Collider*>> visible =
+            std::make_shared<std::vector<Collider*>>();
+
+    visible->reserve(visibleColliders.size());
+    for (auto it = visibleColliders.begin(); it != visibleColliders.end(); ++it) {
+        visible->push_back(reinterpret_cast<Collider*>(*it));
+    }
+    std::sort(visible->begin(), visible->end());
+    std::atomic_store(&visible_snapshot_,
+            std::shared_ptr<const std::vector<Collider*>>(visible));
+    visible_colliders_dirty_ = false;
 }
 
 
@@ -83,22 +128,42 @@ void Scene::pick(SceneObject* sceneobj) {
      }
 }
 
+/*
+ * The collider lists are also read by the cull jobs and by the picker
+ * on other threads, so they are only searched with the lock held.
+ * New colliders are indexed for picking on the next frame.
+ */
 void Scene::addCollider(Collider* collider) {
+    std::lock_guard<std::mutex> lock(collider_mutex_);
     auto it = std::find(allColliders.begin(), allColliders.end(), collider);
     if (it == allColliders.end()) {
-        lockColliders();
         allColliders.push_back(collider);
-        unlockColliders();
+        collider_index_dirty_ = true;
     }
 }
 
+/*
+ * Removed colliders leave the picking index right away. This waits
+ * for the picks still using it, so the collider can be deleted safely
+ * afterwards.
+ */
 void Scene::removeCollider(Collider* collider) {
+    uint64_t epoch;
+
+    collider_mutex_.lock();
     auto it = std::find(allColliders.begin(), allColliders.end(), collider);
     if (it != allColliders.end()) {
-        lockColliders();
         allColliders.erase(it);
-        unlockColliders();
+        collider_index_dirty_ = true;
     }
+    it = std::find(visibleColliders.begin(), visibleColliders.end(), collider);
+    if (it != visibleColliders.end()) {
+        visibleColliders.erase(it);
+        visible_colliders_dirty_ = true;
+    }
+    epoch = collider_index_.remove(collider);
+    unlockColliders();
+    collider_index_.synchronize(epoch);
 }
 
 void Scene::set_main_scene(Scene* scene) {
@@ -28,6 +28,10 @@
 #include "objects/hybrid_object.h"
 #include "components/camera_rig.h"
 #include "engine/renderer/renderer.h"
+#include "engine/renderer/cull_list.h"
+#include "engine/renderer/transform_list.h"
+#include "engine/picker/collider_index.h"
+#include "objects/textures/texture_uploader.h"
 #include "objects/light.h"
 
 namespace gvr {
@@ -60,6 +64,34 @@ public:
     void set_occlusion_culling( bool occlusion_flag){ occlusion_flag_ = occlusion_flag; }
     bool get_occlusion_culling(){ return occlusion_flag_; }
 
+    /*
+     * If set to true occlusion culling tests against a depth buffer of
+     * the occluders rasterized on the CPU instead of GPU queries.
+     * @see SoftwareOcclusionCuller
+     */
+    void set_software_occlusion( bool software_flag){ software_occlusion_flag_ = software_flag; }
+    bool get_software_occlusion(){ return software_occlusion_flag_; }
+
+    /*
+     * If set to true the renderer culls against a flattened
+     * copy of the scene graph instead of walking it recursively.
+     * @see CullList
+     */
+    void set_flat_culling( bool flat_flag){ flat_cull_flag_ = flat_flag; }
+    bool get_flat_culling(){ return flat_cull_flag_; }
+
+    /*
+     * Flattened scene graph used when flat culling is enabled.
+     * Only to be used on the GL thread.
+     */
+    CullList& getCullList() { return cull_list_; }
+
+    /*
+     * Flattened transform hierarchy which updates the model matrices
+     * once per frame. Only to be used on the GL thread.
+     */
+    TransformList& getTransformList() { return transform_list_; }
+
     /*
      * Adds a new light to the scene.
      * Return true if light was added, false if already there or too many lights.
@@ -82,6 +114,50 @@ public:
             return gRenderer->getNumberTriangles();
         }
     }
+    int getNumberStateChanges() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberStateChanges();
+        }
+        return 0;
+    }
+    int getNumberSkippedStateChanges() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberSkippedStateChanges();
+        }
+        return 0;
+    }
+
+    // model matrices recomputed in the last frame
+    int getNumberTransformsUpdated() {
+        return transform_list_.updated_count();
+    }
+
+    // hierarchical bounding volumes recomputed in the last frame
+    int getNumberBoundsRefit() {
+        return transform_list_.refit_count();
+    }
+
+    // time the GL thread spent uploading textures in the last frame
+    float getTextureUploadMilliseconds() {
+        return TextureUploader::getInstance().upload_milliseconds();
+    }
+
+    int getTextureUploadBytes() {
+        return TextureUploader::getInstance().upload_bytes();
+    }
+
+    int getTextureMemoryKB() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getTextureMemoryKB();
+        }
+        return 0;
+    }
+    int getNumberTexturesEvicted() {
+        if(nullptr!= gRenderer) {
+            return gRenderer->getNumberTexturesEvicted();
+        }
+        return 0;
+    }
 
     void exportToFile(std::string filepath);
 
@@ -132,7 +208,10 @@ public:
      * to contain only the pickable objects that are visible.
      * This function does not lock the collider list!
      */
-    void clearVisibleColliders() { visibleColliders.clear(); }
+    void clearVisibleColliders() {
+        visibleColliders.clear();
+        visible_colliders_dirty_ = true;
+    }
 
     /*
      * Called during culling to add a scene object's
@@ -156,9 +235,36 @@ public:
      * Don't call this unless you have called lockColliders first.
      */
     void unlockColliders() {
+        if (visible_colliders_dirty_) {
+            publishVisibleColliders();
+        }
         collider_mutex_.unlock();
     }
 
+    /*
+     * Bring the collider hierarchy used for picking up to date.
+     * Must be called on the GL thread before the scene bounding
+     * volumes are recomputed.
+     */
+    void updateColliderIndex();
+
+    /*
+     * Get the collider hierarchy. Pick through a ColliderIndex::Reader,
+     * the colliders it refers to stay alive while it is held, so only
+     * hold it for the duration of a pick.
+     */
+    const ColliderIndex& getColliderIndex() const {
+        return collider_index_;
+    }
+
+    /*
+     * Get a sorted copy of the visible collider list without locking.
+     * It is republished whenever culling rebuilds the list.
+     */
+    std::shared_ptr<const std::vector<Collider*>> getVisibleColliders() const {
+        return std::atomic_load(&visible_snapshot_);
+    }
+
     static Scene* main_scene() {
         return main_scene_;
     }
@@ -172,6 +278,7 @@ private:
     Scene& operator=(Scene&& scene);
     void gatherColliders();
     void clearAllColliders();
+    void publishVisibleColliders();
 
 private:
     static Scene* main_scene_;
@@ -180,12 +287,21 @@ private:
     int dirtyFlag_;
     bool frustum_flag_;
     bool occlusion_flag_;
+    bool software_occlusion_flag_;
+    bool flat_cull_flag_;
     bool pick_visible_;
     std::mutex collider_mutex_;
     std::vector<Light*> lightList;
     std::vector<Component*> allColliders;
     std::vector<Component*> visibleColliders;
+    ColliderIndex collider_index_;
+    bool collider_index_dirty_;
+    bool gather_colliders_;
+    std::shared_ptr<const std::vector<Collider*>> visible_snapshot_;
+    bool visible_colliders_dirty_;
     bool is_shadowmap_invalid;
+    CullList cull_list_;
+    TransformList transform_list_;
 };
 
 }
@@ -45,11 +45,17 @@ extern "C" {
     Java_org_gearvrf_NativeScene_setFrustumCulling(JNIEnv * env,
             jobject obj, jlong jscene, jboolean flag);
     JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeScene_setFlatCulling(JNIEnv * env,
+            jobject obj, jlong jscene, jboolean flag);
+    JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeScene_setPickVisible(JNIEnv * env,
             jobject obj, jlong jscene, jboolean flag);
     JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeScene_setOcclusionQuery(JNIEnv * env,
             jobject obj, jlong jscene, jboolean flag);
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeScene_setSoftwareOcclusion(JNIEnv * env,
+            jobject obj, jlong jscene, jboolean flag);
 
     JNIEXPORT void JNICALL
     Java_org_gearvrf_NativeScene_resetStats(JNIEnv * env,
@@ -67,6 +73,38 @@ extern "C" {
     Java_org_gearvrf_NativeScene_getNumberTriangles(JNIEnv * env,
             jobject obj, jlong jscene);
 
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberStateChanges(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberSkippedStateChanges(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberTransformsUpdated(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberBoundsRefit(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT jfloat JNICALL
+    Java_org_gearvrf_NativeScene_getTextureUploadMilliseconds(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getTextureUploadBytes(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getTextureMemoryKB(JNIEnv * env,
+            jobject obj, jlong jscene);
+
+    JNIEXPORT int JNICALL
+    Java_org_gearvrf_NativeScene_getNumberTexturesEvicted(JNIEnv * env,
+            jobject obj, jlong jscene);
+
     JNIEXPORT jboolean JNICALL
     Java_org_gearvrf_NativeScene_addLight(
             JNIEnv * env, jobject obj, jlong jscene, jlong light);
@@ -143,6 +181,13 @@ Java_org_gearvrf_NativeScene_setFrustumCulling(JNIEnv * env,
     scene->set_frustum_culling(static_cast<bool>(flag));
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeScene_setFlatCulling(JNIEnv * env,
+        jobject obj, jlong jscene, jboolean flag) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    scene->set_flat_culling(static_cast<bool>(flag));
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeScene_setPickVisible(JNIEnv * env,
         jobject obj, jlong jscene, jboolean flag) {
@@ -157,6 +202,13 @@ Java_org_gearvrf_NativeScene_setOcclusionQuery(JNIEnv * env,
     scene->set_occlusion_culling(static_cast<bool>(flag));
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeScene_setSoftwareOcclusion(JNIEnv * env,
+        jobject obj, jlong jscene, jboolean flag) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    scene->set_software_occlusion(static_cast<bool>(flag));
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeScene_resetStats(JNIEnv * env,
         jobject obj, jlong jscene) {
@@ -180,6 +232,62 @@ Java_org_gearvrf_NativeScene_getNumberTriangles(JNIEnv * env,
     return scene->getNumberTriangles();
 }
 
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberStateChanges(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberStateChanges();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberSkippedStateChanges(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberSkippedStateChanges();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberTransformsUpdated(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberTransformsUpdated();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberBoundsRefit(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberBoundsRefit();
+}
+
+JNIEXPORT jfloat JNICALL
+Java_org_gearvrf_NativeScene_getTextureUploadMilliseconds(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getTextureUploadMilliseconds();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getTextureUploadBytes(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getTextureUploadBytes();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getTextureMemoryKB(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getTextureMemoryKB();
+}
+
+JNIEXPORT int JNICALL
+Java_org_gearvrf_NativeScene_getNumberTexturesEvicted(JNIEnv * env,
+        jobject obj, jlong jscene) {
+    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    return scene->getNumberTexturesEvicted();
+}
+
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeScene_exportToFile(JNIEnv * env,
         jobject obj, jlong jscene, jstring filepath) {
@@ -28,18 +28,93 @@
 
 namespace gvr {
 
-SceneObject::SceneObject() :
-        HybridObject(), name_(""), children_(), visible_(true), transform_dirty_(false), in_frustum_(
-                false),  enabled_(true),query_currently_issued_(false), vis_count_(0),
-                cull_status_(false), bounding_volume_dirty_(true) {
+std::atomic<unsigned int> SceneObject::hierarchy_version_(0);
+std::mutex SceneObject::edited_mutex_;
+std::vector<SceneObject*> SceneObject::edited_objects_;
 
-    // Occlusion query setup
-    queries_ = new GLuint[1];
-    glGenQueries(1, queries_);
+SceneObject::SceneObject() :
+        HybridObject(), name_(""), children_(), children_edited_(false), visible_(true), transform_dirty_(false), in_frustum_(
+                false),  enabled_(true), cull_status_(false), bounding_volume_dirty_(true),
+        mesh_bounding_volume_dirty_(true) {
 }
 
+/*
+ * Scene objects are deleted on the GL thread. A parent which has not
+ * published the removal of this object yet must do so now, before
+ * the renderer reads its children again.
+ */
 SceneObject::~SceneObject() {
-    delete queries_;
+    bool pending;
+    {
+        std::lock_guard < std::mutex > lock(edited_mutex_);
+        if (children_edited_) {
+            edited_objects_.erase(std::remove(edited_objects_.begin(),
+                    edited_objects_.end(), this), edited_objects_.end());
+        }
+        pending = !edited_objects_.empty();
+    }
+    if (pending) {
+        applyPendingEdits();
+    }
+}
+
+void SceneObject::markChildrenEdited() {
+    std::lock_guard < std::mutex > lock(edited_mutex_);
+    if (!children_edited_) {
+        children_edited_ = true;
+        edited_objects_.push_back(this);
+    }
+}
+
+void SceneObject::applyPendingEdits() {
+    std::vector<SceneObject*> edited;
+    {
+        std::lock_guard < std::mutex > lock(edited_mutex_);
+        if (edited_objects_.empty()) {
+            return;
+        }
+        edited.swap(edited_objects_);
+        for (auto it = edited.begin(); it != edited.end(); ++it) {
+            (*it)->children_edited_ = false;
+        }
+    }
+    for (auto it = edited.begin(); it != edited.end(); ++it) {
+        SceneObject* object = *it;
+        std::vector<SceneObject*> previous;
+        {
+            std::lock_guard < std::mutex > lock(object->children_mutex_);
+            previous.swap(object->published_children_);
+            object->published_children_ = object->children_;
+        }
+
+        // children follow their new parent only once it publishes them,
+        // a child moved to another object may already have done so
+        for (auto child = previous.begin(); child != previous.end(); ++child) {
+            if ((*child)->parent_ == object) {
+                (*child)->setParent(NULL);
+            }
+        }
+        const std::vector<SceneObject*>& children = object->published_children_;
+        for (auto child = children.begin(); child != children.end(); ++child) {
+            (*child)->setParent(object);
+        }
+        object->dirtyHierarchicalBoundingVolume();
+    }
+    ++hierarchy_version_;
+}
+
+/*
+ * Called on the GL thread, the model matrix changes with the parent.
+ */
+void SceneObject::setParent(SceneObject* parent) {
+    if (parent_ == parent) {
+        return;
+    }
+    parent_ = parent;
+    Transform* const t = transform();
+    if (nullptr != t) {
+        t->invalidate(false);
+    }
 }
 
 bool SceneObject::attachComponent(Component* component) {
@@ -49,6 +124,7 @@ bool SceneObject::attachComponent(Component* component) {
     }
     component->set_owner_object(this);
     components_.push_back(component);
+    ++hierarchy_version_;
     dirtyHierarchicalBoundingVolume();
     return true;
 }
@@ -59,6 +135,7 @@ bool SceneObject::detachComponent(Component* component) {
         return false;
     (*it)->set_owner_object(NULL);
     components_.erase(it);
+    ++hierarchy_version_;
     dirtyHierarchicalBoundingVolume();
     return true;
 }
@@ -69,6 +146,7 @@ Component* SceneObject::detachComponent(long long type) {
             Component* component = *it;
             component->set_owner_object(NULL);
             components_.erase(it);
+            ++hierarchy_version_;
             dirtyHierarchicalBoundingVolume();
             return component;
         }
@@ -96,14 +174,14 @@ void SceneObject::getAllComponents(std::vector<Component*>& components, long lon
             components.push_back(*it);
         }
     }
-    for (auto it2 = children_.begin(); it2 != children_.end(); ++it2) {
+    for (auto it2 = published_children_.begin(); it2 != published_children_.end(); ++it2) {
         SceneObject* obj = *it2;
         obj->getAllComponents(components, componentType);
     }
 }
 
 void SceneObject::addChildObject(SceneObject* self, SceneObject* child) {
-    for (SceneObject* parent = parent_; parent; parent = parent->parent_) {
+    for (SceneObject* parent = edited_parent_; parent; parent = parent->edited_parent_) {
         if (child == parent) {
             std::string error =
                     "SceneObject::addChildObject() : cycle of scene objects is not allowed.";
@@ -115,44 +193,53 @@ void SceneObject::addChildObject(SceneObject* self, SceneObject* child) {
         std::lock_guard < std::mutex > lock(children_mutex_);
         children_.push_back(child);
     }
-    child->parent_ = self;
-    Transform* const t = child->transform();
-    if (nullptr != t) {
-        t->invalidate(false);
-    }
+    child->edited_parent_ = self;
+    markChildrenEdited();
     dirtyHierarchicalBoundingVolume();
 }
 
 void SceneObject::removeChildObject(SceneObject* child) {
-    if (child->parent_ == this) {
+    if (child->edited_parent_ == this) {
         {
             std::lock_guard < std::mutex > lock(children_mutex_);
             children_.erase(std::remove(children_.begin(), children_.end(), child), children_.end());
         }
-        child->parent_ = NULL;
+        child->edited_parent_ = NULL;
+        markChildrenEdited();
     }
+    dirtyHierarchicalBoundingVolume();
+}
 
-    Transform* const t = child->transform();
-    if (nullptr != t) {
-        t->invalidate(false);
+void SceneObject::clear() {
+    {
+        std::lock_guard < std::mutex > lock(children_mutex_);
+        for (auto it = children_.begin(); it != children_.end(); ++it) {
+            SceneObject* child = *it;
+            child->edited_parent_ = NULL;
+        }
+        children_.clear();
     }
+    markChildrenEdited();
     dirtyHierarchicalBoundingVolume();
 }
 
-void SceneObject::clear() {
+void SceneObject::invalidateChildTransforms() {
     std::lock_guard < std::mutex > lock(children_mutex_);
     for (auto it = children_.begin(); it != children_.end(); ++it) {
-        SceneObject* child = *it;
-        child->parent_ = NULL;
+        Transform* const t = (*it)->transform();
+        if (nullptr != t) {
+            t->invalidate(false);
+        }
     }
-    children_.clear();
 }
 
-int SceneObject::getChildrenCount() const {
+int SceneObject::getChildrenCount() {
+    std::lock_guard < std::mutex > lock(children_mutex_);
     return children_.size();
 }
 
 SceneObject* SceneObject::getChildByIndex(int index) {
+    std::lock_guard < std::mutex > lock(children_mutex_);
     if (index < children_.size()) {
         return children_[index];
     } else {
@@ -170,29 +257,6 @@ void SceneObject::getDescendants(std::vector<SceneObject*>& descendants) {
     }
 }
 
-void SceneObject::set_visible(bool visibility = true) {
-
-    //HACK
-    //If checked every frame, queries may return
-    //an inconsistent result when used with bounding boxes.
-
-    //We need to make sure that the object's visibility status is consistent before
-    //changing the status to avoid flickering artifacts.
-
-    if (visibility == true)
-        vis_count_++;
-    else
-        vis_count_--;
-
-    if (vis_count_ > check_frames_) {
-        visible_ = true;
-        vis_count_ = 0;
-    } else if (vis_count_ < (-1 * check_frames_)) {
-        visible_ = false;
-        vis_count_ = 0;
-    }
-}
-
 bool SceneObject::isColliding(SceneObject *scene_object) {
 
     //Get the transformed bounding boxes in world coordinates and check if they intersect
@@ -319,6 +383,15 @@ bool SceneObject::intersectsBoundingVolume(SceneObject *scene_object) {
 }
 
 void SceneObject::dirtyHierarchicalBoundingVolume() {
+    mesh_bounding_volume_dirty_ = true;
+    dirtyBoundingVolume();
+}
+
+/*
+ * The ancestors only need to aggregate their children again,
+ * their own mesh bounding volume is unchanged.
+ */
+void SceneObject::dirtyBoundingVolume() {
     if (bounding_volume_dirty_) {
         return;
     }
@@ -326,7 +399,7 @@ void SceneObject::dirtyHierarchicalBoundingVolume() {
     bounding_volume_dirty_ = true;
 
     if (parent_ != NULL) {
-        parent_->dirtyHierarchicalBoundingVolume();
+        parent_->dirtyBoundingVolume();
     }
 }
 
@@ -334,25 +407,26 @@ BoundingVolume& SceneObject::getBoundingVolume() {
     if (!bounding_volume_dirty_) {
         return transformed_bounding_volume_;
     }
-    RenderData* rdata = render_data();
     // Calculate the new bounding volume from itself and all its children
-    // 1. Start from its own mesh's bounding volume if there is any
-    transformed_bounding_volume_.reset();
-    if (rdata != NULL && rdata->mesh() != NULL) {
-        // Future optimization:
-        // If the mesh and transform are still valid, don't need to recompute the mesh_bounding_volume
-        // if (!render_data_->mesh()->hasBoundingVolume()
-        // || !transform_->isModelMatrixValid()) {
-        mesh_bounding_volume = rdata->mesh()->getBoundingVolume();
-        if (mesh_bounding_volume.radius() > 0) {
-            mesh_bounding_volume.transform(rdata->mesh()->getBoundingVolume(), transform()->getModelMatrix());
-            transformed_bounding_volume_ = mesh_bounding_volume;
+    // 1. Start from its own mesh's bounding volume if there is any, it is
+    //    only transformed again when this object moved or changed its mesh
+    if (mesh_bounding_volume_dirty_) {
+        RenderData* rdata = render_data();
+
+        mesh_bounding_volume.reset();
+        if (rdata != NULL && rdata->mesh() != NULL) {
+            const BoundingVolume& mesh_bounds = rdata->mesh()->getBoundingVolume();
+            if (mesh_bounds.radius() > 0) {
+                mesh_bounding_volume.transform(mesh_bounds, transform()->getModelMatrix());
+            }
         }
+        mesh_bounding_volume_dirty_ = false;
     }
+    transformed_bounding_volume_ = mesh_bounding_volume;
+
     // 2. Aggregate with all its children's bounding volumes
-    std::vector<SceneObject*> childrenCopy = children();
-    for (auto it = childrenCopy.begin(); it != childrenCopy.end(); ++it) {
-        BoundingVolume child_bounding_volume = (*it)->getBoundingVolume();
+    for (auto it = published_children_.begin(); it != published_children_.end(); ++it) {
+        const BoundingVolume& child_bounding_volume = (*it)->getBoundingVolume();
         if (child_bounding_volume.radius() > 0) {
             transformed_bounding_volume_.expand(child_bounding_volume);
         }
@@ -385,10 +459,6 @@ bool SceneObject::checkSphereVsFrustum(float frustum[6][4],
     return true; // fully inside
 }
 
-enum AABB_STATE {
-    OUTSIDE, INTERSECT, INSIDE
-};
-
 // frustumCull() return 3 possible values:
 // 0 when the HBV of the object is completely outside the frustum: cull itself and all its children out
 // 1 when the HBV of the object is intersecting the frustum but the object itself is not: cull it out and continue culling test with its children
@@ -405,10 +475,11 @@ int SceneObject::frustumCull(glm::vec3 camera_position, const float frustum[6][4
         return 0;
     }
 
-    // 1. Check if the bounding volume intersects with or inside the view frustum
-    BoundingVolume bounding_volume_ = getBoundingVolume();
-    char outPlaneMask;
-    int checkResult = checkAABBVsFrustumOpt(frustum, bounding_volume_,
+    // 1. Check if the bounding volume intersects with or inside the view frustum,
+    //    the bounding volumes have been refit before the cull started
+    const BoundingVolume& bounding_volume_ = getRefitBoundingVolume();
+    int checkResult = checkAABBVsFrustumOpt(frustum,
+            bounding_volume_.min_corner(), bounding_volume_.max_corner(),
             planeMask);
     // int checkResult = checkSphereVsFrustum(frustum, bounding_volume_);
 
@@ -443,15 +514,11 @@ int SceneObject::frustumCull(glm::vec3 camera_position, const float frustum[6][4
     }
 
     // 3. Check if the object itself is intersecting with or inside the frustum
-    size_t size;
-    {
-        std::lock_guard < std::mutex > lock(children_mutex_);
-        size = children_.size();
-    }
-    if (0 < size) {
+    if (!published_children_.empty()) {
         int tempMask = planeMask;
-        checkResult = checkAABBVsFrustumOpt(frustum, mesh_bounding_volume,
-                tempMask);
+        checkResult = checkAABBVsFrustumOpt(frustum,
+                mesh_bounding_volume.min_corner(),
+                mesh_bounding_volume.max_corner(), tempMask);
         //	checkResult = checkSphereVsFrustum(frustum, mesh_bounding_volume);
     }
 
@@ -474,84 +541,21 @@ int SceneObject::frustumCull(glm::vec3 camera_position, const float frustum[6][4
 // If the AABB is completely inside all frustum planes, return 2 indicating the AABB is completely inside the frustum.
 int SceneObject::checkAABBVsFrustumOpt(const float frustum[6][4],
         BoundingVolume &bounding_volume, int& planeMask) {
-    glm::vec3 min_corner = bounding_volume.min_corner();
-    glm::vec3 max_corner = bounding_volume.max_corner();
-
-    float Xmin = min_corner[0];
-    float Ymin = min_corner[1];
-    float Zmin = min_corner[2];
-    float Xmax = max_corner[0];
-    float Ymax = max_corner[1];
-    float Zmax = max_corner[2];
-
-    bool isCompleteInside = true;
-
-    for (int p = 0; p < 6; p++) {
-        //skip current plane if the corresponding planeMask is set
-        if ((planeMask >> p) & 1) {
-            if (DEBUG_RENDERER) {
-                LOGD("PLANE %d MASKED", p);
-            }
-            continue;
-        }
-
-        int count = 0;
-        if (frustum[p][0] * (Xmin) + frustum[p][1] * (Ymin)
-                + frustum[p][2] * (Zmin) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmax) + frustum[p][1] * (Ymin)
-                + frustum[p][2] * (Zmin) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmin) + frustum[p][1] * (Ymax)
-                + frustum[p][2] * (Zmin) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmax) + frustum[p][1] * (Ymax)
-                + frustum[p][2] * (Zmin) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmin) + frustum[p][1] * (Ymin)
-                + frustum[p][2] * (Zmax) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmax) + frustum[p][1] * (Ymin)
-                + frustum[p][2] * (Zmax) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmin) + frustum[p][1] * (Ymax)
-                + frustum[p][2] * (Zmax) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        if (frustum[p][0] * (Xmax) + frustum[p][1] * (Ymax)
-                + frustum[p][2] * (Zmax) + frustum[p][3] > 0) {
-            count++;
-        }
-
-        // All vertices are completely outside the frustum plane
-        if (count == 0) {
-            return OUTSIDE;
-        }
-
-        // If any vertex is outside the frustum plane, it cannot be completely inside the whole frustum
-        if (count < 8) {
-            isCompleteInside = false;
-        }
-        // If all vertices are inside the frustum plane, mask this plane so we can skip testing all its children against it
-        else {
-            planeMask = planeMask | (1 << p);
-        }
-    }
+    return checkAABBVsFrustumOpt(frustum, bounding_volume.min_corner(),
+            bounding_volume.max_corner(), planeMask);
+}
 
-    return isCompleteInside ? INSIDE : INTERSECT;
+int SceneObject::checkAABBVsFrustumOpt(const float frustum[6][4],
+        const glm::vec3& min_corner, const glm::vec3& max_corner,
+        int& planeMask) {
+    // the same SIMD kernel the CullList runs on blocks of objects
+    unsigned char outside;
+    unsigned char inside;
+
+    classifyAABBsVsFrustum(frustum, &min_corner.x, &min_corner.y,
+            &min_corner.z, &max_corner.x, &max_corner.y, &max_corner.z, 1,
+            &outside, &inside);
+    return resolveAABBVsFrustum(outside, inside, planeMask);
 }
 
 bool SceneObject::checkAABBVsFrustumBasic(const float frustum[6][4],
@@ -21,6 +21,7 @@
 #define SCENE_OBJECT_H_
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 
 #include "objects/hybrid_object.h"
@@ -30,6 +31,7 @@
 #include "objects/components/camera_rig.h"
 #include "objects/components/collider.h"
 #include "objects/bounding_volume.h"
+#include "engine/renderer/aabb_frustum.h"
 #include "util/gvr_gl.h"
 
 namespace gvr {
@@ -65,17 +67,12 @@ public:
         return in_frustum_;
     }
 
-    void set_visible(bool visibility);
-    bool visible() const {
-        return visible_;
+    void set_visible(bool visibility = true) {
+        visible_ = visibility;
     }
 
-    void set_query_issued(bool issued = true) {
-        query_currently_issued_ = issued;
-    }
-
-    bool is_query_issued() {
-        return query_currently_issued_;
+    bool visible() const {
+        return visible_;
     }
 
     bool attachComponent(Component* component);
@@ -104,6 +101,9 @@ public:
         return (Collider*) getComponent(Collider::getComponentType());
     }
 
+    /*
+     * Parent as of the last applyPendingEdits(), like children().
+     */
     SceneObject* parent() const {
         return parent_;
     }
@@ -124,20 +124,30 @@ public:
     bool isCulled(){
     	return cull_status_;
     }
-    std::vector<SceneObject*> children() {
-        std::lock_guard < std::mutex > lock(children_mutex_);
-        return std::vector<SceneObject*>(children_);
+
+    /*
+     * Children as of the last applyPendingEdits(). Only to be used on
+     * the GL thread, which is the only one changing this list, so it
+     * is read without locking or copying.
+     */
+    const std::vector<SceneObject*>& children() const {
+        return published_children_;
     }
 
+    /*
+     * Structural edits (addChildObject, removeChildObject, clear) may
+     * come from any thread. They take effect right away for the editing
+     * thread, but children() and parent() are only updated here.
+     * Called by the renderer on the GL thread at the start of a frame.
+     */
+    static void applyPendingEdits();
+
     void addChildObject(SceneObject* self, SceneObject* child);
     void removeChildObject(SceneObject* child);
     void getDescendants(std::vector<SceneObject*>& descendants);
     void clear();
-    int getChildrenCount() const;
+    int getChildrenCount();
     SceneObject* getChildByIndex(int index);
-    GLuint *get_occlusion_array() {
-        return queries_;
-    }
     bool isColliding(SceneObject* scene_object);
     bool intersectsBoundingVolume(float rox, float roy, float roz, float rdx,
             float rdy, float rdz);
@@ -146,28 +156,69 @@ public:
     void dirtyHierarchicalBoundingVolume();
     BoundingVolume& getBoundingVolume();
 
+    /*
+     * Invalidate the transforms of the children in place,
+     * without copying the list of children.
+     */
+    void invalidateChildTransforms();
+
+    bool isBoundingVolumeDirty() const {
+        return bounding_volume_dirty_;
+    }
+
+    /*
+     * The bounding volume computed by the last getBoundingVolume,
+     * never recomputed here. The cull jobs read the volumes refit by
+     * TransformList::refitBounds through this so they do not write
+     * to the scene objects they share.
+     */
+    const BoundingVolume& getRefitBoundingVolume() const {
+        return transformed_bounding_volume_;
+    }
+
+    /*
+     * Bounding volume of this object's own mesh in world coordinates.
+     * Only valid after getBoundingVolume has been called.
+     */
+    const BoundingVolume& getMeshBoundingVolume() const {
+        return mesh_bounding_volume;
+    }
+
     int frustumCull(glm::vec3 camera_position, const float frustum[6][4], int& planeMask);
 
+    static int checkAABBVsFrustumOpt(const float frustum[6][4],
+            const glm::vec3& min_corner, const glm::vec3& max_corner,
+            int& planeMask);
+
+    /*
+     * Incremented whenever a scene object gains or loses a component
+     * and whenever applyPendingEdits publishes new children. Flattened copies of the scene graph
+     * (like CullList) compare against it to know when to rebuild.
+     */
+    static unsigned int hierarchyVersion() {
+        return hierarchy_version_;
+    }
+
 private:
     std::string name_;
     std::vector<Component*> components_;
     SceneObject* parent_ = nullptr;
+    // parent as of the last edit, for the edits to check against
+    SceneObject* edited_parent_ = nullptr;
+    // edited under children_mutex_, published to the GL thread once a frame
     std::vector<SceneObject*> children_;
+    std::vector<SceneObject*> published_children_;
+    bool children_edited_;
     bool cull_status_;
     bool transform_dirty_;
     BoundingVolume transformed_bounding_volume_;
     bool bounding_volume_dirty_;
     BoundingVolume mesh_bounding_volume;
+    bool mesh_bounding_volume_dirty_;
 
-    //Flags to check for visibility of a node and
-    //whether there are any pending occlusion queries on it
-    const int check_frames_ = 12;
-    int vis_count_;
     bool visible_;
     bool enabled_;
     bool in_frustum_;
-    bool query_currently_issued_;
-    GLuint *queries_ = nullptr;
 
     SceneObject(const SceneObject& scene_object);
     SceneObject(SceneObject&& scene_object);
@@ -182,7 +233,14 @@ private:
     bool checkAABBVsFrustumBasic(const float frustum[6][4],
             BoundingVolume &bounding_volume);
 
+    void markChildrenEdited();
+    void setParent(SceneObject* parent);
+    void dirtyBoundingVolume();
+
     std::mutex children_mutex_;
+    static std::atomic<unsigned int> hierarchy_version_;
+    static std::mutex edited_mutex_;
+    static std::vector<SceneObject*> edited_objects_;
 };
 
 }
@@ -61,9 +61,36 @@ public:
         glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
                 GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap (GL_TEXTURE_2D);
+        // luminance can not be copied into an atlas
+        replacePixels(0, 0);
+        // a third more for the mipmaps
+        setGpuBytes((size_t) width * height * 4 / 3);
         return (glGetError() == 0) ? 1 : 0;
     }
 
+    /*
+     * A bitmap has been uploaded from Java, small ones may be copied
+     * into a TextureAtlas. Called on the GL thread.
+     */
+    void bitmapUploaded(int width, int height) {
+        replacePixels(width, height);
+        // a third more for the mipmaps
+        setGpuBytes((size_t) width * height * 4 * 4 / 3);
+    }
+
+    int width() const {
+        return width_;
+    }
+
+    int height() const {
+        return height_;
+    }
+
+    bool atlasable() const {
+        return (0 < width_) && (width_ <= TextureAtlas::MAX_SIZE)
+                && (0 < height_) && (height_ <= TextureAtlas::MAX_SIZE);
+    }
+
     GLenum getTarget() const {
         return TARGET;
     }
@@ -85,7 +112,9 @@ public:
         }
     }
 
+    // textures updated from buffers change too often to be copied into an atlas
     void updateFromBuffer(int width, int height, int format, int type, void* data) {
+        replacePixels(0, 0);
         glBindTexture(GL_TEXTURE_2D, getId());
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, data);
         glBindTexture(GL_TEXTURE_2D, 0);
@@ -97,6 +126,13 @@ private:
     BaseTexture& operator=(const BaseTexture& base_texture);
     BaseTexture& operator=(BaseTexture&& base_texture);
 
+    // the copy in the atlas, if any, is out of date
+    void replacePixels(int width, int height) {
+        TextureAtlas::getInstance().remove(this);
+        width_ = width;
+        height_ = height;
+    }
+
 private:
     static const GLenum TARGET = GL_TEXTURE_2D;
 
@@ -105,6 +141,10 @@ private:
     jweak textureObjectWeak_ = nullptr;
     jclass gvrTextureClass_ = nullptr;
     jmethodID javaMethodIdAvailable_;
+
+    // size of the bitmap if it may be copied into an atlas, 0 otherwise
+    int width_ = 0;
+    int height_ = 0;
 };
 
 }
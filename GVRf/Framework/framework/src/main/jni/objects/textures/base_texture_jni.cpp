@@ -35,6 +35,10 @@ extern "C" {
     JNIEXPORT jboolean JNICALL
     Java_org_gearvrf_NativeBaseTexture_update(JNIEnv * env, jobject obj,
             jlong jtexture, jint width, jint height, jbyteArray jdata);
+
+    JNIEXPORT void JNICALL
+    Java_org_gearvrf_NativeBaseTexture_bitmapUploaded(JNIEnv * env, jobject obj,
+            jlong jtexture, jint width, jint height);
 }
 
 JNIEXPORT jlong JNICALL
@@ -61,6 +65,13 @@ Java_org_gearvrf_NativeBaseTexture_update(JNIEnv * env, jobject obj,
     return result;
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeBaseTexture_bitmapUploaded(JNIEnv * env, jobject obj,
+        jlong jtexture, jint width, jint height) {
+    BaseTexture* texture = reinterpret_cast<BaseTexture*>(jtexture);
+    texture->bitmapUploaded(width, height);
+}
+
 extern "C"
 JNIEXPORT jboolean JNICALL
 Java_org_gearvrf_NativeBaseTexture_updateFromBuffer(JNIEnv *env, jclass type_, jlong pointer,
@@ -20,7 +20,10 @@
 #ifndef compressed_texture_H_
 #define compressed_texture_H_
 
+#include <vector>
+
 #include "objects/textures/texture.h"
+#include "objects/textures/texture_uploader.h"
 #include "util/gvr_jni.h"
 #include "util/gvr_log.h"
 #include "util/jni_utils.h"
@@ -36,44 +39,36 @@ public:
         pending_gl_task_ = GL_TASK_INIT_PLAIN;
     }
 
-    // The constructor to use when loading a single-level texture
+    // The constructor to use when loading a single-level texture.
+    // The image is copied here, on the loading thread, and uploaded
+    // by the TextureUploader in a later frame.
     explicit CompressedTexture(JNIEnv* env, GLenum target, GLenum internalFormat,
             GLsizei width, GLsizei height, GLsizei imageSize, jbyteArray bytes,
             int dataOffset, int* texture_parameters) :
             Texture(new GLTexture(target, texture_parameters)), target(target) {
-        pending_gl_task_ = GL_TASK_INIT_INTERNAL_FORMAT;
-        if (JNI_OK != env->GetJavaVM(&javaVm_)) {
-            FAIL("GetJavaVM failed");
-        }
-
-        internalFormat_ = internalFormat;
-        width_ = width;
-        height_ = height;
-        imageSize_ = imageSize;
-        bytesRef_ = static_cast<jbyteArray>(env->NewGlobalRef(bytes));
-        dataOffset_ = dataOffset;
+        pending_gl_task_ = GL_TASK_NONE;
+
+        image_size_ = imageSize;
+        std::vector<char> pixels(imageSize);
+        env->GetByteArrayRegion(bytes, dataOffset, imageSize,
+                reinterpret_cast<jbyte*>(pixels.data()));
+        TextureUploader::Image image = { target, 0, internalFormat, width, height,
+                0, 0, false };
+        TextureUploader::getInstance().queue(this, image, std::move(pixels));
     }
 
     virtual ~CompressedTexture() {
-        JNIEnv* env = getCurrentEnv(javaVm_);
-
-        // Release global refs. Race condition does not occur because if
-        // the runPendingGL is running, the object won't be destructed.
-        switch (pending_gl_task_) {
-        case GL_TASK_INIT_INTERNAL_FORMAT: {
-            env->DeleteGlobalRef(bytesRef_);
-            break;
-        }
-
-        default:
-            break;
-        }
+        TextureUploader::getInstance().cancel(this);
     }
 
     GLenum getTarget() const {
         return target;
     }
 
+    virtual void levelUploaded(int level) {
+        setGpuBytes(image_size_);
+    }
+
     virtual void runPendingGL() {
         Texture::runPendingGL();
 
@@ -85,19 +80,6 @@ public:
             glBindTexture(target, gl_texture_->id());
             break;
 
-        case GL_TASK_INIT_INTERNAL_FORMAT: {
-            JNIEnv* env = getCurrentEnv(javaVm_);
-            jbyte* data = env->GetByteArrayElements(bytesRef_, 0);
-
-            glBindTexture(target, gl_texture_->id());
-            glCompressedTexImage2D(target, 0, internalFormat_, width_, height_, 0,
-                    imageSize_, data + dataOffset_);
-
-            env->ReleaseByteArrayElements(bytesRef_, data, 0);
-            env->DeleteGlobalRef(bytesRef_);
-            break;
-        }
-
         } // switch
 
         pending_gl_task_ = GL_TASK_NONE;
@@ -117,19 +99,9 @@ private:
     enum {
         GL_TASK_NONE = 0,
         GL_TASK_INIT_PLAIN,
-        GL_TASK_INIT_INTERNAL_FORMAT,
     };
     int pending_gl_task_;
-
-    JavaVM* javaVm_;
-
-    // For GL_TASK_INIT_INTERNAL_FORMAT
-    GLenum internalFormat_;
-    GLsizei width_;
-    GLsizei height_;
-    GLsizei imageSize_;
-    int dataOffset_;
-    jbyteArray bytesRef_;
+    GLsizei image_size_ = 0;
 };
 
 }
@@ -34,6 +34,7 @@ public:
         glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0,
                 GL_RG, GL_FLOAT, data);
+        setGpuBytes((size_t) width * height * 2 * sizeof(float));
         return (glGetError() == 0) ? 1 : 0;
     }
 
@@ -0,0 +1,419 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Compressed texture streamed from a memory mapped KTX file.
+ ***************************************************************************/
+
+#include "ktx_texture.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "objects/textures/texture_uploader.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+namespace {
+
+const unsigned char KTX1_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+const unsigned char KTX2_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+const size_t KTX1_HEADER_SIZE = 64;
+const size_t KTX2_LEVEL_INDEX = 80;
+const size_t KTX2_LEVEL_SIZE = 24;
+
+uint32_t readUint32(const char* p, bool swap = false) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return swap ? __builtin_bswap32(value) : value;
+}
+
+uint64_t readUint64(const char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/*
+ * Rejects empty images, sizes which do not fit a GLsizei and more
+ * levels than the full mipmap chain of the image has.
+ */
+bool checkDimensions(uint32_t width, uint32_t height, uint32_t level_count) {
+    if ((0 == width) || (0 == height)) {
+        LOGE("KtxTexture: empty %ux%u texture", width, height);
+        return false;
+    }
+    if ((width > INT_MAX) || (height > INT_MAX)) {
+        LOGE("KtxTexture: %ux%u texture is too large", width, height);
+        return false;
+    }
+    const uint32_t max_levels = 32 - __builtin_clz(std::max(width, height));
+    if (level_count > max_levels) {
+        LOGE("KtxTexture: %u levels for a %ux%u texture", level_count, width, height);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * GL internal format of the Vulkan formats KTX 2.0 files hold.
+ * ETC2 and EAC come in the same order in both APIs, ASTC alternates
+ * UNORM and SRGB in Vulkan.
+ */
+GLenum internalFormatFromVk(uint32_t vk_format) {
+    static const GLenum etc2_formats[] = {
+            0x9274, 0x9275, 0x9276, 0x9277, 0x9278,     // ETC2 RGB8 to SRGB8_ALPHA8
+            0x9279, 0x9270, 0x9271, 0x9272, 0x9273 };   // EAC R11 to SIGNED_RG11
+    static const uint32_t VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147;
+    static const uint32_t VK_FORMAT_ASTC_4x4_UNORM_BLOCK = 157;
+    static const uint32_t VK_FORMAT_ASTC_12x12_SRGB_BLOCK = 184;
+    static const GLenum GL_COMPRESSED_RGBA_ASTC_4x4 = 0x93B0;
+    static const GLenum GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 = 0x93D0;
+
+    if ((vk_format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK)
+            && (vk_format < VK_FORMAT_ASTC_4x4_UNORM_BLOCK)) {
+        return etc2_formats[vk_format - VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK];
+    }
+    if ((vk_format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK)
+            && (vk_format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)) {
+        uint32_t index = vk_format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+        return ((index & 1) ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4
+                : GL_COMPRESSED_RGBA_ASTC_4x4) + index / 2;
+    }
+    return 0;
+}
+
+}
+
+KtxTexture* KtxTexture::load(int fd, long offset, long length, int* texture_parameters) {
+    if (length <= 0) {
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            LOGE("KtxTexture: cannot stat file");
+            return nullptr;
+        }
+        length = status.st_size - offset;
+    }
+    if ((offset < 0) || (length <= 0)) {
+        LOGE("KtxTexture: nothing to load at offset %ld", offset);
+        return nullptr;
+    }
+
+    // mappings start on a page, assets may start anywhere in the APK
+    long page_mask = sysconf(_SC_PAGESIZE) - 1;
+    long page_offset = offset & ~page_mask;
+    size_t mapping_size = length + (offset - page_offset);
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, page_offset);
+    if (MAP_FAILED == mapping) {
+        LOGE("KtxTexture: cannot map %ld bytes at offset %ld", length, offset);
+        return nullptr;
+    }
+
+    KtxTexture* texture = new KtxTexture(mapping, mapping_size, texture_parameters);
+    const char* data = static_cast<const char*>(mapping) + (offset - page_offset);
+
+    if ((length >= sizeof(KTX1_IDENTIFIER))
+            && (0 == memcmp(data, KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER)))) {
+        if (!texture->parseKtx1(data, length)) {
+            delete texture;
+            return nullptr;
+        }
+    } else if ((length >= sizeof(KTX2_IDENTIFIER))
+            && (0 == memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)))) {
+        if (!texture->parseKtx2(data, length)) {
+            delete texture;
+            return nullptr;
+        }
+    } else {
+        LOGE("KtxTexture: not a KTX file");
+        delete texture;
+        return nullptr;
+    }
+
+    int initial_level = 0;
+    while ((initial_level + 1 < texture->levels_.size())
+            && (std::max(texture->width_, texture->height_) >> initial_level) > INITIAL_SIZE) {
+        ++initial_level;
+    }
+    texture->low_level_ = initial_level;
+    texture->queued_level_ = texture->levels_.size();
+    texture->queueLevels(initial_level, true);
+    return texture;
+}
+
+KtxTexture::KtxTexture(void* mapping, size_t mapping_size, int* texture_parameters) :
+        Texture(new GLTexture(GL_TEXTURE_2D, texture_parameters)),
+        mapping_(mapping), mapping_size_(mapping_size), internal_format_(0),
+        width_(0), height_(0), low_level_(0), queued_level_(0), storage_level_(0),
+        base_level_(0), storage_allocated_(false) {
+    streamed_ = true;
+}
+
+KtxTexture::~KtxTexture() {
+    TextureUploader::getInstance().cancel(this);
+    munmap(mapping_, mapping_size_);
+}
+
+/*
+ * KTX 1.1: a header with GL enums in the byte order of the writer,
+ * then each level as its size and the image padded to four bytes.
+ */
+bool KtxTexture::parseKtx1(const char* data, size_t size) {
+    if (size < KTX1_HEADER_SIZE) {
+        LOGE("KtxTexture: truncated KTX header");
+        return false;
+    }
+    const uint32_t endianness = readUint32(data + 12);
+    if ((0x04030201 != endianness) && (0x01020304 != endianness)) {
+        LOGE("KtxTexture: bad endianness 0x%08x", endianness);
+        return false;
+    }
+    const bool swap = (0x01020304 == endianness);
+    const uint32_t gl_type = readUint32(data + 16, swap);
+    const uint32_t gl_format = readUint32(data + 24, swap);
+    const uint32_t pixel_depth = readUint32(data + 44, swap);
+    const uint32_t array_elements = readUint32(data + 48, swap);
+    const uint32_t faces = readUint32(data + 52, swap);
+    const uint32_t level_count = std::max(1u, readUint32(data + 56, swap));
+    const uint32_t key_value_bytes = readUint32(data + 60, swap);
+    const uint32_t width = readUint32(data + 36, swap);
+    const uint32_t height = readUint32(data + 40, swap);
+
+    internal_format_ = readUint32(data + 28, swap);
+    if ((0 != gl_type) || (0 != gl_format)) {
+        LOGE("KtxTexture: only compressed KTX files are supported");
+        return false;
+    }
+    if ((pixel_depth > 1) || (0 != array_elements) || (1 != faces)) {
+        LOGE("KtxTexture: only 2D KTX textures are supported");
+        return false;
+    }
+    if (!checkDimensions(width, height, level_count)) {
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    if (key_value_bytes > size - KTX1_HEADER_SIZE) {
+        LOGE("KtxTexture: truncated KTX key value data");
+        return false;
+    }
+
+    // compare against the bytes left so that nothing wraps around
+    size_t offset = KTX1_HEADER_SIZE + key_value_bytes;
+    for (uint32_t i = 0; i < level_count; ++i) {
+        if ((offset > size) || (sizeof(uint32_t) > size - offset)) {
+            LOGE("KtxTexture: truncated KTX level %u", i);
+            return false;
+        }
+        const uint32_t image_size = readUint32(data + offset, swap);
+        offset += sizeof(uint32_t);
+        if (image_size > size - offset) {
+            LOGE("KtxTexture: truncated KTX level %u", i);
+            return false;
+        }
+        if (image_size > INT_MAX) {
+            LOGE("KtxTexture: KTX level %u is too large", i);
+            return false;
+        }
+        Level level = { data + offset, (int) image_size };
+        levels_.push_back(level);
+        offset = (offset + image_size + 3) & ~3;
+    }
+    return true;
+}
+
+/*
+ * KTX 2.0: a little endian header with a Vulkan format and an index
+ * of the levels, which may be stored in any order.
+ */
+bool KtxTexture::parseKtx2(const char* data, size_t size) {
+    if (size < KTX2_LEVEL_INDEX) {
+        LOGE("KtxTexture: truncated KTX2 header");
+        return false;
+    }
+    const uint32_t vk_format = readUint32(data + 12);
+    const uint32_t pixel_depth = readUint32(data + 28);
+    const uint32_t layers = readUint32(data + 32);
+    const uint32_t faces = readUint32(data + 36);
+    const uint32_t level_count = std::max(1u, readUint32(data + 40));
+    const uint32_t supercompression = readUint32(data + 44);
+    const uint32_t width = readUint32(data + 20);
+    const uint32_t height = readUint32(data + 24);
+
+    internal_format_ = internalFormatFromVk(vk_format);
+    if (0 == internal_format_) {
+        LOGE("KtxTexture: unsupported KTX2 format %u", vk_format);
+        return false;
+    }
+    if (0 != supercompression) {
+        LOGE("KtxTexture: supercompressed KTX2 files are not supported");
+        return false;
+    }
+    if ((0 != pixel_depth) || (0 != layers) || (1 != faces)) {
+        LOGE("KtxTexture: only 2D KTX2 textures are supported");
+        return false;
+    }
+    if (!checkDimensions(width, height, level_count)) {
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    if (level_count > (size - KTX2_LEVEL_INDEX) / KTX2_LEVEL_SIZE) {
+        LOGE("KtxTexture: truncated KTX2 level index");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < level_count; ++i) {
+        const char* entry = data + KTX2_LEVEL_INDEX + i * KTX2_LEVEL_SIZE;
+        const uint64_t offset = readUint64(entry);
+        const uint64_t length = readUint64(entry + 8);
+
+        if ((offset > size) || (length > size - offset)) {
+            LOGE("KtxTexture: truncated KTX2 level %u", i);
+            return false;
+        }
+        if (length > INT_MAX) {
+            LOGE("KtxTexture: KTX2 level %u is too large", i);
+            return false;
+        }
+        Level level = { data + offset, (int) length };
+        levels_.push_back(level);
+    }
+    return true;
+}
+
+/*
+ * Queue the levels from the finest one queued so far down to
+ * finest_level, coarse to fine so that they arrive in that order.
+ */
+void KtxTexture::queueLevels(int finest_level, bool hold_ready) {
+    TextureUploader& uploader = TextureUploader::getInstance();
+
+    for (int i = queued_level_ - 1; i >= finest_level; --i) {
+        TextureUploader::Image image = { GL_TEXTURE_2D, i - storage_level_, internal_format_,
+                std::max(1, width_ >> i), std::max(1, height_ >> i), 0, 0, true };
+        uploader.queue(this, image, levels_[i].pixels, levels_[i].size, hold_ready);
+    }
+    queued_level_ = finest_level;
+}
+
+/*
+ * Allocate all the levels from the storage level on at once, sampling
+ * is limited to the levels which have been uploaded with the base level.
+ */
+void KtxTexture::runPendingGL() {
+    Texture::runPendingGL();
+
+    if (storage_allocated_ || levels_.empty()) {
+        return;
+    }
+    const int gl_levels = levels_.size() - storage_level_;
+    size_t bytes = 0;
+
+    glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
+    glTexStorage2D(GL_TEXTURE_2D, gl_levels, internal_format_,
+            std::max(1, width_ >> storage_level_), std::max(1, height_ >> storage_level_));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, gl_levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, gl_levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    base_level_ = levels_.size() - 1;
+    storage_allocated_ = true;
+
+    for (int i = storage_level_; i < levels_.size(); ++i) {
+        bytes += levels_[i].size;
+    }
+    setGpuBytes(bytes);
+}
+
+void KtxTexture::levelUploaded(int gl_level) {
+    const int level = gl_level + storage_level_;
+
+    if (level >= base_level_) {
+        return;
+    }
+    base_level_ = level;
+    glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, gl_level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool KtxTexture::evict() {
+    if (!storage_allocated_ || (storage_level_ >= low_level_)) {
+        return false;
+    }
+    reallocate(low_level_);
+    return true;
+}
+
+/*
+ * Replace the GL texture by one with storage from the given level on.
+ * Uploads still queued for the old one are dropped and the levels up
+ * to the finer of the base and the storage level are copied from the
+ * mapping right away. Those are only the small initial levels, since
+ * the storage only grows after an eviction.
+ */
+void KtxTexture::reallocate(int storage_level) {
+    TextureUploader::getInstance().cancel(this);
+    const int resident = std::max(base_level_, storage_level);
+    int texture_parameters[MAX_TEXTURE_PARAM_NUM];
+
+    memcpy(texture_parameters, gl_texture_->texture_parameters(), sizeof(texture_parameters));
+    delete gl_texture_;
+    gl_texture_ = new GLTexture(GL_TEXTURE_2D, texture_parameters);
+    storage_level_ = storage_level;
+    storage_allocated_ = false;
+    runPendingGL();
+
+    glBindTexture(GL_TEXTURE_2D, gl_texture_->id());
+    for (int i = levels_.size() - 1; i >= resident; --i) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, i - storage_level_, 0, 0,
+                std::max(1, width_ >> i), std::max(1, height_ >> i), internal_format_,
+                levels_[i].size, levels_[i].pixels);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, resident - storage_level_);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    base_level_ = resident;
+    queued_level_ = resident;
+}
+
+/*
+ * The finest level needed is the smallest one which still has at
+ * least as many texels as the object covers pixels.
+ */
+void KtxTexture::requestScreenSize(float pixels) {
+    const int size = std::max(width_, height_);
+    int level = 0;
+
+    while ((level + 1 < levels_.size()) && ((size >> (level + 1)) >= pixels)) {
+        ++level;
+    }
+    if (level < storage_level_) {
+        reallocate(0);
+    }
+    if (level < queued_level_) {
+        queueLevels(level, false);
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Compressed texture streamed from a memory mapped KTX file.
+ ***************************************************************************/
+
+#ifndef KTX_TEXTURE_H_
+#define KTX_TEXTURE_H_
+
+#include <vector>
+
+#include "objects/textures/texture.h"
+
+namespace gvr {
+
+/*
+ * A compressed 2D texture read from a KTX 1.1 or KTX 2.0 file without
+ * copying it: the file is mapped and the mip levels are uploaded by
+ * the TextureUploader straight from the mapping.
+ *
+ * The coarsest levels, up to INITIAL_SIZE pixels, are queued when the
+ * texture is created and it becomes ready once they are on the GPU.
+ * Finer levels are queued, coarse to fine, only when an object using
+ * the texture is drawn large enough to need them. The texture has
+ * immutable storage from its storage level on and its base level
+ * follows the finest level uploaded so far.
+ *
+ * When the TextureResidency evicts the texture its storage is
+ * reallocated without the levels finer than the initial ones, and
+ * allocated in full again once they are requested.
+ *
+ * KTX 2.0 files must not be supercompressed and must hold an ETC2,
+ * EAC or ASTC format.
+ */
+class KtxTexture: public Texture {
+public:
+    /*
+     * Map length bytes at offset of the file and parse them.
+     * Returns null, after logging why, if the file is not a KTX file
+     * this class can load. The descriptor may be closed afterwards.
+     */
+    static KtxTexture* load(int fd, long offset, long length, int* texture_parameters);
+
+    virtual ~KtxTexture();
+
+    GLenum getTarget() const {
+        return GL_TEXTURE_2D;
+    }
+
+    virtual void runPendingGL();
+    virtual void levelUploaded(int level);
+    virtual void requestScreenSize(float pixels);
+    virtual bool evict();
+
+    int level_count() const {
+        return levels_.size();
+    }
+
+    // finest level queued for upload so far
+    int queued_level() const {
+        return queued_level_;
+    }
+
+private:
+    KtxTexture(const KtxTexture& ktx_texture);
+    KtxTexture(KtxTexture&& ktx_texture);
+    KtxTexture& operator=(const KtxTexture& ktx_texture);
+    KtxTexture& operator=(KtxTexture&& ktx_texture);
+
+    // levels this small or smaller are loaded up front
+    static const int INITIAL_SIZE = 128;
+
+    struct Level {
+        const char* pixels;
+        int size;
+    };
+
+    KtxTexture(void* mapping, size_t mapping_size, int* texture_parameters);
+    bool parseKtx1(const char* data, size_t size);
+    bool parseKtx2(const char* data, size_t size);
+    void queueLevels(int finest_level, bool hold_ready);
+    void reallocate(int storage_level);
+
+    void* mapping_;
+    size_t mapping_size_;
+    GLenum internal_format_;
+    GLsizei width_;
+    GLsizei height_;
+    std::vector<Level> levels_;     // finest level first
+    int low_level_;                 // finest level kept when evicted
+    int queued_level_;
+
+    // GL thread only, levels of the file, not of the GL texture
+    int storage_level_;             // level stored in GL level 0
+    int base_level_;
+    bool storage_allocated_;
+};
+
+}
+#endif
@@ -0,0 +1,41 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * JNI
+ ***************************************************************************/
+
+#include "ktx_texture.h"
+
+#include "util/gvr_jni.h"
+
+namespace gvr {
+extern "C" {
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_NativeKtxTexture_load(JNIEnv * env, jobject obj,
+        jint fd, jlong offset, jlong length, jintArray jtexture_parameters);
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_gearvrf_NativeKtxTexture_load(JNIEnv * env, jobject obj,
+        jint fd, jlong offset, jlong length, jintArray jtexture_parameters) {
+    jint* texture_parameters = env->GetIntArrayElements(jtexture_parameters, 0);
+    KtxTexture* texture = KtxTexture::load(fd, offset, length, texture_parameters);
+
+    env->ReleaseIntArrayElements(jtexture_parameters, texture_parameters, 0);
+    return reinterpret_cast<jlong>(texture);
+}
+
+}
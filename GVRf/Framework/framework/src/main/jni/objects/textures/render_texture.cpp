@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "render_texture.h"
+#include "gl/gl_state.h"
 #include "util/gvr_gl_ext.h"
 #include "eglextension/msaa/msaa.h"
 
@@ -240,9 +241,10 @@ void RenderTexture::beginRendering() {
     glBindFramebuffer(GL_FRAMEBUFFER, renderTexture_gl_frame_buffer_->id());
     glViewport(0, 0, width, height);
     glScissor(0, 0, width, height);
-    glDepthMask(GL_TRUE);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    GLState& gl = GLState::getInstance();
+    gl.depthMask(GL_TRUE);
+    gl.enable(GL_DEPTH_TEST);
+    gl.depthFunc(GL_LEQUAL);
     invalidateFrameBuffer(GL_FRAMEBUFFER, true, true, true);
     if ((back_color_[0] + back_color_[1] + back_color_[2] + use_stencil_) != 0)
     {
@@ -251,7 +253,7 @@ void RenderTexture::beginRendering() {
         if (use_stencil_)
         {
             mask |= GL_STENCIL_BUFFER_BIT;
-            glStencilMask(~0);
+            gl.stencilMask(~0);
         }
         glClear(mask);
     }
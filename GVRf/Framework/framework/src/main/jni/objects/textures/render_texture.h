@@ -21,6 +21,8 @@
 #ifndef RENDER_TEXTURE_H_
 #define RENDER_TEXTURE_H_
 
+#include <algorithm>
+
 #include "gl/gl_render_buffer.h"
 #include "gl/gl_frame_buffer.h"
 #include "util/gvr_parameters.h"
@@ -56,6 +58,10 @@ public:
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
         readback_started_ = false;
+
+        // color, depth and read back buffer at four bytes a pixel,
+        // multisampled attachments hold every sample
+        setGpuBytes((size_t) width_ * height_ * 4 * (1 + 2 * std::max(1, sample_count_)));
     }
 
     GLenum getTarget() const {
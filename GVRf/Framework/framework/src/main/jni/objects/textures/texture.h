@@ -20,15 +20,21 @@
 #ifndef TEXTURE_H_
 #define TEXTURE_H_
 
+#include <atomic>
+
 #include "gl/gl_texture.h"
 #include "objects/hybrid_object.h"
 #include "objects/gl_pending_task.h"
+#include "objects/textures/texture_atlas.h"
+#include "objects/textures/texture_residency.h"
 
 namespace gvr {
 
 class Texture: public HybridObject, GLPendingTask {
 public:
     virtual ~Texture() {
+        TextureAtlas::getInstance().remove(this);
+        setGpuBytes(0);
         delete gl_texture_;
     }
 
@@ -70,6 +76,10 @@ public:
         glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter_type_);
         glTexParameteri(target, GL_TEXTURE_MAG_FILTER, mag_filter_type_);
         glBindTexture(target, 0);
+
+        // the copy in an atlas was sampled with the old parameters
+        gl_texture_->set_texture_parameters(texture_parameters);
+        TextureAtlas::getInstance().remove(this);
     }
 
     virtual GLenum getTarget() const = 0;
@@ -81,19 +91,113 @@ public:
     }
 
     bool isReady() {
-        return ready;
+        return ready && (0 == pending_uploads_);
     }
 
     void setReady(bool ready) {
         this->ready = ready;
     }
 
+    // images queued on the TextureUploader which have not reached the GPU yet
+    void addPendingUpload() {
+        ++pending_uploads_;
+    }
+
+    void removePendingUpload() {
+        --pending_uploads_;
+    }
+
+    // called on the GL thread once a level queued on the TextureUploader is on the GPU
+    virtual void levelUploaded(int level) {
+    }
+
+    /*
+     * Textures streaming their mip levels load the levels needed to
+     * cover the given number of pixels on screen. Called on the GL
+     * thread for every draw with a material which uses them.
+     */
+    virtual void requestScreenSize(float pixels) {
+    }
+
+    bool streamed() const {
+        return streamed_;
+    }
+
+    // GPU memory of the texture as reported to the TextureResidency
+    size_t gpu_bytes() const {
+        return gpu_bytes_;
+    }
+
+    unsigned int last_used_frame() const {
+        return last_used_frame_;
+    }
+
+    // called by the renderer for the textures of each material it draws
+    void markUsed() {
+        last_used_frame_ = TextureResidency::frame();
+    }
+
+    /*
+     * Free GPU memory by dropping to a lower resolution, which has to
+     * be reloaded transparently when needed. Returns false if the
+     * texture can not do that. Called on the GL thread.
+     */
+    virtual bool evict() {
+        return false;
+    }
+
+    // size of level 0 if the texture is 2D and the size is known, 0 otherwise
+    virtual int width() const {
+        return 0;
+    }
+
+    virtual int height() const {
+        return 0;
+    }
+
+    /*
+     * Whether the pixels of the texture may be copied into a layer of
+     * a TextureArray by the TextureAtlas. The texture must remove
+     * itself from the atlas whenever its pixels change.
+     */
+    virtual bool atlasable() const {
+        return false;
+    }
+
+    // texture array holding a copy of the texture, if any
+    TextureArray* atlas() const {
+        return atlas_;
+    }
+
+    int atlas_layer() const {
+        return atlas_layer_;
+    }
+
+    // set by the TextureAtlas
+    void setAtlas(TextureArray* atlas, int layer) {
+        atlas_ = atlas;
+        atlas_layer_ = layer;
+    }
+
+    const int* texture_parameters() const {
+        return gl_texture_->texture_parameters();
+    }
+
 protected:
     Texture(GLTexture* gl_texture) : HybridObject() {
         gl_texture_ = gl_texture;
+        last_used_frame_ = TextureResidency::frame();
+    }
+
+    void setGpuBytes(size_t bytes) {
+        if (bytes != gpu_bytes_) {
+            TextureResidency::getInstance().setBytes(this, gpu_bytes_, bytes);
+            gpu_bytes_ = bytes;
+        }
     }
 
     GLTexture* gl_texture_;
+    bool streamed_ = false;
 
 private:
     Texture(const Texture& texture);
@@ -104,6 +208,11 @@ private:
 private:
     static const GLenum target = GL_TEXTURE_2D;
     bool ready = false;
+    std::atomic<int> pending_uploads_ { 0 };
+    size_t gpu_bytes_ = 0;
+    unsigned int last_used_frame_;
+    TextureArray* atlas_ = nullptr;
+    int atlas_layer_ = -1;
 };
 
 }
@@ -0,0 +1,83 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * 2D array texture whose layers hold copies of small textures.
+ ***************************************************************************/
+
+#include "texture_array.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gvr {
+
+TextureArray::TextureArray(int width, int height, int layer_count,
+        const int* texture_parameters) :
+        Texture(newGLTexture(texture_parameters)), width_(width), height_(height),
+        used_(layer_count, false), used_count_(0), storage_allocated_(false) {
+}
+
+GLTexture* TextureArray::newGLTexture(const int* texture_parameters) {
+    int parameters[MAX_TEXTURE_PARAM_NUM];
+
+    std::memcpy(parameters, texture_parameters, sizeof(parameters));
+    std::fill(parameters + 5, parameters + MAX_TEXTURE_PARAM_NUM, 0);
+    return new GLTexture(GL_TEXTURE_2D_ARRAY, parameters);
+}
+
+void TextureArray::runPendingGL() {
+    Texture::runPendingGL();
+
+    if (storage_allocated_) {
+        return;
+    }
+    int levels = 1;
+    size_t bytes = 0;
+
+    while ((width_ >> levels) || (height_ >> levels)) {
+        ++levels;
+    }
+    for (int i = 0; i < levels; ++i) {
+        bytes += (size_t) std::max(1, width_ >> i) * std::max(1, height_ >> i) * 4;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_->id());
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width_, height_, used_.size());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    storage_allocated_ = true;
+    setGpuBytes(bytes * used_.size());
+}
+
+int TextureArray::addLayer() {
+    auto it = std::find(used_.begin(), used_.end(), false);
+
+    if (it == used_.end()) {
+        return -1;
+    }
+    *it = true;
+    ++used_count_;
+    return it - used_.begin();
+}
+
+void TextureArray::releaseLayer(int layer) {
+    if (used_[layer]) {
+        used_[layer] = false;
+        --used_count_;
+    }
+}
+
+}
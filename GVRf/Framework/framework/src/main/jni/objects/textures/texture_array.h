@@ -0,0 +1,83 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * 2D array texture whose layers hold copies of small textures.
+ ***************************************************************************/
+
+#ifndef TEXTURE_ARRAY_H_
+#define TEXTURE_ARRAY_H_
+
+#include <vector>
+
+#include "objects/textures/texture.h"
+
+namespace gvr {
+
+/*
+ * Array of layers of the same size in RGBA8 with a full mip chain,
+ * filled by the TextureAtlas. Every layer is a whole texture, so the
+ * texture coordinates of a mesh stay the same and only the layer is
+ * added.
+ *
+ * The layers in use are only changed by the TextureAtlas, under its
+ * lock.
+ */
+class TextureArray: public Texture {
+public:
+    TextureArray(int width, int height, int layer_count, const int* texture_parameters);
+
+    GLenum getTarget() const {
+        return GL_TEXTURE_2D_ARRAY;
+    }
+
+    virtual void runPendingGL();
+
+    int width() const {
+        return width_;
+    }
+
+    int height() const {
+        return height_;
+    }
+
+    // first free layer, marked used, or -1 if the array is full
+    int addLayer();
+
+    void releaseLayer(int layer);
+
+    int used_layers() const {
+        return used_count_;
+    }
+
+private:
+    TextureArray(const TextureArray& texture_array);
+    TextureArray(TextureArray&& texture_array);
+    TextureArray& operator=(const TextureArray& texture_array);
+    TextureArray& operator=(TextureArray&& texture_array);
+
+    // parameters without the image description GLTexture would allocate
+    static GLTexture* newGLTexture(const int* texture_parameters);
+
+    int width_;
+    int height_;
+    std::vector<bool> used_;
+    int used_count_;
+    bool storage_allocated_;
+};
+
+}
+#endif
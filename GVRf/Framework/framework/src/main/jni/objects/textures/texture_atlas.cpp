@@ -0,0 +1,159 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Packs small textures into texture arrays so materials can be batched.
+ ***************************************************************************/
+
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "objects/textures/texture.h"
+#include "objects/textures/texture_array.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+TextureAtlas::TextureAtlas() :
+        framebuffer_(0) {
+}
+
+void TextureAtlas::request(Texture* texture) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if ((rejected_.find(texture) == rejected_.end())
+            && (std::find(requested_.begin(), requested_.end(), texture) == requested_.end())) {
+        requested_.push_back(texture);
+    }
+}
+
+void TextureAtlas::remove(Texture* texture) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TextureArray* array = texture->atlas();
+
+    if (nullptr != array) {
+        array->releaseLayer(texture->atlas_layer());
+        texture->setAtlas(nullptr, -1);
+    }
+    requested_.erase(std::remove(requested_.begin(), requested_.end(), texture),
+            requested_.end());
+    rejected_.erase(texture);
+}
+
+/*
+ * Array of the same size and sampling parameters with a free layer,
+ * a new one if there is none.
+ */
+TextureArray* TextureAtlas::findArray(Texture* texture) {
+    const int* parameters = texture->texture_parameters();
+
+    for (auto it = arrays_.begin(); it != arrays_.end(); ++it) {
+        TextureArray* array = *it;
+
+        if ((array->width() == texture->width()) && (array->height() == texture->height())
+                && (array->used_layers() < LAYERS_PER_ARRAY)
+                && (0 == std::memcmp(array->texture_parameters(), parameters, 5 * sizeof(int)))) {
+            return array;
+        }
+    }
+    TextureArray* array = new TextureArray(texture->width(), texture->height(),
+            LAYERS_PER_ARRAY, parameters);
+    arrays_.push_back(array);
+    return array;
+}
+
+/*
+ * Copy level 0 of the texture into the layer through the read
+ * framebuffer, which has to be bound.
+ */
+bool TextureAtlas::copy(Texture* texture, TextureArray* array, int layer) {
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+            texture->getId(), 0);
+    if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_READ_FRAMEBUFFER)) {
+        return false;
+    }
+    glGetError();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->getId());
+    glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 0, 0,
+            texture->width(), texture->height());
+    return GL_NO_ERROR == glGetError();
+}
+
+void TextureAtlas::update() {
+    std::vector<TextureArray*> unused;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<TextureArray*> copied;
+
+        if (!requested_.empty()) {
+            GLint read_framebuffer = 0;
+
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+            if (0 == framebuffer_) {
+                glGenFramebuffers(1, &framebuffer_);
+            }
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+
+            for (auto it = requested_.begin(); it != requested_.end(); ++it) {
+                Texture* texture = *it;
+
+                if ((nullptr != texture->atlas()) || !texture->atlasable()) {
+                    continue;
+                }
+                TextureArray* array = findArray(texture);
+                int layer = array->addLayer();
+
+                if (!copy(texture, array, layer)) {
+                    LOGD("TextureAtlas: texture %p can not be copied into an array", texture);
+                    array->releaseLayer(layer);
+                    rejected_.insert(texture);
+                    continue;
+                }
+                texture->setAtlas(array, layer);
+                if (std::find(copied.begin(), copied.end(), array) == copied.end()) {
+                    copied.push_back(array);
+                }
+            }
+            requested_.clear();
+
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+            for (auto it = copied.begin(); it != copied.end(); ++it) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, (*it)->getId());
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            }
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        }
+
+        for (auto it = arrays_.begin(); it != arrays_.end();) {
+            if (0 == (*it)->used_layers()) {
+                unused.push_back(*it);
+                it = arrays_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // outside of the lock, deleting a texture removes it from the atlas
+    for (auto it = unused.begin(); it != unused.end(); ++it) {
+        delete *it;
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Packs small textures into texture arrays so materials can be batched.
+ ***************************************************************************/
+
+#ifndef TEXTURE_ATLAS_H_
+#define TEXTURE_ATLAS_H_
+
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class Texture;
+class TextureArray;
+
+/*
+ * Copies small 2D textures into layers of shared TextureArrays, one
+ * array per size and sampling parameters, so that materials which
+ * only differ by such a texture can be drawn in one batch with the
+ * layer as a vertex attribute.
+ *
+ * Materials request the copy of their main texture when they are
+ * batched and update() makes it on the GPU at the start of the next
+ * frame. The original texture stays as it is for the draws which are
+ * not batched. Textures which can not be copied, because they are not
+ * color renderable or not compatible with RGBA8, are remembered and
+ * not requested again.
+ */
+class TextureAtlas {
+public:
+    static TextureAtlas& getInstance() {
+        static TextureAtlas instance;
+        return instance;
+    }
+
+    // largest width and height of a texture copied into the atlas
+    static const int MAX_SIZE = 256;
+    static const int LAYERS_PER_ARRAY = 16;
+
+    /*
+     * Queue the copy of an atlasable texture. Called on the GL thread.
+     */
+    void request(Texture* texture);
+
+    /*
+     * Copy the requested textures and delete the arrays which are no
+     * longer used. Called by the renderer on the GL thread.
+     */
+    void update();
+
+    /*
+     * Forget the texture and free its layer, called when it is deleted
+     * or its pixels or parameters change. May be called on any thread.
+     */
+    void remove(Texture* texture);
+
+private:
+    TextureAtlas();
+    TextureAtlas(const TextureAtlas& texture_atlas);
+    TextureAtlas(TextureAtlas&& texture_atlas);
+    TextureAtlas& operator=(const TextureAtlas& texture_atlas);
+    TextureAtlas& operator=(TextureAtlas&& texture_atlas);
+
+    TextureArray* findArray(Texture* texture);
+    bool copy(Texture* texture, TextureArray* array, int layer);
+
+    std::mutex mutex_;
+    std::vector<Texture*> requested_;
+    std::unordered_set<Texture*> rejected_;
+    std::vector<TextureArray*> arrays_;
+    GLuint framebuffer_;
+};
+
+}
+#endif
@@ -30,6 +30,9 @@ Java_org_gearvrf_NativeTexture_getId(JNIEnv * env, jobject obj,
 JNIEXPORT void JNICALL
 Java_org_gearvrf_NativeTexture_updateTextureParameters(JNIEnv * env, jobject obj,
         jlong jtexture, jintArray jtexture_parameters);
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeTexture_setGpuMemoryBudget(JNIEnv * env, jobject obj,
+        jlong jbytes);
 }
 ;
 
@@ -51,4 +54,10 @@ Java_org_gearvrf_NativeTexture_updateTextureParameters(JNIEnv * env, jobject obj
 
 }
 
+JNIEXPORT void JNICALL
+Java_org_gearvrf_NativeTexture_setGpuMemoryBudget(JNIEnv * env, jobject obj,
+        jlong jbytes) {
+    TextureResidency::getInstance().set_budget(jbytes);
+}
+
 }
@@ -0,0 +1,79 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Keeps the GPU memory held by textures within a budget.
+ ***************************************************************************/
+
+#include "texture_residency.h"
+
+#include <algorithm>
+
+#include "objects/textures/texture.h"
+
+namespace gvr {
+
+unsigned int TextureResidency::frame_ = 0;
+
+TextureResidency::TextureResidency() :
+        resident_bytes_(0), budget_(0), evicted_count_(0) {
+}
+
+void TextureResidency::setBytes(Texture* texture, size_t old_bytes, size_t new_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if ((0 == old_bytes) && (0 != new_bytes)) {
+        textures_.push_back(texture);
+    } else if ((0 != old_bytes) && (0 == new_bytes)) {
+        textures_.erase(std::remove(textures_.begin(), textures_.end(), texture),
+                textures_.end());
+    }
+    resident_bytes_ += new_bytes;
+    resident_bytes_ -= old_bytes;
+}
+
+void TextureResidency::update() {
+    std::vector<Texture*> candidates;
+
+    ++frame_;
+    evicted_count_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if ((0 == budget_) || (resident_bytes_ <= budget_)) {
+            return;
+        }
+        for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+            if (frame_ - (*it)->last_used_frame() > RECENT_FRAMES) {
+                candidates.push_back(*it);
+            }
+        }
+    }
+
+    // oldest first, evicting changes the tracked bytes through setBytes
+    // so the lock is not held here
+    std::sort(candidates.begin(), candidates.end(),
+            [](const Texture* a, const Texture* b) {
+                return a->last_used_frame() < b->last_used_frame();
+            });
+    for (auto it = candidates.begin();
+            (it != candidates.end()) && (resident_bytes_ > budget_); ++it) {
+        if ((*it)->evict()) {
+            ++evicted_count_;
+        }
+    }
+}
+
+}
@@ -0,0 +1,104 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Keeps the GPU memory held by textures within a budget.
+ ***************************************************************************/
+
+#ifndef TEXTURE_RESIDENCY_H_
+#define TEXTURE_RESIDENCY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace gvr {
+class Texture;
+
+/*
+ * Tracks the GPU memory of every texture which reports it and the
+ * frame each texture was last bound in. Once per frame, if the total
+ * is over the budget, the least recently used textures which have not
+ * been bound for RECENT_FRAMES are asked to evict themselves until
+ * the total fits again. Textures which can reload their pixels, like
+ * KtxTexture, drop to a low resolution mip and load the finer levels
+ * again when they are drawn large; the others keep their memory.
+ *
+ * A budget of 0, the default, never evicts anything.
+ */
+class TextureResidency {
+public:
+    static TextureResidency& getInstance() {
+        static TextureResidency instance;
+        return instance;
+    }
+
+    // frame counter stamped on textures when they are bound
+    static unsigned int frame() {
+        return frame_;
+    }
+
+    /*
+     * Change the memory tracked for a texture, 0 stops tracking it.
+     * May be called on any thread.
+     */
+    void setBytes(Texture* texture, size_t old_bytes, size_t new_bytes);
+
+    /*
+     * Start the next frame and evict textures if over the budget.
+     * Called by the renderer on the GL thread.
+     */
+    void update();
+
+    void set_budget(size_t bytes) {
+        budget_ = bytes;
+    }
+
+    size_t budget() const {
+        return budget_;
+    }
+
+    size_t resident_bytes() const {
+        return resident_bytes_;
+    }
+
+    // textures evicted by the last update()
+    int evicted_count() const {
+        return evicted_count_;
+    }
+
+private:
+    TextureResidency();
+    TextureResidency(const TextureResidency& texture_residency);
+    TextureResidency(TextureResidency&& texture_residency);
+    TextureResidency& operator=(const TextureResidency& texture_residency);
+    TextureResidency& operator=(TextureResidency&& texture_residency);
+
+    // textures bound this recently are never evicted
+    static const unsigned int RECENT_FRAMES = 30;
+
+    static unsigned int frame_;
+
+    std::mutex mutex_;
+    std::vector<Texture*> textures_;
+    // atomic since update() evicts without holding mutex_
+    std::atomic<size_t> resident_bytes_;
+    std::atomic<size_t> budget_;
+    int evicted_count_;
+};
+
+}
+#endif
@@ -0,0 +1,186 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uploads texture images spread over several frames.
+ ***************************************************************************/
+
+#include "texture_uploader.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "objects/textures/texture.h"
+#include "util/gvr_log.h"
+
+namespace gvr {
+
+TextureUploader::TextureUploader() :
+        staging_index_(0), frame_budget_(DEFAULT_FRAME_BUDGET),
+        upload_milliseconds_(0.0f), upload_bytes_(0) {
+    for (int i = 0; i < STAGING_BUFFER_COUNT; ++i) {
+        staging_buffers_[i] = 0;
+    }
+}
+
+void TextureUploader::queue(Texture* texture, const Image& image,
+        std::vector<char>&& pixels) {
+    const int size = pixels.size();
+    Upload upload = { texture, image, true, nullptr, size, std::move(pixels) };
+    add(std::move(upload));
+}
+
+void TextureUploader::queue(Texture* texture, const Image& image,
+        const void* pixels, int size, bool hold_ready) {
+    Upload upload = { texture, image, hold_ready,
+            static_cast<const char*>(pixels), size, std::vector<char>() };
+    add(std::move(upload));
+}
+
+void TextureUploader::add(Upload&& upload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (upload.hold_ready) {
+        upload.texture->addPendingUpload();
+    }
+    pending_.push_back(std::move(upload));
+}
+
+void TextureUploader::cancel(Texture* texture) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                [texture](const Upload& upload) {
+                    if ((upload.texture == texture) && upload.hold_ready) {
+                        texture->removePendingUpload();
+                    }
+                    return upload.texture == texture;
+                }), pending_.end());
+    }
+    for (auto batch = in_flight_.begin(); batch != in_flight_.end(); ++batch) {
+        for (auto it = batch->images.begin(); it != batch->images.end(); ++it) {
+            if (it->texture != texture) {
+                continue;
+            }
+            if (it->hold_ready) {
+                texture->removePendingUpload();
+            }
+            it->texture = nullptr;
+        }
+    }
+}
+
+void TextureUploader::update() {
+    auto start = std::chrono::steady_clock::now();
+    Batch batch;
+    int bytes = 0;
+
+    retireBatches();
+    for (;;) {
+        Upload next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty()
+                    || ((bytes > 0) && (bytes + pending_.front().size > frame_budget_))) {
+                break;
+            }
+            next = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        upload(next);
+        bytes += next.size;
+
+        Uploaded uploaded = { next.texture, next.image.level, next.hold_ready };
+        batch.images.push_back(uploaded);
+    }
+
+    if (!batch.images.empty()) {
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        in_flight_.push_back(std::move(batch));
+    }
+    upload_bytes_ = bytes;
+    upload_milliseconds_ = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * Stage the pixels in the next buffer of the ring and specify the
+ * image from it. Respecifying the whole buffer lets the driver orphan
+ * a copy which may still be read by an earlier upload.
+ */
+void TextureUploader::upload(const Upload& upload) {
+    if (0 == staging_buffers_[0]) {
+        glGenBuffers(STAGING_BUFFER_COUNT, staging_buffers_);
+    }
+    GLuint staging_buffer = staging_buffers_[staging_index_];
+    staging_index_ = (staging_index_ + 1) % STAGING_BUFFER_COUNT;
+
+    const Image& image = upload.image;
+    const char* pixels = upload.pixels ? upload.pixels : upload.owned_pixels.data();
+
+    glBindTexture(image.target, upload.texture->getId());
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, upload.size, pixels, GL_STREAM_DRAW);
+    if (image.immutable_storage && (0 == image.type)) {
+        glCompressedTexSubImage2D(image.target, image.level, 0, 0, image.width,
+                image.height, image.internal_format, upload.size, nullptr);
+    } else if (image.immutable_storage) {
+        glTexSubImage2D(image.target, image.level, 0, 0, image.width, image.height,
+                image.format, image.type, nullptr);
+    } else if (0 == image.type) {
+        glCompressedTexImage2D(image.target, image.level, image.internal_format,
+                image.width, image.height, 0, upload.size, nullptr);
+    } else {
+        glTexImage2D(image.target, image.level, image.internal_format,
+                image.width, image.height, 0, image.format, image.type, nullptr);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(image.target, 0);
+
+    GLenum error = glGetError();
+    if (GL_NO_ERROR != error) {
+        LOGE("TextureUploader: upload of %dx%d level %d failed with 0x%x",
+                image.width, image.height, image.level, error);
+    }
+}
+
+/*
+ * Batches complete in order, stop at the first fence not yet signaled.
+ */
+void TextureUploader::retireBatches() {
+    int retired = 0;
+
+    for (; retired < in_flight_.size(); ++retired) {
+        Batch& batch = in_flight_[retired];
+        GLenum status = glClientWaitSync(batch.fence, 0, 0);
+
+        if (GL_TIMEOUT_EXPIRED == status) {
+            break;
+        }
+        glDeleteSync(batch.fence);
+        for (auto it = batch.images.begin(); it != batch.images.end(); ++it) {
+            if (nullptr == it->texture) {
+                continue;
+            }
+            if (it->hold_ready) {
+                it->texture->removePendingUpload();
+            }
+            it->texture->levelUploaded(it->level);
+        }
+    }
+    in_flight_.erase(in_flight_.begin(), in_flight_.begin() + retired);
+}
+
+}
@@ -0,0 +1,154 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Uploads texture images spread over several frames.
+ ***************************************************************************/
+
+#ifndef TEXTURE_UPLOADER_H_
+#define TEXTURE_UPLOADER_H_
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "gl/gl_headers.h"
+
+namespace gvr {
+class Texture;
+
+/*
+ * Queue of texture images waiting to be uploaded on the GL thread.
+ *
+ * Images are queued from any thread with their pixels already copied
+ * into native memory, so the GL thread never touches Java arrays.
+ * Once per frame update() uploads images until the frame budget is
+ * used up, at least one per frame. Each image is staged through a
+ * ring of pixel unpack buffers so the driver can copy it to the GPU
+ * without stalling the frame. Once the fence issued after an upload
+ * has signaled the texture is told with Texture::levelUploaded().
+ */
+class TextureUploader {
+public:
+    /*
+     * Where an image goes. Compressed images have type 0. Images of
+     * textures with immutable storage replace a level of it.
+     */
+    struct Image {
+        GLenum target;
+        int level;
+        GLenum internal_format;
+        GLsizei width;
+        GLsizei height;
+        GLenum format;
+        GLenum type;
+        bool immutable_storage;
+    };
+
+    static TextureUploader& getInstance() {
+        static TextureUploader instance;
+        return instance;
+    }
+
+    /*
+     * Queue an image with pixels the uploader takes over. The texture
+     * is not ready until the image has reached the GPU.
+     * May be called on any thread.
+     */
+    void queue(Texture* texture, const Image& image, std::vector<char>&& pixels);
+
+    /*
+     * Queue an image whose pixels the caller keeps alive until they
+     * are uploaded or the texture is cancelled, like a mapped file.
+     * If hold_ready is false the texture stays ready meanwhile.
+     */
+    void queue(Texture* texture, const Image& image, const void* pixels, int size,
+            bool hold_ready);
+
+    /*
+     * Drop everything queued for a texture which is being deleted or
+     * reallocated, the texture no longer waits for it to be ready.
+     * Must be called on the GL thread.
+     */
+    void cancel(Texture* texture);
+
+    /*
+     * Retire the uploads whose fence signaled and upload the next
+     * images within the budget. Called by the renderer once per frame.
+     */
+    void update();
+
+    void set_frame_budget(int bytes) {
+        frame_budget_ = bytes;
+    }
+
+    // time spent in the last update() and the bytes it uploaded
+    float upload_milliseconds() const {
+        return upload_milliseconds_;
+    }
+
+    int upload_bytes() const {
+        return upload_bytes_;
+    }
+
+private:
+    TextureUploader();
+    TextureUploader(const TextureUploader& texture_uploader);
+    TextureUploader(TextureUploader&& texture_uploader);
+    TextureUploader& operator=(const TextureUploader& texture_uploader);
+    TextureUploader& operator=(TextureUploader&& texture_uploader);
+
+    static const int STAGING_BUFFER_COUNT = 3;
+    static const int DEFAULT_FRAME_BUDGET = 4 * 1024 * 1024;
+
+    struct Upload {
+        Texture* texture;
+        Image image;
+        bool hold_ready;
+        const char* pixels;     // owned_pixels if null
+        int size;
+        std::vector<char> owned_pixels;
+    };
+
+    struct Uploaded {
+        Texture* texture;       // null once cancelled
+        int level;
+        bool hold_ready;
+    };
+
+    // images uploaded in the same frame, done once the fence signals
+    struct Batch {
+        GLsync fence;
+        std::vector<Uploaded> images;
+    };
+
+    void add(Upload&& upload);
+    void upload(const Upload& upload);
+    void retireBatches();
+
+    std::mutex mutex_;
+    std::deque<Upload> pending_;
+
+    // only used on the GL thread
+    std::vector<Batch> in_flight_;
+    GLuint staging_buffers_[STAGING_BUFFER_COUNT];
+    int staging_index_;
+    int frame_budget_;
+    float upload_milliseconds_;
+    int upload_bytes_;
+};
+
+}
+#endif
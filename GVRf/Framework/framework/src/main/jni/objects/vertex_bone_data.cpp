@@ -3,28 +3,62 @@
  ***************************************************************************/
 
 #include <math.h>
+#include <algorithm>
+#include <limits>
 #include "scene.h"
+#include "engine/renderer/job_queue.h"
+#include "objects/mesh.h"
+#include "objects/mesh_bvh.h"
 #include "objects/vertex_bone_data.h"
 #include "objects/components/bone.h"
+#include "gl/gl_uniform_block.h"
 #include "util/gvr_log.h"
+#include "util/gvr_simd.h"
 
 #define TOL 1e-6
 
 namespace gvr {
 
+std::mutex VertexBoneData::skinnedMutex;
+std::vector<VertexBoneData*> VertexBoneData::skinnedBoneData;
+
+std::shared_ptr<MeshBVH> SkinnedPose::getBVH(const Mesh& mesh) const {
+    std::lock_guard<std::mutex> lock(bvh_mutex_);
+
+    if (nullptr == bvh_) {
+        if (!mesh.int_indices().empty()) {
+            bvh_ = std::make_shared<MeshBVH>(vertices_, mesh.int_indices());
+        } else {
+            bvh_ = std::make_shared<MeshBVH>(vertices_, mesh.indices());
+        }
+    }
+    return bvh_;
+}
+
 VertexBoneData::VertexBoneData(Mesh *mesh)
 : mesh(mesh)
+, palette(nullptr)
+, paletteDirty(true)
+, cpuSkinningEnabled(false)
+, poseDirty(true)
 , bones()
 , boneMatrices()
 , boneData()
 {
 }
 
+VertexBoneData::~VertexBoneData() {
+    setCpuSkinning(false);
+    delete palette;
+}
+
 void VertexBoneData::setBones(std::vector<Bone*>&& bonesVec) {
     bones = std::move(bonesVec);
 
     boneMatrices.clear();
     boneMatrices.resize(bones.size());
+    paletteDirty = true;
+    poseDirty = true;
 
     if (bones.empty())
         return;
@@ -33,10 +67,183 @@ void VertexBoneData::setBones(std::vector<Bone*>&& bonesVec) {
     boneData.clear();
     boneData.resize(vertexNum);
 
-    auto itMat = boneMatrices.begin();
-    for (auto it = bones.begin(); it != bones.end(); ++it, ++itMat) {
-        (*it)->setFinalTransformMatrixPtr(&*itMat);
+    int boneId = 0;
+    for (auto it = bones.begin(); it != bones.end(); ++it, ++boneId) {
+        (*it)->setBoneData(this, boneId);
+    }
+}
+
+void VertexBoneData::bindBonePalette() {
+    static const int ROW_SIZE = 4 * sizeof(float);
+    int numBones = std::min((int) boneMatrices.size(), MAX_BONES);
+
+    if (nullptr == palette) {
+        palette = new GLUniformBlock(3 * ROW_SIZE * MAX_BONES);
+    }
+    if (paletteDirty) {
+        for (int i = 0; i < numBones; ++i) {
+            const glm::mat4& m = boneMatrices[i];
+            // bone matrices are affine, the last row is not needed
+            for (int row = 0; row < 3; ++row) {
+                glm::vec4 r(m[0][row], m[1][row], m[2][row], m[3][row]);
+                palette->set((3 * i + row) * ROW_SIZE, &r, ROW_SIZE);
+            }
+        }
+        paletteDirty = false;
+    }
+    palette->bind(BONE_BLOCK_BINDING, 3 * ROW_SIZE * numBones);
+}
+
+void VertexBoneData::setCpuSkinning(bool enable) {
+    std::lock_guard<std::mutex> lock(skinnedMutex);
+
+    if (enable == cpuSkinningEnabled) {
+        return;
+    }
+    cpuSkinningEnabled = enable;
+    if (enable) {
+        skinnedBoneData.push_back(this);
+        poseDirty = true;
+    } else {
+        skinnedBoneData.erase(std::remove(skinnedBoneData.begin(),
+                skinnedBoneData.end(), this), skinnedBoneData.end());
+        std::atomic_store(&pose, std::shared_ptr<const SkinnedPose>());
+        sparePose.reset();
+    }
+}
+
+std::shared_ptr<const SkinnedPose> VertexBoneData::getSkinnedPose() const {
+    return std::atomic_load(&pose);
+}
+
+void VertexBoneData::skinAll(JobQueue& jobQueue) {
+    struct PendingPose {
+        VertexBoneData* boneData;
+        std::shared_ptr<SkinnedPose> pose;
+        int firstJob;
+        int jobCount;
+    };
+    std::lock_guard<std::mutex> lock(skinnedMutex);
+    std::vector<PendingPose> pending;
+    int jobCount = 0;
+
+    for (auto it = skinnedBoneData.begin(); it != skinnedBoneData.end(); ++it) {
+        VertexBoneData* boneData = *it;
+        const Mesh& mesh = *boneData->mesh;
+        int count = std::min(mesh.vertices().size(), boneData->boneData.size());
+
+        if (!boneData->poseDirty || boneData->bones.empty() || (0 == count)) {
+            continue;
+        }
+        // recycle the older pose if no reader holds on to it
+        std::shared_ptr<SkinnedPose> next;
+        next.swap(boneData->sparePose);
+        if ((nullptr == next) || !next.unique()) {
+            next = std::make_shared<SkinnedPose>();
+        }
+        next->bvh_.reset();
+        next->vertices_.resize(count);
+        next->normals_.resize((mesh.normals().size() == mesh.vertices().size()) ? count : 0);
+
+        PendingPose entry = { boneData, next, jobCount,
+                (count + SKIN_JOB_SIZE - 1) / SKIN_JOB_SIZE };
+        pending.push_back(entry);
+        jobCount += entry.jobCount;
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // every job reports the bounds of its vertices, two corners each
+    std::vector<glm::vec3> corners(2 * jobCount);
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        VertexBoneData* boneData = it->boneData;
+        SkinnedPose* pose = it->pose.get();
+        int count = pose->vertices_.size();
+
+        for (int i = 0; i < it->jobCount; ++i) {
+            int first = i * SKIN_JOB_SIZE;
+            int end = std::min(count, first + SKIN_JOB_SIZE);
+            glm::vec3* jobCorners = &corners[2 * (it->firstJob + i)];
+
+            jobQueue.add([boneData, pose, first, end, jobCorners]() {
+                boneData->skinRange(*pose, first, end, jobCorners[0], jobCorners[1]);
+            });
+        }
+    }
+    jobQueue.wait();
+
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        SkinnedPose& pose = *it->pose;
+
+        pose.min_corner_ = corners[2 * it->firstJob];
+        pose.max_corner_ = corners[2 * it->firstJob + 1];
+        for (int i = 1; i < it->jobCount; ++i) {
+            pose.min_corner_ = glm::min(pose.min_corner_, corners[2 * (it->firstJob + i)]);
+            pose.max_corner_ = glm::max(pose.max_corner_, corners[2 * (it->firstJob + i) + 1]);
+        }
+
+        VertexBoneData* boneData = it->boneData;
+        std::shared_ptr<const SkinnedPose> previous = boneData->pose;
+        std::atomic_store(&boneData->pose, std::shared_ptr<const SkinnedPose>(it->pose));
+        boneData->sparePose = std::const_pointer_cast<SkinnedPose>(previous);
+        boneData->poseDirty = false;
+    }
+}
+
+/*
+ * Blend the bone matrices of each vertex four floats at a time, one
+ * column per vector, and transform the vertex and normal with the
+ * result. This is the same weighted sum the skinning shaders compute.
+ */
+void VertexBoneData::skinRange(SkinnedPose& pose, int first, int end,
+        glm::vec3& minCorner, glm::vec3& maxCorner) const {
+    using namespace simd;
+
+    const std::vector<glm::vec3>& vertices = mesh->vertices();
+    const std::vector<glm::vec3>& normals = mesh->normals();
+    const bool skinNormals = !pose.normals_.empty();
+    const float* matrices = &boneMatrices[0][0][0];
+    const uint32_t numBones = boneMatrices.size();
+    Lanes lo = splat(std::numeric_limits<float>::max());
+    Lanes hi = splat(-std::numeric_limits<float>::max());
+    float out[4];
+
+    for (int i = first; i < end; ++i) {
+        const BoneData& weights = boneData[i];
+        Lanes c0 = splat(0.0f), c1 = c0, c2 = c0, c3 = c0;
+
+        for (int j = 0; j < BONES_PER_VERTEX; ++j) {
+            if ((0.0f == weights.weights[j]) || (weights.ids[j] >= numBones)) {
+                continue;
+            }
+            const float* m = matrices + 16 * weights.ids[j];
+            const Lanes w = splat(weights.weights[j]);
+            c0 = madd(load(m), w, c0);
+            c1 = madd(load(m + 4), w, c1);
+            c2 = madd(load(m + 8), w, c2);
+            c3 = madd(load(m + 12), w, c3);
+        }
+
+        const glm::vec3& v = vertices[i];
+        const Lanes p = madd(c0, splat(v.x), madd(c1, splat(v.y), madd(c2, splat(v.z), c3)));
+        lo = min(lo, p);
+        hi = max(hi, p);
+        store(out, p);
+        pose.vertices_[i] = glm::vec3(out[0], out[1], out[2]);
+
+        if (skinNormals) {
+            const glm::vec3& n = normals[i];
+            store(out, madd(c0, splat(n.x), madd(c1, splat(n.y), mul(c2, splat(n.z)))));
+            glm::vec3 normal(out[0], out[1], out[2]);
+            float length = glm::length(normal);
+            pose.normals_[i] = (length > 0.0f) ? normal / length : normal;
+        }
     }
+    store(out, lo);
+    minCorner = glm::vec3(out[0], out[1], out[2]);
+    store(out, hi);
+    maxCorner = glm::vec3(out[0], out[1], out[2]);
 }
 
 int VertexBoneData::getFreeBoneSlot(int vertexId) {
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <stdint.h>
 #include <string>
@@ -31,29 +32,120 @@
 #include "glm/geometric.hpp"
 #include "util/gvr_log.h"
 
-#define MAX_BONES 60
+/*
+ * Bones in the palette block, three vec4 rows each.
+ * 256 bones fill 12KB of the 16KB every GLES 3 block may hold.
+ */
+#define MAX_BONES 256
 #define BONES_PER_VERTEX 4
 
 namespace gvr {
 class Bone;
+class GLUniformBlock;
+class JobQueue;
 class Mesh;
+class MeshBVH;
+
+/*
+ * Vertices and normals of a mesh skinned on the CPU for one pose of
+ * its bones. A pose is immutable once published, readers on any
+ * thread may keep it as long as they like.
+ */
+class SkinnedPose {
+public:
+    SkinnedPose() { }
+
+    const std::vector<glm::vec3>& vertices() const {
+        return vertices_;
+    }
+
+    const std::vector<glm::vec3>& normals() const {
+        return normals_;
+    }
+
+    const glm::vec3& min_corner() const {
+        return min_corner_;
+    }
+
+    const glm::vec3& max_corner() const {
+        return max_corner_;
+    }
+
+    /*
+     * Hierarchy over the skinned triangles, built on first use from
+     * the indices of the mesh the pose belongs to.
+     */
+    std::shared_ptr<MeshBVH> getBVH(const Mesh& mesh) const;
+
+private:
+    SkinnedPose(const SkinnedPose& skinned_pose);
+    SkinnedPose(SkinnedPose&& skinned_pose);
+    SkinnedPose& operator=(const SkinnedPose& skinned_pose);
+    SkinnedPose& operator=(SkinnedPose&& skinned_pose);
+
+    friend class VertexBoneData;
+
+    std::vector<glm::vec3> vertices_;
+    std::vector<glm::vec3> normals_;
+    glm::vec3 min_corner_;
+    glm::vec3 max_corner_;
+    mutable std::mutex bvh_mutex_;
+    mutable std::shared_ptr<MeshBVH> bvh_;
+};
+
 class VertexBoneData {
 public:
     VertexBoneData(Mesh *mesh);
+    ~VertexBoneData();
     void setBones(std::vector<Bone*>&& bonesVec);
 
     int getNumBones() const {
         return bones.size();
     }
 
-    glm::mat4 getFinalBoneTransform(int boneId) {
+    const glm::mat4& getFinalBoneTransform(int boneId) const {
         return boneMatrices[boneId];
     }
 
-    void setFinalBoneTransform(int boneId, glm::mat4 &transform) {
+    void setFinalBoneTransform(int boneId, const glm::mat4 &transform) {
         boneMatrices[boneId] = transform;
+        paletteDirty = true;
+        poseDirty = true;
+    }
+
+    /*
+     * Bind the bone palette, the first three rows of every bone matrix,
+     * to BONE_BLOCK_BINDING for shaders declaring the Bones block.
+     * It is only uploaded again after a bone moved, so every mesh
+     * drawn with the same bone data in a frame shares one upload.
+     * Must be called on the GL thread.
+     */
+    void bindBonePalette();
+
+    /*
+     * Also skin the mesh on the CPU every frame the bones moved, so
+     * that picking and the physics shapes built from the mesh see the
+     * animated pose. The shaders keep skinning on the GPU.
+     */
+    void setCpuSkinning(bool enable);
+
+    bool cpuSkinning() const {
+        return cpuSkinningEnabled;
     }
 
+    /*
+     * The latest pose skinned on the CPU, null if CPU skinning is off
+     * or nothing has been skinned yet. May be called on any thread.
+     */
+    std::shared_ptr<const SkinnedPose> getSkinnedPose() const;
+
+    /*
+     * Skin every mesh with CPU skinning whose bones moved since the
+     * last frame, split into jobs on the queue. Called by the renderer
+     * on the GL thread before the scene bounds are updated.
+     */
+    static void skinAll(JobQueue& jobQueue);
+
     int getFreeBoneSlot(int vertexId);
     void setVertexBoneWeight(int vertexId, int boneSlot, int boneId, float boneWeight);
     void normalizeWeights();
@@ -74,7 +166,7 @@ public:
         }
 
         int getFreeBoneSlot() {
-            for (int i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+            for (int i = 0; i < BONES_PER_VERTEX; i++) {
                 if (weights[i] == 0.0) {
                     return i;
                 }
@@ -88,7 +180,32 @@ public:
     std::vector<BoneData>   boneData;
 
 private:
+    VertexBoneData(const VertexBoneData& vertex_bone_data);
+    VertexBoneData(VertexBoneData&& vertex_bone_data);
+    VertexBoneData& operator=(const VertexBoneData& vertex_bone_data);
+    VertexBoneData& operator=(VertexBoneData&& vertex_bone_data);
+
+    // vertices skinned by one job
+    static const int SKIN_JOB_SIZE = 1024;
+
+    void skinRange(SkinnedPose& pose, int first, int end, glm::vec3& minCorner,
+            glm::vec3& maxCorner) const;
+
     Mesh *mesh;
+    GLUniformBlock* palette;
+    bool paletteDirty;
+
+    /*
+     * Poses are double buffered: the next pose is skinned into the one
+     * published before the current one, unless a reader still holds it.
+     */
+    bool cpuSkinningEnabled;
+    bool poseDirty;
+    std::shared_ptr<const SkinnedPose> pose;
+    std::shared_ptr<SkinnedPose> sparePose;
+
+    static std::mutex skinnedMutex;
+    static std::vector<VertexBoneData*> skinnedBoneData;
 
     // Static bone data loaded from model
     std::vector<Bone*> bones;
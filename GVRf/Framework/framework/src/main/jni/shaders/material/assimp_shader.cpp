@@ -56,7 +56,9 @@ static const char VERTEX_SHADER[] =
                 "in ivec4 a_bone_indices;\n"
                 "in vec4 a_bone_weights;\n"
                 "const int MAX_BONES = " STR(MAX_BONES) ";\n"
-                "uniform mat4 u_bone_matrix[MAX_BONES];\n"
+                "layout (std140) uniform Bones {\n"
+                "  vec4 u_bone_rows[3 * MAX_BONES];\n"
+                "};\n"
                 "#endif\n"
                 "\n"
 
@@ -67,12 +69,17 @@ static const char VERTEX_SHADER[] =
 
                 "#ifdef AS_SKINNING\n"
                 "  vec4 weights = a_bone_weights; \n"
-                "  ivec4 bone_idx = a_bone_indices; \n"
-                "  mat4 bone = u_bone_matrix[bone_idx[0]] * weights[0]; \n"
-                "  bone += u_bone_matrix[bone_idx[1]] * weights[1]; \n"
-                "  bone += u_bone_matrix[bone_idx[2]] * weights[2]; \n"
-                "  bone += u_bone_matrix[bone_idx[3]] * weights[3]; \n"
-                "  vec4 animated_pos = bone * vec4(a_position, 1); \n"
+                "  ivec4 bone_idx = 3 * a_bone_indices; \n"
+                "  vec4 row0 = u_bone_rows[bone_idx[0]] * weights[0]; \n"
+                "  vec4 row1 = u_bone_rows[bone_idx[0] + 1] * weights[0]; \n"
+                "  vec4 row2 = u_bone_rows[bone_idx[0] + 2] * weights[0]; \n"
+                "  for (int i = 1; i < 4; ++i) { \n"
+                "    row0 += u_bone_rows[bone_idx[i]] * weights[i]; \n"
+                "    row1 += u_bone_rows[bone_idx[i] + 1] * weights[i]; \n"
+                "    row2 += u_bone_rows[bone_idx[i] + 2] * weights[i]; \n"
+                "  } \n"
+                "  vec4 position = vec4(a_position, 1); \n"
+                "  vec4 animated_pos = vec4(dot(row0, position), dot(row1, position), dot(row2, position), 1); \n"
                 "  gl_Position = u_mvp * animated_pos;\n"
                 "#else\n"
                 "  gl_Position = u_mvp * vec4(a_position, 1);\n"
@@ -220,7 +227,7 @@ void AssimpShader::render(RenderState* rstate,
     glm::vec3 color = material->getVec3("color");
     float opacity = material->getFloat("opacity");
 
-    glUseProgram(program_->id());
+    program_->use();
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
 
     if (ISSET(feature_set, AS_DIFFUSE_TEXTURE)) {
@@ -240,20 +247,10 @@ void AssimpShader::render(RenderState* rstate,
     if (ISSET(feature_set, AS_SKINNING)) {
         a_bone_indices_ = glGetAttribLocation(program_->id(), "a_bone_indices");
         a_bone_weights_ = glGetAttribLocation(program_->id(), "a_bone_weights");
-        u_bone_matrices_ = glGetUniformLocation(program_->id(), "u_bone_matrix[0]");
-        if (u_bone_matrices_ == -1) {
-            LOGD("Warning! Unable to get the location of uniform u_bone_matrix[0]\n");
-        }
         Mesh* mesh = render_data->mesh();
         mesh->setBoneLoc(a_bone_indices_, a_bone_weights_);
         mesh->generateBoneArrayBuffers(program_->id());
-
-        glm::mat4 finalTransform;
-        int nBones = MIN(mesh->getVertexBoneData().getNumBones(), MAX_BONES);
-        for (int i = 0; i < nBones; ++i) {
-            finalTransform = mesh->getVertexBoneData().getFinalBoneTransform(i);
-            glUniformMatrix4fv(u_bone_matrices_ + i, 1, GL_FALSE, glm::value_ptr(finalTransform));
-        }
+        mesh->getVertexBoneData().bindBonePalette();
     }
 
     glUniform3f(u_color_, color.r, color.g, color.b);
@@ -73,7 +73,6 @@ private:
     // Bones
     GLuint a_bone_indices_;
     GLuint a_bone_weights_;
-    GLuint u_bone_matrices_;
 };
 
 }
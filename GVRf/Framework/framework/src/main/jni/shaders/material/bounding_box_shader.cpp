@@ -50,10 +50,18 @@ BoundingBoxShader::~BoundingBoxShader() {
 
 void BoundingBoxShader::render(const glm::mat4& mvp_matrix,
         RenderData* render_data, Material* material) {
-    glUseProgram(program_->id());
-    glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(mvp_matrix));
+    render(mvp_matrix);
     checkGLError("BoundingBoxShader::render");
 }
 
+void BoundingBoxShader::render(const glm::mat4& mvp_matrix) {
+    program_->use();
+    glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(mvp_matrix));
+}
+
+GLuint BoundingBoxShader::getProgramId() {
+    return program_->id();
+}
+
 }
 ;
@@ -40,6 +40,13 @@ public:
 
     void render(const glm::mat4& mvp_matrix, RenderData* render_data, Material* material);
 
+    /*
+     * Use the program with the given matrix, the caller binds the
+     * geometry and issues the draw.
+     */
+    void render(const glm::mat4& mvp_matrix);
+    GLuint getProgramId();
+
 private:
     BoundingBoxShader(const BoundingBoxShader& bounding_box_shader);
     BoundingBoxShader(BoundingBoxShader&& bounding_box_shader);
@@ -119,7 +119,7 @@ void CubemapReflectionShader::render(RenderState* rstate, RenderData* render_dat
         throw error;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
     glUniformMatrix4fv(u_mv_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mv));
     glUniformMatrix4fv(u_mv_it_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mv_it));
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
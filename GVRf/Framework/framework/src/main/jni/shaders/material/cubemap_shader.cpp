@@ -105,7 +105,7 @@ void CubemapShader::render(RenderState* rstate, RenderData* render_data, Materia
         std::string error = "CubemapShader::render : texture with wrong target";
         throw error;
     }
-    glUseProgram(program_->id());
+    program_->use();
     glUniformMatrix4fv(u_model_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_model));
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glActiveTexture (GL_TEXTURE0);
@@ -18,15 +18,43 @@
  ***************************************************************************/
 
 #include "custom_shader.h"
+#include "gl/gl_uniform_block.h"
 #include "objects/scene.h"
+#include "objects/vertex_bone_data.h"
 #include "util/gvr_log.h"
 
 #include <sys/time.h>
 #include "objects/components/shadow_map.h"
 
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
 namespace gvr {
+
+/*
+ * Define MAX_BONES right after the #version line, which has to come
+ * first, so the Bones block of the vertex templates matches the size of
+ * the palette VertexBoneData uploads.
+ */
+static std::string defineMaxBones(const std::string& vertex_shader) {
+    static const char define[] = "#define MAX_BONES " STR(MAX_BONES) "\n";
+    std::string source(vertex_shader);
+    std::string::size_type pos = 0;
+
+    if (0 == source.compare(0, 8, "#version")) {
+        pos = source.find('\n');
+        if (std::string::npos == pos) {
+            pos = source.size();
+            source += '\n';
+        }
+        ++pos;
+    }
+    return source.insert(pos, define);
+}
+
 CustomShader::CustomShader(const std::string& vertex_shader, const std::string& fragment_shader)
-    : vertexShader_(vertex_shader), fragmentShader_(fragment_shader) {
+    : vertexShader_(defineMaxBones(vertex_shader)), fragmentShader_(fragment_shader),
+      bone_matrix_count_(0), bone_block_(false) {
 }
 void CustomShader::initializeOnDemand(RenderState* rstate) {
     if (nullptr == program_)
@@ -54,48 +82,59 @@ void CustomShader::initializeOnDemand(RenderState* rstate) {
         }
         u_right_ = glGetUniformLocation(program_->id(), "u_right");
         u_model_ = glGetUniformLocation(program_->id(), "u_model");
+        u_proj_ = glGetUniformLocation(program_->id(), "u_proj");
+        a_bone_indices_ = glGetAttribLocation(program_->id(), "a_bone_indices");
+        a_bone_weights_ = glGetAttribLocation(program_->id(), "a_bone_weights");
+        u_bone_matrices_ = glGetUniformLocation(program_->id(), "u_bone_matrix[0]");
+        if (u_bone_matrices_ >= 0) {
+            const char* name = "u_bone_matrix[0]";
+            GLuint index = GL_INVALID_INDEX;
+            glGetUniformIndices(program_->id(), 1, &name, &index);
+            if (GL_INVALID_INDEX != index) {
+                glGetActiveUniformsiv(program_->id(), 1, &index, GL_UNIFORM_SIZE,
+                        &bone_matrix_count_);
+            }
+        }
+        bone_block_ = glGetUniformBlockIndex(program_->id(), BONE_BLOCK_NAME)
+                != GL_INVALID_INDEX;
+        u_shadow_maps_ = glGetUniformLocation(program_->id(), "u_shadow_maps");
         vertexShader_.clear();
         fragmentShader_.clear();
         LOGE("Custom shader added program %d", program_->id());
     }
-   if (textureVariablesDirty_) {
+    if (textureVariablesDirty_.exchange(false)) {
         std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::texture:location: variable: %s location: %d", it->variable.c_str(),
-                        it->location);
-                checkGLError("CustomShader::initialize texture");
-            }
-
-        }
-        textureVariablesDirty_ = false;
+        updateSnapshot(textureVariables_, textures_);
+        checkGLError("CustomShader::initialize texture");
     }
-
-    if (uniformVariablesDirty_) {
+    if (uniformVariablesDirty_.exchange(false)) {
         std::lock_guard<std::mutex> lock(uniformVariablesLock_);
-        for (auto it = uniformVariables_.begin(); it != uniformVariables_.end(); ++it) {
-            LOGV("CustomShader::uniform:location: variable: %s", it->variable.c_str());
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::uniform:location: location: %d", it->location);
-            }
-        }
+        updateSnapshot(uniformVariables_, uniforms_);
         checkGLError("CustomShader::initialize uniforms");
-        uniformVariablesDirty_ = false;
     }
+    if (attributeVariablesDirty_.exchange(false)) {
+        std::lock_guard<std::mutex> lock(attributeVariablesLock_);
+        updateSnapshot(attributeVariables_, attributes_);
+        checkGLError("CustomShader::initialize attributes");
+    }
+}
 
-    if (attributeVariablesDirty_) {
-        std::lock_guard <std::mutex> lock(attributeVariablesLock_);
-        for (auto it = attributeVariables_.begin(); it != attributeVariables_.end(); ++it) {
-            if (-1 == it->location) {
-                it->location = it->variableType.f_getLocation(program_->id());
-                LOGV("CustomShader::attribute:location: variable: %s location: %d", it->variable.c_str(),
-                        it->location);
-            }
+/*
+ * Look up the locations of new descriptors and copy all of them into the
+ * snapshot read by render(). Called on the GL thread with the lock of the
+ * descriptor set held, so render() itself never has to take the lock.
+ */
+template <class T> void CustomShader::updateSnapshot(
+        const std::set<Descriptor<T>, DescriptorComparator<T>>& descriptors,
+        std::vector<Descriptor<T>>& snapshot) {
+    snapshot.clear();
+    for (auto it = descriptors.begin(); it != descriptors.end(); ++it) {
+        if (-1 == it->location) {
+            it->location = it->variableType.f_getLocation(program_->id());
+            LOGV("CustomShader::location: variable: %s location: %d", it->variable.c_str(),
+                    it->location);
         }
-        checkGLError("CustomShader::initialize attributes");
-        attributeVariablesDirty_ = false;
+        snapshot.push_back(*it);
     }
 }
 
@@ -253,60 +292,55 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
 	//LOGE(" start of render %s", render_data->owner_object()->name().c_str());
 	initializeOnDemand(rstate);
     checkGLError("CustomShader::initialize");
-    {
-        std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            Texture* texture = material->getTextureNoError(it->key);
-            if ((texture == NULL) || !texture->isReady()) {
-                return;
-            }
-            checkGLError("CustomShader::render textureReady");
+    for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+        Texture* texture = material->getTextureNoError(it->key);
+        if ((texture == NULL) || !texture->isReady()) {
+            return;
         }
     }
    // LOGE("rendering %s with program %d", render_data->owner_object()->name().c_str(), program_->id());
 
     Mesh* mesh = render_data->mesh();
-    glUseProgram(program_->id());
+    program_->use();
     /*
      * Update the bone matrices
      */
-    int a_bone_indices = glGetAttribLocation(program_->id(), "a_bone_indices");
-    int a_bone_weights = glGetAttribLocation(program_->id(), "a_bone_weights");
-    int u_bone_matrices = glGetUniformLocation(program_->id(), "u_bone_matrix[0]");
-    if ((a_bone_indices >= 0) ||
-        (a_bone_weights >= 0) ||
-        (u_bone_matrices >= 0)) {
-        glm::mat4 finalTransform;
-        mesh->setBoneLoc(a_bone_indices, a_bone_weights);
+    if ((a_bone_indices_ >= 0) ||
+        (a_bone_weights_ >= 0) ||
+        (u_bone_matrices_ >= 0) || bone_block_) {
+        VertexBoneData& bone_data = mesh->getVertexBoneData();
+        mesh->setBoneLoc(a_bone_indices_, a_bone_weights_);
         mesh->generateBoneArrayBuffers(program_->id());
-        int nBones = mesh->getVertexBoneData().getNumBones();
-        if (nBones > MAX_BONES)
-            nBones = MAX_BONES;
-        for (int i = 0; i < nBones; ++i) {
-            finalTransform = mesh->getVertexBoneData().getFinalBoneTransform(i);
-            glUniformMatrix4fv(u_bone_matrices + i, 1, GL_FALSE, glm::value_ptr(finalTransform));
+        if (bone_block_) {
+            bone_data.bindBonePalette();
+        } else if (u_bone_matrices_ >= 0) {
+            // older shaders declare a mat4 array, set it in one call
+            int nBones = std::min(bone_data.getNumBones(), (int) bone_matrix_count_);
+            if (nBones > 0) {
+                glUniformMatrix4fv(u_bone_matrices_, nBones, GL_FALSE,
+                        glm::value_ptr(bone_data.boneMatrices[0]));
+            }
         }
         checkGLError("CustomShader::render bones");
     }
     /*
      * Update values of uniform variables
      */
-    {
-        std::lock_guard<std::mutex> lock(uniformVariablesLock_);
-        for (auto it = uniformVariables_.begin(); it != uniformVariables_.end(); ++it) {
-            auto d = *it;
-            try {
-                d.variableType.f_bind(*material, d.location);
-                checkGLError("CustomShader::render bindUniform");
-            } catch(const std::string& exc) {
-                //the keys defined for this shader might not have been used by the material yet
-            }
+    for (auto it = uniforms_.begin(); it != uniforms_.end(); ++it) {
+        try {
+            it->variableType.f_bind(*material, it->location);
+            checkGLError("CustomShader::render bindUniform");
+        } catch(const std::string& exc) {
+            //the keys defined for this shader might not have been used by the material yet
         }
     }
 
     if (u_model_ != -1){
     	glUniformMatrix4fv(u_model_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_model));
     }
+    if (u_proj_ != -1) {
+        glUniformMatrix4fv(u_proj_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_proj));
+    }
     if (u_mvp_ != -1) {
         if(use_multiview && !rstate->shadow_map)
             glUniformMatrix4fv(u_mvp_, 2, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp_[0]));
@@ -338,14 +372,10 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
      * Bind textures
      */
     int texture_index = 0;
-    {
-        std::lock_guard<std::mutex> lock(textureVariablesLock_);
-        for (auto it = textureVariables_.begin(); it != textureVariables_.end(); ++it) {
-            auto d = *it;
-            d.variableType.f_bind(texture_index, *material, d.location);
-            texture_index++;
-            checkGLError("CustomShader::render bindTexture");
-        }
+    for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+        it->variableType.f_bind(texture_index, *material, it->location);
+        texture_index++;
+        checkGLError("CustomShader::render bindTexture");
     }
     /*
      * Update the uniforms for the lights
@@ -369,10 +399,9 @@ void CustomShader::render(RenderState* rstate, RenderData* render_data, Material
     }
     if (shadowMap)
     {
-        int loc = glGetUniformLocation(program_->id(), "u_shadow_maps");
-        if (loc >= 0)
+        if (u_shadow_maps_ >= 0)
         {
-            shadowMap->bindTexture(loc, texture_index);
+            shadowMap->bindTexture(u_shadow_maps_, texture_index);
         }
     }
     checkGLError("CustomShader::render");
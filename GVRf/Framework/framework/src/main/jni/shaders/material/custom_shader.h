@@ -21,6 +21,7 @@
 #ifndef CUSTOM_SHADER_H_
 #define CUSTOM_SHADER_H_
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <memory>
@@ -61,6 +62,20 @@ public:
     void addUniformVec4Key(const std::string& variable_name, const std::string& key);
     void addUniformMat4Key(const std::string& variable_name, const std::string& key);
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material);
+
+    /*
+     * Shaders whose linked program uses "in mat4 a_model_instance" opt in
+     * to instancing. They are always drawn instanced, with the model matrix
+     * in a_model_instance and the view and projection in u_view and u_proj.
+     */
+    virtual bool supportsInstancing(RenderState* rstate) {
+        initializeOnDemand(rstate);
+        return program_->instanceLocation() >= 0;
+    }
+
+    virtual bool requiresInstancing(RenderState* rstate) {
+        return supportsInstancing(rstate);
+    }
     static int getGLTexture(int n);
     GLuint getProgramId();
 private:
@@ -107,6 +122,10 @@ private:
         UniformVariableBind f_bind;
     };
 
+    template <class T> void updateSnapshot(
+            const std::set<Descriptor<T>, DescriptorComparator<T>>& descriptors,
+            std::vector<Descriptor<T>>& snapshot);
+
 private:
     GLuint u_mvp_;
     GLuint u_mv_;
@@ -114,17 +133,33 @@ private:
     GLuint u_mv_it_;
     GLuint u_right_;
     GLuint u_model_;
-    bool textureVariablesDirty_ = false;
+    GLuint u_proj_;
+    GLint u_bone_matrices_;
+    // size of the u_bone_matrix array of older shaders
+    GLint bone_matrix_count_;
+    // true if the shader declares the Bones block
+    bool bone_block_;
+    GLint u_shadow_maps_;
+    GLint a_bone_indices_;
+    GLint a_bone_weights_;
+
+    // The descriptor sets are changed from the Java thread under their lock.
+    // The GL thread copies them into the snapshots below when the dirty flag
+    // is set, render() reads only the snapshots and takes no lock.
+    std::atomic<bool> textureVariablesDirty_{false};
     std::mutex textureVariablesLock_;
     std::set<Descriptor<TextureVariable>, DescriptorComparator<TextureVariable>> textureVariables_;
+    std::vector<Descriptor<TextureVariable>> textures_;
 
-    bool attributeVariablesDirty_ = false;
+    std::atomic<bool> attributeVariablesDirty_{false};
     std::mutex attributeVariablesLock_;
     std::set<Descriptor<AttributeVariable>, DescriptorComparator<AttributeVariable>> attributeVariables_;
+    std::vector<Descriptor<AttributeVariable>> attributes_;
 
-    bool uniformVariablesDirty_ = false;
+    std::atomic<bool> uniformVariablesDirty_{false};
     std::mutex uniformVariablesLock_;
     std::set<Descriptor<UniformVariable>, DescriptorComparator<UniformVariable>> uniformVariables_;
+    std::vector<Descriptor<UniformVariable>> uniforms_;
 
     std::string vertexShader_;
     std::string fragmentShader_;
@@ -52,7 +52,7 @@ void ErrorShader::render(RenderState* rstate, RenderData* render_data, Material*
     float b = 0.0f;
     float a = 1.0f;
 
-    glUseProgram(program_->id());
+    program_->use();
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glUniform4f(u_color_, r, g, b, a);
     checkGLError("ErrorShader::render");
@@ -5,6 +5,7 @@
 #include "external_renderer_shader.h"
 
 #include "glm/gtc/matrix_transform.hpp"
+#include "gl/gl_state.h"
 #include "objects/material.h"
 #include "objects/components/texture_capturer.h"
 #include "objects/textures/external_renderer_texture.h"
@@ -75,6 +76,8 @@ void ExternalRendererShader::render(RenderState* rstate, RenderData* render_data
                          glm::value_ptr(rstate->uniforms.u_mvp), 16,
                          glm::value_ptr(*mesh->getVec2Vector("a_texcoord").data()), mesh->getVec2Vector("a_texcoord").size() * 2,
                          material->getFloat("opacity"));
+        // the external renderer may change any GL state
+        GLState::getInstance().invalidate();
     } else {
         // Capture texture in RenderTexture
         capturer->beginCapture();
@@ -90,6 +93,7 @@ void ExternalRendererShader::render(RenderState* rstate, RenderData* render_data
                     glm::value_ptr(mvp), 16,
                     glm::value_ptr(*mesh->getVec2Vector("a_texcoord").data()), mesh->getVec2Vector("a_texcoord").size() * 2,
                     1.0);
+            GLState::getInstance().invalidate();
         }
 
         capturer->startReadBack();
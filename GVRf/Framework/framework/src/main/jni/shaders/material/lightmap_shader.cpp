@@ -74,7 +74,7 @@ void LightMapShader::render(RenderState* rstate,
     glm::vec2 lightmap_offset = material->getVec2("lightmap_offset");
     glm::vec2 lightmap_scale = material->getVec2("lightmap_scale");
 
-    glUseProgram(program_->id());
+    program_->use();
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
 
@@ -86,7 +86,7 @@ void OESHorizontalStereoShader::render(RenderState* rstate,
         mono_rendering  = false;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glActiveTexture (GL_TEXTURE0);
@@ -151,7 +151,7 @@ void OESShader::render(RenderState* rstate, RenderData* render_data, Material* m
         throw error;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
     if (use_multiview) {
         glUniformMatrix4fv(u_mvp_, 2, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp_[0]));
     } else {
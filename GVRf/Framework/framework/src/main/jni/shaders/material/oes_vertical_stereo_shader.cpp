@@ -81,7 +81,7 @@ void OESVerticalStereoShader::render(RenderState* rstate,
         mono_rendering = false;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glActiveTexture (GL_TEXTURE0);
     glBindTexture(texture->getTarget(), texture->getId());
@@ -39,6 +39,23 @@ public:
     ShaderBase() : program_(nullptr) {
     };
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material)=0;
+
+    /*
+     * Shaders which take the model matrix from the per instance attribute
+     * a_model_instance can draw many copies of a mesh in one draw call.
+     * Called on the GL thread, the shader may link its program to answer.
+     */
+    virtual bool supportsInstancing(RenderState* rstate) {
+        return false;
+    }
+
+    /*
+     * Shaders which have no other source for the model matrix than
+     * a_model_instance must be drawn instanced, even for a single copy.
+     */
+    virtual bool requiresInstancing(RenderState* rstate) {
+        return false;
+    }
     GLuint getProgramId()
     {
         if (program_)
@@ -51,6 +68,14 @@ public:
         }
     }
 
+    /*
+     * Location of a_model_instance in the current program, -1 if none.
+     */
+    GLint getInstanceLocation()
+    {
+        return program_ ? program_->instanceLocation() : -1;
+    }
+
 protected:
     GLProgram* program_;
 };
@@ -20,6 +20,7 @@
 #include "texture_shader.h"
 #include "objects/material.h"
 #include "objects/light.h"
+#include "objects/textures/texture_array.h"
 #include "util/gvr_log.h"
 
 #define LIGHT           1
@@ -28,6 +29,10 @@
 #define NO_MULTIVIEW    8
 #define BATCHING        16
 #define NO_BATCHING     32
+#define INSTANCING      64
+#define NO_INSTANCING   128
+#define TEXTURE_ARRAY   256
+#define NO_TEXTURE_ARRAY 512
 
 namespace gvr {
 static const char USE_MULTIVIEW[] = "#define MULTIVIEW\n";
@@ -37,6 +42,10 @@ static const char USE_LIGHT[] = "#define USE_LIGHT\n";
 static const char NOT_USE_LIGHT[] = "#undef USE_LIGHT\n";
 static const char USE_BATCHING[] = "#define USE_BATCHING\n";
 static const char NOT_USE_BATCHING[] ="#undef USE_BATCHING\n";
+static const char USE_INSTANCING[] = "#define USE_INSTANCING\n";
+static const char NOT_USE_INSTANCING[] = "#undef USE_INSTANCING\n";
+static const char USE_TEXTURE_ARRAY[] = "#define USE_TEXTURE_ARRAY\n";
+static const char NOT_USE_TEXTURE_ARRAY[] = "#undef USE_TEXTURE_ARRAY\n";
 
 static const char VERTEX_SHADER[] =
         "#ifdef MULTIVIEW\n"
@@ -44,17 +53,20 @@ static const char VERTEX_SHADER[] =
         "layout(num_views = 2) in;\n"
         "#endif\n"
 
-        "uniform mat4 u_proj;\n"
+        "layout (std140) uniform Camera {\n"
+        "    mat4 u_view;\n"
+        "    mat4 u_proj;\n"
+        "    mat4 u_view_inv;\n"
+        "    mat4 u_view_[2];\n"
+        "    mat4 u_view_inv_[2];\n"
+        "    highp int u_right;\n"
+        "};\n"
         "in vec3 a_position;\n"
         "in vec2 a_texcoord;\n"
 
-        "#ifdef MULTIVIEW\n"
-        "uniform mat4 u_view_[2];\n"
-        "#else\n"
-        "uniform mat4 u_view;\n"
-        "#endif\n"
-
-        "#ifndef USE_BATCHING\n"
+        "#ifdef USE_INSTANCING\n"
+        "in mat4 a_model_instance;\n"
+        "#elif !defined(USE_BATCHING)\n"
         "uniform mat4 u_model;\n"
         "#endif\n"
 
@@ -72,6 +84,11 @@ static const char VERTEX_SHADER[] =
         "uniform vec4 u_matrices[240];\n"
         "#endif\n"
 
+        "#ifdef USE_TEXTURE_ARRAY\n"
+        "in float a_texture_layer;\n"
+        "flat out float v_texture_layer;\n"
+        "#endif\n"
+
         "void main() {\n"
             "mat4 mv;\n"
             "mat4 mv_it;\n"
@@ -80,6 +97,8 @@ static const char VERTEX_SHADER[] =
             "#ifdef USE_BATCHING\n"
             "int index =int(a_matrix_index);\n"
             "mat4 model_matrix = mat4(u_matrices[index*4],u_matrices[index*4+1],u_matrices[index*4+2],u_matrices[index*4+3]);\n"
+            "#elif defined(USE_INSTANCING)\n"
+            "mat4 model_matrix = a_model_instance;\n"
             "#else\n"
             "mat4 model_matrix = u_model;\n"
             "#endif\n"
@@ -105,13 +124,23 @@ static const char VERTEX_SHADER[] =
                 "v_viewspace_normal = (mv_it * vec4(a_normal, 1.0)).xyz;\n"
             "#endif\n"
             "  v_tex_coord = a_texcoord.xy;\n"
+            "#ifdef USE_TEXTURE_ARRAY\n"
+            "  v_texture_layer = a_texture_layer;\n"
+            "#endif\n"
             "gl_Position = mvp * vec4(a_position,1.0);\n"
         "}\n";
 
 static const char FRAGMENT_SHADER[] =
         "precision highp float;\n"
         "out vec4 out_color;\n"
+        "#ifdef USE_TEXTURE_ARRAY\n"
+        "uniform mediump sampler2DArray u_texture;\n"
+        "flat in float v_texture_layer;\n"
+        "#define SAMPLE_TEXTURE(uv) texture(u_texture, vec3(uv, v_texture_layer))\n"
+        "#else\n"
         "uniform sampler2D u_texture;\n"
+        "#define SAMPLE_TEXTURE(uv) texture(u_texture, uv)\n"
+        "#endif\n"
         "uniform vec3 u_color;\n"
         "uniform float u_opacity;\n"
         "in vec2 v_tex_coord;\n"
@@ -141,7 +170,7 @@ static const char FRAGMENT_SHADER[] =
         "  color += materialAmbientColor * lightAmbientIntensity;\n"
         "\n"
         "  // Modulate in the texture\n"
-        "  color *= texture(u_texture, v_tex_coord);\n"
+        "  color *= SAMPLE_TEXTURE(v_tex_coord);\n"
 		"\n"
         "  // Specular Light\n"
         "  vec3 reflection = normalize(reflect(-normalize(v_viewspace_light_direction), normalize(v_viewspace_normal)));\n"
@@ -150,7 +179,7 @@ static const char FRAGMENT_SHADER[] =
         "    color += pow(specular, materialSpecularExponent) * materialSpecularColor * lightSpecularIntensity;\n"
         "  }\n"
         "#else\n"
-        "  color = texture(u_texture, v_tex_coord);\n"
+        "  color = SAMPLE_TEXTURE(v_tex_coord);\n"
 		"#endif\n"
         "\n"
         "  out_color = vec4(color.r * u_color.r * u_opacity, color.g * u_color.g * u_opacity, color.b * u_color.b * u_opacity, color.a * u_opacity);\n"
@@ -170,7 +199,6 @@ void TextureShader::initUniforms(int feature_set, GLuint program_id,uniforms& lo
     locations.u_texture = glGetUniformLocation(program_id, "u_texture");
     locations.u_color = glGetUniformLocation(program_id, "u_color");
     locations.u_opacity = glGetUniformLocation(program_id, "u_opacity");
-    locations.u_proj = glGetUniformLocation(program_id, "u_proj");
 
     if(feature_set & LIGHT){
         locations.u_light_pos = glGetUniformLocation(program_id, "u_light_pos");
@@ -189,11 +217,6 @@ void TextureShader::initUniforms(int feature_set, GLuint program_id,uniforms& lo
         locations.u_light_specular_intensity_ = glGetUniformLocation(program_id,
                 "lightSpecularIntensity");
     }
-    if(feature_set & MULTIVIEW)
-        locations.u_view = glGetUniformLocation(program_id, "u_view_[0]");
-    else
-        locations.u_view = glGetUniformLocation(program_id, "u_view");
-
     if(feature_set & BATCHING)
         locations.u_model = glGetUniformLocation(program_id, "u_matrices[0]");
     else
@@ -229,38 +252,44 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
     }
 
     bool batching_enabled = batching;
+    bool instancing_enabled = !batching && (rstate->instance_count > 0);
+    // batches of single pass render data sample the main texture from its atlas layer
+    bool texture_array_enabled = batching && (render_data->pass_count() == 1)
+            && (nullptr != material->batch_atlas());
     int feature_set =0;
     feature_set |= (use_light) ? LIGHT : NO_LIGHT;
     feature_set |= (use_multiview) ? MULTIVIEW : NO_MULTIVIEW;
     feature_set |= (batching_enabled) ? BATCHING : NO_BATCHING;
+    feature_set |= (instancing_enabled) ? INSTANCING : NO_INSTANCING;
+    feature_set |= (texture_array_enabled) ? TEXTURE_ARRAY : NO_TEXTURE_ARRAY;
 
-    bool properties [] = {use_light, use_multiview, batching_enabled};
-    const char* feature_strings[2][3]={{NOT_USE_LIGHT, NOT_USE_MULTIVIEW, NOT_USE_BATCHING},
-            {USE_LIGHT, USE_MULTIVIEW, USE_BATCHING}};
+    bool properties [] = {use_light, use_multiview, batching_enabled, instancing_enabled, texture_array_enabled};
+    const char* feature_strings[2][5]={{NOT_USE_LIGHT, NOT_USE_MULTIVIEW, NOT_USE_BATCHING, NOT_USE_INSTANCING, NOT_USE_TEXTURE_ARRAY},
+            {USE_LIGHT, USE_MULTIVIEW, USE_BATCHING, USE_INSTANCING, USE_TEXTURE_ARRAY}};
 
-    int feature_string_lengths[2][3]={{strlen(NOT_USE_LIGHT), strlen(NOT_USE_MULTIVIEW), strlen(NOT_USE_BATCHING)},
-            {strlen(USE_LIGHT),strlen(USE_MULTIVIEW), strlen(USE_BATCHING)}};
+    int feature_string_lengths[2][5]={{strlen(NOT_USE_LIGHT), strlen(NOT_USE_MULTIVIEW), strlen(NOT_USE_BATCHING), strlen(NOT_USE_INSTANCING), strlen(NOT_USE_TEXTURE_ARRAY)},
+            {strlen(USE_LIGHT),strlen(USE_MULTIVIEW), strlen(USE_BATCHING), strlen(USE_INSTANCING), strlen(USE_TEXTURE_ARRAY)}};
 
     uniforms uniform_locations;
     GLProgram* prgram = nullptr;
     if(program_object_map_.find(feature_set)==program_object_map_.end()){
 
-        const char* vertex_shader_strings[5];
-        GLint vertex_shader_string_lengths[5];
+        const char* vertex_shader_strings[7];
+        GLint vertex_shader_string_lengths[7];
         vertex_shader_strings[0]=version;
-        vertex_shader_strings[4]=VERTEX_SHADER;
+        vertex_shader_strings[6]=VERTEX_SHADER;
         vertex_shader_string_lengths[0]= (GLint) strlen(version);
-        vertex_shader_string_lengths[4]= (GLint) strlen(VERTEX_SHADER);
+        vertex_shader_string_lengths[6]= (GLint) strlen(VERTEX_SHADER);
 
-        const char* frag_shader_strings[5];
-        GLint frag_shader_string_lengths[5];
+        const char* frag_shader_strings[7];
+        GLint frag_shader_string_lengths[7];
         frag_shader_strings[0]=version;
-        frag_shader_strings[4]=FRAGMENT_SHADER;
+        frag_shader_strings[6]=FRAGMENT_SHADER;
         frag_shader_string_lengths [0] = vertex_shader_string_lengths[0];
-        frag_shader_string_lengths [4] = (GLint) strlen(FRAGMENT_SHADER);
+        frag_shader_string_lengths [6] = (GLint) strlen(FRAGMENT_SHADER);
 
         int index = 1;
-        for(int i=0;i<3; i++){
+        for(int i=0;i<5; i++){
             vertex_shader_strings[index]= feature_strings[properties[i]][i];
             vertex_shader_string_lengths [index]= feature_string_lengths[properties[i]][i];
             frag_shader_strings[index]=vertex_shader_strings[index];
@@ -269,7 +298,7 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
         }
         prgram = new GLProgram(vertex_shader_strings,
                 vertex_shader_string_lengths, frag_shader_strings,
-                frag_shader_string_lengths, 5);
+                frag_shader_string_lengths, 7);
         program_object_map_[feature_set] = prgram;
 
         if(use_multiview)
@@ -285,7 +314,10 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
     program_ = prgram;
     GLuint programId = prgram->id();
     //render_data->mesh()->generateVAO(programId);
-    GL(glUseProgram(programId));
+    prgram->use();
+    if (texture_array_enabled) {
+        texture = material->batch_atlas();
+    }
     GL(glActiveTexture (GL_TEXTURE0));
     GL(glBindTexture(texture->getTarget(), texture->getId()));
 
@@ -293,10 +325,9 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
     glUniform3f(uniform_locations.u_color, color.r, color.g, color.b);
     glUniform1f(uniform_locations.u_opacity, opacity);
 
-    if(!batching_enabled)
+    if(!batching_enabled && !instancing_enabled)
         glUniformMatrix4fv(uniform_locations.u_model, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_model));
 
-    glUniformMatrix4fv(uniform_locations.u_proj, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_proj));
     if (use_light) {
         glm::vec3 light_position = light->getVec3("world_position");
         glm::vec4 light_ambient_intensity = light->getVec4("ambient_intensity");
@@ -329,11 +360,6 @@ void TextureShader::programInit(RenderState* rstate, RenderData* render_data, Ma
 
     }
 
-    if(use_multiview)
-        glUniformMatrix4fv(uniform_locations.u_view, 2, GL_FALSE, glm::value_ptr(rstate->uniforms.u_view_[0]));
-    else
-        glUniformMatrix4fv(uniform_locations.u_view, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_view));
-
 
     if(batching){
         glUniform4fv(uniform_locations.u_model, drawcount*4, &model_matrix[0][0][0]);
@@ -32,6 +32,9 @@ public:
     virtual ~TextureShader();
 
     virtual void render(RenderState* rstate, RenderData* render_data, Material* material);
+    virtual bool supportsInstancing(RenderState* rstate) {
+        return true;
+    }
     void render_batch(const std::vector<glm::mat4>& model_matrix,
               RenderData* render_data,  RenderState& rstate, unsigned int, int);
 
@@ -49,8 +52,6 @@ private:
         GLuint u_texture;
         GLuint u_color;
         GLuint u_opacity;
-        GLuint u_view;
-        GLuint u_proj;
         GLuint u_light_pos;
         GLuint u_material_ambient_color_;
         GLuint u_material_diffuse_color_;
@@ -72,7 +72,7 @@ void UnlitFboShader::render(RenderState* rstate,
         throw error;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glActiveTexture (GL_TEXTURE0);
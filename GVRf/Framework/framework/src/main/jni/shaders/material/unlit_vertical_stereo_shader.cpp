@@ -80,7 +80,7 @@ void UnlitVerticalStereoShader::render(RenderState* rstate,
         mono_rendering = false;
     }
 
-   glUseProgram(program_->id());
+   program_->use();
 
     glUniformMatrix4fv(u_mvp_, 1, GL_FALSE, glm::value_ptr(rstate->uniforms.u_mvp));
     glActiveTexture (GL_TEXTURE0);
@@ -75,7 +75,7 @@ void ColorBlendPostEffectShader::render(
     float b = post_effect_data->getFloat("b");
     float factor = post_effect_data->getFloat("factor");
 
-    glUseProgram(program_->id());
+    program_->use();
 
     GLuint tmpID;
 
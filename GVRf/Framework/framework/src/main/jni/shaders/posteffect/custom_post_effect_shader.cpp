@@ -102,7 +102,7 @@ void CustomPostEffectShader::render(Camera* camera,
         return;
     }
 
-    glUseProgram(program_->id());
+    program_->use();
 
     if(vaoID_ == 0)
     {
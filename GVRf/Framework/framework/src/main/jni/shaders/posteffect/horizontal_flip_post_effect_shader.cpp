@@ -63,7 +63,7 @@ void HorizontalFlipPostEffectShader::render(
         PostEffectData* post_effect_data,
         std::vector<glm::vec3>& vertices, std::vector<glm::vec2>& tex_coords,
         std::vector<unsigned short>& triangles) {
-    glUseProgram(program_->id());
+    program_->use();
 
     GLuint tmpID;
 
@@ -0,0 +1,316 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Four float lanes on NEON, SSE2 or plain C++.
+ ***************************************************************************/
+
+#ifndef GVR_SIMD_H_
+#define GVR_SIMD_H_
+
+#include <cmath>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GVR_SIMD_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GVR_SIMD_SSE
+#endif
+
+namespace gvr {
+namespace simd {
+
+/*
+ * Lanes holds four floats, LaneMask the result of comparing them.
+ * bits() packs a mask into one bit per lane, lane 0 in bit 0.
+ * The scalar version has the same semantics as the vector ones,
+ * comparisons involving NaN are false.
+ */
+#if defined(GVR_SIMD_NEON)
+
+typedef float32x4_t Lanes;
+typedef uint32x4_t LaneMask;
+
+static inline Lanes splat(float f) {
+    return vdupq_n_f32(f);
+}
+static inline Lanes ramp(float f) {
+    static const float offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    return vaddq_f32(vdupq_n_f32(f), vld1q_f32(offsets));
+}
+static inline Lanes load(const float* p) {
+    return vld1q_f32(p);
+}
+static inline void store(float* p, Lanes v) {
+    vst1q_f32(p, v);
+}
+static inline Lanes add(Lanes a, Lanes b) {
+    return vaddq_f32(a, b);
+}
+static inline Lanes sub(Lanes a, Lanes b) {
+    return vsubq_f32(a, b);
+}
+static inline Lanes mul(Lanes a, Lanes b) {
+    return vmulq_f32(a, b);
+}
+static inline Lanes div(Lanes a, Lanes b) {
+    // two Newton-Raphson steps give full float precision
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+static inline Lanes madd(Lanes a, Lanes b, Lanes c) {
+    return vmlaq_f32(c, a, b);
+}
+static inline Lanes min(Lanes a, Lanes b) {
+    return vminq_f32(a, b);
+}
+static inline Lanes max(Lanes a, Lanes b) {
+    return vmaxq_f32(a, b);
+}
+static inline LaneMask greaterEqual(Lanes a, Lanes b) {
+    return vcgeq_f32(a, b);
+}
+static inline LaneMask greater(Lanes a, Lanes b) {
+    return vcgtq_f32(a, b);
+}
+static inline LaneMask both(LaneMask a, LaneMask b) {
+    return vandq_u32(a, b);
+}
+static inline Lanes select(LaneMask m, Lanes a, Lanes b) {
+    return vbslq_f32(m, a, b);
+}
+static inline bool any(LaneMask m) {
+    uint32x2_t half = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(half, 0) | vget_lane_u32(half, 1)) != 0;
+}
+static inline int bits(LaneMask m) {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    uint32x4_t w = vandq_u32(m, vld1q_u32(weights));
+    uint32x2_t half = vadd_u32(vget_low_u32(w), vget_high_u32(w));
+    return vget_lane_u32(vpadd_u32(half, half), 0);
+}
+
+#elif defined(GVR_SIMD_SSE)
+
+typedef __m128 Lanes;
+typedef __m128 LaneMask;
+
+static inline Lanes splat(float f) {
+    return _mm_set1_ps(f);
+}
+static inline Lanes ramp(float f) {
+    return _mm_add_ps(_mm_set1_ps(f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+}
+static inline Lanes load(const float* p) {
+    return _mm_loadu_ps(p);
+}
+static inline void store(float* p, Lanes v) {
+    _mm_storeu_ps(p, v);
+}
+static inline Lanes add(Lanes a, Lanes b) {
+    return _mm_add_ps(a, b);
+}
+static inline Lanes sub(Lanes a, Lanes b) {
+    return _mm_sub_ps(a, b);
+}
+static inline Lanes mul(Lanes a, Lanes b) {
+    return _mm_mul_ps(a, b);
+}
+static inline Lanes div(Lanes a, Lanes b) {
+    return _mm_div_ps(a, b);
+}
+static inline Lanes madd(Lanes a, Lanes b, Lanes c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+static inline Lanes min(Lanes a, Lanes b) {
+    return _mm_min_ps(a, b);
+}
+static inline Lanes max(Lanes a, Lanes b) {
+    return _mm_max_ps(a, b);
+}
+static inline LaneMask greaterEqual(Lanes a, Lanes b) {
+    return _mm_cmpge_ps(a, b);
+}
+static inline LaneMask greater(Lanes a, Lanes b) {
+    return _mm_cmpgt_ps(a, b);
+}
+static inline LaneMask both(LaneMask a, LaneMask b) {
+    return _mm_and_ps(a, b);
+}
+static inline Lanes select(LaneMask m, Lanes a, Lanes b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline bool any(LaneMask m) {
+    return _mm_movemask_ps(m) != 0;
+}
+static inline int bits(LaneMask m) {
+    return _mm_movemask_ps(m);
+}
+
+#else
+
+struct Lanes {
+    float v[4];
+};
+struct LaneMask {
+    bool v[4];
+};
+
+static inline Lanes splat(float f) {
+    Lanes r = { { f, f, f, f } };
+    return r;
+}
+static inline Lanes ramp(float f) {
+    Lanes r = { { f, f + 1.0f, f + 2.0f, f + 3.0f } };
+    return r;
+}
+static inline Lanes load(const float* p) {
+    Lanes r = { { p[0], p[1], p[2], p[3] } };
+    return r;
+}
+static inline void store(float* p, Lanes a) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = a.v[i];
+    }
+}
+static inline Lanes add(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] + b.v[i];
+    }
+    return r;
+}
+static inline Lanes sub(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] - b.v[i];
+    }
+    return r;
+}
+static inline Lanes mul(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] * b.v[i];
+    }
+    return r;
+}
+static inline Lanes div(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] / b.v[i];
+    }
+    return r;
+}
+static inline Lanes madd(Lanes a, Lanes b, Lanes c) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] * b.v[i] + c.v[i];
+    }
+    return r;
+}
+static inline Lanes min(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+static inline Lanes max(Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+static inline LaneMask greaterEqual(Lanes a, Lanes b) {
+    LaneMask r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] >= b.v[i];
+    }
+    return r;
+}
+static inline LaneMask greater(Lanes a, Lanes b) {
+    LaneMask r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] > b.v[i];
+    }
+    return r;
+}
+static inline LaneMask both(LaneMask a, LaneMask b) {
+    LaneMask r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = a.v[i] && b.v[i];
+    }
+    return r;
+}
+static inline Lanes select(LaneMask m, Lanes a, Lanes b) {
+    Lanes r;
+    for (int i = 0; i < 4; ++i) {
+        r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+static inline bool any(LaneMask m) {
+    return m.v[0] || m.v[1] || m.v[2] || m.v[3];
+}
+static inline int bits(LaneMask m) {
+    return (m.v[0] ? 1 : 0) | (m.v[1] ? 2 : 0) | (m.v[2] ? 4 : 0) | (m.v[3] ? 8 : 0);
+}
+
+#endif
+
+/*
+ * Distances at which rays enter and leave the slab between the planes lo
+ * and hi of one axis, inv being 1 / direction. A ray parallel to the slab
+ * gets infinite distances, or 0 * inf = NaN when its origin lies on one
+ * of the planes; that ray never leaves the slab either, so NaN is taken
+ * as an unbounded slab.
+ */
+static inline void slab(Lanes lo, Lanes hi, Lanes origin, Lanes inv,
+        Lanes& enter, Lanes& leave) {
+    const Lanes t0 = mul(sub(lo, origin), inv);
+    const Lanes t1 = mul(sub(hi, origin), inv);
+    const LaneMask ordered = both(greaterEqual(t0, t0), greaterEqual(t1, t1));
+    enter = select(ordered, min(t0, t1), splat(-INFINITY));
+    leave = select(ordered, max(t0, t1), splat(INFINITY));
+}
+
+/*
+ * r = a * b for column major 4x4 matrices, r may be a or b.
+ * Each column of r is the columns of a weighted by a column of b.
+ */
+static inline void multiplyMatrix(const float* a, const float* b, float* r) {
+    const Lanes a0 = load(a), a1 = load(a + 4), a2 = load(a + 8), a3 = load(a + 12);
+    Lanes columns[4];
+
+    for (int i = 0; i < 4; ++i) {
+        const float* column = b + 4 * i;
+        Lanes sum = mul(a0, splat(column[0]));
+        sum = madd(a1, splat(column[1]), sum);
+        sum = madd(a2, splat(column[2]), sum);
+        columns[i] = madd(a3, splat(column[3]), sum);
+    }
+    for (int i = 0; i < 4; ++i) {
+        store(r + 4 * i, columns[i]);
+    }
+}
+
+}
+}
+#endif
@@ -0,0 +1,242 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Refits and removals of the collider index, and removals racing with
+ * the picks of other threads.
+ ***************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test_scene.h"
+#include "test_util.h"
+
+#include "engine/picker/collider_index.h"
+#include "engine/picker/picker.h"
+#include "objects/bounding_volume.h"
+#include "objects/scene.h"
+#include "objects/scene_object.h"
+#include "objects/components/sphere_collider.h"
+#include "objects/components/transform.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static const ColliderIndex::Entry* find_entry(
+        const ColliderIndex::Snapshot& snapshot, Collider* collider) {
+    for (auto it = snapshot.entries.begin(); it != snapshot.entries.end(); ++it) {
+        if (it->collider == collider) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+/*
+ * The colliders the index finds along a ray, in the order of the
+ * colliders tested one by one.
+ */
+static bool same_hits(PickScene& pick_scene, const glm::vec3& start,
+        const glm::vec3& dir) {
+    ColliderIndex::Reader reader(pick_scene.scene()->getColliderIndex());
+    std::vector<ColliderData> hits;
+    std::vector<ColliderData> expected(pick_scene.hits(start, dir));
+
+    ColliderIndex::intersect(reader.snapshot(), &start, &dir, 1, false,
+            nullptr, &hits);
+    if (hits.size() != expected.size()) {
+        return false;
+    }
+    for (auto it = expected.begin(); it != expected.end(); ++it) {
+        bool found = false;
+        for (auto hit = hits.begin(); hit != hits.end(); ++hit) {
+            found = found || (hit->ColliderHit == it->ColliderHit);
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * A small move refits the bounds in place, a large one rebuilds the
+ * hierarchy, and the moved collider is found where it went either way.
+ */
+static void test_refit() {
+    PickScene pick_scene(50, 5);
+    SphereCollider* collider = pick_scene.collider(0);
+    Transform* transform = collider->owner_object()->transform();
+    const ColliderIndex& index = pick_scene.scene()->getColliderIndex();
+    const glm::vec3 eye(0.0f, 0.0f, 40.0f);
+    float built_area;
+
+    {
+        ColliderIndex::Reader reader(index);
+        built_area = reader.snapshot().built_area;
+        TEST_CHECK(reader.snapshot().entries.size() == 50);
+    }
+
+    glm::vec3 position(transform->position() + glm::vec3(0.25f, 0.0f, 0.0f));
+    transform->set_position(position);
+    pick_scene.objects().prepare(pick_scene.scene());
+    {
+        ColliderIndex::Reader reader(index);
+        const ColliderIndex::Entry* entry = find_entry(reader.snapshot(), collider);
+        BoundingVolume bounds;
+
+        TEST_CHECK(reader.snapshot().built_area == built_area);
+        TEST_CHECK(collider->getWorldBounds(bounds));
+        TEST_CHECK((nullptr != entry) && (entry->min_corner == bounds.min_corner())
+                && (entry->max_corner == bounds.max_corner()));
+    }
+    TEST_CHECK(same_hits(pick_scene, eye, glm::normalize(position - eye)));
+
+    position = glm::vec3(200.0f, 0.0f, 0.0f);
+    transform->set_position(position);
+    pick_scene.objects().prepare(pick_scene.scene());
+    {
+        ColliderIndex::Reader reader(index);
+        const ColliderIndex::Entry* entry = find_entry(reader.snapshot(), collider);
+
+        TEST_CHECK(reader.snapshot().built_area != built_area);
+        TEST_CHECK((nullptr != entry) && (entry->min_corner.x > 190.0f));
+    }
+    TEST_CHECK(same_hits(pick_scene, eye, glm::normalize(position - eye)));
+}
+
+/*
+ * A removed collider leaves the index right away, and the next update
+ * rebuilds the hierarchy without it.
+ */
+static void test_remove() {
+    PickScene pick_scene(50, 6);
+    const ColliderIndex& index = pick_scene.scene()->getColliderIndex();
+    SphereCollider* collider = pick_scene.collider(3);
+    const glm::vec3 eye(0.0f, 0.0f, 40.0f);
+    const glm::vec3 dir(glm::normalize(pick_scene.centers()[3] - eye));
+
+    TEST_CHECK(same_hits(pick_scene, eye, dir));
+    pick_scene.deleteCollider(3);
+    {
+        ColliderIndex::Reader reader(index);
+        TEST_CHECK(nullptr == find_entry(reader.snapshot(), collider));
+        TEST_CHECK(reader.snapshot().entries.size() == 50);
+    }
+    TEST_CHECK(same_hits(pick_scene, eye, dir));
+
+    pick_scene.objects().prepare(pick_scene.scene());
+    {
+        ColliderIndex::Reader reader(index);
+        TEST_CHECK(reader.snapshot().entries.size() == 49);
+    }
+    TEST_CHECK(same_hits(pick_scene, eye, dir));
+}
+
+/*
+ * synchronize waits for a reader which entered before the removal even
+ * when another snapshot was published in between, but not for the
+ * readers which entered after it.
+ */
+static void test_synchronize() {
+    PickScene pick_scene(8, 7);
+    std::vector<Component*> colliders;
+    ColliderIndex index;
+
+    for (int i = 0; i < 8; ++i) {
+        colliders.push_back(pick_scene.collider(i));
+    }
+    index.update(colliders, true);
+
+    ColliderIndex::Reader* early = new ColliderIndex::Reader(index);
+    TEST_CHECK(nullptr != find_entry(early->snapshot(), pick_scene.collider(0)));
+    index.update(colliders, true);
+    uint64_t epoch = index.remove(pick_scene.collider(0));
+    ColliderIndex::Reader late(index);
+    TEST_CHECK(nullptr == find_entry(late.snapshot(), pick_scene.collider(0)));
+
+    std::atomic<bool> done(false);
+    std::thread remover([&]() {
+        index.synchronize(epoch);
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST_CHECK(!done);
+    delete early;
+    // late is still held, the remover must get through anyway
+    remover.join();
+    TEST_CHECK(done);
+}
+
+/*
+ * Colliders are deleted one after the other while other threads keep
+ * picking. Run under AddressSanitizer this catches a pick testing a
+ * deleted collider.
+ */
+static void test_concurrent_delete() {
+    const int COLLIDER_COUNT = 64;
+    const int PICKER_COUNT = 4;
+    PickScene pick_scene(COLLIDER_COUNT, 8);
+    std::vector<float> rays(pick_scene.rays(glm::vec3(0.0f, 0.0f, 40.0f),
+            COLLIDER_COUNT, 9));
+    std::atomic<bool> stop(false);
+    std::atomic<int> picks(0);
+    std::vector<std::thread> pickers;
+
+    for (int p = 0; p < PICKER_COUNT; ++p) {
+        pickers.emplace_back([&]() {
+            PickBatch batch;
+            while (!stop) {
+                Picker::pickRays(pick_scene.scene(), nullptr, rays.data(),
+                        COLLIDER_COUNT, batch);
+                ++picks;
+            }
+        });
+    }
+    for (int i = 0; i < COLLIDER_COUNT; ++i) {
+        // let the pickers get into the index between the removals
+        int start = picks;
+        while (picks < start + PICKER_COUNT) {
+            std::this_thread::yield();
+        }
+        pick_scene.deleteCollider(i);
+    }
+    stop = true;
+    for (auto it = pickers.begin(); it != pickers.end(); ++it) {
+        it->join();
+    }
+
+    PickBatch batch;
+    Picker::pickRays(pick_scene.scene(), nullptr, rays.data(), COLLIDER_COUNT, batch);
+    TEST_CHECK(batch.total_hit_count() == 0);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_refit();
+    test_remove();
+    test_synchronize();
+    test_concurrent_delete();
+    return result("collider_index_test");
+}
@@ -0,0 +1,208 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Checks the flattened cull against the recursive one and times both.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "test_scene.h"
+#include "test_util.h"
+
+#include "engine/renderer/cull_list.h"
+#include "objects/scene_object.h"
+#include "objects/components/transform.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static glm::mat4 view_projection(const glm::vec3& eye,
+        const glm::vec3& center) {
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.5f,
+            0.1f, 500.0f);
+    return projection * glm::lookAt(eye, center, glm::vec3(0, 1, 0));
+}
+
+/*
+ * Cull the scene from a random camera both ways and compare the
+ * render lists and the cull status of every object.
+ */
+static void compare_culls(TestScene& scene, CullList& cull_list,
+        std::mt19937& random, float size) {
+    std::uniform_real_distribution<float> coordinate(-size, size);
+    glm::vec3 eye(coordinate(random), coordinate(random), coordinate(random));
+    glm::vec3 center(coordinate(random), coordinate(random),
+            coordinate(random));
+    float frustum[6][4];
+    std::vector<SceneObject*> expected;
+    std::vector<SceneObject*> actual;
+    std::vector<bool> expected_status;
+
+    build_frustum(frustum, view_projection(eye, center));
+    frustum_cull(glm::vec3(), scene.root(), frustum, expected, true, 0, true);
+    for (auto it = scene.objects().begin(); it != scene.objects().end();
+            ++it) {
+        expected_status.push_back((*it)->isCulled());
+    }
+
+    cull_list.cull(0, frustum, true, true, actual);
+    TEST_CHECK(actual == expected);
+    for (size_t i = 0; i < expected_status.size(); ++i) {
+        TEST_CHECK(scene.objects()[i]->isCulled() == expected_status[i]);
+    }
+
+    // a second view must not touch the cull status
+    actual.clear();
+    cull_list.cull(1, frustum, true, false, actual);
+    TEST_CHECK(actual == expected);
+
+    // without culling everything enabled is drawn
+    expected.clear();
+    actual.clear();
+    frustum_cull(glm::vec3(), scene.root(), frustum, expected, false, 0, false);
+    cull_list.cull(1, frustum, false, false, actual);
+    TEST_CHECK(actual == expected);
+}
+
+static void test_matches_recursive_cull() {
+    const float size = 100.0f;
+    std::mt19937 random(1);
+    TestScene scene;
+    CullList cull_list;
+
+    scene.addGroups(2000, 8, size, 7);
+
+    // nested groups, the cull skips whole subtrees of these
+    SceneObject* parent = nullptr;
+    for (int i = 0; i < 6; ++i) {
+        parent = scene.add(parent, glm::vec3(3.0f, 0.0f, 0.0f),
+                glm::vec3(1.0f));
+        scene.add(parent, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.5f));
+    }
+
+    scene.prepare();
+    cull_list.update(scene.root(), 2);
+    TEST_CHECK(cull_list.size() == scene.objects().size());
+    for (int i = 0; i < 20; ++i) {
+        compare_culls(scene, cull_list, random, size);
+    }
+
+    // disabled and invisible objects skip their subtrees
+    std::uniform_int_distribution<int> pick(1, scene.objects().size() - 1);
+    for (int i = 0; i < 100; ++i) {
+        scene.objects()[pick(random)]->set_enable(false);
+        scene.objects()[pick(random)]->set_visible(false);
+    }
+    scene.prepare();
+    cull_list.update(scene.root(), 2);
+    for (int i = 0; i < 20; ++i) {
+        compare_culls(scene, cull_list, random, size);
+    }
+
+    // moved objects only refit their bounds
+    std::uniform_real_distribution<float> coordinate(-size, size);
+    for (int i = 0; i < 200; ++i) {
+        scene.objects()[pick(random)]->transform()->set_position(
+                coordinate(random), coordinate(random), coordinate(random));
+    }
+    scene.prepare();
+    cull_list.update(scene.root(), 2);
+    for (int i = 0; i < 20; ++i) {
+        compare_culls(scene, cull_list, random, size);
+    }
+
+    // removed children rebuild the list
+    for (int i = 0; i < 50; ++i) {
+        SceneObject* object = scene.objects()[pick(random)];
+        if (nullptr != object->parent()) {
+            object->parent()->removeChildObject(object);
+        }
+    }
+    scene.prepare();
+    cull_list.update(scene.root(), 2);
+    TEST_CHECK(cull_list.size() < scene.objects().size());
+    for (int i = 0; i < 20; ++i) {
+        compare_culls(scene, cull_list, random, size);
+    }
+}
+
+/*
+ * Time both culls over the same cameras for a scene of count objects.
+ */
+static void benchmark(int count) {
+    const float size = 20.0f * cbrtf(count);
+    const int cameras = 16;
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> coordinate(-size, size);
+    std::vector<glm::mat4> vp_matrices;
+    std::vector<SceneObject*> scene_objects;
+    TestScene scene;
+    CullList cull_list;
+    size_t drawn = 0;
+
+    scene.addGroups(count, 16, size, count);
+    scene.prepare();
+    cull_list.update(scene.root(), 1);
+    for (int i = 0; i < cameras; ++i) {
+        vp_matrices.push_back(view_projection(glm::vec3(coordinate(random),
+                coordinate(random), coordinate(random)), glm::vec3()));
+    }
+
+    const int repeat = std::max(1, 200000 / count);
+    double recursive_ms = time_ms(repeat, [&]() {
+        for (auto it = vp_matrices.begin(); it != vp_matrices.end(); ++it) {
+            float frustum[6][4];
+            build_frustum(frustum, *it);
+            scene_objects.clear();
+            frustum_cull(glm::vec3(), scene.root(), frustum, scene_objects, true, 0, true);
+            drawn += scene_objects.size();
+        }
+    }) / cameras;
+    double flat_ms = time_ms(repeat, [&]() {
+        for (auto it = vp_matrices.begin(); it != vp_matrices.end(); ++it) {
+            float frustum[6][4];
+            build_frustum(frustum, *it);
+            scene_objects.clear();
+            cull_list.cull(0, frustum, true, true, scene_objects);
+            drawn -= scene_objects.size();
+        }
+    }) / cameras;
+
+    // both culls drew the same number of objects
+    TEST_CHECK(drawn == 0);
+    printf("%7d objects: recursive %8.3f ms, cull list %8.3f ms, %.2fx\n",
+            count, recursive_ms, flat_ms, recursive_ms / flat_ms);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_matches_recursive_cull();
+    benchmark(1000);
+    benchmark(10000);
+    benchmark(100000);
+    return result("cull_list_test");
+}
@@ -0,0 +1,392 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Checks the SIMD helpers and the box / frustum kernel against plain C++.
+ ***************************************************************************/
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include "test_util.h"
+
+#include "engine/renderer/aabb_frustum.h"
+#include "objects/scene_object.h"
+#include "util/gvr_simd.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static bool same_bits(float a, float b) {
+    return 0 == memcmp(&a, &b, sizeof(float));
+}
+
+static bool same_bits(const float* a, const float* b, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (!same_bits(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_lanes() {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> value(-1000.0f, 1000.0f);
+
+    for (int t = 0; t < 10000; ++t) {
+        float a[4];
+        float b[4];
+        float c[4];
+        float r[4];
+        float e[4];
+
+        for (int i = 0; i < 4; ++i) {
+            a[i] = value(random);
+            b[i] = value(random);
+            c[i] = value(random);
+        }
+        // equal lanes exercise the comparisons
+        if (t & 1) {
+            b[t & 3] = a[t & 3];
+        }
+
+        const simd::Lanes la = simd::load(a);
+        const simd::Lanes lb = simd::load(b);
+        const simd::Lanes lc = simd::load(c);
+
+        simd::store(r, simd::add(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[i] + b[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::sub(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[i] - b[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::mul(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[i] * b[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::madd(la, lb, lc));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[i] * b[i];
+            e[i] += c[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        // NEON divides by refining a reciprocal estimate
+        simd::store(r, simd::div(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[i] / b[i];
+#if defined(GVR_SIMD_NEON)
+            TEST_CHECK(fabsf(r[i] - e[i]) <= 2e-7f * fabsf(e[i]));
+#else
+            TEST_CHECK(same_bits(r[i], e[i]));
+#endif
+        }
+
+        simd::store(r, simd::min(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = (a[i] < b[i]) ? a[i] : b[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::max(la, lb));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = (a[i] > b[i]) ? a[i] : b[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        int greater = 0;
+        int greater_equal = 0;
+        int both = 0;
+        for (int i = 0; i < 4; ++i) {
+            greater |= (a[i] > b[i]) << i;
+            greater_equal |= (a[i] >= b[i]) << i;
+            both |= ((a[i] > b[i]) && (a[i] >= c[i])) << i;
+        }
+        const simd::LaneMask gt = simd::greater(la, lb);
+        TEST_CHECK(simd::bits(gt) == greater);
+        TEST_CHECK(simd::any(gt) == (greater != 0));
+        TEST_CHECK(simd::bits(simd::greaterEqual(la, lb)) == greater_equal);
+        TEST_CHECK(simd::bits(simd::both(gt,
+                simd::greaterEqual(la, lc))) == both);
+
+        simd::store(r, simd::select(gt, la, lc));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = ((greater >> i) & 1) ? a[i] : c[i];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::splat(a[0]));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[0];
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+
+        simd::store(r, simd::ramp(a[0]));
+        for (int i = 0; i < 4; ++i) {
+            e[i] = a[0] + (float) i;
+        }
+        TEST_CHECK(same_bits(r, e, 4));
+    }
+}
+
+static void test_multiply_matrix() {
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+
+    for (int t = 0; t < 10000; ++t) {
+        glm::mat4 a;
+        glm::mat4 b;
+
+        for (int i = 0; i < 16; ++i) {
+            glm::value_ptr(a)[i] = value(random);
+            glm::value_ptr(b)[i] = value(random);
+        }
+
+        const glm::mat4 expected = a * b;
+        glm::mat4 r;
+        simd::multiplyMatrix(glm::value_ptr(a), glm::value_ptr(b),
+                glm::value_ptr(r));
+        TEST_CHECK(same_bits(glm::value_ptr(r), glm::value_ptr(expected),
+                16));
+
+        // the result may overwrite either input
+        simd::multiplyMatrix(glm::value_ptr(a), glm::value_ptr(b),
+                glm::value_ptr(a));
+        TEST_CHECK(same_bits(glm::value_ptr(a), glm::value_ptr(expected),
+                16));
+    }
+}
+
+/*
+ * Plane bits of one box, testing all eight corners like the scalar
+ * SceneObject::checkAABBVsFrustumOpt used to.
+ */
+static void classify_corners(const float frustum[6][4],
+        const glm::vec3& min_corner, const glm::vec3& max_corner,
+        unsigned char& outside, unsigned char& inside) {
+    outside = 0;
+    inside = 0;
+    for (int p = 0; p < 6; ++p) {
+        int count = 0;
+
+        for (int corner = 0; corner < 8; ++corner) {
+            const float x = (corner & 1) ? max_corner.x : min_corner.x;
+            const float y = (corner & 2) ? max_corner.y : min_corner.y;
+            const float z = (corner & 4) ? max_corner.z : min_corner.z;
+
+            if (frustum[p][0] * x + frustum[p][1] * y + frustum[p][2] * z
+                    + frustum[p][3] > 0) {
+                ++count;
+            }
+        }
+        if (count == 0) {
+            outside |= 1 << p;
+        } else if (count == 8) {
+            inside |= 1 << p;
+        }
+    }
+}
+
+/*
+ * The scalar SceneObject::checkAABBVsFrustumOpt, stopping at the first
+ * plane the box is outside of.
+ */
+static int check_corners(const float frustum[6][4],
+        const glm::vec3& min_corner, const glm::vec3& max_corner,
+        int& planeMask) {
+    unsigned char outside;
+    unsigned char inside;
+    bool complete_inside = true;
+
+    classify_corners(frustum, min_corner, max_corner, outside, inside);
+    for (int p = 0; p < 6; ++p) {
+        if ((planeMask >> p) & 1) {
+            continue;
+        }
+        if ((outside >> p) & 1) {
+            return OUTSIDE;
+        }
+        if ((inside >> p) & 1) {
+            planeMask |= 1 << p;
+        } else {
+            complete_inside = false;
+        }
+    }
+    return complete_inside ? INSIDE : INTERSECT;
+}
+
+/*
+ * Random boxes and planes. Every other case uses small integers, so
+ * that corners land exactly on the planes.
+ */
+struct BoxCases {
+    std::vector<float> frustum;
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    BoxCases(int count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> extent(0.0f, 5.0f);
+        std::uniform_int_distribution<int> integer(-3, 3);
+
+        for (int i = 0; i < count; ++i) {
+            const bool exact = (i & 1) != 0;
+            float lower[3];
+
+            for (int k = 0; k < 24; ++k) {
+                frustum.push_back(exact ? integer(random) : value(random));
+            }
+            for (int k = 0; k < 3; ++k) {
+                lower[k] = exact ? integer(random) : value(random);
+            }
+            min_x.push_back(lower[0]);
+            min_y.push_back(lower[1]);
+            min_z.push_back(lower[2]);
+            max_x.push_back(lower[0] + (exact ? integer(random) + 3
+                    : extent(random)));
+            max_y.push_back(lower[1] + (exact ? integer(random) + 3
+                    : extent(random)));
+            max_z.push_back(lower[2] + (exact ? integer(random) + 3
+                    : extent(random)));
+        }
+    }
+
+    const float (*planes(int i) const)[4] {
+        return reinterpret_cast<const float (*)[4]>(&frustum[i * 24]);
+    }
+};
+
+static void test_classify_matches_corners() {
+    const int count = 100000;
+    BoxCases cases(count, 4);
+    std::mt19937 random(5);
+
+    for (int i = 0; i < count; ++i) {
+        const glm::vec3 min_corner(cases.min_x[i], cases.min_y[i],
+                cases.min_z[i]);
+        const glm::vec3 max_corner(cases.max_x[i], cases.max_y[i],
+                cases.max_z[i]);
+        unsigned char expected_out;
+        unsigned char expected_in;
+        unsigned char out;
+        unsigned char in;
+
+        classify_corners(cases.planes(i), min_corner, max_corner,
+                expected_out, expected_in);
+        classifyAABBsVsFrustum(cases.planes(i), &cases.min_x[i],
+                &cases.min_y[i], &cases.min_z[i], &cases.max_x[i],
+                &cases.max_y[i], &cases.max_z[i], 1, &out, &in);
+        TEST_CHECK(out == expected_out);
+        TEST_CHECK(in == expected_in);
+
+        const int mask = random() & 0x3f;
+        int expected_mask = mask;
+        int actual_mask = mask;
+        const int expected = check_corners(cases.planes(i), min_corner,
+                max_corner, expected_mask);
+        TEST_CHECK(SceneObject::checkAABBVsFrustumOpt(cases.planes(i),
+                min_corner, max_corner, actual_mask) == expected);
+        TEST_CHECK(actual_mask == expected_mask);
+    }
+
+    // full and partial blocks against one frustum
+    for (int first = 0; first + AABB_FRUSTUM_LANES <= count;
+            first += AABB_FRUSTUM_LANES) {
+        const float (*frustum)[4] = cases.planes(first);
+        const int lanes = 1 + (first / AABB_FRUSTUM_LANES)
+                % AABB_FRUSTUM_LANES;
+        unsigned char out[AABB_FRUSTUM_LANES];
+        unsigned char in[AABB_FRUSTUM_LANES];
+
+        classifyAABBsVsFrustum(frustum, &cases.min_x[first],
+                &cases.min_y[first], &cases.min_z[first],
+                &cases.max_x[first], &cases.max_y[first],
+                &cases.max_z[first], lanes, out, in);
+        for (int i = 0; i < lanes; ++i) {
+            unsigned char expected_out;
+            unsigned char expected_in;
+
+            classify_corners(frustum,
+                    glm::vec3(cases.min_x[first + i], cases.min_y[first + i],
+                            cases.min_z[first + i]),
+                    glm::vec3(cases.max_x[first + i], cases.max_y[first + i],
+                            cases.max_z[first + i]),
+                    expected_out, expected_in);
+            TEST_CHECK(out[i] == expected_out);
+            TEST_CHECK(in[i] == expected_in);
+        }
+    }
+}
+
+static void benchmark_classify() {
+    const int count = 100000;
+    BoxCases cases(count, 6);
+    const float (*frustum)[4] = cases.planes(0);
+    std::vector<unsigned char> out(count);
+    std::vector<unsigned char> in(count);
+    unsigned int checksum = 0;
+
+    double corners_ms = time_ms(20, [&]() {
+        for (int i = 0; i < count; ++i) {
+            classify_corners(frustum,
+                    glm::vec3(cases.min_x[i], cases.min_y[i], cases.min_z[i]),
+                    glm::vec3(cases.max_x[i], cases.max_y[i], cases.max_z[i]),
+                    out[i], in[i]);
+        }
+        checksum += out[count - 1] + in[count - 1];
+    });
+    double lanes_ms = time_ms(20, [&]() {
+        for (int i = 0; i < count; i += AABB_FRUSTUM_LANES) {
+            classifyAABBsVsFrustum(frustum, &cases.min_x[i],
+                    &cases.min_y[i], &cases.min_z[i], &cases.max_x[i],
+                    &cases.max_y[i], &cases.max_z[i],
+                    std::min(AABB_FRUSTUM_LANES, count - i), &out[i], &in[i]);
+        }
+        checksum -= out[count - 1] + in[count - 1];
+    });
+
+    TEST_CHECK(checksum == 0);
+    printf("%d boxes: eight corners %.3f ms, SIMD kernel %.3f ms, %.2fx\n",
+            count, corners_ms, lanes_ms, corners_ms / lanes_ms);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_lanes();
+    test_multiply_matrix();
+    test_classify_matches_corners();
+    benchmark_classify();
+    return result("gvr_simd_test");
+}
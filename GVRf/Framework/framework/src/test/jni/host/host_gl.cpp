@@ -0,0 +1,76 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * GL context for the native unit tests which need one.
+ ***************************************************************************/
+
+#include "host_gl.h"
+
+#if defined(HOST_GL_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstdio>
+
+namespace gvr {
+namespace test {
+
+#if defined(HOST_GL_EGL)
+
+bool makeGLContextCurrent() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (nullptr == getPlatformDisplay) {
+        fprintf(stderr, "no eglGetPlatformDisplayEXT\n");
+        return false;
+    }
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+            EGL_DEFAULT_DISPLAY, nullptr);
+    if ((EGL_NO_DISPLAY == display) || !eglInitialize(display, nullptr, nullptr)) {
+        fprintf(stderr, "no surfaceless EGL display\n");
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint config_attributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT, EGL_NONE };
+    const EGLint context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+
+    eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+    EGLContext context = eglCreateContext(display, config_count ? config : nullptr,
+            EGL_NO_CONTEXT, context_attributes);
+    if ((EGL_NO_CONTEXT == context)
+            || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        fprintf(stderr, "no GLES 3 context, EGL error 0x%x\n", eglGetError());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool makeGLContextCurrent() {
+    fprintf(stderr, "built without EGL\n");
+    return false;
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,36 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * GL context for the native unit tests which need one.
+ ***************************************************************************/
+
+#ifndef HOST_GL_H_
+#define HOST_GL_H_
+
+namespace gvr {
+namespace test {
+
+/*
+ * Make a GLES 3 context current on the calling thread, on the
+ * surfaceless platform of Mesa so no window is needed. Returns false
+ * if the host can not create one; the test is then skipped.
+ */
+bool makeGLContextCurrent();
+
+}
+}
+#endif
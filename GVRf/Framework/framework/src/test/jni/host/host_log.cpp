@@ -0,0 +1,38 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Prints the framework log to stderr when running the native unit tests.
+ ***************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <android/log.h>
+
+extern "C" int __android_log_print(int prio, const char* tag,
+        const char* fmt, ...) {
+    if (prio < ANDROID_LOG_WARN) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: ", tag);
+    int result = vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    return result;
+}
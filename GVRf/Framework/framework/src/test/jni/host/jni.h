@@ -0,0 +1,121 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Host stand-in for jni.h, used by the native unit tests. Only declares
+ * what the headers of the framework need to compile. The tests never
+ * call into Java, so every call fails.
+ ***************************************************************************/
+
+#ifndef HOST_JNI_H_
+#define HOST_JNI_H_
+
+#include <stdint.h>
+
+typedef uint8_t jboolean;
+typedef int8_t jbyte;
+typedef uint16_t jchar;
+typedef int16_t jshort;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef float jfloat;
+typedef double jdouble;
+typedef jint jsize;
+
+class _jobject {};
+class _jclass : public _jobject {};
+class _jstring : public _jobject {};
+class _jarray : public _jobject {};
+class _jobjectArray : public _jarray {};
+class _jbyteArray : public _jarray {};
+class _jintArray : public _jarray {};
+class _jfloatArray : public _jarray {};
+
+typedef _jobject* jobject;
+typedef _jclass* jclass;
+typedef _jstring* jstring;
+typedef _jarray* jarray;
+typedef _jobjectArray* jobjectArray;
+typedef _jbyteArray* jbyteArray;
+typedef _jintArray* jintArray;
+typedef _jfloatArray* jfloatArray;
+typedef jobject jweak;
+
+struct _jfieldID;
+typedef struct _jfieldID* jfieldID;
+struct _jmethodID;
+typedef struct _jmethodID* jmethodID;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+#define JNI_OK 0
+#define JNI_ERR (-1)
+#define JNI_EDETACHED (-2)
+#define JNI_VERSION_1_6 0x00010006
+
+#define JNIEXPORT
+#define JNICALL
+
+struct _JavaVM;
+
+struct _JNIEnv {
+    jint GetJavaVM(_JavaVM** vm) {
+        *vm = nullptr;
+        return JNI_ERR;
+    }
+    jclass FindClass(const char*) {
+        return nullptr;
+    }
+    jmethodID GetMethodID(jclass, const char*, const char*) {
+        return nullptr;
+    }
+    jmethodID GetStaticMethodID(jclass, const char*, const char*) {
+        return nullptr;
+    }
+    jobject NewGlobalRef(jobject) {
+        return nullptr;
+    }
+    void DeleteGlobalRef(jobject) {
+    }
+    jobject NewLocalRef(jobject) {
+        return nullptr;
+    }
+    void DeleteLocalRef(jobject) {
+    }
+    jweak NewWeakGlobalRef(jobject) {
+        return nullptr;
+    }
+    void DeleteWeakGlobalRef(jweak) {
+    }
+    void CallVoidMethod(jobject, jmethodID, ...) {
+    }
+};
+
+struct _JavaVM {
+    jint GetEnv(void**, jint) {
+        return JNI_EDETACHED;
+    }
+    jint AttachCurrentThread(_JNIEnv**, void*) {
+        return JNI_ERR;
+    }
+    jint DetachCurrentThread() {
+        return JNI_ERR;
+    }
+};
+
+typedef _JNIEnv JNIEnv;
+typedef _JavaVM JavaVM;
+
+#endif
@@ -0,0 +1,375 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Loads synthetic KTX 1.1 and KTX 2.0 files with KtxTexture, checks that
+ * broken headers are rejected and streams the levels of valid ones.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+#include "host/host_gl.h"
+#include "test_util.h"
+
+#include "objects/textures/ktx_texture.h"
+#include "objects/textures/texture_uploader.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static const uint32_t GL_ETC2_RGB8 = 0x9274;
+static const uint32_t VK_ETC2_RGB8 = 147;
+static const unsigned char KTX1_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char KTX2_IDENTIFIER[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+static int texture_parameters[MAX_TEXTURE_PARAM_NUM] = { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
+        1, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+
+// bytes of an ETC2 RGB8 level, 8 per 4x4 block
+static uint32_t etc2Size(uint32_t width, uint32_t height, int level) {
+    const uint32_t w = std::max(1u, width >> level);
+    const uint32_t h = std::max(1u, height >> level);
+    return ((w + 3) / 4) * ((h + 3) / 4) * 8;
+}
+
+static void put32(std::vector<char>& bytes, size_t at, uint32_t value, bool swap = false) {
+    if (swap) {
+        value = __builtin_bswap32(value);
+    }
+    memcpy(&bytes[at], &value, sizeof(value));
+}
+
+static void put64(std::vector<char>& bytes, size_t at, uint64_t value) {
+    memcpy(&bytes[at], &value, sizeof(value));
+}
+
+/*
+ * A KTX 1.1 file of an ETC2 texture, written in the byte order of a
+ * big endian writer if swap is set. The levels are filled with their
+ * index; a level count of 0 still writes the base level.
+ */
+static std::vector<char> ktx1(uint32_t width, uint32_t height, uint32_t level_count,
+        bool swap = false) {
+    std::vector<char> bytes(64);
+
+    memcpy(&bytes[0], KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER));
+    put32(bytes, 12, 0x04030201, swap);
+    put32(bytes, 28, GL_ETC2_RGB8, swap);
+    put32(bytes, 32, 0x1907, swap);     // GL_RGB
+    put32(bytes, 36, width, swap);
+    put32(bytes, 40, height, swap);
+    put32(bytes, 52, 1, swap);
+    put32(bytes, 56, level_count, swap);
+    for (uint32_t i = 0; i < std::max(1u, level_count); ++i) {
+        const uint32_t size = etc2Size(width, height, i);
+        const size_t at = bytes.size();
+
+        bytes.resize(at + 4 + ((size + 3) & ~3u), (char) i);
+        put32(bytes, at, size, swap);
+    }
+    return bytes;
+}
+
+/*
+ * A KTX 2.0 file of an ETC2 texture with the levels stored coarse to
+ * fine, as the format recommends, after the level index.
+ */
+static std::vector<char> ktx2(uint32_t width, uint32_t height, uint32_t level_count) {
+    std::vector<char> bytes(80 + 24 * level_count);
+
+    memcpy(&bytes[0], KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    put32(bytes, 12, VK_ETC2_RGB8);
+    put32(bytes, 20, width);
+    put32(bytes, 24, height);
+    put32(bytes, 36, 1);
+    put32(bytes, 40, level_count);
+    for (int i = level_count - 1; i >= 0; --i) {
+        const uint32_t size = etc2Size(width, height, i);
+        const size_t at = bytes.size();
+
+        bytes.resize(at + size, (char) i);
+        put64(bytes, 80 + 24 * i, at);
+        put64(bytes, 80 + 24 * i + 8, size);
+        put64(bytes, 80 + 24 * i + 16, size);
+    }
+    return bytes;
+}
+
+/*
+ * Write the bytes after offset bytes of padding, as an asset inside
+ * an APK, and load them from a temporary file.
+ */
+static KtxTexture* load(const std::vector<char>& bytes, long offset = 0) {
+    char path[] = "/tmp/ktx_texture_test_XXXXXX";
+    const int fd = mkstemp(path);
+
+    if (fd < 0) {
+        fail(__FILE__, __LINE__, "mkstemp");
+        return nullptr;
+    }
+    unlink(path);
+
+    std::vector<char> file(offset, 0);
+    file.insert(file.end(), bytes.begin(), bytes.end());
+    if (write(fd, file.data(), file.size()) != (ssize_t) file.size()) {
+        fail(__FILE__, __LINE__, "write");
+    }
+    KtxTexture* texture = KtxTexture::load(fd, offset, offset ? bytes.size() : 0,
+            texture_parameters);
+    close(fd);
+    return texture;
+}
+
+static bool rejected(const std::vector<char>& bytes) {
+    KtxTexture* texture = load(bytes);
+    delete texture;
+    return nullptr == texture;
+}
+
+static void test_valid_files() {
+    std::unique_ptr<KtxTexture> texture(load(ktx1(256, 128, 9)));
+    TEST_CHECK(nullptr != texture);
+    if (nullptr != texture) {
+        TEST_CHECK(texture->level_count() == 9);
+        // the levels up to 128 pixels are queued up front
+        TEST_CHECK(texture->queued_level() == 1);
+        TEST_CHECK(!texture->isReady());
+    }
+
+    texture.reset(load(ktx1(64, 64, 7, true)));
+    TEST_CHECK(nullptr != texture);
+    if (nullptr != texture) {
+        TEST_CHECK(texture->level_count() == 7);
+        TEST_CHECK(texture->queued_level() == 0);
+    }
+
+    texture.reset(load(ktx2(256, 256, 9), 1000));
+    TEST_CHECK(nullptr != texture);
+    if (nullptr != texture) {
+        TEST_CHECK(texture->level_count() == 9);
+        TEST_CHECK(texture->queued_level() == 1);
+    }
+
+    // a level count of 0 asks for the base level only
+    texture.reset(load(ktx1(16, 16, 0)));
+    TEST_CHECK((nullptr != texture) && (texture->level_count() == 1));
+}
+
+static void test_ktx1_rejected() {
+    const std::vector<char> valid = ktx1(64, 64, 7);
+    std::vector<char> bytes;
+
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.begin() + 63)));
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.begin() + 12)));
+
+    bytes = valid;
+    put32(bytes, 12, 0x12345678);
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 16, 0x1401);       // GL_UNSIGNED_BYTE, not compressed
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 52, 6);            // cube map
+    TEST_CHECK(rejected(bytes));
+
+    TEST_CHECK(rejected(ktx1(0, 64, 1)));
+    TEST_CHECK(rejected(ktx1(64, 0, 1)));
+
+    // dimensions which do not fit a GLsizei
+    bytes = valid;
+    put32(bytes, 36, 0x80000000u);
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put32(bytes, 40, 0xffffffffu);
+    TEST_CHECK(rejected(bytes));
+
+    // more levels than a 64x64 mipmap chain has
+    bytes = valid;
+    put32(bytes, 56, 8);
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put32(bytes, 56, 0xffffffffu);
+    TEST_CHECK(rejected(bytes));
+
+    // key value data running past the end, or wrapping around
+    bytes = valid;
+    put32(bytes, 60, valid.size());
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put32(bytes, 60, 0xfffffffcu);
+    TEST_CHECK(rejected(bytes));
+
+    // a level size which would wrap the offset around
+    bytes = valid;
+    put32(bytes, 64, 0xfffffffcu);
+    TEST_CHECK(rejected(bytes));
+
+    // the last level or its size cut off
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.end() - 1)));
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.end() - 8)));
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.end() - 10)));
+
+    // the same checks hold for the other byte order
+    bytes = ktx1(64, 64, 7, true);
+    put32(bytes, 56, 8, true);
+    TEST_CHECK(rejected(bytes));
+    bytes = ktx1(64, 64, 7, true);
+    TEST_CHECK(rejected(std::vector<char>(bytes.begin(), bytes.end() - 1)));
+
+    TEST_CHECK(rejected(std::vector<char>(1, 0)));
+}
+
+static void test_ktx2_rejected() {
+    const std::vector<char> valid = ktx2(64, 64, 7);
+    std::vector<char> bytes;
+
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.begin() + 79)));
+
+    bytes = valid;
+    put32(bytes, 12, 37);           // VK_FORMAT_R8G8B8A8_UNORM
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 44, 2);            // zstd supercompression
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 32, 4);            // array texture
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 20, 0x80000000u);
+    TEST_CHECK(rejected(bytes));
+
+    bytes = valid;
+    put32(bytes, 40, 8);
+    TEST_CHECK(rejected(bytes));
+
+    // a level index longer than the file
+    bytes = ktx2(4, 4, 1);
+    put32(bytes, 40, 3);
+    TEST_CHECK(rejected(bytes));
+    TEST_CHECK(rejected(std::vector<char>(valid.begin(), valid.begin() + 80 + 24 * 7 - 1)));
+
+    // a level starting past the end, running past it or wrapping around
+    bytes = valid;
+    put64(bytes, 80, valid.size() + 1);
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put64(bytes, 88, valid.size());
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put64(bytes, 80, 0xffffffffffffff00ull);
+    TEST_CHECK(rejected(bytes));
+    bytes = valid;
+    put64(bytes, 80, 100);
+    put64(bytes, 88, 0xffffffffffffff00ull);
+    TEST_CHECK(rejected(bytes));
+}
+
+/*
+ * Run frames of the uploader until nothing is in flight any more.
+ */
+static void uploadAll() {
+    for (int i = 0; i < 20; ++i) {
+        glFinish();
+        TextureUploader::getInstance().update();
+    }
+}
+
+static int baseLevel(Texture* texture) {
+    GLint level = -1;
+
+    glBindTexture(GL_TEXTURE_2D, texture->getId());
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return level;
+}
+
+/*
+ * The initial levels make the texture ready, finer ones are streamed
+ * when it is drawn large and dropped again when it is evicted.
+ */
+static void test_stream_and_evict() {
+    std::unique_ptr<KtxTexture> texture(load(ktx2(512, 512, 10)));
+    TEST_CHECK(nullptr != texture);
+    if (nullptr == texture) {
+        return;
+    }
+    TEST_CHECK(texture->queued_level() == 2);
+    // as Material::setTexture does, readiness then waits for the uploads
+    texture->setReady(true);
+    TEST_CHECK(!texture->isReady());
+    uploadAll();
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+    TEST_CHECK(texture->isReady());
+    TEST_CHECK(baseLevel(texture.get()) == 2);
+    const size_t full_bytes = texture->gpu_bytes();
+    TEST_CHECK(full_bytes > etc2Size(512, 512, 0));
+
+    // 100 pixels on screen need the 128 pixel level, then the whole image
+    texture->requestScreenSize(100.0f);
+    TEST_CHECK(texture->queued_level() == 2);
+    texture->requestScreenSize(300.0f);
+    TEST_CHECK(texture->queued_level() == 0);
+    TEST_CHECK(texture->isReady());
+    uploadAll();
+    TEST_CHECK(baseLevel(texture.get()) == 0);
+
+    TEST_CHECK(texture->evict());
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+    TEST_CHECK(texture->gpu_bytes() < etc2Size(512, 512, 1));
+    TEST_CHECK(texture->queued_level() == 2);
+    TEST_CHECK(baseLevel(texture.get()) == 0);
+    TEST_CHECK(!texture->evict());
+
+    texture->requestScreenSize(300.0f);
+    TEST_CHECK(texture->gpu_bytes() == full_bytes);
+    uploadAll();
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+    TEST_CHECK(baseLevel(texture.get()) == 0);
+    TEST_CHECK(texture->isReady());
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_valid_files();
+    test_ktx1_rejected();
+    test_ktx2_rejected();
+    if (makeGLContextCurrent()) {
+        test_stream_and_evict();
+    } else {
+        printf("ktx_texture_test: no GL context, uploads not tested\n");
+    }
+    return result("ktx_texture_test");
+}
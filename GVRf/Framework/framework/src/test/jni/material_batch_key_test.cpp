@@ -0,0 +1,182 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Checks which materials Material::batchEquals and the batch key let
+ * share a draw once their main textures are in a texture array.
+ ***************************************************************************/
+
+#include <glm/glm.hpp>
+
+#include "test_texture.h"
+#include "test_util.h"
+
+#include "objects/material.h"
+#include "objects/textures/texture_array.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static int texture_parameters[MAX_TEXTURE_PARAM_NUM] = { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
+        1, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+
+/*
+ * Two texture shader materials whose main textures sit in layers of
+ * the same array, put there as TextureAtlas::update() would without
+ * copying anything.
+ */
+class Fixture {
+public:
+    Fixture() :
+            array(16, 16, 16, texture_parameters),
+            texture_a(16, 16), texture_b(16, 16), other(16, 16),
+            a(Material::TEXTURE_SHADER), b(Material::TEXTURE_SHADER) {
+        texture_a.setAtlas(&array, array.addLayer());
+        texture_b.setAtlas(&array, array.addLayer());
+        a.setTexture("main_texture", &texture_a);
+        b.setTexture("main_texture", &texture_b);
+        update();
+    }
+
+    void update() {
+        a.updateBatchKey();
+        b.updateBatchKey();
+    }
+
+    bool batched() {
+        update();
+        return (a.batch_key() == b.batch_key()) && a.batchEquals(b) && b.batchEquals(a);
+    }
+
+    // declared first so the textures leave it before it goes
+    TextureArray array;
+    TestTexture texture_a;
+    TestTexture texture_b;
+    TestTexture other;
+    Material a;
+    Material b;
+};
+
+static void test_without_atlas() {
+    TestTexture texture(16, 16);
+    Material a(Material::TEXTURE_SHADER);
+    Material b(Material::TEXTURE_SHADER);
+
+    a.setTexture("main_texture", &texture);
+    b.setTexture("main_texture", &texture);
+    a.updateBatchKey();
+    b.updateBatchKey();
+
+    // the key is the material itself
+    TEST_CHECK(a.batch_key() == a.id());
+    TEST_CHECK(a.batch_key() != b.batch_key());
+    TEST_CHECK(!a.batchEquals(b));
+    TEST_CHECK(a.batchEquals(a));
+    TEST_CHECK((nullptr == a.batch_atlas()) && (a.batch_layer() == -1));
+}
+
+static void test_layers_batch() {
+    Fixture fixture;
+
+    TEST_CHECK(fixture.batched());
+    TEST_CHECK(fixture.a.batch_atlas() == &fixture.array);
+    TEST_CHECK(fixture.a.batch_layer() == 0);
+    TEST_CHECK(fixture.b.batch_layer() == 1);
+}
+
+static void test_uniforms() {
+    Fixture fixture;
+
+    fixture.a.setFloat("opacity", 0.5f);
+    TEST_CHECK(!fixture.batched());
+    fixture.b.setFloat("opacity", 0.5f);
+    TEST_CHECK(fixture.batched());
+
+    fixture.a.setVec3("color", glm::vec3(1.0f, 0.0f, 0.0f));
+    TEST_CHECK(!fixture.batched());
+    fixture.a.setVec3("color", glm::vec3(1.0f, 1.0f, 1.0f));
+    TEST_CHECK(fixture.batched());
+
+    fixture.b.setVec4("tint", glm::vec4(1.0f));
+    TEST_CHECK(!fixture.batched());
+    fixture.a.setVec4("tint", glm::vec4(1.0f));
+    TEST_CHECK(fixture.batched());
+
+    fixture.a.setMat4("uv_transform", glm::mat4(2.0f));
+    fixture.b.setMat4("uv_transform", glm::mat4(1.0f));
+    TEST_CHECK(!fixture.batched());
+}
+
+static void test_shader_and_textures() {
+    Fixture fixture;
+
+    fixture.a.set_shader_feature_set(1);
+    TEST_CHECK(!fixture.batched());
+    fixture.b.set_shader_feature_set(1);
+    TEST_CHECK(fixture.batched());
+
+    fixture.a.set_shader_type(Material::TEXTURE_SHADER_NOLIGHT);
+    TEST_CHECK(!fixture.batched());
+    fixture.a.set_shader_type(Material::TEXTURE_SHADER);
+    TEST_CHECK(fixture.batched());
+
+    // other textures are bound as they are and have to be the same
+    fixture.a.setTexture("lightmap_texture", &fixture.other);
+    TEST_CHECK(!fixture.batched());
+    fixture.b.setTexture("lightmap_texture", &fixture.texture_a);
+    TEST_CHECK(!fixture.batched());
+    fixture.b.setTexture("lightmap_texture", &fixture.other);
+    TEST_CHECK(fixture.batched());
+}
+
+/*
+ * Leaving the array, or moving to another one, is picked up by the
+ * next updateBatchKey().
+ */
+static void test_atlas_changes() {
+    Fixture fixture;
+    TextureArray other_array(16, 16, 16, texture_parameters);
+
+    fixture.texture_b.setAtlas(&other_array, other_array.addLayer());
+    TEST_CHECK(!fixture.batched());
+    TEST_CHECK(fixture.b.batch_atlas() == &other_array);
+    TEST_CHECK(fixture.b.batch_layer() == 0);
+
+    fixture.texture_b.setAtlas(&fixture.array, 5);
+    TEST_CHECK(fixture.batched());
+    TEST_CHECK(fixture.b.batch_layer() == 5);
+
+    TextureAtlas::getInstance().remove(&fixture.texture_b);
+    TEST_CHECK(!fixture.batched());
+    TEST_CHECK(fixture.b.batch_key() == fixture.b.id());
+    TEST_CHECK(nullptr == fixture.b.batch_atlas());
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_without_atlas();
+    test_layers_batch();
+    test_uniforms();
+    test_shader_and_textures();
+    test_atlas_changes();
+    return result("material_batch_key_test");
+}
@@ -0,0 +1,276 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Checks the mesh hierarchy against testing every triangle.
+ ***************************************************************************/
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "test_util.h"
+
+#include "objects/mesh_bvh.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+/*
+ * The triangle test MeshCollider used before the hierarchy.
+ */
+static float rayTriangleIntersect(glm::vec3& hitPos,
+        const glm::vec3& rayStart, const glm::vec3& rayDir,
+        const glm::vec3& V1, const glm::vec3& V2, const glm::vec3& V3) {
+    glm::vec3 e1(V2 - V1);
+    glm::vec3 e2(V3 - V1);
+    glm::vec3 P = glm::cross(rayDir, e2);
+    glm::vec3 T(rayStart - V1);
+    float det = glm::dot(e1, P);
+    const float EPSILON = 0.00001f;
+
+    if (det > -EPSILON && det < EPSILON) {
+        return -1;
+    }
+
+    float inv_det = 1.0f / det;
+    float u = glm::dot(T, P) * inv_det;
+
+    if (u < 0.0f || u > 1.0f) {
+        return -1;
+    }
+
+    glm::vec3 Q = glm::cross(T, e1);
+    float v = glm::dot(rayDir, Q) * inv_det;
+
+    if (v < 0.0f || (u + v) > 1.0f) {
+        return -1;
+    }
+
+    float t = glm::dot(e2, Q) * inv_det;
+
+    if (t > EPSILON) {
+        hitPos = (1.0f - u - v) * V1 + u * V2 + v * V3;
+        return t;
+    }
+    return -1;
+}
+
+/*
+ * Nearest hit over all the triangles, -1 if none.
+ */
+static float brute_force(const std::vector<glm::vec3>& vertices,
+        const std::vector<unsigned int>& indices, const glm::vec3& rayStart,
+        const glm::vec3& rayDir) {
+    float nearest = -1;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        glm::vec3 hitPos;
+        float distance = rayTriangleIntersect(hitPos, rayStart, rayDir,
+                vertices[indices[i]], vertices[indices[i + 1]],
+                vertices[indices[i + 2]]);
+
+        if ((distance > 0) && ((nearest < 0) || (distance < nearest))) {
+            nearest = distance;
+        }
+    }
+    return nearest;
+}
+
+/*
+ * Unit squares of two triangles each, in the z = 0 plane over
+ * [0, size] x [0, size] and on the six faces of the cube [0, size]^3.
+ * All coordinates are integers, so the hits of rays through half
+ * integer points are exact.
+ */
+static void make_lattice(int size, std::vector<glm::vec3>& vertices,
+        std::vector<unsigned int>& indices) {
+    for (int face = 0; face < 7; ++face) {
+        // the plane z = 0 first, then x, y, z = 0 and x, y, z = size
+        const int axis = (face == 0) ? 2 : (face - 1) % 3;
+        const float offset = (face < 4) ? 0.0f : (float) size;
+
+        for (int a = 0; a < size; ++a) {
+            for (int b = 0; b < size; ++b) {
+                const unsigned int first = vertices.size();
+
+                for (int corner = 0; corner < 4; ++corner) {
+                    glm::vec3 v;
+                    v[axis] = offset;
+                    v[(axis + 1) % 3] = a + (corner & 1);
+                    v[(axis + 2) % 3] = b + (corner >> 1);
+                    vertices.push_back(v);
+                }
+                const unsigned int quad[] = { 0, 1, 2, 2, 1, 3 };
+                for (int i = 0; i < 6; ++i) {
+                    indices.push_back(first + quad[i]);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Rays along the axes through every half integer lattice point,
+ * including those lying in the planes of the faces, where the slab
+ * test computes 0 / 0.
+ */
+static void test_axis_aligned_rays() {
+    const int size = 4;
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+    int hit_count = 0;
+
+    make_lattice(size, vertices, indices);
+    MeshBVH bvh(vertices, indices);
+    TEST_CHECK(bvh.triangle_count() == (int) indices.size() / 3);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            for (int a = -1; a <= 2 * size + 1; ++a) {
+                for (int b = -1; b <= 2 * size + 1; ++b) {
+                    glm::vec3 start;
+                    glm::vec3 dir;
+
+                    start[axis] = (sign < 0) ? size + 3.0f : -3.0f;
+                    start[(axis + 1) % 3] = 0.5f * a;
+                    start[(axis + 2) % 3] = 0.5f * b;
+                    dir[axis] = (float) sign;
+                    // the other components are +0 and -0
+                    dir[(axis + 2) % 3] = -0.0f;
+
+                    glm::vec3 hitPos;
+                    const float expected = brute_force(vertices, indices,
+                            start, dir);
+                    const float actual = bvh.intersect(start, dir, hitPos);
+
+                    TEST_CHECK(actual == expected);
+                    if (expected > 0) {
+                        TEST_CHECK(hitPos == start + actual * dir);
+                        ++hit_count;
+                    }
+                }
+            }
+        }
+    }
+    TEST_CHECK(hit_count > 0);
+
+    // a centered gaze ray against a box with min_x == 0
+    glm::vec3 hitPos;
+    TEST_CHECK(bvh.intersect(glm::vec3(0.0f, 0.0f, 10.0f),
+            glm::vec3(0.0f, 0.0f, -1.0f), hitPos)
+            == brute_force(vertices, indices, glm::vec3(0.0f, 0.0f, 10.0f),
+                    glm::vec3(0.0f, 0.0f, -1.0f)));
+}
+
+/*
+ * Random triangles hit by rays aimed at random points on them.
+ */
+static void test_random_rays() {
+    std::mt19937 random(9);
+    std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> barycentric(0.05f, 0.45f);
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+
+    for (int i = 0; i < 3000; ++i) {
+        const glm::vec3 center(coordinate(random), coordinate(random),
+                coordinate(random));
+
+        for (int k = 0; k < 3; ++k) {
+            indices.push_back(vertices.size());
+            vertices.push_back(center + glm::vec3(offset(random),
+                    offset(random), offset(random)));
+        }
+    }
+    MeshBVH bvh(vertices, indices);
+    int miss_count = 0;
+
+    for (int i = 0; i < 3000; ++i) {
+        const int triangle = random() % (indices.size() / 3);
+        const float u = barycentric(random);
+        const float v = barycentric(random);
+        const glm::vec3 target = vertices[3 * triangle]
+                + u * (vertices[3 * triangle + 1] - vertices[3 * triangle])
+                + v * (vertices[3 * triangle + 2] - vertices[3 * triangle]);
+        const glm::vec3 start(coordinate(random) * 3.0f,
+                coordinate(random) * 3.0f, coordinate(random) * 3.0f);
+        // also rays pointing away from everything
+        const glm::vec3 dir = (i & 7) ? target - start : start - target;
+
+        glm::vec3 hitPos;
+        const float expected = brute_force(vertices, indices, start, dir);
+        const float actual = bvh.intersect(start, dir, hitPos);
+
+        TEST_CHECK((expected > 0) == (actual > 0));
+        if ((expected > 0) && (actual > 0)) {
+            TEST_CHECK(fabsf(actual - expected) <= 1e-4f * expected);
+        } else {
+            ++miss_count;
+        }
+    }
+    TEST_CHECK(miss_count > 0);
+}
+
+static void benchmark() {
+    const int size = 64;
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+    std::mt19937 random(10);
+    std::uniform_real_distribution<float> coordinate(0.0f, (float) size);
+    std::vector<glm::vec3> starts;
+
+    make_lattice(size, vertices, indices);
+    MeshBVH bvh(vertices, indices);
+    for (int i = 0; i < 100; ++i) {
+        starts.push_back(glm::vec3(coordinate(random), coordinate(random),
+                size + 5.0f));
+    }
+
+    float sum = 0.0f;
+    const glm::vec3 dir(0.01f, 0.02f, -1.0f);
+    double brute_ms = time_ms(1, [&]() {
+        for (auto it = starts.begin(); it != starts.end(); ++it) {
+            sum += brute_force(vertices, indices, *it, dir);
+        }
+    }) / starts.size();
+    double bvh_ms = time_ms(100, [&]() {
+        for (auto it = starts.begin(); it != starts.end(); ++it) {
+            glm::vec3 hitPos;
+            sum -= bvh.intersect(*it, dir, hitPos) / 100;
+        }
+    }) / starts.size();
+
+    TEST_CHECK(fabsf(sum) < 1e-2f * starts.size());
+    printf("%d triangles: every triangle %.4f ms, hierarchy %.5f ms per ray\n",
+            bvh.triangle_count(), brute_ms, bvh_ms);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_axis_aligned_rays();
+    test_random_rays();
+    benchmark();
+    return result("mesh_bvh_test");
+}
@@ -0,0 +1,134 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Casts batches of rays with Picker::pickRays and compares the hits with
+ * testing every collider of the scene.
+ ***************************************************************************/
+
+#include <vector>
+
+#include "test_scene.h"
+#include "test_util.h"
+
+#include "engine/picker/picker.h"
+#include "objects/scene.h"
+#include "objects/scene_object.h"
+#include "objects/components/transform.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+// more than ColliderIndex::MAX_RAYS so the rays span two batches
+static const int RAY_COUNT = 40;
+
+/*
+ * Every ray of the batch gets the same hits as testing each collider,
+ * sorted by distance, and the offsets of the batch index them.
+ */
+static void test_pick_rays_order() {
+    PickScene pick_scene(200, 1);
+    std::vector<float> rays(pick_scene.rays(glm::vec3(2.0f, 3.0f, 30.0f), RAY_COUNT, 2));
+    PickBatch batch;
+    int total = 0;
+    int multiple = 0;
+
+    Picker::pickRays(pick_scene.scene(), nullptr, rays.data(), RAY_COUNT, batch);
+    TEST_CHECK(batch.ray_count() == RAY_COUNT);
+    for (int r = 0; r < RAY_COUNT; ++r) {
+        const float* ray = &rays[6 * r];
+        glm::vec3 start(ray[0], ray[1], ray[2]);
+        glm::vec3 dir(ray[3], ray[4], ray[5]);
+
+        // the picker renormalizes the direction
+        Collider::transformRay(glm::mat4(), start, dir);
+        std::vector<ColliderData> expected(pick_scene.hits(start, dir));
+
+        TEST_CHECK(batch.first_hit(r) == total);
+        TEST_CHECK(batch.hit_count(r) == expected.size());
+        if (batch.hit_count(r) != expected.size()) {
+            continue;
+        }
+        for (int h = 0; h < expected.size(); ++h) {
+            const ColliderData& hit = batch.hits()[total + h];
+
+            TEST_CHECK(hit.ColliderHit == expected[h].ColliderHit);
+            TEST_CHECK(hit.Distance == expected[h].Distance);
+            if (h > 0) {
+                TEST_CHECK(batch.hits()[total + h - 1].Distance <= hit.Distance);
+            }
+        }
+        total += expected.size();
+        multiple += (expected.size() > 1) ? 1 : 0;
+    }
+    TEST_CHECK(batch.total_hit_count() == total);
+    // the rays must actually exercise the sorting
+    TEST_CHECK(multiple > RAY_COUNT / 2);
+
+    // reusing the batch for fewer rays drops the old hits
+    Picker::pickRays(pick_scene.scene(), nullptr, rays.data(), 1, batch);
+    TEST_CHECK(batch.ray_count() == 1);
+    TEST_CHECK(batch.total_hit_count() == batch.hit_count(0));
+    Picker::pickRays(pick_scene.scene(), nullptr, rays.data(), 0, batch);
+    TEST_CHECK(batch.ray_count() == 0);
+    TEST_CHECK(batch.total_hit_count() == 0);
+}
+
+/*
+ * Rays given in the coordinates of a transform hit the same colliders
+ * as the same rays given in world coordinates.
+ */
+static void test_pick_rays_transform() {
+    PickScene pick_scene(100, 3);
+    const glm::vec3 offset(1.0f, -2.0f, 5.0f);
+    std::vector<float> world(pick_scene.rays(glm::vec3(-4.0f, 2.0f, 25.0f), RAY_COUNT, 4));
+    std::vector<float> local(world);
+    SceneObject* frame = pick_scene.objects().add(nullptr, offset,
+            glm::vec3(1.0f), false);
+    PickBatch world_batch;
+    PickBatch local_batch;
+
+    pick_scene.objects().prepare();
+    for (int r = 0; r < RAY_COUNT; ++r) {
+        local[6 * r] -= offset.x;
+        local[6 * r + 1] -= offset.y;
+        local[6 * r + 2] -= offset.z;
+    }
+    Picker::pickRays(pick_scene.scene(), nullptr, world.data(), RAY_COUNT, world_batch);
+    Picker::pickRays(pick_scene.scene(), frame->transform(), local.data(),
+            RAY_COUNT, local_batch);
+    TEST_CHECK(world_batch.total_hit_count() > 0);
+    TEST_CHECK(local_batch.total_hit_count() == world_batch.total_hit_count());
+    for (int r = 0; r < RAY_COUNT; ++r) {
+        TEST_CHECK(local_batch.hit_count(r) == world_batch.hit_count(r));
+    }
+    for (int h = 0; (h < world_batch.total_hit_count())
+            && (h < local_batch.total_hit_count()); ++h) {
+        TEST_CHECK(local_batch.hits()[h].ColliderHit == world_batch.hits()[h].ColliderHit);
+    }
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_pick_rays_order();
+    test_pick_rays_transform();
+    return result("picker_test");
+}
@@ -0,0 +1,221 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Edits the scene graph from several threads while another one renders.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "test_scene.h"
+#include "test_util.h"
+
+#include "engine/renderer/cull_list.h"
+#include "objects/scene_object.h"
+#include "objects/components/transform.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static const int EDITOR_COUNT = 4;
+static const int POOL_SIZE = 64;
+static const int EDIT_COUNT = 20000;
+
+/*
+ * Each editor owns one group below the root and a pool of objects it
+ * moves in and out of the group, checking that its own edits show up
+ * right away. Returns the children the group should end up with.
+ */
+static void edit(SceneObject* group, std::vector<SceneObject*> pool,
+        unsigned int seed, std::vector<SceneObject*>& expected) {
+    std::mt19937 random(seed);
+    std::vector<SceneObject*> detached;
+
+    expected = pool;
+    for (int i = 0; i < EDIT_COUNT; ++i) {
+        const int op = random() % 16;
+
+        if ((op == 0) && !expected.empty()) {
+            group->clear();
+            detached.insert(detached.end(), expected.begin(), expected.end());
+            expected.clear();
+        } else if ((op < 8) && !detached.empty()) {
+            const int index = random() % detached.size();
+            SceneObject* child = detached[index];
+
+            group->addChildObject(group, child);
+            detached.erase(detached.begin() + index);
+            expected.push_back(child);
+        } else if (!expected.empty()) {
+            const int index = random() % expected.size();
+            SceneObject* child = expected[index];
+
+            group->removeChildObject(child);
+            expected.erase(expected.begin() + index);
+            detached.push_back(child);
+        }
+
+        bool same = (group->getChildrenCount() == (int) expected.size());
+        for (int j = 0; same && (j < (int) expected.size()); ++j) {
+            same = (group->getChildByIndex(j) == expected[j]);
+        }
+        TEST_CHECK(same);
+    }
+}
+
+/*
+ * What the GL thread does once a frame: publish the edits, then walk
+ * the published children and cull them with a cull list.
+ */
+static void render_frame(TestScene& scene, CullList& cull_list,
+        const std::vector<SceneObject*>& groups,
+        const std::vector<std::set<SceneObject*> >& pools) {
+    scene.prepare();
+    TEST_CHECK(scene.root()->children() == groups);
+
+    int count = 1;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        const std::vector<SceneObject*>& children = groups[i]->children();
+        std::set<SceneObject*> unique(children.begin(), children.end());
+
+        // only objects from the pool of the group, each at most once,
+        // and parent() agrees with the published children
+        TEST_CHECK(unique.size() == children.size());
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            TEST_CHECK(pools[i].count(*it) == 1);
+            TEST_CHECK((*it)->children().empty());
+        }
+        for (auto it = pools[i].begin(); it != pools[i].end(); ++it) {
+            TEST_CHECK((*it)->parent() == (unique.count(*it) ? groups[i] : nullptr));
+        }
+        count += 1 + children.size();
+    }
+
+    float frustum[6][4];
+    std::vector<SceneObject*> scene_objects;
+
+    build_frustum(frustum, glm::perspective(1.0f, 1.0f, 0.1f, 100.0f));
+    cull_list.update(scene.root(), 1);
+    cull_list.cull(0, frustum, false, true, scene_objects);
+    TEST_CHECK(cull_list.size() == count);
+    TEST_CHECK((int) scene_objects.size() == count);
+}
+
+static void test_concurrent_edits() {
+    TestScene scene;
+    CullList cull_list;
+    std::vector<SceneObject*> groups;
+    std::vector<std::vector<SceneObject*> > pools(EDITOR_COUNT);
+    std::vector<std::set<SceneObject*> > pool_sets(EDITOR_COUNT);
+    std::vector<std::vector<SceneObject*> > expected(EDITOR_COUNT);
+    std::vector<std::thread> editors;
+    std::atomic<int> running(EDITOR_COUNT);
+    int frames = 0;
+
+    for (int i = 0; i < EDITOR_COUNT; ++i) {
+        SceneObject* group = scene.add(nullptr,
+                glm::vec3(10.0f * i, 0.0f, -20.0f), glm::vec3(1.0f), false);
+
+        groups.push_back(group);
+        for (int j = 0; j < POOL_SIZE; ++j) {
+            pools[i].push_back(scene.add(group,
+                    glm::vec3(j % 8, j / 8, 0.0f), glm::vec3(0.5f)));
+        }
+        pool_sets[i].insert(pools[i].begin(), pools[i].end());
+    }
+    render_frame(scene, cull_list, groups, pool_sets);
+
+    const unsigned int version = SceneObject::hierarchyVersion();
+    for (int i = 0; i < EDITOR_COUNT; ++i) {
+        editors.push_back(std::thread([&, i]() {
+            edit(groups[i], pools[i], i + 1, expected[i]);
+            --running;
+        }));
+    }
+    while (running > 0) {
+        render_frame(scene, cull_list, groups, pool_sets);
+        ++frames;
+    }
+    for (auto it = editors.begin(); it != editors.end(); ++it) {
+        it->join();
+    }
+
+    // the last frame publishes exactly what the editors ended up with
+    render_frame(scene, cull_list, groups, pool_sets);
+    for (int i = 0; i < EDITOR_COUNT; ++i) {
+        TEST_CHECK(groups[i]->children() == expected[i]);
+        for (auto it = expected[i].begin(); it != expected[i].end(); ++it) {
+            TEST_CHECK((*it)->parent() == groups[i]);
+        }
+    }
+    TEST_CHECK(SceneObject::hierarchyVersion() != version);
+    printf("%d editors, %d edits each, %d frames\n", EDITOR_COUNT, EDIT_COUNT,
+            frames);
+}
+
+/*
+ * Edits made between two frames are invisible to children() and
+ * parent(), and so to the model matrices, until the next
+ * applyPendingEdits.
+ */
+static void test_edits_wait_for_the_frame() {
+    TestScene scene;
+    SceneObject* a = scene.add(nullptr, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+    SceneObject* b = scene.add(nullptr, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f));
+    const std::vector<SceneObject*> both = { a, b };
+
+    scene.prepare();
+    TEST_CHECK(scene.root()->children() == both);
+
+    std::thread([&]() {
+        scene.root()->removeChildObject(a);
+        scene.root()->removeChildObject(b);
+        a->addChildObject(a, b);
+    }).join();
+    TEST_CHECK(scene.root()->children() == both);
+    TEST_CHECK(a->children().empty());
+    TEST_CHECK(scene.root()->getChildrenCount() == 0);
+    TEST_CHECK(a->getChildrenCount() == 1);
+    TEST_CHECK(a->parent() == scene.root());
+    TEST_CHECK(b->parent() == scene.root());
+    TEST_CHECK(glm::vec3(b->transform()->getModelMatrix()[3]) == glm::vec3(0.0f, 2.0f, 0.0f));
+
+    scene.prepare();
+    TEST_CHECK(scene.root()->children().empty());
+    TEST_CHECK(a->children() == std::vector<SceneObject*>(1, b));
+    TEST_CHECK(a->parent() == nullptr);
+    TEST_CHECK(b->parent() == a);
+    TEST_CHECK(glm::vec3(b->transform()->getModelMatrix()[3]) == glm::vec3(1.0f, 2.0f, 0.0f));
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_edits_wait_for_the_frame();
+    test_concurrent_edits();
+    return result("scene_object_edit_test");
+}
@@ -0,0 +1,259 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Occluder wall in front of a grid of boxes, culled on the CPU.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "test_scene.h"
+#include "test_util.h"
+
+#include "engine/renderer/cull_list.h"
+#include "engine/renderer/software_occlusion_culler.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+// the camera sits at the origin looking down -z
+static const float WALL_Z = -10.0f;
+static const float WALL_HALF_SIZE = 5.0f;
+
+static glm::mat4 view_projection() {
+    return glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 200.0f);
+}
+
+/*
+ * Add the wall, a square facing the camera one unit thick.
+ */
+static SceneObject* add_wall(TestScene& scene) {
+    SceneObject* wall = scene.add(nullptr, glm::vec3(0.0f, 0.0f, WALL_Z),
+            glm::vec3(2.0f * WALL_HALF_SIZE, 2.0f * WALL_HALF_SIZE, 1.0f));
+    wall->render_data()->set_occluder(true);
+    return wall;
+}
+
+/*
+ * True if the box is behind the front face of the wall and its
+ * projection onto that face is inside the wall.
+ */
+static bool behind_wall(const glm::vec3& min_corner,
+        const glm::vec3& max_corner) {
+    const float front = WALL_Z + 0.5f;
+
+    if (max_corner.z >= front) {
+        return false;
+    }
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 p((corner & 1) ? max_corner.x : min_corner.x,
+                (corner & 2) ? max_corner.y : min_corner.y,
+                (corner & 4) ? max_corner.z : min_corner.z);
+        const float scale = front / p.z;
+
+        if ((fabsf(p.x * scale) > WALL_HALF_SIZE)
+                || (fabsf(p.y * scale) > WALL_HALF_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Frustum cull the scene with the cull list, then occlusion cull it.
+ */
+static void cull(TestScene& scene, SoftwareOcclusionCuller& culler,
+        std::vector<SceneObject*>& scene_objects) {
+    const glm::mat4 vp_matrix = view_projection();
+    float frustum[6][4];
+    CullList cull_list;
+
+    scene.prepare();
+    cull_list.update(scene.root(), 1);
+    build_frustum(frustum, vp_matrix);
+    scene_objects.clear();
+    cull_list.cull(0, frustum, true, true, scene_objects);
+    culler.cull(vp_matrix, scene_objects);
+}
+
+static bool contains(const std::vector<SceneObject*>& scene_objects,
+        SceneObject* object) {
+    return std::find(scene_objects.begin(), scene_objects.end(), object)
+            != scene_objects.end();
+}
+
+static void test_wall_hides_grid() {
+    TestScene scene;
+    SoftwareOcclusionCuller culler;
+    std::vector<SceneObject*> hidden;
+    std::vector<SceneObject*> shown;
+    std::vector<SceneObject*> scene_objects;
+    SceneObject* wall = add_wall(scene);
+
+    // well inside the shadow of the wall
+    for (int x = -5; x <= 5; ++x) {
+        for (int y = -5; y <= 5; ++y) {
+            hidden.push_back(scene.add(nullptr,
+                    glm::vec3(2.0f * x, 2.0f * y, -30.0f), glm::vec3(1.0f)));
+        }
+    }
+    // in front of the wall, beside it and crossing its edges
+    for (int y = -5; y <= 5; ++y) {
+        shown.push_back(scene.add(nullptr, glm::vec3(0.0f, 0.4f * y, -5.0f),
+                glm::vec3(0.3f)));
+        shown.push_back(scene.add(nullptr, glm::vec3(25.0f, 2.0f * y, -30.0f),
+                glm::vec3(1.0f)));
+        shown.push_back(scene.add(nullptr, glm::vec3(-25.0f, 2.0f * y, -30.0f),
+                glm::vec3(1.0f)));
+    }
+    shown.push_back(scene.add(nullptr, glm::vec3(15.0f, 0.0f, -30.0f),
+            glm::vec3(1.0f)));
+    shown.push_back(scene.add(nullptr, glm::vec3(0.0f, -15.0f, -30.0f),
+            glm::vec3(1.0f)));
+
+    cull(scene, culler, scene_objects);
+
+    TEST_CHECK(culler.occluder_triangles() == 12);
+    TEST_CHECK(culler.occluded_count() == (int) hidden.size());
+    TEST_CHECK(contains(scene_objects, wall));
+    for (auto it = hidden.begin(); it != hidden.end(); ++it) {
+        TEST_CHECK(!contains(scene_objects, *it));
+    }
+    for (auto it = shown.begin(); it != shown.end(); ++it) {
+        TEST_CHECK(contains(scene_objects, *it));
+    }
+
+    // the wall covers the middle of the depth buffer, not the corners
+    const std::vector<float>& depth = culler.depth();
+    const int width = culler.width();
+    const int height = culler.height();
+    TEST_CHECK(depth[(height / 2) * width + width / 2] < 1.0f);
+    TEST_CHECK(depth[0] == 1.0f);
+    TEST_CHECK(depth[width * height - 1] == 1.0f);
+
+    // without an occluder nothing is removed
+    wall->render_data()->set_occluder(false);
+    cull(scene, culler, scene_objects);
+    TEST_CHECK(culler.occluded_count() == 0);
+    TEST_CHECK(scene_objects.size() == hidden.size() + shown.size() + 1);
+}
+
+/*
+ * Random boxes around the wall. A box may only be removed if it is
+ * really hidden, and the boxes well inside its shadow must be removed.
+ */
+static void test_never_hides_visible_boxes() {
+    std::mt19937 random(8);
+    std::uniform_real_distribution<float> lateral(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> distance(-60.0f, -2.0f);
+    std::uniform_real_distribution<float> size(0.1f, 3.0f);
+    TestScene scene;
+    SoftwareOcclusionCuller culler;
+    std::vector<SceneObject*> boxes;
+    std::vector<SceneObject*> scene_objects;
+    int well_hidden = 0;
+
+    add_wall(scene);
+    for (int i = 0; i < 5000; ++i) {
+        boxes.push_back(scene.add(nullptr,
+                glm::vec3(lateral(random), lateral(random), distance(random)),
+                glm::vec3(size(random))));
+    }
+
+    cull(scene, culler, scene_objects);
+    for (auto it = boxes.begin(); it != boxes.end(); ++it) {
+        const BoundingVolume& bv = (*it)->getMeshBoundingVolume();
+        const glm::vec3 margin(0.5f);
+
+        if (!(*it)->isCulled() && !contains(scene_objects, *it)) {
+            TEST_CHECK(behind_wall(bv.min_corner(), bv.max_corner()));
+        }
+        // a pixel of margin around the box
+        if (behind_wall(bv.min_corner() - margin, bv.max_corner() + margin)
+                && (bv.max_corner().z < WALL_Z - 2.0f)) {
+            TEST_CHECK(!contains(scene_objects, *it));
+            ++well_hidden;
+        }
+    }
+    TEST_CHECK(well_hidden > 0);
+}
+
+/*
+ * Time the occlusion cull of a large grid behind a wall of many
+ * occluders.
+ */
+static void benchmark() {
+    TestScene scene;
+    SoftwareOcclusionCuller culler;
+    std::vector<SceneObject*> visible;
+    std::vector<SceneObject*> scene_objects;
+    const glm::mat4 vp_matrix = view_projection();
+    float frustum[6][4];
+    CullList cull_list;
+
+    // a wall of 32 x 16 bricks
+    for (int x = 0; x < 32; ++x) {
+        for (int y = 0; y < 16; ++y) {
+            SceneObject* brick = scene.add(nullptr,
+                    glm::vec3(-15.5f + x, -7.5f + y, WALL_Z),
+                    glm::vec3(1.0f));
+            brick->render_data()->set_occluder(true);
+        }
+    }
+    for (int x = 0; x < 100; ++x) {
+        for (int y = 0; y < 100; ++y) {
+            scene.add(nullptr, glm::vec3(-24.75f + 0.5f * x,
+                    -12.375f + 0.25f * y, -40.0f), glm::vec3(0.2f));
+        }
+    }
+    scene.prepare();
+    cull_list.update(scene.root(), 1);
+    build_frustum(frustum, vp_matrix);
+    cull_list.cull(0, frustum, true, true, visible);
+
+    double ms = time_ms(20, [&]() {
+        scene_objects = visible;
+        culler.cull(vp_matrix, scene_objects);
+    });
+
+    // the grid is entirely in the shadow of the wall
+    TEST_CHECK(culler.occluded_count() == 100 * 100);
+    TEST_CHECK(scene_objects.size() + culler.occluded_count()
+            == visible.size());
+    printf("%d triangles, %d of %d objects occluded in %.3f ms\n",
+            culler.occluder_triangles(), culler.occluded_count(),
+            (int) visible.size(), ms);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_wall_hides_grid();
+    test_never_hides_visible_boxes();
+    benchmark();
+    return result("software_occlusion_culler_test");
+}
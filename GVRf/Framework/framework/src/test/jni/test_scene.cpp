@@ -0,0 +1,225 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Scene graphs built on the host for the native unit tests.
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "test_scene.h"
+
+#include "objects/material.h"
+#include "objects/mesh.h"
+#include "objects/render_pass.h"
+#include "objects/scene_object.h"
+#include "objects/components/render_data.h"
+#include "objects/components/sphere_collider.h"
+#include "objects/components/transform.h"
+
+namespace gvr {
+namespace test {
+
+TestScene::TestScene() :
+        root_(new SceneObject()), box_(new Mesh()),
+        material_(new Material(Material::TEXTURE_SHADER)) {
+    root_->attachComponent(new Transform());
+    objects_.push_back(root_);
+
+    std::vector<glm::vec3> vertices;
+    for (int i = 0; i < 8; ++i) {
+        vertices.push_back(glm::vec3((i & 1) ? 0.5f : -0.5f,
+                (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+    }
+    static const unsigned short triangles[] = {
+        0, 2, 1, 1, 2, 3, // -z
+        4, 5, 6, 5, 7, 6, // +z
+        0, 1, 4, 1, 5, 4, // -y
+        2, 6, 3, 3, 6, 7, // +y
+        0, 4, 2, 2, 4, 6, // -x
+        1, 3, 5, 3, 7, 5  // +x
+    };
+    box_->set_vertices(std::move(vertices));
+    box_->set_triangles(std::vector<unsigned short>(triangles,
+            triangles + sizeof(triangles) / sizeof(triangles[0])));
+}
+
+TestScene::~TestScene() {
+    for (auto it = objects_.begin(); it != objects_.end(); ++it) {
+        delete (*it)->transform();
+    }
+    for (auto it = objects_.rbegin(); it != objects_.rend(); ++it) {
+        delete *it;
+    }
+    for (auto it = render_datas_.begin(); it != render_datas_.end(); ++it) {
+        delete *it;
+    }
+    for (auto it = render_passes_.begin(); it != render_passes_.end();
+            ++it) {
+        delete *it;
+    }
+    delete material_;
+    delete box_;
+}
+
+SceneObject* TestScene::add(SceneObject* parent, const glm::vec3& position,
+        const glm::vec3& scale, bool render_data) {
+    SceneObject* object = new SceneObject();
+    Transform* transform = new Transform();
+
+    object->attachComponent(transform);
+    transform->set_position(position);
+    transform->set_scale(scale);
+    if (render_data) {
+        RenderData* rdata = new RenderData();
+        RenderPass* pass = new RenderPass();
+
+        pass->set_material(material_);
+        rdata->add_pass(pass);
+        rdata->set_mesh(box_);
+        object->attachComponent(rdata);
+        render_datas_.push_back(rdata);
+        render_passes_.push_back(pass);
+    }
+    if (nullptr == parent) {
+        parent = root_;
+    }
+    parent->addChildObject(parent, object);
+    objects_.push_back(object);
+    return object;
+}
+
+void TestScene::addGroups(int count, int group_size, float size,
+        unsigned int seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-0.5f * size,
+            0.5f * size);
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> scale(0.25f, 1.0f);
+
+    for (int i = 0; i < count;) {
+        // every group is an empty node with boxes around its position
+        SceneObject* group = add(nullptr,
+                glm::vec3(position(random), position(random),
+                        position(random)), glm::vec3(1.0f), false);
+        ++i;
+        for (int j = 1; (j < group_size) && (i < count); ++j, ++i) {
+            add(group, glm::vec3(offset(random), offset(random),
+                    offset(random)), glm::vec3(scale(random)));
+        }
+    }
+}
+
+void TestScene::prepare(Scene* scene) {
+    SceneObject::applyPendingEdits();
+    transform_list_.update(root_, nullptr);
+    if (nullptr != scene) {
+        scene->updateColliderIndex();
+    }
+    transform_list_.refitBounds();
+}
+
+PickScene::PickScene(int count, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-8.0f, 8.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    // attached colliders register with the main scene
+    Scene::set_main_scene(&scene_);
+    scene_.setPickVisible(false);
+    scene_.addSceneObject(objects_.root());
+    for (int i = 0; i < count; ++i) {
+        SceneObject* object = objects_.add(nullptr,
+                glm::vec3(position(random), position(random),
+                        position(random)), glm::vec3(scale(random)));
+        colliders_.emplace_back(new SphereCollider());
+        object->attachComponent(colliders_.back().get());
+        centers_.push_back(object->transform()->position());
+    }
+    objects_.prepare(&scene_);
+}
+
+PickScene::~PickScene() {
+    scene_.removeSceneObject(objects_.root());
+    SceneObject::applyPendingEdits();
+}
+
+void PickScene::deleteCollider(int i) {
+    SphereCollider* collider = colliders_[i].get();
+
+    // waits for the picks which may still test the collider
+    collider->owner_object()->detachComponent(collider);
+    colliders_[i].reset();
+}
+
+std::vector<ColliderData> PickScene::hits(const glm::vec3& start,
+        const glm::vec3& dir) const {
+    std::vector<ColliderData> hits;
+
+    for (auto it = colliders_.begin(); it != colliders_.end(); ++it) {
+        if (nullptr == *it) {
+            continue;
+        }
+        ColliderData data = (*it)->isHit(start, dir);
+        if (data.IsHit) {
+            hits.push_back(data);
+        }
+    }
+    std::sort(hits.begin(), hits.end(),
+            [](const ColliderData& a, const ColliderData& b) {
+                return a.Distance < b.Distance;
+            });
+    return hits;
+}
+
+std::vector<float> PickScene::rays(const glm::vec3& start, int ray_count,
+        unsigned int seed) const {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    std::vector<float> rays;
+
+    for (int i = 0; i < ray_count; ++i) {
+        glm::vec3 target(centers_[i % centers_.size()]
+                + glm::vec3(jitter(random), jitter(random), jitter(random)));
+        glm::vec3 dir(glm::normalize(target - start));
+        rays.insert(rays.end(), { start.x, start.y, start.z, dir.x, dir.y, dir.z });
+    }
+    return rays;
+}
+
+void build_frustum(float frustum[6][4], const glm::mat4& vp_matrix) {
+    const float* m = &vp_matrix[0][0];
+    // right, left, bottom, top, far, near
+    static const int rows[6] = { 0, 0, 1, 1, 2, 2 };
+    static const float signs[6] = { -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f };
+
+    for (int p = 0; p < 6; ++p) {
+        for (int c = 0; c < 4; ++c) {
+            frustum[p][c] = m[c * 4 + 3] + signs[p] * m[c * 4 + rows[p]];
+        }
+
+        float t = sqrt(frustum[p][0] * frustum[p][0]
+                + frustum[p][1] * frustum[p][1]
+                + frustum[p][2] * frustum[p][2]);
+        for (int c = 0; c < 4; ++c) {
+            frustum[p][c] /= t;
+        }
+    }
+}
+
+}
+}
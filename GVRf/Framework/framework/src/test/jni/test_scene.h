@@ -0,0 +1,164 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Scene graphs built on the host for the native unit tests.
+ ***************************************************************************/
+
+#ifndef TEST_SCENE_H_
+#define TEST_SCENE_H_
+
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "engine/renderer/transform_list.h"
+#include "objects/scene.h"
+
+namespace gvr {
+class Material;
+class Mesh;
+class RenderData;
+class ColliderData;
+class RenderPass;
+class SceneObject;
+class SphereCollider;
+
+namespace test {
+
+/*
+ * Owns a scene graph of unit boxes and deletes it again.
+ * All the objects share one box mesh and one material.
+ */
+class TestScene {
+public:
+    TestScene();
+    ~TestScene();
+
+    SceneObject* root() const {
+        return root_;
+    }
+
+    Mesh* box() const {
+        return box_;
+    }
+
+    const std::vector<SceneObject*>& objects() const {
+        return objects_;
+    }
+
+    /*
+     * Add an object with a transform under parent, which defaults to
+     * the root. Objects with a render data draw the unit box.
+     */
+    SceneObject* add(SceneObject* parent, const glm::vec3& position,
+            const glm::vec3& scale, bool render_data = true);
+
+    /*
+     * Add count objects in groups of group_size below the root, spread
+     * at random over a cube of the given size around the origin.
+     */
+    void addGroups(int count, int group_size, float size,
+            unsigned int seed);
+
+    /*
+     * Publish the pending edits and bring the model matrices and the
+     * bounding volumes up to date, as Renderer::prepareCull does. The
+     * collider index of the scene, if any, is updated in between.
+     */
+    void prepare(Scene* scene = nullptr);
+
+private:
+    TestScene(const TestScene& test_scene);
+    TestScene(TestScene&& test_scene);
+    TestScene& operator=(const TestScene& test_scene);
+    TestScene& operator=(TestScene&& test_scene);
+
+    SceneObject* root_;
+    Mesh* box_;
+    Material* material_;
+    std::vector<SceneObject*> objects_;
+    std::vector<RenderData*> render_datas_;
+    std::vector<RenderPass*> render_passes_;
+    TransformList transform_list_;
+};
+
+/*
+ * Boxes with a sphere collider each, spread at random over a cube of
+ * size 16 around the origin, below a scene which is made the main scene
+ * and whose collider index is up to date.
+ */
+class PickScene {
+public:
+    PickScene(int count, unsigned int seed);
+    ~PickScene();
+
+    Scene* scene() {
+        return &scene_;
+    }
+
+    TestScene& objects() {
+        return objects_;
+    }
+
+    const std::vector<glm::vec3>& centers() const {
+        return centers_;
+    }
+
+    SphereCollider* collider(int i) const {
+        return colliders_[i].get();
+    }
+
+    /*
+     * Detach the i-th collider from its object and delete it.
+     */
+    void deleteCollider(int i);
+
+    /*
+     * All the hits of a world space ray found by testing every collider
+     * not deleted yet, nearest first.
+     */
+    std::vector<ColliderData> hits(const glm::vec3& start,
+            const glm::vec3& dir) const;
+
+    /*
+     * Rays from start aimed near the box centers in turn, as origin
+     * x, y, z and direction x, y, z.
+     */
+    std::vector<float> rays(const glm::vec3& start, int ray_count,
+            unsigned int seed) const;
+
+private:
+    PickScene(const PickScene& pick_scene);
+    PickScene(PickScene&& pick_scene);
+    PickScene& operator=(const PickScene& pick_scene);
+    PickScene& operator=(PickScene&& pick_scene);
+
+    // the colliders outlive the objects they are attached to
+    std::vector<std::unique_ptr<SphereCollider>> colliders_;
+    TestScene objects_;
+    Scene scene_;
+    std::vector<glm::vec3> centers_;
+};
+
+/*
+ * Same planes as Renderer::build_frustum.
+ */
+void build_frustum(float frustum[6][4], const glm::mat4& vp_matrix);
+
+}
+}
+#endif
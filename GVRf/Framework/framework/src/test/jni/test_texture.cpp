@@ -0,0 +1,87 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Texture standing in for the Java textures in the native unit tests.
+ ***************************************************************************/
+
+#include "test_texture.h"
+
+#include "objects/textures/texture_uploader.h"
+
+namespace gvr {
+namespace test {
+
+static GLTexture* newGLTexture(GLenum min_filter) {
+    int parameters[MAX_TEXTURE_PARAM_NUM] = { (int) min_filter, GL_LINEAR, 1,
+            GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+    return new GLTexture(GL_TEXTURE_2D, parameters);
+}
+
+TestTexture::TestTexture(int width, int height, GLenum min_filter) :
+        Texture(newGLTexture(min_filter)), width_(width), height_(height),
+        filled_(false), low_bytes_(0), eviction_log_(nullptr) {
+    setReady(true);
+}
+
+TestTexture::~TestTexture() {
+    TextureUploader::getInstance().cancel(this);
+}
+
+void TestTexture::fill(unsigned int color) {
+    std::vector<unsigned int> pixels(width_ * height_, color);
+
+    TextureAtlas::getInstance().remove(this);
+    glBindTexture(GL_TEXTURE_2D, getId());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    filled_ = true;
+    setGpuBytes((size_t) width_ * height_ * 4);
+}
+
+bool TestTexture::evict() {
+    if ((nullptr == eviction_log_) || (gpu_bytes() <= low_bytes_)) {
+        return false;
+    }
+    setGpuBytes(low_bytes_);
+    eviction_log_->push_back(this);
+    return true;
+}
+
+unsigned int readTexel(GLuint texture, int level, int layer, int x, int y) {
+    GLuint framebuffer = 0;
+    unsigned char rgba[4] = { };
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (layer < 0) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                texture, level);
+    } else {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture,
+                level, layer);
+    }
+    if (GL_FRAMEBUFFER_COMPLETE == glCheckFramebufferStatus(GL_FRAMEBUFFER)) {
+        glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    return rgba[0] | (rgba[1] << 8) | (rgba[2] << 16) | ((unsigned int) rgba[3] << 24);
+}
+
+}
+}
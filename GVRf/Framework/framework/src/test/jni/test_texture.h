@@ -0,0 +1,105 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Texture standing in for the Java textures in the native unit tests.
+ ***************************************************************************/
+
+#ifndef TEST_TEXTURE_H_
+#define TEST_TEXTURE_H_
+
+#include <vector>
+
+#include "objects/textures/texture.h"
+
+namespace gvr {
+namespace test {
+
+/*
+ * A 2D texture like the bitmap textures uploaded from Java, which
+ * records what the uploader and the residency ask of it. Only fill()
+ * and the destructor need GL.
+ */
+class TestTexture: public Texture {
+public:
+    TestTexture(int width, int height, GLenum min_filter = GL_LINEAR);
+    virtual ~TestTexture();
+
+    GLenum getTarget() const {
+        return GL_TEXTURE_2D;
+    }
+
+    int width() const {
+        return width_;
+    }
+
+    int height() const {
+        return height_;
+    }
+
+    // same rule as BaseTexture once a bitmap has been uploaded
+    bool atlasable() const {
+        return filled_ && (width_ <= TextureAtlas::MAX_SIZE)
+                && (height_ <= TextureAtlas::MAX_SIZE);
+    }
+
+    /*
+     * Upload an RGBA8 image of a single color, 0xAABBGGRR, and report
+     * its size to the residency as a bitmap upload does.
+     */
+    void fill(unsigned int color);
+
+    // report the size of the texture without uploading anything
+    void reportBytes(size_t bytes) {
+        setGpuBytes(bytes);
+    }
+
+    /*
+     * Let evict() drop the texture to low_bytes, appending it to log.
+     */
+    void setEvictable(size_t low_bytes, std::vector<TestTexture*>* log) {
+        low_bytes_ = low_bytes;
+        eviction_log_ = log;
+    }
+
+    virtual bool evict();
+
+    virtual void levelUploaded(int level) {
+        uploaded_levels_.push_back(level);
+    }
+
+    const std::vector<int>& uploaded_levels() const {
+        return uploaded_levels_;
+    }
+
+private:
+    int width_;
+    int height_;
+    bool filled_;
+    size_t low_bytes_;
+    std::vector<TestTexture*>* eviction_log_;
+    std::vector<int> uploaded_levels_;
+};
+
+/*
+ * The texel at x, y of a level of a 2D texture, or of a layer of an
+ * array texture if layer is not negative, as 0xAABBGGRR. Needs GL.
+ */
+unsigned int readTexel(GLuint texture, int level, int layer, int x, int y);
+
+}
+}
+#endif
@@ -0,0 +1,83 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Checks and timing shared by the native unit tests.
+ ***************************************************************************/
+
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <chrono>
+#include <cstdio>
+
+namespace gvr {
+namespace test {
+
+/*
+ * Number of failed checks so far, main() returns non zero if any.
+ */
+extern int failures;
+
+inline void fail(const char* file, int line, const char* condition) {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+    ++failures;
+}
+
+inline int result(const char* test_name) {
+    if (failures) {
+        printf("%s: %d checks FAILED\n", test_name, failures);
+        return 1;
+    }
+    printf("%s: passed\n", test_name);
+    return 0;
+}
+
+/*
+ * Exit code ctest counts as a skipped test, for tests which need
+ * something the host does not have.
+ */
+static const int SKIPPED = 77;
+
+inline int skipped(const char* test_name) {
+    printf("%s: skipped\n", test_name);
+    return SKIPPED;
+}
+
+/*
+ * Milliseconds per call of func, averaged over the given repeat count.
+ */
+template <class Func>
+double time_ms(int repeat, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        func();
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeat;
+}
+
+}
+}
+
+#define TEST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            gvr::test::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#endif
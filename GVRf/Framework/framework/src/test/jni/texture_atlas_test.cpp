@@ -0,0 +1,211 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Copies small textures into array layers with TextureAtlas on a real
+ * GL context and reads the layers back.
+ ***************************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "host/host_gl.h"
+#include "test_texture.h"
+#include "test_util.h"
+
+#include "objects/material.h"
+#include "objects/textures/texture_array.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+typedef std::vector<std::unique_ptr<TestTexture>> TestTextures;
+
+static unsigned int color(int i) {
+    return 0xff000000u | (i * 0x0f0703u);
+}
+
+static TestTexture* filled(int size, unsigned int color, GLenum min_filter = GL_LINEAR) {
+    TestTexture* texture = new TestTexture(size, size, min_filter);
+
+    texture->fill(color);
+    TextureAtlas::getInstance().request(texture);
+    return texture;
+}
+
+static bool holds(Texture* texture, unsigned int color) {
+    return (nullptr != texture->atlas())
+            && (readTexel(texture->atlas()->getId(), 0, texture->atlas_layer(), 0, 0) == color)
+            && (readTexel(texture->atlas()->getId(), 0, texture->atlas_layer(),
+                    texture->atlas()->width() - 1, texture->atlas()->height() - 1) == color);
+}
+
+/*
+ * Textures of the same size and parameters share an array until it
+ * is full, each layer holding the pixels of its texture.
+ */
+static void test_layers() {
+    TestTextures textures;
+
+    for (int i = 0; i <= TextureAtlas::LAYERS_PER_ARRAY; ++i) {
+        textures.emplace_back(filled(16, color(i)));
+    }
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+
+    TextureArray* array = textures[0]->atlas();
+    TEST_CHECK(nullptr != array);
+    if (nullptr == array) {
+        return;
+    }
+    TEST_CHECK(array->used_layers() == TextureAtlas::LAYERS_PER_ARRAY);
+    for (int i = 0; i < TextureAtlas::LAYERS_PER_ARRAY; ++i) {
+        TEST_CHECK(textures[i]->atlas() == array);
+        TEST_CHECK(textures[i]->atlas_layer() == i);
+        TEST_CHECK(holds(textures[i].get(), color(i)));
+    }
+
+    // the 17th starts a new array
+    TestTexture* last = textures.back().get();
+    TEST_CHECK((nullptr != last->atlas()) && (last->atlas() != array));
+    TEST_CHECK(last->atlas_layer() == 0);
+    TEST_CHECK(holds(last, color(TextureAtlas::LAYERS_PER_ARRAY)));
+
+    // the copies are what a sampler sees at every level
+    const int levels = 5;
+    TEST_CHECK(readTexel(array->getId(), levels - 1, 3, 0, 0) == color(3));
+
+    // a freed layer is reused by the next texture
+    textures[3].reset();
+    TEST_CHECK(array->used_layers() == TextureAtlas::LAYERS_PER_ARRAY - 1);
+    textures[3].reset(filled(16, 0xff00ff00u));
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(textures[3]->atlas() == array);
+    TEST_CHECK(textures[3]->atlas_layer() == 3);
+    TEST_CHECK(holds(textures[3].get(), 0xff00ff00u));
+
+    // new pixels leave the array until the texture is copied again
+    textures[5]->fill(0xffff0000u);
+    TEST_CHECK(nullptr == textures[5]->atlas());
+    TextureAtlas::getInstance().request(textures[5].get());
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(holds(textures[5].get(), 0xffff0000u));
+
+    // an array without layers in use is deleted at the next update
+    const GLuint last_array = last->atlas()->getId();
+    textures.pop_back();
+    TEST_CHECK(glIsTexture(last_array));
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(!glIsTexture(last_array));
+    TEST_CHECK(glIsTexture(array->getId()));
+}
+
+static void test_separate_arrays() {
+    std::unique_ptr<TestTexture> small(filled(16, color(1)));
+    std::unique_ptr<TestTexture> large(filled(32, color(2)));
+    std::unique_ptr<TestTexture> nearest(filled(16, color(3), GL_NEAREST));
+    std::unique_ptr<TestTexture> too_large(filled(TextureAtlas::MAX_SIZE * 2, color(4)));
+    std::unique_ptr<TestTexture> empty(new TestTexture(16, 16));
+
+    TextureAtlas::getInstance().request(empty.get());
+    TextureAtlas::getInstance().update();
+
+    TEST_CHECK(holds(small.get(), color(1)));
+    TEST_CHECK(holds(large.get(), color(2)));
+    TEST_CHECK(holds(nearest.get(), color(3)));
+    TEST_CHECK(small->atlas() != large->atlas());
+    TEST_CHECK(small->atlas() != nearest->atlas());
+    TEST_CHECK(large->atlas()->width() == 32);
+    TEST_CHECK(nullptr == too_large->atlas());
+    TEST_CHECK(nullptr == empty->atlas());
+}
+
+/*
+ * A texture which can not be attached to a framebuffer is not copied,
+ * nor requested again until its pixels change.
+ */
+static void test_rejected() {
+    std::unique_ptr<TestTexture> texture(filled(16, color(1)));
+    std::vector<unsigned char> luminance(16 * 16, 0x80);
+
+    glBindTexture(GL_TEXTURE_2D, texture->getId());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 16, 16, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+            luminance.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(nullptr == texture->atlas());
+
+    std::vector<unsigned int> rgba(16 * 16, color(1));
+    glBindTexture(GL_TEXTURE_2D, texture->getId());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    TextureAtlas::getInstance().request(texture.get());
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(nullptr == texture->atlas());
+
+    texture->fill(color(2));
+    TextureAtlas::getInstance().request(texture.get());
+    TextureAtlas::getInstance().update();
+    TEST_CHECK(holds(texture.get(), color(2)));
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+}
+
+/*
+ * Texture shader materials request their main texture and batch once
+ * it has been copied, each drawing its own layer.
+ */
+static void test_materials() {
+    std::unique_ptr<TestTexture> texture_a(new TestTexture(16, 16));
+    std::unique_ptr<TestTexture> texture_b(new TestTexture(16, 16));
+    Material a(Material::TEXTURE_SHADER);
+    Material b(Material::TEXTURE_SHADER);
+
+    texture_a->fill(color(1));
+    texture_b->fill(color(2));
+    a.setTexture("main_texture", texture_a.get());
+    b.setTexture("main_texture", texture_b.get());
+    a.updateBatchKey();
+    b.updateBatchKey();
+    TEST_CHECK(!a.batchEquals(b));
+
+    TextureAtlas::getInstance().update();
+    a.updateBatchKey();
+    b.updateBatchKey();
+    TEST_CHECK(a.batchEquals(b) && (a.batch_key() == b.batch_key()));
+    TEST_CHECK(a.batch_atlas() == texture_a->atlas());
+    TEST_CHECK(a.batch_layer() != b.batch_layer());
+    TEST_CHECK(holds(texture_b.get(), color(2)));
+    TEST_CHECK(readTexel(b.batch_atlas()->getId(), 0, b.batch_layer(), 0, 0) == color(2));
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    if (!makeGLContextCurrent()) {
+        return skipped("texture_atlas_test");
+    }
+    test_layers();
+    test_separate_arrays();
+    test_rejected();
+    test_materials();
+    gvr::TextureAtlas::getInstance().update();
+    return result("texture_atlas_test");
+}
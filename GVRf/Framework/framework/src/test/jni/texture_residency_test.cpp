@@ -0,0 +1,192 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Checks the order and the extent of the evictions TextureResidency
+ * makes to keep the textures within the budget.
+ ***************************************************************************/
+
+#include <vector>
+
+#include "test_texture.h"
+#include "test_util.h"
+
+#include "objects/textures/texture_residency.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static const size_t TEXTURE_BYTES = 1000;
+static const size_t LOW_BYTES = 100;
+
+/*
+ * Start frames without a budget, so nothing is evicted on the way.
+ */
+static void advance(int frames) {
+    TextureResidency& residency = TextureResidency::getInstance();
+    const size_t budget = residency.budget();
+
+    residency.set_budget(0);
+    for (int i = 0; i < frames; ++i) {
+        residency.update();
+    }
+    residency.set_budget(budget);
+}
+
+/*
+ * Run the frame which evicts with the given budget.
+ */
+static void evictTo(size_t budget) {
+    TextureResidency& residency = TextureResidency::getInstance();
+
+    residency.set_budget(budget);
+    residency.update();
+    residency.set_budget(0);
+}
+
+static void test_bytes() {
+    TextureResidency& residency = TextureResidency::getInstance();
+    const size_t resident = residency.resident_bytes();
+
+    {
+        TestTexture a(16, 16);
+        TestTexture b(16, 16);
+
+        a.reportBytes(TEXTURE_BYTES);
+        b.reportBytes(2 * TEXTURE_BYTES);
+        TEST_CHECK(residency.resident_bytes() == resident + 3 * TEXTURE_BYTES);
+        b.reportBytes(TEXTURE_BYTES);
+        TEST_CHECK(residency.resident_bytes() == resident + 2 * TEXTURE_BYTES);
+        a.reportBytes(0);
+        TEST_CHECK(residency.resident_bytes() == resident + TEXTURE_BYTES);
+    }
+    // destroyed textures stop counting
+    TEST_CHECK(residency.resident_bytes() == resident);
+}
+
+static void test_within_budget() {
+    TextureResidency& residency = TextureResidency::getInstance();
+    std::vector<TestTexture*> evicted;
+    TestTexture a(16, 16);
+    TestTexture b(16, 16);
+
+    a.reportBytes(TEXTURE_BYTES);
+    a.setEvictable(LOW_BYTES, &evicted);
+    b.reportBytes(TEXTURE_BYTES);
+    b.setEvictable(LOW_BYTES, &evicted);
+    advance(100);
+
+    // no budget
+    residency.update();
+    TEST_CHECK(evicted.empty() && (residency.evicted_count() == 0));
+
+    // exactly at the budget
+    evictTo(residency.resident_bytes());
+    TEST_CHECK(evicted.empty() && (residency.evicted_count() == 0));
+    TEST_CHECK(a.gpu_bytes() == TEXTURE_BYTES);
+}
+
+/*
+ * The least recently used textures go first and only until the total
+ * fits, textures bound in the last RECENT_FRAMES frames stay.
+ */
+static void test_lru_order() {
+    TextureResidency& residency = TextureResidency::getInstance();
+    const size_t resident = residency.resident_bytes();
+    std::vector<TestTexture*> evicted;
+    TestTexture a(16, 16);
+    TestTexture b(16, 16);
+    TestTexture c(16, 16);
+    TestTexture d(16, 16);
+    TestTexture* all[] = { &a, &b, &c, &d };
+
+    for (TestTexture* texture : all) {
+        texture->reportBytes(TEXTURE_BYTES);
+        texture->setEvictable(LOW_BYTES, &evicted);
+    }
+
+    c.markUsed();
+    advance(5);
+    a.markUsed();
+    advance(5);
+    d.markUsed();
+    advance(30);
+    b.markUsed();
+    advance(5);
+
+    // two evictions bring 4000 bytes under 2300
+    evictTo(resident + 2300);
+    TEST_CHECK(residency.evicted_count() == 2);
+    TEST_CHECK((evicted.size() == 2) && (evicted[0] == &c) && (evicted[1] == &a));
+    TEST_CHECK(residency.resident_bytes() == resident + 2 * TEXTURE_BYTES + 2 * LOW_BYTES);
+
+    // c and a have nothing left to give, b was bound recently
+    evicted.clear();
+    evictTo(resident + TEXTURE_BYTES);
+    TEST_CHECK(residency.evicted_count() == 1);
+    TEST_CHECK((evicted.size() == 1) && (evicted[0] == &d));
+    TEST_CHECK(b.gpu_bytes() == TEXTURE_BYTES);
+
+    // until it has not been bound for more than 30 frames, each
+    // update() above started one
+    evicted.clear();
+    advance(22);
+    evictTo(resident + TEXTURE_BYTES);
+    TEST_CHECK(evicted.empty());
+    evictTo(resident + TEXTURE_BYTES);
+    TEST_CHECK((evicted.size() == 1) && (evicted[0] == &b));
+    TEST_CHECK(residency.resident_bytes() == resident + 4 * LOW_BYTES);
+}
+
+/*
+ * Textures which cannot reload their pixels keep their memory and the
+ * eviction moves on to the next one.
+ */
+static void test_not_evictable() {
+    TextureResidency& residency = TextureResidency::getInstance();
+    const size_t resident = residency.resident_bytes();
+    std::vector<TestTexture*> evicted;
+    TestTexture bitmap(16, 16);
+    TestTexture streamed(16, 16);
+
+    bitmap.reportBytes(TEXTURE_BYTES);
+    bitmap.markUsed();
+    advance(1);
+    streamed.reportBytes(TEXTURE_BYTES);
+    streamed.setEvictable(LOW_BYTES, &evicted);
+    streamed.markUsed();
+    advance(100);
+
+    evictTo(resident + TEXTURE_BYTES);
+    TEST_CHECK(residency.evicted_count() == 1);
+    TEST_CHECK((evicted.size() == 1) && (evicted[0] == &streamed));
+    TEST_CHECK(bitmap.gpu_bytes() == TEXTURE_BYTES);
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    test_bytes();
+    test_within_budget();
+    test_lru_order();
+    test_not_evictable();
+    return result("texture_residency_test");
+}
@@ -0,0 +1,204 @@
+/* Copyright 2015 Samsung Electronics Co., LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/***************************************************************************
+ * Uploads images with the TextureUploader on a real GL context and checks
+ * the frame budget, the fences and what reaches the textures.
+ ***************************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "host/host_gl.h"
+#include "test_texture.h"
+#include "test_util.h"
+
+#include "objects/textures/texture_uploader.h"
+
+namespace gvr {
+namespace test {
+
+int failures = 0;
+
+static const int SIZE = 64;
+static const int IMAGE_BYTES = SIZE * SIZE * 4;
+
+static TextureUploader::Image rgbaImage() {
+    TextureUploader::Image image = { GL_TEXTURE_2D, 0, GL_RGBA8, SIZE, SIZE, GL_RGBA,
+            GL_UNSIGNED_BYTE, false };
+    return image;
+}
+
+static std::vector<char> pixels(unsigned int color) {
+    std::vector<char> bytes(IMAGE_BYTES);
+    unsigned int* texels = reinterpret_cast<unsigned int*>(bytes.data());
+
+    for (int i = 0; i < SIZE * SIZE; ++i) {
+        texels[i] = color;
+    }
+    return bytes;
+}
+
+/*
+ * Finish the GPU work so the fences of the last frame have signaled,
+ * then run the next frame.
+ */
+static void nextFrame() {
+    glFinish();
+    TextureUploader::getInstance().update();
+}
+
+/*
+ * Each frame uploads images until the next one would exceed the budget,
+ * and a texture is only ready once the fence after its upload signaled.
+ */
+static void test_budget_and_fences() {
+    TextureUploader& uploader = TextureUploader::getInstance();
+    std::vector<std::unique_ptr<TestTexture>> textures;
+
+    uploader.set_frame_budget(IMAGE_BYTES * 5 / 2);
+    for (int i = 0; i < 5; ++i) {
+        textures.emplace_back(new TestTexture(SIZE, SIZE));
+        uploader.queue(textures[i].get(), rgbaImage(), pixels(0xff000010 + i));
+        TEST_CHECK(!textures[i]->isReady());
+    }
+
+    uploader.update();
+    TEST_CHECK(uploader.upload_bytes() == 2 * IMAGE_BYTES);
+    for (int i = 0; i < 5; ++i) {
+        TEST_CHECK(!textures[i]->isReady());
+        TEST_CHECK(textures[i]->uploaded_levels().empty());
+    }
+
+    nextFrame();
+    TEST_CHECK(uploader.upload_bytes() == 2 * IMAGE_BYTES);
+    for (int i = 0; i < 5; ++i) {
+        TEST_CHECK(textures[i]->isReady() == (i < 2));
+    }
+
+    nextFrame();
+    TEST_CHECK(uploader.upload_bytes() == IMAGE_BYTES);
+    nextFrame();
+    TEST_CHECK(uploader.upload_bytes() == 0);
+    for (int i = 0; i < 5; ++i) {
+        TEST_CHECK(textures[i]->isReady());
+        TEST_CHECK(textures[i]->uploaded_levels() == std::vector<int>(1, 0));
+        TEST_CHECK(readTexel(textures[i]->getId(), 0, -1, SIZE / 2, SIZE / 2)
+                == 0xff000010 + i);
+    }
+}
+
+/*
+ * An image larger than the budget still goes out, alone in its frame.
+ */
+static void test_image_over_budget() {
+    TextureUploader& uploader = TextureUploader::getInstance();
+    TestTexture first(SIZE, SIZE);
+    TestTexture second(SIZE, SIZE);
+
+    uploader.set_frame_budget(IMAGE_BYTES / 4);
+    uploader.queue(&first, rgbaImage(), pixels(0xff0000ff));
+    uploader.queue(&second, rgbaImage(), pixels(0xff00ff00));
+
+    uploader.update();
+    TEST_CHECK(uploader.upload_bytes() == IMAGE_BYTES);
+    nextFrame();
+    TEST_CHECK(uploader.upload_bytes() == IMAGE_BYTES);
+    TEST_CHECK(first.isReady());
+    TEST_CHECK(!second.isReady());
+    nextFrame();
+    TEST_CHECK(second.isReady());
+    TEST_CHECK(readTexel(second.getId(), 0, -1, 0, 0) == 0xff00ff00);
+}
+
+/*
+ * Images of a texture with immutable storage replace its levels, and
+ * one queued without holding the texture leaves it ready meanwhile.
+ */
+static void test_immutable_storage_levels() {
+    TextureUploader& uploader = TextureUploader::getInstance();
+    TestTexture texture(SIZE, SIZE);
+    std::vector<char> level0 = pixels(0xff112233);
+    std::vector<char> level1 = pixels(0xff445566);
+
+    glBindTexture(GL_TEXTURE_2D, texture.getId());
+    glTexStorage2D(GL_TEXTURE_2D, 2, GL_RGBA8, SIZE, SIZE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    TextureUploader::Image image = rgbaImage();
+    image.immutable_storage = true;
+    image.level = 1;
+    image.width = SIZE / 2;
+    image.height = SIZE / 2;
+    uploader.set_frame_budget(IMAGE_BYTES * 4);
+    uploader.queue(&texture, image, level1.data(), IMAGE_BYTES / 4, true);
+    image.level = 0;
+    image.width = SIZE;
+    image.height = SIZE;
+    uploader.queue(&texture, image, level0.data(), IMAGE_BYTES, false);
+    TEST_CHECK(!texture.isReady());
+
+    nextFrame();
+    nextFrame();
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+    TEST_CHECK(texture.isReady());
+    TEST_CHECK(texture.uploaded_levels() == std::vector<int>({ 1, 0 }));
+    TEST_CHECK(readTexel(texture.getId(), 0, -1, 1, 1) == 0xff112233);
+    TEST_CHECK(readTexel(texture.getId(), 1, -1, 1, 1) == 0xff445566);
+}
+
+/*
+ * Cancelled images, queued or already in flight, no longer hold the
+ * texture and are never reported as uploaded.
+ */
+static void test_cancel() {
+    TextureUploader& uploader = TextureUploader::getInstance();
+    TestTexture queued(SIZE, SIZE);
+    TestTexture in_flight(SIZE, SIZE);
+
+    uploader.set_frame_budget(IMAGE_BYTES);
+    uploader.queue(&in_flight, rgbaImage(), pixels(0xff000000));
+    uploader.queue(&queued, rgbaImage(), pixels(0xff000000));
+    uploader.update();
+    TEST_CHECK(uploader.upload_bytes() == IMAGE_BYTES);
+
+    uploader.cancel(&queued);
+    uploader.cancel(&in_flight);
+    TEST_CHECK(queued.isReady());
+    TEST_CHECK(in_flight.isReady());
+
+    nextFrame();
+    TEST_CHECK(uploader.upload_bytes() == 0);
+    nextFrame();
+    TEST_CHECK(queued.uploaded_levels().empty());
+    TEST_CHECK(in_flight.uploaded_levels().empty());
+}
+
+}
+}
+
+int main() {
+    using namespace gvr::test;
+
+    if (!makeGLContextCurrent()) {
+        return skipped("texture_uploader_test");
+    }
+    test_budget_and_fences();
+    test_image_over_budget();
+    test_immutable_storage_levels();
+    test_cancel();
+    return result("texture_uploader_test");
+}